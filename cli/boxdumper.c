@@ -154,7 +154,7 @@ int main( int argc, char *argv[] )
             lsmash_initialize_media_parameters( &media_param );
             if( lsmash_get_media_parameters( root, track_ID, &media_param ) )
                 return BOXDUMPER_ERR( "Failed to get media parameters.\n" );
-            if( lsmash_construct_timeline( root, track_ID ) )
+            if( lsmash_construct_lazy_timeline( root, track_ID ) )
                 return BOXDUMPER_ERR( "Failed to construct timeline.\n" );
             uint32_t timeline_shift;
             if( lsmash_get_composition_to_decode_shift_from_media_timeline( root, track_ID, &timeline_shift ) )
@@ -60,6 +60,18 @@ int lsmash_write_lsmash_indicator( lsmash_root_t *root )
     return lsmash_write_top_level_box( free_box );
 }
 
+int lsmash_set_recycled_sample_pool( lsmash_root_t *root )
+{
+    /* Recycle the memory of the samples read through the ROOT.
+     * The ROOT holds its own reference to the pool. */
+    lsmash_sample_pool_t *sample_pool = lsmash_create_sample_pool( 0 );
+    if( !sample_pool )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    int ret = lsmash_set_sample_pool( root, sample_pool );
+    lsmash_destroy_sample_pool( sample_pool );
+    return ret;
+}
+
 /*** Dry Run tools ***/
 
 typedef struct
@@ -151,7 +163,12 @@ int dry_open_file
     param->max_chunk_duration  = 0.5;
     param->max_async_tolerance = 2.0;
     param->max_chunk_size      = 4 * 1024 * 1024;
+    param->write_async         = 0;
     param->max_read_size       = 4 * 1024 * 1024;
+    param->read_mmap           = 0;
+    param->read_ahead          = 0;
+    param->read_lazily         = 0;
+    param->read_minimally      = 0;
     return 0;
 }
 
@@ -40,6 +40,7 @@
 #endif
 
 int lsmash_write_lsmash_indicator( lsmash_root_t *root );
+int lsmash_set_recycled_sample_pool( lsmash_root_t *root );
 
 int dry_open_file
 (
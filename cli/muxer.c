@@ -810,6 +810,8 @@ static int open_input_files( muxer_t *muxer )
         if( !root )
             return ERROR_MSG( "failed to create a ROOT for input file.\n" );
         input->root = root;
+        if( lsmash_set_recycled_sample_pool( root ) < 0 )
+            return ERROR_MSG( "failed to set a sample pool for input file.\n" );
         input->importer = lsmash_importer_open( root, input->file_name, "auto" );
         if( !input->importer )
             return ERROR_MSG( "failed to open input file.\n" );
@@ -0,0 +1,972 @@
+/*****************************************************************************
+ * readchecker.c
+ *****************************************************************************
+ * Copyright (C) 2026 L-SMASH project
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *****************************************************************************/
+
+/* This file is available under an ISC license. */
+
+/* This tool reads a file through each of the ways to read samples and checks that all of them get the same samples
+ * as the plain lsmash_get_sample_from_media_timeline() on a file opened with the default parameters.
+ * If no input is given, a movie with known samples is written by the muxing API and checked instead. */
+
+#include "cli.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#define LSMASH_MIN( a, b ) ((a) < (b) ? (a) : (b))
+
+#define eprintf( ... ) fprintf( stderr, __VA_ARGS__ )
+
+#define MAX_NUM_OF_TRACKS      16
+#define MAX_NUM_OF_VIEWS       64
+#define DEFAULT_MAX_READ_SIZE  1000
+#define DEFAULT_WORK_FILE_NAME "readchecker.mp4"
+
+/* Flags to open an input. */
+#define INPUT_READ_AHEAD     0x01
+#define INPUT_READ_MMAP      0x02
+#define INPUT_READ_LAZILY    0x04
+#define INPUT_READ_MINIMALLY 0x08
+
+/* Flags to write a movie. */
+#define TEST_MOVIE_WRITE_ASYNC 0x01
+#define TEST_MOVIE_FRAGMENTED  0x02     /* Put the samples in a movie fragment per second. */
+
+typedef struct
+{
+    const char *input;          /* NULL: check a movie written by this tool */
+    const char *work;           /* the name of the movie written by this tool */
+    uint32_t    max_read_size;  /* max_read_size to open the inputs to check */
+} option_t;
+
+typedef struct
+{
+    lsmash_root_t           *root;
+    lsmash_file_t           *file;
+    lsmash_file_parameters_t param;
+    uint32_t                 num_tracks;
+    uint32_t                 track_ID[MAX_NUM_OF_TRACKS];
+    uint32_t                 sample_count[MAX_NUM_OF_TRACKS];
+} input_t;
+
+static void display_version( void )
+{
+    eprintf( "\n"
+             "L-SMASH isom/mov read checker rev%s  %s\n"
+             "Built on %s %s\n"
+             "Copyright (C) 2026 L-SMASH project\n",
+             LSMASH_REV, LSMASH_GIT_HASH, __DATE__, __TIME__ );
+}
+
+static void display_help( void )
+{
+    display_version();
+    eprintf( "\n"
+             "Usage: readchecker [options] [input]\n"
+             "  If no input is given, a movie with known samples is written and checked.\n"
+             "  options:\n"
+             "    --help                       Display help\n"
+             "    --version                    Display version information\n"
+             "    --max-read-size   <integer>  Specify max_read_size to read the input [%d]\n"
+             "                                 A small value makes reads cross the buffer boundaries often.\n"
+             "    --work            <string>   Specify the name of the movie written if no input is given\n"
+             "                                 [" DEFAULT_WORK_FILE_NAME "]\n",
+             DEFAULT_MAX_READ_SIZE );
+}
+
+/*---- synthetic movie ----*/
+#define TEST_NUM_OF_TRACKS 2
+
+static const struct
+{
+    uint32_t timescale;
+    uint32_t sample_delta;
+    uint32_t sample_count;
+    uint32_t max_sample_size;
+} test_track[TEST_NUM_OF_TRACKS] =
+    {
+        { 25000, 1000, 240, 6000 },
+        { 48000, 1024, 400,  700 }
+    };
+
+static uint32_t get_test_sample_size( uint32_t track_number, uint32_t sample_number )
+{
+    return 1 + ((sample_number * 2654435761u) >> 7) % test_track[track_number - 1].max_sample_size;
+}
+
+static uint8_t get_test_sample_byte( uint32_t track_number, uint32_t sample_number, uint32_t offset )
+{
+    return (uint8_t)(track_number * 131 + sample_number * 31 + offset * 7 + (offset >> 8));
+}
+
+static int write_test_movie( const char *filename, int flags )
+{
+    lsmash_root_t *root = lsmash_create_root();
+    if( !root )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    lsmash_file_parameters_t file_param;
+    int err = lsmash_open_file( filename, 0, &file_param );
+    if( err < 0 )
+    {
+        lsmash_destroy_root( root );
+        return err;
+    }
+    lsmash_brand_type brands[3] = { ISOM_BRAND_TYPE_MP42, ISOM_BRAND_TYPE_MP41, ISOM_BRAND_TYPE_ISOM };
+    file_param.major_brand        = ISOM_BRAND_TYPE_MP42;
+    file_param.brands             = brands;
+    file_param.brand_count        = 3;
+    file_param.max_chunk_duration = 1.0;    /* Make each chunk larger than the buffer of the readers to check. */
+    file_param.write_async        = !!(flags & TEST_MOVIE_WRITE_ASYNC);
+    if( flags & TEST_MOVIE_FRAGMENTED )
+        file_param.mode |= LSMASH_FILE_MODE_FRAGMENTED;
+    uint32_t track_ID    [TEST_NUM_OF_TRACKS] = { 0 };
+    uint32_t sample_entry[TEST_NUM_OF_TRACKS] = { 0 };
+    err = LSMASH_ERR_NAMELESS;
+    if( !lsmash_set_file( root, &file_param ) )
+        goto fail;
+    lsmash_movie_parameters_t movie_param;
+    lsmash_initialize_movie_parameters( &movie_param );
+    if( (err = lsmash_set_movie_parameters( root, &movie_param )) < 0 )
+        goto fail;
+    for( uint32_t i = 0; i < TEST_NUM_OF_TRACKS; i++ )
+    {
+        err = LSMASH_ERR_NAMELESS;
+        track_ID[i] = lsmash_create_track( root, ISOM_MEDIA_HANDLER_TYPE_VIDEO_TRACK );
+        if( track_ID[i] == 0 )
+            goto fail;
+        lsmash_track_parameters_t track_param;
+        lsmash_initialize_track_parameters( &track_param );
+        track_param.mode          = ISOM_TRACK_ENABLED | ISOM_TRACK_IN_MOVIE | ISOM_TRACK_IN_PREVIEW;
+        track_param.display_width  = 320 << 16;
+        track_param.display_height = 240 << 16;
+        if( (err = lsmash_set_track_parameters( root, track_ID[i], &track_param )) < 0 )
+            goto fail;
+        lsmash_media_parameters_t media_param;
+        lsmash_initialize_media_parameters( &media_param );
+        media_param.timescale = test_track[i].timescale;
+        if( (err = lsmash_set_media_parameters( root, track_ID[i], &media_param )) < 0 )
+            goto fail;
+        lsmash_video_summary_t *summary = (lsmash_video_summary_t *)lsmash_create_summary( LSMASH_SUMMARY_TYPE_VIDEO );
+        if( !summary )
+        {
+            err = LSMASH_ERR_MEMORY_ALLOC;
+            goto fail;
+        }
+        summary->sample_type    = ISOM_CODEC_TYPE_MJP2_VIDEO;
+        summary->data_ref_index = 1;
+        summary->width          = 320;
+        summary->height         = 240;
+        sample_entry[i] = lsmash_add_sample_entry( root, track_ID[i], summary );
+        lsmash_cleanup_summary( (lsmash_summary_t *)summary );
+        if( sample_entry[i] == 0 )
+        {
+            err = LSMASH_ERR_NAMELESS;
+            goto fail;
+        }
+    }
+    /* Append the samples of all tracks in the order of their decoding times so that the tracks are interleaved. */
+    uint32_t sample_number[TEST_NUM_OF_TRACKS] = { 0 };
+    while( 1 )
+    {
+        uint32_t i = TEST_NUM_OF_TRACKS;
+        double   min_time = 0;
+        for( uint32_t j = 0; j < TEST_NUM_OF_TRACKS; j++ )
+        {
+            if( sample_number[j] >= test_track[j].sample_count )
+                continue;
+            double time = (double)sample_number[j] * test_track[j].sample_delta / test_track[j].timescale;
+            if( i == TEST_NUM_OF_TRACKS || time < min_time )
+            {
+                i        = j;
+                min_time = time;
+            }
+        }
+        if( i == TEST_NUM_OF_TRACKS )
+            break;
+        if( (flags & TEST_MOVIE_FRAGMENTED) && i == 0 && sample_number[0] && sample_number[0] % 25 == 0 )
+        {
+            for( uint32_t j = 0; j < TEST_NUM_OF_TRACKS; j++ )
+                if( (err = lsmash_flush_pooled_samples( root, track_ID[j], test_track[j].sample_delta )) < 0 )
+                    goto fail;
+            if( (err = lsmash_create_fragment_movie( root )) < 0 )
+                goto fail;
+        }
+        uint32_t number = ++sample_number[i];
+        uint32_t size   = get_test_sample_size( i + 1, number );
+        lsmash_sample_t *sample = lsmash_create_sample( size );
+        if( !sample )
+        {
+            err = LSMASH_ERR_MEMORY_ALLOC;
+            goto fail;
+        }
+        for( uint32_t k = 0; k < size; k++ )
+            sample->data[k] = get_test_sample_byte( i + 1, number, k );
+        sample->dts           = (uint64_t)(number - 1) * test_track[i].sample_delta;
+        sample->cts           = sample->dts;
+        sample->index         = sample_entry[i];
+        sample->prop.ra_flags = (number - 1) % 25 == 0 ? ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC : ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE;
+        if( (err = lsmash_append_sample( root, track_ID[i], sample )) < 0 )
+        {
+            lsmash_delete_sample( sample );
+            goto fail;
+        }
+    }
+    for( uint32_t i = 0; i < TEST_NUM_OF_TRACKS; i++ )
+        if( (err = lsmash_flush_pooled_samples( root, track_ID[i], test_track[i].sample_delta )) < 0 )
+            goto fail;
+    err = lsmash_finish_movie( root, NULL );
+fail:
+    lsmash_destroy_root( root );
+    int ret = lsmash_close_file( &file_param );
+    return err < 0 ? err : ret;
+}
+
+/*---- input ----*/
+static void close_input( input_t *in )
+{
+    lsmash_destroy_root( in->root );
+    in->root = NULL;
+    lsmash_close_file( &in->param );
+}
+
+static int open_input( input_t *in, const char *filename, int flags, uint32_t max_read_size )
+{
+    memset( in, 0, sizeof(input_t) );
+    in->root = lsmash_create_root();
+    if( !in->root )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    int err = lsmash_open_file( filename, 1, &in->param );
+    if( err < 0 )
+    {
+        lsmash_destroy_root( in->root );
+        in->root = NULL;
+        return err;
+    }
+    if( max_read_size )
+        in->param.max_read_size = max_read_size;
+    in->param.read_ahead     = !!(flags & INPUT_READ_AHEAD);
+    in->param.read_mmap      = !!(flags & INPUT_READ_MMAP);
+    in->param.read_lazily    = !!(flags & INPUT_READ_LAZILY);
+    in->param.read_minimally = !!(flags & INPUT_READ_MINIMALLY);
+    in->file = lsmash_set_file( in->root, &in->param );
+    if( !in->file )
+    {
+        err = LSMASH_ERR_NAMELESS;
+        goto fail;
+    }
+    if( (err = lsmash_read_file( in->file, &in->param )) < 0 )
+        goto fail;
+    lsmash_movie_parameters_t movie_param;
+    lsmash_initialize_movie_parameters( &movie_param );
+    if( (err = lsmash_get_movie_parameters( in->root, &movie_param )) < 0 )
+        goto fail;
+    in->num_tracks = LSMASH_MIN( movie_param.number_of_tracks, MAX_NUM_OF_TRACKS );
+    for( uint32_t i = 0; i < in->num_tracks; i++ )
+    {
+        in->track_ID[i] = lsmash_get_track_ID( in->root, i + 1 );
+        if( in->track_ID[i] == 0 )
+        {
+            err = LSMASH_ERR_NAMELESS;
+            goto fail;
+        }
+    }
+    return 0;
+fail:
+    close_input( in );
+    return err;
+}
+
+static int construct_timelines( input_t *in )
+{
+    for( uint32_t i = 0; i < in->num_tracks; i++ )
+    {
+        int err = lsmash_construct_timeline( in->root, in->track_ID[i] );
+        if( err < 0 )
+            return err;
+        in->sample_count[i] = lsmash_get_sample_count_in_media_timeline( in->root, in->track_ID[i] );
+    }
+    return 0;
+}
+
+static int is_same_sample( lsmash_sample_t *a, lsmash_sample_t *b )
+{
+    return a && b
+        && a->length == b->length
+        && a->dts    == b->dts
+        && a->cts    == b->cts
+        && a->pos    == b->pos
+        && a->index  == b->index
+        && !memcmp( &a->prop, &b->prop, sizeof(lsmash_sample_property_t) )
+        && (a->length == 0 || !memcmp( a->data, b->data, a->length ));
+}
+
+/* Return 1 if the sample gotten from the reference input is the same as a given one, 0 otherwise. */
+static int is_reference_sample( input_t *ref, uint32_t track_number, uint32_t sample_number, lsmash_sample_t *sample )
+{
+    lsmash_sample_t *ref_sample = lsmash_get_sample_from_media_timeline( ref->root, ref->track_ID[track_number - 1], sample_number );
+    int same = is_same_sample( ref_sample, sample );
+    lsmash_delete_sample( ref_sample );
+    return same;
+}
+
+/* Compare all samples in the media timelines of an input with the reference.
+ * Return the number of mismatches. */
+static int compare_samples( input_t *in, input_t *ref )
+{
+    int mismatches = in->num_tracks != ref->num_tracks;
+    for( uint32_t i = 1; i <= in->num_tracks && i <= ref->num_tracks; i++ )
+    {
+        mismatches += in->sample_count[i - 1] != ref->sample_count[i - 1];
+        for( uint32_t j = 1; j <= in->sample_count[i - 1]; j++ )
+        {
+            lsmash_sample_t *sample = lsmash_get_sample_from_media_timeline( in->root, in->track_ID[i - 1], j );
+            mismatches += !is_reference_sample( ref, i, j, sample );
+            lsmash_delete_sample( sample );
+        }
+    }
+    return mismatches;
+}
+
+/* Read a whole file on memory. */
+static uint8_t *load_file( const char *filename, size_t *size )
+{
+    FILE *fp = lsmash_fopen( filename, "rb" );
+    if( !fp )
+        return NULL;
+    uint8_t *data = NULL;
+    int64_t  end;
+    if( lsmash_fseek( fp, 0, SEEK_END ) == 0
+     && (end = lsmash_ftell( fp )) > 0
+     && (uint64_t)end <= SIZE_MAX
+     && lsmash_fseek( fp, 0, SEEK_SET ) == 0
+     && (data = malloc( (size_t)end )) )
+    {
+        if( fread( data, 1, (size_t)end, fp ) == (size_t)end )
+            *size = (size_t)end;
+        else
+        {
+            free( data );
+            data = NULL;
+        }
+    }
+    fclose( fp );
+    return data;
+}
+
+/* Write data into a file opened in a given mode, i.e. "wb" to overwrite or "ab" to append. */
+static int write_file( const char *filename, const char *mode, const uint8_t *data, size_t size )
+{
+    FILE *fp = lsmash_fopen( filename, mode );
+    if( !fp )
+        return LSMASH_ERR_NAMELESS;
+    int err = fwrite( data, 1, size, fp ) == size ? 0 : LSMASH_ERR_NAMELESS;
+    if( fclose( fp ) != 0 )
+        err = LSMASH_ERR_NAMELESS;
+    return err;
+}
+
+static uint64_t get_be( const uint8_t *p, int length )
+{
+    uint64_t value = 0;
+    for( int i = 0; i < length; i++ )
+        value = (value << 8) | p[i];
+    return value;
+}
+
+/* Get the offset of the first top-level Movie Fragment Box in a file on memory.
+ * Return the size of the file if not found. */
+static size_t get_first_fragment_offset( const uint8_t *data, size_t size )
+{
+    size_t pos = 0;
+    while( size - pos >= 8 )
+    {
+        if( !memcmp( &data[pos + 4], "moof", 4 ) )
+            return pos;
+        uint64_t box_size = get_be( &data[pos], 4 );
+        if( box_size == 1 && size - pos >= 16 )
+            box_size = get_be( &data[pos + 8], 8 );
+        if( box_size < 8 || box_size > size - pos )
+            break;
+        pos += box_size;
+    }
+    return size;
+}
+
+/*---- checks ----*/
+/* Each check returns the number of mismatches, or a negative value if failed to get samples. */
+/* Compare all samples in the media timelines of an input with the samples written by write_test_movie().
+ * Return the number of mismatches, or a negative value if failed to get samples. */
+static int compare_test_samples( input_t *in )
+{
+    if( in->num_tracks != TEST_NUM_OF_TRACKS )
+        return 1;
+    int mismatches = 0;
+    for( uint32_t i = 1; i <= TEST_NUM_OF_TRACKS; i++ )
+    {
+        if( in->sample_count[i - 1] != test_track[i - 1].sample_count )
+            ++mismatches;
+        for( uint32_t j = 1; j <= in->sample_count[i - 1]; j++ )
+        {
+            lsmash_sample_t *sample = lsmash_get_sample_from_media_timeline( in->root, in->track_ID[i - 1], j );
+            if( !sample )
+                return LSMASH_ERR_NAMELESS;
+            uint32_t size = get_test_sample_size( i, j );
+            int same = sample->length == size
+                    && sample->dts    == (uint64_t)(j - 1) * test_track[i - 1].sample_delta;
+            for( uint32_t k = 0; same && k < size; k++ )
+                same = sample->data[k] == get_test_sample_byte( i, j, k );
+            mismatches += !same;
+            lsmash_delete_sample( sample );
+        }
+    }
+    return mismatches;
+}
+
+static int check_test_movie( option_t *opt, input_t *ref )
+{
+    (void)opt;
+    return compare_test_samples( ref );
+}
+
+static int check_read_ahead( option_t *opt, input_t *ref )
+{
+    input_t in;
+    int err = open_input( &in, opt->input, INPUT_READ_AHEAD, opt->max_read_size );
+    if( err < 0 )
+        return err;
+    if( (err = construct_timelines( &in )) < 0 )
+    {
+        close_input( &in );
+        return err;
+    }
+    int mismatches = compare_samples( &in, ref );
+    close_input( &in );
+    return mismatches;
+}
+
+static int check_sample_views( option_t *opt, input_t *ref )
+{
+    input_t in;
+    int err = open_input( &in, opt->input, INPUT_READ_AHEAD, opt->max_read_size );
+    if( err < 0 )
+        return err;
+    if( (err = construct_timelines( &in )) < 0 )
+        goto fail;
+    int mismatches = 0;
+    for( uint32_t i = 1; i <= in.num_tracks; i++ )
+    {
+        /* Get the samples one by one in a backward order so that every view needs a seek. */
+        for( uint32_t j = in.sample_count[i - 1]; j; j-- )
+        {
+            lsmash_sample_t view;
+            if( (err = lsmash_get_sample_view_from_media_timeline( in.root, in.track_ID[i - 1], j, &view )) < 0 )
+                goto fail;
+            mismatches += !is_reference_sample( ref, i, j, &view );
+        }
+        /* Get the samples in chunk units. */
+        for( uint32_t j = 1; j <= in.sample_count[i - 1]; )
+        {
+            lsmash_sample_t views[MAX_NUM_OF_VIEWS];
+            uint32_t        view_count = MAX_NUM_OF_VIEWS;
+            if( (err = lsmash_get_sample_views_from_media_timeline( in.root, in.track_ID[i - 1], j, views, &view_count )) < 0 )
+                goto fail;
+            if( view_count == 0 )
+            {
+                err = LSMASH_ERR_NAMELESS;
+                goto fail;
+            }
+            for( uint32_t k = 0; k < view_count; k++ )
+                mismatches += !is_reference_sample( ref, i, j + k, &views[k] );
+            j += view_count;
+        }
+    }
+    close_input( &in );
+    return mismatches;
+fail:
+    close_input( &in );
+    return err;
+}
+
+static int check_read_planner( option_t *opt, input_t *ref )
+{
+    input_t in;
+    int err = open_input( &in, opt->input, INPUT_READ_AHEAD, opt->max_read_size );
+    if( err < 0 )
+        return err;
+    lsmash_read_planner_t *planner = NULL;
+    if( (err = construct_timelines( &in )) < 0 )
+        goto fail;
+    planner = lsmash_create_read_planner( in.root, in.track_ID, in.num_tracks, opt->max_read_size );
+    if( !planner )
+    {
+        err = LSMASH_ERR_NAMELESS;
+        goto fail;
+    }
+    /* Demux all tracks in turn as the remuxer does, and jump back to the start of each track once in the middle. */
+    int      mismatches = 0;
+    uint32_t sample_number[MAX_NUM_OF_TRACKS];
+    int      jumped       [MAX_NUM_OF_TRACKS] = { 0 };
+    for( uint32_t i = 0; i < in.num_tracks; i++ )
+        sample_number[i] = 1;
+    for( int active = 1; active; )
+    {
+        active = 0;
+        for( uint32_t i = 1; i <= in.num_tracks; i++ )
+        {
+            uint32_t j = sample_number[i - 1];
+            if( j > in.sample_count[i - 1] )
+                continue;
+            lsmash_sample_t *sample = lsmash_get_sample_from_read_planner( planner, in.track_ID[i - 1], j );
+            mismatches += !is_reference_sample( ref, i, j, sample );
+            lsmash_delete_sample( sample );
+            if( !jumped[i - 1] && j == in.sample_count[i - 1] / 2 )
+            {
+                jumped[i - 1] = 1;
+                sample_number[i - 1] = 1;
+            }
+            else
+                ++sample_number[i - 1];
+            active = 1;
+        }
+    }
+    lsmash_destroy_read_planner( planner );
+    close_input( &in );
+    return mismatches;
+fail:
+    lsmash_destroy_read_planner( planner );
+    close_input( &in );
+    return err;
+}
+
+static int check_write_async( option_t *opt, input_t *ref )
+{
+    char filename[FILENAME_MAX];
+    snprintf( filename, sizeof(filename), "%s.async", opt->work );
+    int err = write_test_movie( filename, TEST_MOVIE_WRITE_ASYNC );
+    if( err < 0 )
+        goto fail;
+    input_t in;
+    if( (err = open_input( &in, filename, 0, 0 )) < 0 )
+        goto fail;
+    if( (err = construct_timelines( &in )) < 0 )
+    {
+        close_input( &in );
+        goto fail;
+    }
+    int mismatches = compare_samples( &in, ref );
+    close_input( &in );
+    remove( filename );
+    return mismatches;
+fail:
+    remove( filename );
+    return err;
+}
+
+/* Write a fragmented movie, and then check the timelines extended while the movie grows up to it as if recorded live. */
+static int check_extension( option_t *opt, int flags )
+{
+    char source[FILENAME_MAX];
+    char growing[FILENAME_MAX];
+    snprintf( source,  sizeof(source),  "%s.frag", opt->work );
+    snprintf( growing, sizeof(growing), "%s.grow", opt->work );
+    uint8_t *data = NULL;
+    size_t   size = 0;
+    input_t  in;
+    in.root = NULL;
+    int err = write_test_movie( source, TEST_MOVIE_FRAGMENTED );
+    if( err < 0 )
+        goto done;
+    data = load_file( source, &size );
+    if( !data )
+    {
+        err = LSMASH_ERR_NAMELESS;
+        goto done;
+    }
+    /* Start from the movie without any movie fragment, and append a part of the rest at a time. */
+    size_t pos = get_first_fragment_offset( data, size );
+    if( (err = write_file( growing, "wb", data, pos )) < 0
+     || (err = open_input( &in, growing, flags, opt->max_read_size )) < 0
+     || (err = construct_timelines( &in )) < 0 )
+        goto done;
+    while( pos < size )
+    {
+        size_t append_size = LSMASH_MIN( 7000, size - pos );
+        if( (err = write_file( growing, "ab", data + pos, append_size )) < 0 )
+            goto done;
+        pos += append_size;
+        for( uint32_t i = 0; i < in.num_tracks; i++ )
+            if( (err = lsmash_extend_timeline( in.root, in.track_ID[i], &in.sample_count[i] )) < 0 )
+                goto done;
+    }
+    err = compare_test_samples( &in );
+done:
+    if( in.root )
+        close_input( &in );
+    free( data );
+    remove( growing );
+    remove( source );
+    return err;
+}
+
+static int check_extend_timeline( option_t *opt, input_t *ref )
+{
+    (void)ref;
+    return check_extension( opt, 0 );
+}
+
+static int check_extend_mapped_timeline( option_t *opt, input_t *ref )
+{
+    (void)ref;
+    return check_extension( opt, INPUT_READ_MMAP );
+}
+
+static int check_read_lazily( option_t *opt, input_t *ref )
+{
+    input_t in;
+    int err = open_input( &in, opt->input, INPUT_READ_LAZILY, opt->max_read_size );
+    if( err < 0 )
+        return err;
+    if( (err = construct_timelines( &in )) < 0 )
+    {
+        close_input( &in );
+        return err;
+    }
+    int mismatches = compare_samples( &in, ref );
+    close_input( &in );
+    return mismatches;
+}
+
+/* Read all samples of the input, and get the number of bytes read from the file. */
+static int count_read_bytes( option_t *opt, int flags, input_t *ref, uint64_t *read_bytes )
+{
+    input_t in;
+    int err = open_input( &in, opt->input, flags, 0 );
+    if( err < 0 )
+        return err;
+    if( (err = construct_timelines( &in )) == 0 )
+    {
+        err = compare_samples( &in, ref );
+        *read_bytes = lsmash_count_read_bytes( in.file );
+    }
+    close_input( &in );
+    return err;
+}
+
+/* Check that reading lazily does not read more bytes than usual with the default max_read_size,
+ * i.e. the table boxes and the movie fragments on hand are not deferred to be read again. */
+static int check_read_lazily_bytes( option_t *opt, input_t *ref )
+{
+    uint64_t usual_bytes;
+    uint64_t lazy_bytes;
+    int usual = count_read_bytes( opt, 0,                 ref, &usual_bytes );
+    if( usual < 0 )
+        return usual;
+    int lazy  = count_read_bytes( opt, INPUT_READ_LAZILY, ref, &lazy_bytes );
+    if( lazy < 0 )
+        return lazy;
+    return usual + lazy + (lazy_bytes > usual_bytes);
+}
+
+/* Write a fragmented movie, which has the Movie Fragment Random Access Box at the end, and check it read lazily,
+ * i.e. the movie fragments indexed by the box are read at the construction of the timelines. */
+static int check_fragments_read_lazily( option_t *opt, input_t *ref )
+{
+    (void)ref;
+    char filename[FILENAME_MAX];
+    snprintf( filename, sizeof(filename), "%s.frag", opt->work );
+    input_t in;
+    in.root = NULL;
+    int err = write_test_movie( filename, TEST_MOVIE_FRAGMENTED );
+    if( err < 0
+     || (err = open_input( &in, filename, INPUT_READ_LAZILY, opt->max_read_size )) < 0
+     || (err = construct_timelines( &in )) < 0 )
+        goto done;
+    err = compare_test_samples( &in );
+done:
+    if( in.root )
+        close_input( &in );
+    remove( filename );
+    return err;
+}
+
+/* Read the samples allocated from a sample pool, and check that the memory blocks are reused and all returned to the pool. */
+static int check_sample_pool( option_t *opt, input_t *ref )
+{
+    lsmash_sample_pool_t *pool = lsmash_create_sample_pool( 0 );
+    if( !pool )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    input_t in;
+    in.root = NULL;
+    int err = open_input( &in, opt->input, 0, opt->max_read_size );
+    if( err < 0
+     || (err = lsmash_set_sample_pool( in.root, pool )) < 0
+     || (err = construct_timelines( &in )) < 0 )
+        goto done;
+    int mismatches = compare_samples( &in, ref );
+    /* Grow and shrink the data of a pooled sample, which shall keep its contents. */
+    lsmash_sample_t *sample = lsmash_create_sample_from_pool( pool, 100 );
+    if( !sample )
+    {
+        err = LSMASH_ERR_MEMORY_ALLOC;
+        goto done;
+    }
+    for( uint32_t i = 0; i < 100; i++ )
+        sample->data[i] = (uint8_t)i;
+    if( (err = lsmash_sample_alloc( sample, 5000 )) < 0
+     || (err = lsmash_sample_alloc( sample, 50 )) < 0 )
+    {
+        lsmash_delete_sample( sample );
+        goto done;
+    }
+    for( uint32_t i = 0; i < 50; i++ )
+        mismatches += sample->data[i] != (uint8_t)i;
+    lsmash_delete_sample( sample );
+    lsmash_sample_pool_stats_t stats;
+    if( (err = lsmash_get_sample_pool_stats( pool, &stats )) < 0 )
+        goto done;
+    mismatches += stats.live_count != 0 || stats.live_size != 0;
+    mismatches += stats.reuse_count == 0;
+    err = mismatches;
+done:
+    if( in.root )
+        close_input( &in );
+    lsmash_destroy_sample_pool( pool );
+    return err;
+}
+
+/* Load the timelines from an index file and compare their samples with the reference.
+ * Return the number of mismatches, or LSMASH_ERR_INVALID_DATA if the index is not valid for the file. */
+static int compare_indexed_samples( option_t *opt, const char *filename, const char *index, input_t *ref )
+{
+    input_t in;
+    int err = open_input( &in, filename, INPUT_READ_LAZILY, opt->max_read_size );
+    if( err < 0 )
+        return err;
+    if( (err = lsmash_read_timeline_index( in.root, index )) == 0 )
+    {
+        for( uint32_t i = 0; i < in.num_tracks; i++ )
+            in.sample_count[i] = lsmash_get_sample_count_in_media_timeline( in.root, in.track_ID[i] );
+        err = compare_samples( &in, ref );
+    }
+    close_input( &in );
+    return err;
+}
+
+/* Write the timelines into an index file, and check the timelines loaded from it.
+ * The index shall be rejected once the file is changed. */
+static int check_timeline_index( option_t *opt, input_t *ref )
+{
+    static const uint8_t free_box[8] = { 0x00, 0x00, 0x00, 0x08, 'f', 'r', 'e', 'e' };
+    char source[FILENAME_MAX];
+    char index [FILENAME_MAX];
+    snprintf( source, sizeof(source), "%s.src",   opt->work );
+    snprintf( index,  sizeof(index),  "%s.index", opt->work );
+    size_t   size = 0;
+    uint8_t *data = load_file( opt->input, &size );
+    if( !data )
+        return LSMASH_ERR_NAMELESS;
+    input_t in;
+    int err = write_file( source, "wb", data, size );
+    if( err < 0
+     || (err = open_input( &in, source, 0, opt->max_read_size )) < 0 )
+        goto done;
+    if( (err = construct_timelines( &in )) == 0 )
+        err = lsmash_write_timeline_index( in.root, index );
+    close_input( &in );
+    if( err < 0
+     || (err = compare_indexed_samples( opt, source, index, ref )) < 0 )
+        goto done;
+    int mismatches = err;
+    /* Append a Free Space Box to the file, which makes the index stale. */
+    if( (err = write_file( source, "ab", free_box, sizeof(free_box) )) < 0 )
+        goto done;
+    err = compare_indexed_samples( opt, source, index, ref );
+    if( err >= 0 || err == LSMASH_ERR_INVALID_DATA )
+        err = mismatches + (err != LSMASH_ERR_INVALID_DATA);
+done:
+    free( data );
+    remove( index );
+    remove( source );
+    return err;
+}
+
+/* Read a file minimally, and compare the samples with the expected ones.
+ * The number of bytes read by opening the file is set to 'open_bytes'.
+ * Unless read lazily, check that no bytes of the samples are read until their data is gotten, i.e. the bytes read
+ * to construct the timelines and the total size of the samples fit in the file. If read lazily, the headers of the
+ * deferred boxes are read twice. */
+static int check_minimal_reads( const char *filename, int flags, input_t *ref, uint64_t *open_bytes )
+{
+    FILE *fp = fopen( filename, "rb" );
+    if( !fp )
+        return LSMASH_ERR_NAMELESS;
+    int err = fseek( fp, 0, SEEK_END ) != 0 ? LSMASH_ERR_NAMELESS : 0;
+    long file_size = ftell( fp );
+    fclose( fp );
+    if( err < 0 || file_size < 0 )
+        return LSMASH_ERR_NAMELESS;
+    input_t in;
+    if( (err = open_input( &in, filename, INPUT_READ_MINIMALLY | flags, 0 )) < 0 )
+        return err;
+    *open_bytes = lsmash_count_read_bytes( in.file );
+    if( (err = construct_timelines( &in )) < 0 )
+        goto done;
+    uint64_t read_bytes   = lsmash_count_read_bytes( in.file );
+    uint64_t sample_bytes = 0;
+    for( uint32_t i = 0; i < in.num_tracks; i++ )
+        for( uint32_t j = 1; j <= in.sample_count[i]; j++ )
+        {
+            lsmash_sample_t info;
+            if( (err = lsmash_get_sample_info_from_media_timeline( in.root, in.track_ID[i], j, &info )) < 0 )
+                goto done;
+            sample_bytes += info.length;
+        }
+    int mismatches = !(flags & INPUT_READ_LAZILY) && read_bytes + sample_bytes > (uint64_t)file_size;
+    err = mismatches + (ref ? compare_samples( &in, ref ) : compare_test_samples( &in ));
+done:
+    close_input( &in );
+    return err;
+}
+
+static int check_read_minimally( option_t *opt, input_t *ref )
+{
+    uint64_t open_bytes;
+    return check_minimal_reads( opt->input, 0, ref, &open_bytes );
+}
+
+/* Write a fragmented movie, and check it read minimally and lazily, i.e. the indexed movie fragments are skipped
+ * after reading only their header, and therefore opening it reads fewer bytes than without reading lazily. */
+static int check_fragments_read_minimally( option_t *opt, input_t *ref )
+{
+    (void)ref;
+    char filename[FILENAME_MAX];
+    snprintf( filename, sizeof(filename), "%s.frag", opt->work );
+    uint64_t usual_open_bytes;
+    uint64_t lazy_open_bytes;
+    int usual = 0;
+    int lazy  = 0;
+    int err = write_test_movie( filename, TEST_MOVIE_FRAGMENTED );
+    if( err < 0
+     || (err = usual = check_minimal_reads( filename, 0,                 NULL, &usual_open_bytes )) < 0
+     || (err = lazy  = check_minimal_reads( filename, INPUT_READ_LAZILY, NULL, &lazy_open_bytes  )) < 0 )
+        goto done;
+    err = usual + lazy + (lazy_open_bytes >= usual_open_bytes);
+done:
+    remove( filename );
+    return err;
+}
+
+static const struct
+{
+    const char *name;
+    int         test_movie_only;
+    int       (*func)( option_t *opt, input_t *ref );
+} checks[] =
+    {
+        { "muxed samples",                         1, check_test_movie               },
+        { "muxed samples with asynchronous write", 1, check_write_async              },
+        { "samples with read-ahead",               0, check_read_ahead               },
+        { "sample views with read-ahead",          0, check_sample_views             },
+        { "read planner with read-ahead",          0, check_read_planner             },
+        { "timeline extension",                    1, check_extend_timeline          },
+        { "timeline extension of a mapped file",   1, check_extend_mapped_timeline   },
+        { "samples read lazily",                   0, check_read_lazily              },
+        { "movie fragments read lazily",           1, check_fragments_read_lazily    },
+        { "bytes read lazily",                     0, check_read_lazily_bytes        },
+        { "samples read minimally",                0, check_read_minimally           },
+        { "movie fragments read minimally",        1, check_fragments_read_minimally },
+        { "samples from a sample pool",            0, check_sample_pool              },
+        { "timelines loaded from an index",        0, check_timeline_index           },
+        { NULL,                                    0, NULL                           }
+    };
+
+int main( int argc, char *argv[] )
+{
+    lsmash_get_mainargs( &argc, &argv );
+    option_t opt =
+    {
+        .input         = NULL,
+        .work          = DEFAULT_WORK_FILE_NAME,
+        .max_read_size = DEFAULT_MAX_READ_SIZE
+    };
+    for( int argn = 1; argn < argc; argn++ )
+    {
+        if( !strcasecmp( argv[argn], "-h" ) || !strcasecmp( argv[argn], "--help" ) )
+        {
+            display_help();
+            return 0;
+        }
+        else if( !strcasecmp( argv[argn], "-v" ) || !strcasecmp( argv[argn], "--version" ) )
+        {
+            display_version();
+            return 0;
+        }
+        else if( !strcasecmp( argv[argn], "--max-read-size" ) && argn + 1 < argc )
+            opt.max_read_size = atoi( argv[++argn] );
+        else if( !strcasecmp( argv[argn], "--work" ) && argn + 1 < argc )
+            opt.work = argv[++argn];
+        else if( argv[argn][0] != '-' && !opt.input )
+            opt.input = argv[argn];
+        else
+        {
+            display_help();
+            return -1;
+        }
+    }
+    int test_movie = !opt.input;
+    if( test_movie )
+    {
+        int err = write_test_movie( opt.work, 0 );
+        if( err < 0 )
+        {
+            eprintf( "Error: failed to write %s (%d).\n", opt.work, err );
+            return -1;
+        }
+        opt.input = opt.work;
+    }
+    input_t ref;
+    int err = open_input( &ref, opt.input, 0, 0 );
+    if( err < 0 || (err = construct_timelines( &ref )) < 0 )
+    {
+        if( ref.root )
+            close_input( &ref );
+        eprintf( "Error: failed to read %s (%d).\n", opt.input, err );
+        if( test_movie )
+            remove( opt.work );
+        return -1;
+    }
+    int failures = 0;
+    for( int i = 0; checks[i].name; i++ )
+    {
+        if( checks[i].test_movie_only && !test_movie )
+            continue;
+        int ret = checks[i].func( &opt, &ref );
+        if( ret == 0 )
+            eprintf( "%-41s OK\n", checks[i].name );
+        else if( ret > 0 )
+            eprintf( "%-41s FAILED (%d mismatches)\n", checks[i].name, ret );
+        else
+            eprintf( "%-41s FAILED (error %d)\n", checks[i].name, ret );
+        failures += ret != 0;
+    }
+    close_input( &ref );
+    if( test_movie )
+        remove( opt.work );
+    return failures ? -1 : 0;
+}
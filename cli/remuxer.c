@@ -28,6 +28,9 @@
 #include <inttypes.h>
 #include <stdarg.h>
 
+/* the maximum number of the external media files open at a time for each input */
+#define MAX_NUM_OPEN_DATA_REFERENCES 16
+
 typedef struct
 {
     uint32_t                  track_ID;
@@ -125,8 +128,9 @@ typedef struct
 
 typedef struct
 {
-    lsmash_root_t *root;
-    input_file_t   file;
+    lsmash_root_t         *root;
+    lsmash_read_planner_t *planner;
+    input_file_t           file;
 } input_t;
 
 typedef struct
@@ -199,6 +203,8 @@ static void cleanup_input_movie( input_t *input )
         }
         lsmash_freep( &in_movie->track );
     }
+    lsmash_destroy_read_planner( input->planner );
+    input->planner = NULL;
     lsmash_close_file( &input->file.param );
     lsmash_destroy_root( input->root );
     input->root = NULL;
@@ -456,6 +462,11 @@ static int get_movie( input_t *input, char *input_name )
     input->root = lsmash_create_root();
     if( !input->root )
         return ERROR_MSG( "failed to create a ROOT for an input file.\n" );
+    if( lsmash_set_recycled_sample_pool( input->root ) < 0 )
+        return ERROR_MSG( "failed to set a sample pool for an input file.\n" );
+    /* Keep a limited number of the external media files open at a time. */
+    if( lsmash_set_file_handle_cache( input->root, MAX_NUM_OPEN_DATA_REFERENCES ) < 0 )
+        return ERROR_MSG( "failed to set a file handle cache for an input file.\n" );
     input_file_t *in_file = &input->file;
     if( lsmash_open_file( input_name, 1, &in_file->param ) < 0 )
         return ERROR_MSG( "failed to open an input file.\n" );
@@ -525,6 +536,7 @@ static int get_movie( input_t *input, char *input_name )
             WARNING_MSG( "failed to allocate handles of data reference.\n" );
             continue;
         }
+        in_track[i].media.num_data_refs = data_ref_count;
         for( uint32_t j = 0; j < data_ref_count; j++ )
         {
             input_data_ref_t *in_data_ref = &in_track[i].media.data_refs[j];
@@ -1514,6 +1526,29 @@ static void adjust_timestamp( output_track_t *out_track, lsmash_sample_t *sample
     }
 }
 
+static int create_read_planners( remuxer_t *remuxer )
+{
+    for( int i = 0; i < remuxer->num_input; i++ )
+    {
+        input_t       *input    = &remuxer->input[i];
+        input_movie_t *in_movie = &input->file.movie;
+        uint32_t *track_IDs = lsmash_malloc( in_movie->num_tracks * sizeof(uint32_t) );
+        if( !track_IDs )
+            return ERROR_MSG( "failed to allocate track IDs.\n" );
+        uint32_t num_active_tracks = 0;
+        for( uint32_t j = 0; j < in_movie->num_tracks; j++ )
+            if( in_movie->track[j].active )
+                track_IDs[num_active_tracks++] = in_movie->track[j].track_ID;
+        /* Read the samples of all active tracks in the order of the file offsets. */
+        if( num_active_tracks )
+            input->planner = lsmash_create_read_planner( input->root, track_IDs, num_active_tracks, 0 );
+        lsmash_free( track_IDs );
+        if( num_active_tracks && !input->planner )
+            return ERROR_MSG( "failed to create a read planner.\n" );
+    }
+    return 0;
+}
+
 static int do_remux( remuxer_t *remuxer )
 {
 #define LSMASH_MAX( a, b ) ((a) > (b) ? (a) : (b))
@@ -1529,6 +1564,8 @@ static int do_remux( remuxer_t *remuxer )
     uint64_t total_media_size            = 0;
     uint32_t progress_pos                = 0;
     uint8_t  pending_flush_fragments     = (remuxer->frag_base_track != 0); /* For non-fragmented movie, always set to 0. */
+    if( create_read_planners( remuxer ) < 0 )
+        return -1;
     while( 1 )
     {
         input_t       *in       = &inputs[input_movie_number - 1];
@@ -1554,7 +1591,7 @@ static int do_remux( remuxer_t *remuxer )
             /* Get a new sample data if the track doesn't hold any one. */
             if( !sample )
             {
-                sample = lsmash_get_sample_from_media_timeline( in->root, in_track->track_ID, in_track->current_sample_number );
+                sample = lsmash_get_sample_from_read_planner( in->planner, in_track->track_ID, in_track->current_sample_number );
                 if( sample )
                 {
                     output_track_t *out_track = &out_movie->track[ out_movie->current_track_number - 1 ];
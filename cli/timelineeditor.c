@@ -268,6 +268,8 @@ static int get_movie( root_t *input, char *input_name )
     input->root = lsmash_create_root();
     if( !input->root )
         return ERROR_MSG( "failed to create a ROOT for an input file.\n" );
+    if( lsmash_set_recycled_sample_pool( input->root ) < 0 )
+        return ERROR_MSG( "failed to set a sample pool for an input file.\n" );
     file_t *in_file = &input->file;
     if( lsmash_open_file( input_name, 1, &in_file->param ) < 0 )
         return ERROR_MSG( "failed to open an input file.\n" );
@@ -0,0 +1,146 @@
+/*****************************************************************************
+ * arena.c
+ *****************************************************************************
+ * Copyright (C) 2010-2017 L-SMASH project
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *****************************************************************************/
+
+/* This file is available under an ISC license. */
+
+#include "internal.h" /* must be placed first */
+
+#include <string.h>
+
+#define LSMASH_ARENA_FIRST_BLOCK_SIZE (1<<14)
+
+typedef union
+{
+    uint64_t    u;
+    long double f;
+    void       *p;
+} lsmash_arena_align_t;
+
+#define LSMASH_ARENA_ALIGN_SIZE( size ) \
+    (((size) + sizeof(lsmash_arena_align_t) - 1) / sizeof(lsmash_arena_align_t) * sizeof(lsmash_arena_align_t))
+
+typedef struct lsmash_arena_block_tag lsmash_arena_block_t;
+
+struct lsmash_arena_block_tag
+{
+    lsmash_arena_block_t *next;
+    size_t                size;     /* the size of the data */
+    size_t                used;
+    lsmash_arena_align_t  data[];
+};
+
+/* The size of each block is twice as large as the previous one's.
+ * So the number of blocks stays small, which keeps lsmash_arena_contains() cheap. */
+struct lsmash_arena_tag
+{
+    lsmash_arena_block_t *head;     /* the latest block */
+    size_t                next_block_size;
+};
+
+lsmash_arena_t *lsmash_arena_create
+(
+    void
+)
+{
+    lsmash_arena_t *arena = lsmash_malloc( sizeof(lsmash_arena_t) );
+    if( !arena )
+        return NULL;
+    arena->head            = NULL;
+    arena->next_block_size = LSMASH_ARENA_FIRST_BLOCK_SIZE;
+    return arena;
+}
+
+void lsmash_arena_destroy
+(
+    lsmash_arena_t *arena
+)
+{
+    if( !arena )
+        return;
+    for( lsmash_arena_block_t *block = arena->head; block; )
+    {
+        lsmash_arena_block_t *next = block->next;
+        lsmash_free( block );
+        block = next;
+    }
+    lsmash_free( arena );
+}
+
+void *lsmash_arena_alloc
+(
+    lsmash_arena_t *arena,
+    size_t          size
+)
+{
+    if( !arena || size == 0 || size > SIZE_MAX / 2 )
+        return NULL;
+    size = LSMASH_ARENA_ALIGN_SIZE( size );
+    lsmash_arena_block_t *block = arena->head;
+    if( !block || block->size - block->used < size )
+    {
+        size_t block_size = LSMASH_MAX( arena->next_block_size, size );
+        if( block_size > SIZE_MAX - sizeof(lsmash_arena_block_t) )
+            return NULL;
+        block = lsmash_malloc( sizeof(lsmash_arena_block_t) + block_size );
+        if( !block )
+            return NULL;
+        block->next = arena->head;
+        block->size = block_size;
+        block->used = 0;
+        arena->head = block;
+        if( arena->next_block_size <= SIZE_MAX / 4 )
+            arena->next_block_size *= 2;
+    }
+    void *ptr = (uint8_t *)block->data + block->used;
+    block->used += size;
+    return ptr;
+}
+
+void *lsmash_arena_memdup
+(
+    lsmash_arena_t *arena,
+    const void     *ptr,
+    size_t          size
+)
+{
+    if( !ptr )
+        return NULL;
+    void *dst = lsmash_arena_alloc( arena, size );
+    if( !dst )
+        return NULL;
+    memcpy( dst, ptr, size );
+    return dst;
+}
+
+int lsmash_arena_contains
+(
+    lsmash_arena_t *arena,
+    const void     *ptr
+)
+{
+    if( !arena || !ptr )
+        return 0;
+    uintptr_t address = (uintptr_t)ptr;
+    for( lsmash_arena_block_t *block = arena->head; block; block = block->next )
+    {
+        uintptr_t start = (uintptr_t)block->data;
+        if( address >= start && address - start < block->used )
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+/*****************************************************************************
+ * arena.h
+ *****************************************************************************
+ * Copyright (C) 2010-2017 L-SMASH project
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *****************************************************************************/
+
+/* This file is available under an ISC license. */
+
+/* The arena is a region-based allocator.
+ * Memory blocks allocated from an arena can't be deallocated individually,
+ * and all of them are deallocated at a time when the arena is destroyed.
+ * This makes allocation of many small objects which live as long as the arena cheap. */
+typedef struct lsmash_arena_tag lsmash_arena_t;
+
+/* functions for internal usage */
+lsmash_arena_t *lsmash_arena_create
+(
+    void
+);
+
+void lsmash_arena_destroy
+(
+    lsmash_arena_t *arena
+);
+
+/* Allocate a memory block suitably aligned for any type. */
+void *lsmash_arena_alloc
+(
+    lsmash_arena_t *arena,
+    size_t          size
+);
+
+void *lsmash_arena_memdup
+(
+    lsmash_arena_t *arena,
+    const void     *ptr,
+    size_t          size
+);
+
+/* Check whether a given address is in a memory block allocated from the arena.
+ * Return 1 if it is, 0 otherwise. */
+int lsmash_arena_contains
+(
+    lsmash_arena_t *arena,
+    const void     *ptr
+);
@@ -25,6 +25,19 @@
 #include <string.h>
 #include <limits.h>
 
+/* The vector units used to convert arrays between big endian and the host byte order.
+ * They are available on little endian hosts, and selected at compile time. */
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BS_SWAP_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BS_SWAP_SSE2
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#define BS_SWAP_NEON
+#endif
+
 lsmash_bs_t *lsmash_bs_create( void )
 {
     lsmash_bs_t *bs = lsmash_malloc_zero( sizeof(lsmash_bs_t) );
@@ -40,10 +53,11 @@ static void bs_buffer_free( lsmash_bs_t *bs )
 {
     if( bs->buffer.internal )
         lsmash_free( bs->buffer.data );
-    bs->buffer.data  = NULL;
-    bs->buffer.alloc = 0;
-    bs->buffer.store = 0;
-    bs->buffer.pos   = 0;
+    bs->buffer.data   = NULL;
+    bs->buffer.alloc  = 0;
+    bs->buffer.store  = 0;
+    bs->buffer.pos    = 0;
+    bs->buffer.mapped = 0;
 }
 
 void lsmash_bs_cleanup( lsmash_bs_t *bs )
@@ -79,10 +93,37 @@ int lsmash_bs_set_empty_stream( lsmash_bs_t *bs, uint8_t *data, size_t size )
     return 0;
 }
 
+int lsmash_bs_set_mapped_stream( lsmash_bs_t *bs, const uint8_t *data, size_t size )
+{
+    if( !bs || !data )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    bs_buffer_free( bs );
+    bs->eof        = 1;         /* no more read from the stream since the whole stream is on the buffer */
+    bs->eob        = 0;
+    bs->error      = 0;
+    bs->written    = size;
+    bs->offset     = size;      /* behave as if the whole stream has been read into the buffer */
+    bs->buffer.unseekable = 0;
+    bs->buffer.internal   = 0;  /* must not be allocated internally */
+    bs->buffer.mapped     = 1;
+    bs->buffer.data       = (uint8_t *)data;
+    bs->buffer.store      = size;
+    bs->buffer.alloc      = size;
+    bs->buffer.pos        = 0;
+    bs->buffer.count      = 0;
+    return 0;
+}
+
 void lsmash_bs_empty( lsmash_bs_t *bs )
 {
     if( !bs )
         return;
+    if( bs->buffer.mapped )
+    {
+        /* The mapped data is not discarded so that we can seek on it later. */
+        bs->buffer.pos = bs->buffer.store;
+        return;
+    }
     if( bs->buffer.data && bs->write != NULL )
         memset( bs->buffer.data, 0, bs->buffer.alloc );
     bs->buffer.store = 0;
@@ -116,6 +157,401 @@ static void bs_alloc( lsmash_bs_t *bs, size_t alloc )
     bs->buffer.alloc    = alloc;
 }
 
+/*---- asynchronous writer ----*/
+typedef struct bs_write_job_tag bs_write_job_t;
+
+struct bs_write_job_tag
+{
+    bs_write_job_t   *next;
+    size_t            size;     /* the total size of the memory blocks */
+    uint32_t          count;    /* the number of the memory blocks */
+    lsmash_bs_iovec_t vec[];    /* the memory blocks owned by the job */
+};
+
+struct lsmash_bs_writer_tag
+{
+    lsmash_thread_t *thread;
+    lsmash_mutex_t  *mutex;
+    lsmash_cond_t   *cond;              /* broadcast whenever the queue or the state is changed */
+    void            *stream;            /* the stream the jobs are written into, set by the bytestream queueing a job */
+    int     (*write) ( void *opaque, uint8_t *buf, int size );
+    int64_t (*writev)( void *opaque, const lsmash_bs_iovec_t *vec, int count );
+    bs_write_job_t  *head;              /* the job being written or written next */
+    bs_write_job_t  *tail;
+    size_t           queued_size;       /* the total size of the queued jobs */
+    size_t           max_queue_size;
+    int              error;             /* If set to 1, any write failed. All the following jobs are discarded. */
+    int              quit;
+};
+
+static void bs_free_vectors( lsmash_bs_iovec_t *vec, uint32_t count )
+{
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        if( vec[i].release )
+            vec[i].release( vec[i].data );
+        else
+            lsmash_free( vec[i].data );
+        vec[i].data = NULL;
+    }
+}
+
+static int bs_write_job( lsmash_bs_writer_t *writer, bs_write_job_t *job )
+{
+    if( writer->writev && job->count > 1 )
+    {
+        int64_t write_size = writer->writev( writer->stream, job->vec, (int)job->count );
+        return write_size >= 0 && (uint64_t)write_size == job->size ? 0 : LSMASH_ERR_NAMELESS;
+    }
+    for( uint32_t i = 0; i < job->count; i++ )
+    {
+        uint8_t *data = job->vec[i].data;
+        size_t   size = job->vec[i].size;
+        while( size )
+        {
+            int write_size = LSMASH_MIN( size, INT_MAX );
+            if( writer->write( writer->stream, data, write_size ) != write_size )
+                return LSMASH_ERR_NAMELESS;
+            data += write_size;
+            size -= write_size;
+        }
+    }
+    return 0;
+}
+
+static void *bs_writer_main( void *arg )
+{
+    lsmash_bs_writer_t *writer = (lsmash_bs_writer_t *)arg;
+    lsmash_mutex_lock( writer->mutex );
+    while( 1 )
+    {
+        while( !writer->head && !writer->quit )
+            lsmash_cond_wait( writer->cond, writer->mutex );
+        bs_write_job_t *job = writer->head;
+        if( !job )
+            break;
+        int error = writer->error;
+        lsmash_mutex_unlock( writer->mutex );
+        /* Don't write anything after a failure since the following data would be misplaced.
+         * The stream and its methods are not changed while the queue is not empty. */
+        if( !error && bs_write_job( writer, job ) < 0 )
+            error = 1;
+        bs_free_vectors( job->vec, job->count );
+        lsmash_mutex_lock( writer->mutex );
+        writer->error        = error;
+        writer->head         = job->next;
+        writer->queued_size -= job->size;
+        if( !writer->head )
+            writer->tail = NULL;
+        lsmash_free( job );
+        lsmash_cond_broadcast( writer->cond );
+    }
+    lsmash_mutex_unlock( writer->mutex );
+    return NULL;
+}
+
+lsmash_bs_writer_t *lsmash_bs_writer_create( size_t max_queue_size )
+{
+    if( max_queue_size == 0 )
+        return NULL;
+    lsmash_bs_writer_t *writer = lsmash_malloc_zero( sizeof(lsmash_bs_writer_t) );
+    if( !writer )
+        return NULL;
+    writer->max_queue_size = max_queue_size;
+    writer->mutex = lsmash_mutex_create();
+    writer->cond  = lsmash_cond_create();
+    if( !writer->mutex || !writer->cond )
+        goto fail;
+    writer->thread = lsmash_thread_create( bs_writer_main, writer );
+    if( !writer->thread )
+        goto fail;
+    return writer;
+fail:
+    lsmash_cond_destroy( writer->cond );
+    lsmash_mutex_destroy( writer->mutex );
+    lsmash_free( writer );
+    return NULL;
+}
+
+/* Write all the queued data and stop the writer.
+ * Return a negative value if any write failed. */
+int lsmash_bs_writer_destroy( lsmash_bs_writer_t *writer )
+{
+    if( !writer )
+        return 0;
+    lsmash_mutex_lock( writer->mutex );
+    writer->quit = 1;
+    lsmash_cond_broadcast( writer->cond );
+    lsmash_mutex_unlock( writer->mutex );
+    lsmash_thread_join( writer->thread );
+    int error = writer->error;
+    lsmash_cond_destroy( writer->cond );
+    lsmash_mutex_destroy( writer->mutex );
+    lsmash_free( writer );
+    return error ? LSMASH_ERR_NAMELESS : 0;
+}
+
+/* Wait until all the queued data is written so that the stream can be accessed directly. */
+static int bs_writer_wait( lsmash_bs_t *bs )
+{
+    lsmash_bs_writer_t *writer = bs->writer;
+    if( !writer )
+        return 0;
+    lsmash_mutex_lock( writer->mutex );
+    while( writer->head )
+        lsmash_cond_wait( writer->cond, writer->mutex );
+    int error = writer->error;
+    lsmash_mutex_unlock( writer->mutex );
+    if( error )
+    {
+        bs->error = 1;
+        return LSMASH_ERR_NAMELESS;
+    }
+    return 0;
+}
+
+/* Queue the memory blocks to be written after all the queued data.
+ * The blocks are owned by the writer even if failed.
+ * Wait for the room if the queue is full, but a job of any size is accepted by the empty queue. */
+static int bs_writer_push( lsmash_bs_t *bs, lsmash_bs_iovec_t *vec, uint32_t count )
+{
+    lsmash_bs_writer_t *writer = bs->writer;
+    bs_write_job_t *job = lsmash_malloc( sizeof(bs_write_job_t) + count * sizeof(lsmash_bs_iovec_t) );
+    if( !job )
+    {
+        bs_free_vectors( vec, count );
+        bs->error = 1;
+        return LSMASH_ERR_MEMORY_ALLOC;
+    }
+    job->next  = NULL;
+    job->size  = 0;
+    job->count = count;
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        job->vec[i] = vec[i];
+        job->size  += vec[i].size;
+        vec[i].data = NULL;
+    }
+    lsmash_mutex_lock( writer->mutex );
+    while( writer->head
+        && writer->queued_size + job->size > writer->max_queue_size
+        && !writer->error )
+        lsmash_cond_wait( writer->cond, writer->mutex );
+    if( writer->error )
+    {
+        lsmash_mutex_unlock( writer->mutex );
+        bs_free_vectors( job->vec, job->count );
+        lsmash_free( job );
+        bs->error = 1;
+        return LSMASH_ERR_NAMELESS;
+    }
+    if( writer->tail )
+        writer->tail->next = job;
+    else
+    {
+        /* The writer is idle, so we can change the stream safely. */
+        writer->stream = bs->stream;
+        writer->write  = bs->write;
+        writer->writev = bs->writev;
+        writer->head   = job;
+    }
+    writer->tail         = job;
+    writer->queued_size += job->size;
+    /* The position of the stream is known already though the data is not written yet. */
+    bs->written += job->size;
+    bs->offset  += job->size;
+    lsmash_cond_broadcast( writer->cond );
+    lsmash_mutex_unlock( writer->mutex );
+    return 0;
+}
+/*---- ----*/
+
+/*---- read-ahead ----*/
+struct lsmash_bs_readahead_tag
+{
+    lsmash_thread_t *thread;    /* the thread running prefetches one after another */
+    lsmash_mutex_t  *mutex;
+    lsmash_cond_t   *cond;
+    int      busy;              /* set to 1 while a prefetch is requested or in flight */
+    int      quit;
+    void    *stream;            /* the stream the prefetch reads from */
+    int    (*read)( void *opaque, uint8_t *buf, int size );
+    uint8_t *data;              /* prefetched data */
+    size_t   alloc;             /* the maximum number of bytes prefetched at a time */
+    size_t   store;             /* the number of prefetched bytes */
+    size_t   pos;               /* the number of prefetched bytes already taken */
+    int      status;            /* the last return value of 'read' in the prefetch
+                                 * 0 or a negative value is reported after all the prefetched bytes are taken. */
+};
+
+static void *bs_readahead_main( void *arg )
+{
+    lsmash_bs_readahead_t *readahead = (lsmash_bs_readahead_t *)arg;
+    lsmash_mutex_lock( readahead->mutex );
+    while( 1 )
+    {
+        while( !readahead->busy && !readahead->quit )
+            lsmash_cond_wait( readahead->cond, readahead->mutex );
+        if( readahead->quit )
+            break;
+        lsmash_mutex_unlock( readahead->mutex );
+        /* The fields other than 'busy' and 'quit' are not touched by the owner of the bytestream while busy. */
+        while( readahead->store < readahead->alloc )
+        {
+            int read_size = readahead->read( readahead->stream, readahead->data + readahead->store, readahead->alloc - readahead->store );
+            readahead->status = read_size;
+            if( read_size <= 0 )
+                break;
+            readahead->store += read_size;
+        }
+        lsmash_mutex_lock( readahead->mutex );
+        readahead->busy = 0;
+        lsmash_cond_broadcast( readahead->cond );
+    }
+    lsmash_mutex_unlock( readahead->mutex );
+    return NULL;
+}
+
+lsmash_bs_readahead_t *lsmash_bs_readahead_create( size_t size )
+{
+    if( size == 0 || size > INT_MAX )
+        return NULL;
+    lsmash_bs_readahead_t *readahead = lsmash_malloc_zero( sizeof(lsmash_bs_readahead_t) );
+    if( !readahead )
+        return NULL;
+    readahead->alloc  = size;
+    readahead->status = 1;
+    readahead->data   = lsmash_malloc( size );
+    readahead->mutex  = lsmash_mutex_create();
+    readahead->cond   = lsmash_cond_create();
+    if( !readahead->data || !readahead->mutex || !readahead->cond )
+        goto fail;
+    readahead->thread = lsmash_thread_create( bs_readahead_main, readahead );
+    if( !readahead->thread )
+        goto fail;
+    return readahead;
+fail:
+    lsmash_cond_destroy( readahead->cond );
+    lsmash_mutex_destroy( readahead->mutex );
+    lsmash_free( readahead->data );
+    lsmash_free( readahead );
+    return NULL;
+}
+
+/* Wait for the prefetch in flight if any. */
+static void bs_readahead_wait( lsmash_bs_readahead_t *readahead )
+{
+    lsmash_mutex_lock( readahead->mutex );
+    while( readahead->busy )
+        lsmash_cond_wait( readahead->cond, readahead->mutex );
+    lsmash_mutex_unlock( readahead->mutex );
+}
+
+void lsmash_bs_readahead_destroy( lsmash_bs_readahead_t *readahead )
+{
+    if( !readahead )
+        return;
+    lsmash_mutex_lock( readahead->mutex );
+    readahead->quit = 1;
+    lsmash_cond_broadcast( readahead->cond );
+    lsmash_mutex_unlock( readahead->mutex );
+    lsmash_thread_join( readahead->thread );
+    lsmash_cond_destroy( readahead->cond );
+    lsmash_mutex_destroy( readahead->mutex );
+    lsmash_free( readahead->data );
+    lsmash_free( readahead );
+}
+
+/* Start to prefetch the region following the data taken from the stream so far.
+ * Nothing is done if any prefetched data or status remains. */
+static void bs_readahead_start( lsmash_bs_t *bs )
+{
+    lsmash_bs_readahead_t *readahead = bs->readahead;
+    if( !readahead || bs->eof || bs->error )
+        return;
+    bs_readahead_wait( readahead );
+    if( readahead->pos < readahead->store
+     || readahead->status <= 0 )
+        return;
+    readahead->stream = bs->stream;
+    readahead->read   = bs->read;
+    readahead->store  = 0;
+    readahead->pos    = 0;
+    lsmash_mutex_lock( readahead->mutex );
+    readahead->busy = 1;
+    lsmash_cond_broadcast( readahead->cond );
+    lsmash_mutex_unlock( readahead->mutex );
+}
+
+/* Read from the stream, taking prefetched data first. */
+static int bs_read_stream( lsmash_bs_t *bs, uint8_t *buf, int size )
+{
+    int err = bs_writer_wait( bs );
+    if( err < 0 )
+        return err;
+    lsmash_bs_readahead_t *readahead = bs->readahead;
+    int read_size;
+    if( !readahead )
+        read_size = bs->read( bs->stream, buf, size );
+    else
+    {
+        bs_readahead_wait( readahead );
+        size_t remainder = readahead->store - readahead->pos;
+        if( remainder )
+        {
+            read_size = LSMASH_MIN( remainder, size );
+            memcpy( buf, readahead->data + readahead->pos, read_size );
+            readahead->pos += read_size;
+        }
+        else if( readahead->status <= 0 )
+        {
+            /* Report EOF or an error which the prefetch encountered. */
+            read_size = readahead->status;
+            readahead->status = 1;
+        }
+        else
+            read_size = bs->read( bs->stream, buf, size );
+    }
+    if( read_size > 0 )
+        bs->read_size += read_size;
+    return read_size;
+}
+
+/* Try to seek on the prefetched data.
+ * Return 1 if done, 0 if the prefetched data is discarded, a negative value if failed.
+ * When the prefetched data is discarded, the stream gets back to the position where the prefetch started
+ * so that the position of the stream matches with 'offset' of the bytestream. */
+static int bs_readahead_seek( lsmash_bs_t *bs, int64_t offset, int whence )
+{
+    lsmash_bs_readahead_t *readahead = bs->readahead;
+    bs_readahead_wait( readahead );
+    size_t remainder = readahead->store - readahead->pos;
+    if( whence != SEEK_END )
+    {
+        int64_t dst_offset = whence == SEEK_SET ? offset : (int64_t)bs->offset + offset;
+        if( dst_offset >= 0
+         && (uint64_t)dst_offset >= bs->offset
+         && (uint64_t)dst_offset - bs->offset <= remainder )
+        {
+            readahead->pos += dst_offset - bs->offset;
+            bs->offset  = dst_offset;
+            bs->written = LSMASH_MAX( bs->written, bs->offset );
+            bs->eof     = 0;
+            bs->eob     = 0;
+            /* The data on the buffer is invalid. */
+            lsmash_bs_empty( bs );
+            return 1;
+        }
+    }
+    readahead->store  = 0;
+    readahead->pos    = 0;
+    readahead->status = 1;
+    if( remainder && bs->seek( bs->stream, bs->offset, SEEK_SET ) < 0 )
+        return LSMASH_ERR_NAMELESS;
+    return 0;
+}
+/*---- ----*/
+
 static uint64_t bs_estimate_seek_offset( lsmash_bs_t *bs, int64_t offset, int whence )
 {
     /* Calculate the offset after the seek. */
@@ -155,8 +591,11 @@ int64_t lsmash_bs_write_seek( lsmash_bs_t *bs, int64_t offset, int whence )
         return LSMASH_ERR_NAMELESS;
     if( whence != SEEK_SET && whence != SEEK_CUR && whence != SEEK_END )
         return LSMASH_ERR_FUNCTION_PARAM;
+    int64_t ret = bs_writer_wait( bs );
+    if( ret < 0 )
+        return ret;
     /* Try to seek the stream. */
-    int64_t ret = bs->seek( bs->stream, offset, whence );
+    ret = bs->seek( bs->stream, offset, whence );
     if( ret < 0 )
         return ret;
     bs->offset = bs_estimate_seek_offset( bs, offset, whence );
@@ -172,14 +611,18 @@ int64_t lsmash_bs_read_seek( lsmash_bs_t *bs, int64_t offset, int whence )
         return LSMASH_ERR_FUNCTION_PARAM;
     if( whence == SEEK_CUR )
         offset -= lsmash_bs_get_remaining_buffer_size( bs );
-    /* Check whether we can seek on the buffer. */
+    /* The data read so far exists in the stream at least. */
+    bs->written = LSMASH_MAX( bs->written, bs->offset );
+    /* Check whether we can seek on the buffer.
+     * The end of the stream is unknown until it is reached or the stream is mapped on the buffer. */
     if( !bs->buffer.unseekable )
     {
         assert( bs->offset >= bs->buffer.store );
         uint64_t dst_offset = bs_estimate_seek_offset( bs, offset, whence );
         uint64_t offset_s = bs->offset - bs->buffer.store;
         uint64_t offset_e = bs->offset;
-        if( bs->unseekable || (dst_offset >= offset_s && dst_offset < offset_e) )
+        if( bs->unseekable || bs->buffer.mapped
+         || ((whence != SEEK_END || bs->eof) && dst_offset >= offset_s && dst_offset < offset_e) )
         {
             /* OK, we can. So, seek on the buffer. */
             bs->buffer.pos = dst_offset - offset_s;
@@ -189,6 +632,17 @@ int64_t lsmash_bs_read_seek( lsmash_bs_t *bs, int64_t offset, int whence )
     }
     if( bs->unseekable )
         return LSMASH_ERR_NAMELESS;
+    int err = bs_writer_wait( bs );
+    if( err < 0 )
+        return err;
+    if( bs->readahead )
+    {
+        int ret = bs_readahead_seek( bs, offset, whence );
+        if( ret < 0 )
+            return ret;
+        if( ret == 1 )
+            return lsmash_bs_get_stream_pos( bs );
+    }
     /* Try to seek the stream. */
     int64_t ret = bs->seek( bs->stream, offset, whence );
     if( ret < 0 )
@@ -204,6 +658,9 @@ int64_t lsmash_bs_read_seek( lsmash_bs_t *bs, int64_t offset, int whence )
 
 void lsmash_bs_dispose_past_data( lsmash_bs_t *bs )
 {
+    if( bs->buffer.mapped )
+        /* Nothing to dispose since the buffer is the stream itself. */
+        return;
     /* Move remainder bytes. */
     assert( bs->buffer.store >= bs->buffer.pos );
     size_t remainder = lsmash_bs_get_remaining_buffer_size( bs );
@@ -213,6 +670,110 @@ void lsmash_bs_dispose_past_data( lsmash_bs_t *bs )
     bs->buffer.pos   = 0;
 }
 
+/* Deallocate the buffer for reading until the next read.
+ * The data left unread on the buffer is discarded, so the offset goes back to the position of the next byte to be read,
+ * and the stream must be at the returned offset before the next access. */
+uint64_t lsmash_bs_release_buffer( lsmash_bs_t *bs )
+{
+    if( !bs->buffer.internal || bs->buffer.mapped || bs->readahead || bs->writer )
+        return bs->offset;
+    bs->offset = lsmash_bs_get_stream_pos( bs );
+    bs->eof    = 0;
+    bs_buffer_free( bs );
+    return bs->offset;
+}
+
+/*---- byte order conversion of arrays ----*/
+/* Reverse the byte order of each of 'count' 32-bit words from 'src' to 'dst' as far as the vector unit can.
+ * Return the number of the words done, and leave the rest to the caller. */
+static size_t bs_swap32_vector( uint8_t *dst, const uint8_t *src, size_t count )
+{
+    size_t i = 0;
+#if defined(BS_SWAP_AVX2)
+    const __m256i shuffle = _mm256_setr_epi8( 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                              3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 );
+    for( ; i + 8 <= count; i += 8 )
+    {
+        __m256i v = _mm256_loadu_si256( (const __m256i *)(src + 4 * i) );
+        _mm256_storeu_si256( (__m256i *)(dst + 4 * i), _mm256_shuffle_epi8( v, shuffle ) );
+    }
+#elif defined(BS_SWAP_SSE2)
+    for( ; i + 4 <= count; i += 4 )
+    {
+        __m128i v = _mm_loadu_si128( (const __m128i *)(src + 4 * i) );
+        /* Swap the bytes in each 16-bit word, and then the 16-bit words in each 32-bit word. */
+        v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+        v = _mm_shufflelo_epi16( v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+        v = _mm_shufflehi_epi16( v, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+        _mm_storeu_si128( (__m128i *)(dst + 4 * i), v );
+    }
+#elif defined(BS_SWAP_NEON)
+    for( ; i + 4 <= count; i += 4 )
+        vst1q_u8( dst + 4 * i, vrev32q_u8( vld1q_u8( src + 4 * i ) ) );
+#else
+    (void)dst;
+    (void)src;
+#endif
+    return i;
+}
+
+/* Same as bs_swap32_vector() but for 64-bit words. */
+static size_t bs_swap64_vector( uint8_t *dst, const uint8_t *src, size_t count )
+{
+    size_t i = 0;
+#if defined(BS_SWAP_AVX2)
+    const __m256i shuffle = _mm256_setr_epi8( 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                              7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 );
+    for( ; i + 4 <= count; i += 4 )
+    {
+        __m256i v = _mm256_loadu_si256( (const __m256i *)(src + 8 * i) );
+        _mm256_storeu_si256( (__m256i *)(dst + 8 * i), _mm256_shuffle_epi8( v, shuffle ) );
+    }
+#elif defined(BS_SWAP_SSE2)
+    for( ; i + 2 <= count; i += 2 )
+    {
+        __m128i v = _mm_loadu_si128( (const __m128i *)(src + 8 * i) );
+        /* Swap the bytes in each 16-bit word, and then reverse the 16-bit words in each 64-bit word. */
+        v = _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+        v = _mm_shufflelo_epi16( v, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+        v = _mm_shufflehi_epi16( v, _MM_SHUFFLE( 0, 1, 2, 3 ) );
+        _mm_storeu_si128( (__m128i *)(dst + 8 * i), v );
+    }
+#elif defined(BS_SWAP_NEON)
+    for( ; i + 2 <= count; i += 2 )
+        vst1q_u8( dst + 8 * i, vrev64q_u8( vld1q_u8( src + 8 * i ) ) );
+#else
+    (void)dst;
+    (void)src;
+#endif
+    return i;
+}
+
+static void bs_decode_be32_array( uint32_t *dst, const uint8_t *src, size_t count )
+{
+    for( size_t i = bs_swap32_vector( (uint8_t *)dst, src, count ); i < count; i++ )
+        dst[i] = LSMASH_GET_BE32( src + 4 * i );
+}
+
+static void bs_decode_be64_array( uint64_t *dst, const uint8_t *src, size_t count )
+{
+    for( size_t i = bs_swap64_vector( (uint8_t *)dst, src, count ); i < count; i++ )
+        dst[i] = LSMASH_GET_BE64( src + 8 * i );
+}
+
+static void bs_encode_be32_array( uint8_t *dst, const uint32_t *src, size_t count )
+{
+    for( size_t i = bs_swap32_vector( dst, (const uint8_t *)src, count ); i < count; i++ )
+        LSMASH_SET_BE32( dst + 4 * i, src[i] );
+}
+
+static void bs_encode_be64_array( uint8_t *dst, const uint64_t *src, size_t count )
+{
+    for( size_t i = bs_swap64_vector( dst, (const uint8_t *)src, count ); i < count; i++ )
+        LSMASH_SET_BE64( dst + 8 * i, src[i] );
+}
+/*---- ----*/
+
 /*---- bitstream writer ----*/
 void lsmash_bs_put_byte( lsmash_bs_t *bs, uint8_t value )
 {
@@ -286,6 +847,36 @@ void lsmash_bs_put_be32_from_64( lsmash_bs_t *bs, uint64_t value )
     lsmash_bs_put_be32( bs, value );
 }
 
+void lsmash_bs_put_be32_array( lsmash_bs_t *bs, const uint32_t *value, size_t count )
+{
+    if( count == 0 || !value )
+        return;
+    if( bs->buffer.internal
+     || bs->buffer.data )
+    {
+        bs_alloc( bs, bs->buffer.store + 4 * count );
+        if( bs->error )
+            return;
+        bs_encode_be32_array( lsmash_bs_get_buffer_data_end( bs ), value, count );
+    }
+    bs->buffer.store += 4 * count;
+}
+
+void lsmash_bs_put_be64_array( lsmash_bs_t *bs, const uint64_t *value, size_t count )
+{
+    if( count == 0 || !value )
+        return;
+    if( bs->buffer.internal
+     || bs->buffer.data )
+    {
+        bs_alloc( bs, bs->buffer.store + 8 * count );
+        if( bs->error )
+            return;
+        bs_encode_be64_array( lsmash_bs_get_buffer_data_end( bs ), value, count );
+    }
+    bs->buffer.store += 8 * count;
+}
+
 void lsmash_bs_put_le16( lsmash_bs_t *bs, uint16_t value )
 {
     lsmash_bs_put_byte( bs, value );
@@ -305,6 +896,35 @@ int lsmash_bs_flush_buffer( lsmash_bs_t *bs )
     if( bs->buffer.store == 0
      || (bs->stream && bs->write && !bs->buffer.data) )
         return 0;
+    if( bs->writer && bs->stream && bs->write && !bs->error )
+    {
+        /* Hand over the buffer itself to the writer, and allocate a new buffer on the next write.
+         * The unused area of the buffer is given back to the heap since the writer holds it until written.
+         * A buffer not allocated internally is handed over as a copy. */
+        lsmash_bs_iovec_t vec = { NULL, bs->buffer.store, NULL };
+        if( bs->buffer.internal )
+        {
+            vec.data = bs->buffer.store < bs->buffer.alloc
+                     ? lsmash_realloc( bs->buffer.data, bs->buffer.store )
+                     : bs->buffer.data;
+            if( vec.data )
+            {
+                bs->buffer.data  = NULL;
+                bs->buffer.alloc = 0;
+            }
+        }
+        else
+            vec.data = lsmash_memdup( lsmash_bs_get_buffer_data_start( bs ), bs->buffer.store );
+        int err = vec.data ? bs_writer_push( bs, &vec, 1 ) : LSMASH_ERR_MEMORY_ALLOC;
+        if( err < 0 )
+        {
+            bs_buffer_free( bs );
+            bs->error = 1;
+            return err;
+        }
+        bs->buffer.store = 0;
+        return 0;
+    }
     if( bs->error
      || (bs->stream && bs->write && bs->write( bs->stream, lsmash_bs_get_buffer_data_start( bs ), bs->buffer.store ) != bs->buffer.store) )
     {
@@ -327,7 +947,7 @@ int lsmash_bs_write_data( lsmash_bs_t *bs, const uint8_t *buf, size_t size )
         return LSMASH_ERR_FUNCTION_PARAM;
     if( !buf || size == 0 )
         return 0;
-    if( bs->error || !bs->stream )
+    if( bs->error || !bs->stream || bs_writer_wait( bs ) < 0 )
     {
         bs_buffer_free( bs );
         bs->error = 1;
@@ -339,6 +959,72 @@ int lsmash_bs_write_data( lsmash_bs_t *bs, const uint8_t *buf, size_t size )
     return write_size != size ? LSMASH_ERR_NAMELESS : 0;
 }
 
+/* Write the memory blocks in order just after the data on the buffer.
+ * If the stream supports gather output, all the blocks are written at once without copying into the buffer. */
+int lsmash_bs_write_vectors( lsmash_bs_t *bs, const lsmash_bs_iovec_t *vec, uint32_t count )
+{
+    if( !bs || (!vec && count) || count > INT_MAX )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    if( !bs->stream || !bs->write )
+    {
+        /* There is no stream to write, so place the blocks on the buffer. */
+        for( uint32_t i = 0; i < count; i++ )
+            lsmash_bs_put_bytes( bs, vec[i].size, vec[i].data );
+        return bs->error ? LSMASH_ERR_NAMELESS : 0;
+    }
+    int err = lsmash_bs_flush_buffer( bs );
+    if( err < 0 )
+        return err;
+    if( !bs->writev )
+    {
+        for( uint32_t i = 0; i < count; i++ )
+            if( (err = lsmash_bs_write_data( bs, vec[i].data, vec[i].size )) < 0 )
+                return err;
+        return 0;
+    }
+    if( count == 0 )
+        return 0;
+    if( bs->error || bs_writer_wait( bs ) < 0 )
+        return LSMASH_ERR_NAMELESS;
+    uint64_t total_size = 0;
+    for( uint32_t i = 0; i < count; i++ )
+        total_size += vec[i].size;
+    int64_t write_size = bs->writev( bs->stream, vec, (int)count );
+    if( write_size > 0 )
+    {
+        bs->written += write_size;
+        bs->offset  += write_size;
+    }
+    if( write_size < 0 || (uint64_t)write_size != total_size )
+    {
+        bs->error = 1;
+        return LSMASH_ERR_NAMELESS;
+    }
+    return 0;
+}
+
+/* Write the memory blocks in the same way as lsmash_bs_write_vectors(), and then deallocate them.
+ * The blocks are deallocated even if failed.
+ * If the bytestream has the asynchronous writer, the blocks are handed over to it, and may be written after return. */
+int lsmash_bs_write_vectors_and_free( lsmash_bs_t *bs, lsmash_bs_iovec_t *vec, uint32_t count )
+{
+    if( !bs || (!vec && count) || count > INT_MAX )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    int err;
+    if( bs->writer && bs->stream && bs->write )
+    {
+        if( (err = lsmash_bs_flush_buffer( bs )) < 0 )
+        {
+            bs_free_vectors( vec, count );
+            return err;
+        }
+        return count ? bs_writer_push( bs, vec, count ) : 0;
+    }
+    err = lsmash_bs_write_vectors( bs, vec, count );
+    bs_free_vectors( vec, count );
+    return err;
+}
+
 void *lsmash_bs_export_data( lsmash_bs_t *bs, uint32_t *length )
 {
     if( !bs || !bs->buffer.data || bs->buffer.store == 0 || bs->error )
@@ -353,11 +1039,45 @@ void *lsmash_bs_export_data( lsmash_bs_t *bs, uint32_t *length )
 /*---- ----*/
 
 /*---- bitstream reader ----*/
+/* Fill the buffer with the prefetched data first, and prefetch the next.
+ * As with the reads without prefetch, the buffer is filled up to its allocated size unless reached EOF,
+ * so that a request larger than the prefetched data is met by the synchronous reads following it. */
+static void bs_fill_buffer_ahead( lsmash_bs_t *bs )
+{
+    lsmash_bs_readahead_t *readahead = bs->readahead;
+    bs_readahead_wait( readahead );
+    size_t remainder = readahead->store - readahead->pos;
+    /* If nothing is prefetched, e.g. just after a seek, read synchronously as much as prefetched. */
+    bs_alloc( bs, bs->buffer.store + (remainder ? remainder : bs->buffer.max_size) );
+    if( bs->error )
+        return;
+    while( bs->buffer.alloc > bs->buffer.store )
+    {
+        int max_read_size = LSMASH_MIN( bs->buffer.alloc - bs->buffer.store, INT_MAX );
+        int read_size = bs_read_stream( bs, lsmash_bs_get_buffer_data_end( bs ), max_read_size );
+        if( read_size == 0 )
+        {
+            bs->eof = 1;
+            return;
+        }
+        else if( read_size < 0 )
+        {
+            bs->error = 1;
+            return;
+        }
+        bs->buffer.unseekable = 0;
+        bs->buffer.store += read_size;
+        bs->offset       += read_size;
+        bs->written = LSMASH_MAX( bs->written, bs->offset );
+    }
+    bs_readahead_start( bs );
+}
+
 static void bs_fill_buffer( lsmash_bs_t *bs )
 {
     if( bs->eof || bs->error )
         return;
-    if( !bs->read || !bs->stream || bs->buffer.max_size == 0 )
+    if( !bs->read || !bs->stream || bs->buffer.max_size == 0 || bs->buffer.mapped )
     {
         bs->eof = 1;
         return;
@@ -368,8 +1088,15 @@ static void bs_fill_buffer( lsmash_bs_t *bs )
         if( bs->error )
             return;
     }
+    if( bs_writer_wait( bs ) < 0 )
+        return;
     /* Read bytes from the stream to fill the buffer. */
     lsmash_bs_dispose_past_data( bs );
+    if( bs->readahead )
+    {
+        bs_fill_buffer_ahead( bs );
+        return;
+    }
     while( bs->buffer.alloc > bs->buffer.store )
     {
         uint64_t invalid_buffer_size = bs->buffer.alloc - bs->buffer.store;
@@ -388,6 +1115,7 @@ static void bs_fill_buffer( lsmash_bs_t *bs )
         bs->buffer.unseekable = 0;
         bs->buffer.store += read_size;
         bs->offset       += read_size;
+        bs->read_size    += read_size;
         bs->written = LSMASH_MAX( bs->written, bs->offset );
     }
 }
@@ -604,6 +1332,34 @@ int64_t lsmash_bs_get_bytes_ex( lsmash_bs_t *bs, uint32_t size, uint8_t *value )
     return bs_get_bytes( bs, size, value );
 }
 
+/* Get 'size' bytes as a pointer into the buffer instead of a copy.
+ * The buffer is refilled, and grown if needed, so that the bytes are contiguous on it.
+ * The returned data is owned by 'bs' and valid until the next read, seek or write on 'bs'.
+ * Return NULL if the stream ends before 'size' bytes. */
+uint8_t *lsmash_bs_borrow_bytes( lsmash_bs_t *bs, uint32_t size )
+{
+    if( bs->eob || bs->error || size == 0 )
+        return NULL;
+    if( size > lsmash_bs_get_remaining_buffer_size( bs ) && !bs->eof && !bs->buffer.mapped )
+    {
+        bs_alloc( bs, size );
+        bs_fill_buffer( bs );
+        if( bs->error )
+            return NULL;
+    }
+    if( lsmash_bs_get_remaining_buffer_size( bs ) < size )
+    {
+        /* No more read from both the stream and the buffer.
+         * Unlike lsmash_bs_get_bytes(), the lacking bytes are never made up with zeros since they are not the data. */
+        bs->eob = 1;
+        return NULL;
+    }
+    uint8_t *data = lsmash_bs_get_buffer_data( bs );
+    bs->buffer.pos   += size;
+    bs->buffer.count += size;
+    return data;
+}
+
 uint16_t lsmash_bs_get_be16( lsmash_bs_t *bs )
 {
     uint16_t    value = lsmash_bs_get_byte( bs );
@@ -628,6 +1384,58 @@ uint64_t lsmash_bs_get_be64( lsmash_bs_t *bs )
     return (value<<32) | lsmash_bs_get_be32( bs );
 }
 
+/* Get 'count' big endian 32-bit words into 'value'.
+ * The words wholly in the buffer are converted at once, and a word across the end of the buffer is read by refilling.
+ * As with lsmash_bs_get_be32(), the words beyond the end of the stream are set to 0. */
+void lsmash_bs_get_be32_array( lsmash_bs_t *bs, uint32_t *value, size_t count )
+{
+    while( count )
+    {
+        if( bs->eob || bs->error )
+        {
+            memset( value, 0, count * sizeof(uint32_t) );
+            return;
+        }
+        size_t n = LSMASH_MIN( count, lsmash_bs_get_remaining_buffer_size( bs ) / 4 );
+        if( n == 0 )
+        {
+            *value++ = lsmash_bs_get_be32( bs );
+            --count;
+            continue;
+        }
+        bs_decode_be32_array( value, lsmash_bs_get_buffer_data( bs ), n );
+        bs->buffer.pos   += 4 * n;
+        bs->buffer.count += 4 * n;
+        value += n;
+        count -= n;
+    }
+}
+
+/* Same as lsmash_bs_get_be32_array() but for 64-bit words. */
+void lsmash_bs_get_be64_array( lsmash_bs_t *bs, uint64_t *value, size_t count )
+{
+    while( count )
+    {
+        if( bs->eob || bs->error )
+        {
+            memset( value, 0, count * sizeof(uint64_t) );
+            return;
+        }
+        size_t n = LSMASH_MIN( count, lsmash_bs_get_remaining_buffer_size( bs ) / 8 );
+        if( n == 0 )
+        {
+            *value++ = lsmash_bs_get_be64( bs );
+            --count;
+            continue;
+        }
+        bs_decode_be64_array( value, lsmash_bs_get_buffer_data( bs ), n );
+        bs->buffer.pos   += 8 * n;
+        bs->buffer.count += 8 * n;
+        value += n;
+        count -= n;
+    }
+}
+
 uint64_t lsmash_bs_get_byte_to_64( lsmash_bs_t *bs )
 {
     return lsmash_bs_get_byte( bs );
@@ -672,13 +1480,19 @@ int lsmash_bs_read( lsmash_bs_t *bs, uint32_t size )
         return LSMASH_ERR_FUNCTION_PARAM;
     if( size == 0 )
         return 0;
+    if( bs->buffer.mapped )
+    {
+        /* The whole stream is already on the buffer. */
+        bs->eof = 1;
+        return 0;
+    }
     bs_alloc( bs, bs->buffer.store + size );
     if( bs->error || !bs->stream )
     {
         bs->error = 1;
         return LSMASH_ERR_NAMELESS;
     }
-    int read_size = bs->read( bs->stream, lsmash_bs_get_buffer_data_end( bs ), size );
+    int read_size = bs_read_stream( bs, lsmash_bs_get_buffer_data_end( bs ), size );
     if( read_size == 0 )
     {
         bs->eof = 1;
@@ -692,6 +1506,7 @@ int lsmash_bs_read( lsmash_bs_t *bs, uint32_t size )
     bs->buffer.store += read_size;
     bs->offset       += read_size;
     bs->written = LSMASH_MAX( bs->written, bs->offset );
+    bs_readahead_start( bs );
     return read_size;
 }
 
@@ -701,12 +1516,23 @@ int lsmash_bs_read_data( lsmash_bs_t *bs, uint8_t *buf, size_t *size )
         return LSMASH_ERR_FUNCTION_PARAM;
     if( !buf || *size == 0 )
         return 0;
+    if( bs->buffer.mapped && !bs->error )
+    {
+        /* Copy from the mapped stream. */
+        size_t read_size = LSMASH_MIN( *size, lsmash_bs_get_remaining_buffer_size( bs ) );
+        memcpy( buf, lsmash_bs_get_buffer_data( bs ), read_size );
+        bs->buffer.pos += read_size;
+        if( read_size == 0 )
+            bs->eof = 1;
+        *size = read_size;
+        return 0;
+    }
     if( bs->error || !bs->stream )
     {
         bs->error = 1;
         return LSMASH_ERR_NAMELESS;
     }
-    int read_size = bs->read( bs->stream, buf, *size );
+    int read_size = bs_read_stream( bs, buf, *size );
     if( read_size == 0 )
         bs->eof = 1;
     else if( read_size < 0 )
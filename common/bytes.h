@@ -28,6 +28,8 @@ typedef struct
     int      unseekable;    /* If set to 1, the buffer is unseekable. */
     int      internal;      /* If set to 1, the buffer is allocated on heap internally.
                              * The pointer to the buffer shall not be changed by any method other than internal allocation. */
+    int      mapped;        /* If set to 1, the buffer is the whole stream mapped on memory.
+                             * The buffer is read-only, and reads and seeks are done only on it. */
     uint8_t *data;          /* the pointer to the buffer for reading/writing */
     size_t   store;         /* valid data size on the buffer */
     size_t   alloc;         /* total buffer size including invalid area */
@@ -36,6 +38,20 @@ typedef struct
     uint64_t count;         /* counter for arbitrary usage */
 } lsmash_buffer_t;
 
+typedef struct
+{
+    void  *data;            /* the start of a memory block */
+    size_t size;            /* the size of the memory block */
+    void (*release)( void *data );  /* the deallocator of the memory block if not lsmash_free() */
+} lsmash_bs_iovec_t;
+
+/* The read-ahead reads the next region of a stream in background while the data on the buffer is consumed. */
+typedef struct lsmash_bs_readahead_tag lsmash_bs_readahead_t;
+
+/* The writer writes the data flushed from a bytestream in background in order.
+ * The flushed data waits in a queue bounded by size, and the queue is drained before any other access to the stream. */
+typedef struct lsmash_bs_writer_tag lsmash_bs_writer_t;
+
 typedef struct
 {
     void           *stream;         /* I/O stream */
@@ -46,10 +62,19 @@ typedef struct
     uint64_t        written;        /* the number of bytes written into 'stream' already */
     uint64_t        offset;         /* the current position in the 'stream'
                                      * the number of bytes from the beginning */
+    uint64_t        read_size;      /* the total number of bytes read from 'stream' */
     lsmash_buffer_t buffer;
     int     (*read) ( void *opaque, uint8_t *buf, int size );
     int     (*write)( void *opaque, uint8_t *buf, int size );
     int64_t (*seek) ( void *opaque, int64_t offset, int whence );
+    /* optional, gather output of memory blocks at once */
+    int64_t (*writev)( void *opaque, const lsmash_bs_iovec_t *vec, int count );
+    /* optional, read-ahead of 'stream' for reading
+     * This is not owned by the bytestream since it must be stopped before 'stream' is closed. */
+    lsmash_bs_readahead_t *readahead;
+    /* optional, asynchronous writer of 'stream'
+     * This is not owned by the bytestream since it must be stopped before 'stream' is closed. */
+    lsmash_bs_writer_t    *writer;
 } lsmash_bs_t;
 
 static inline void lsmash_bs_reset_counter( lsmash_bs_t *bs )
@@ -100,12 +125,18 @@ static inline size_t lsmash_bs_get_valid_data_size( lsmash_bs_t *bs )
 }
 
 lsmash_bs_t *lsmash_bs_create( void );
+lsmash_bs_readahead_t *lsmash_bs_readahead_create( size_t size );
+void lsmash_bs_readahead_destroy( lsmash_bs_readahead_t *readahead );
+lsmash_bs_writer_t *lsmash_bs_writer_create( size_t max_queue_size );
+int lsmash_bs_writer_destroy( lsmash_bs_writer_t *writer );
 void lsmash_bs_cleanup( lsmash_bs_t *bs );
 int lsmash_bs_set_empty_stream( lsmash_bs_t *bs, uint8_t *data, size_t size );
+int lsmash_bs_set_mapped_stream( lsmash_bs_t *bs, const uint8_t *data, size_t size );
 void lsmash_bs_empty( lsmash_bs_t *bs );
 int64_t lsmash_bs_write_seek( lsmash_bs_t *bs, int64_t offset, int whence );
 int64_t lsmash_bs_read_seek( lsmash_bs_t *bs, int64_t offset, int whence );
 void lsmash_bs_dispose_past_data( lsmash_bs_t *bs );
+uint64_t lsmash_bs_release_buffer( lsmash_bs_t *bs );
 
 /*---- bytestream writer ----*/
 void lsmash_bs_put_byte( lsmash_bs_t *bs, uint8_t value );
@@ -114,6 +145,8 @@ void lsmash_bs_put_be16( lsmash_bs_t *bs, uint16_t value );
 void lsmash_bs_put_be24( lsmash_bs_t *bs, uint32_t value );
 void lsmash_bs_put_be32( lsmash_bs_t *bs, uint32_t value );
 void lsmash_bs_put_be64( lsmash_bs_t *bs, uint64_t value );
+void lsmash_bs_put_be32_array( lsmash_bs_t *bs, const uint32_t *value, size_t count );
+void lsmash_bs_put_be64_array( lsmash_bs_t *bs, const uint64_t *value, size_t count );
 void lsmash_bs_put_byte_from_64( lsmash_bs_t *bs, uint64_t value );
 void lsmash_bs_put_be16_from_64( lsmash_bs_t *bs, uint64_t value );
 void lsmash_bs_put_be24_from_64( lsmash_bs_t *bs, uint64_t value );
@@ -122,6 +155,8 @@ void lsmash_bs_put_le16( lsmash_bs_t *bs, uint16_t value );
 void lsmash_bs_put_le32( lsmash_bs_t *bs, uint32_t value );
 int lsmash_bs_flush_buffer( lsmash_bs_t *bs );
 int lsmash_bs_write_data( lsmash_bs_t *bs, const uint8_t *buf, size_t size );
+int lsmash_bs_write_vectors( lsmash_bs_t *bs, const lsmash_bs_iovec_t *vec, uint32_t count );
+int lsmash_bs_write_vectors_and_free( lsmash_bs_t *bs, lsmash_bs_iovec_t *vec, uint32_t count );
 void *lsmash_bs_export_data( lsmash_bs_t *bs, uint32_t *length );
 
 /*---- bytestream reader ----*/
@@ -138,10 +173,13 @@ void lsmash_bs_skip_bytes( lsmash_bs_t *bs, uint32_t size );
 void lsmash_bs_skip_bytes_64( lsmash_bs_t *bs, uint64_t size );
 uint8_t *lsmash_bs_get_bytes( lsmash_bs_t *bs, uint32_t size );
 int64_t lsmash_bs_get_bytes_ex( lsmash_bs_t *bs, uint32_t size, uint8_t *value );
+uint8_t *lsmash_bs_borrow_bytes( lsmash_bs_t *bs, uint32_t size );
 uint16_t lsmash_bs_get_be16( lsmash_bs_t *bs );
 uint32_t lsmash_bs_get_be24( lsmash_bs_t *bs );
 uint32_t lsmash_bs_get_be32( lsmash_bs_t *bs );
 uint64_t lsmash_bs_get_be64( lsmash_bs_t *bs );
+void lsmash_bs_get_be32_array( lsmash_bs_t *bs, uint32_t *value, size_t count );
+void lsmash_bs_get_be64_array( lsmash_bs_t *bs, uint64_t *value, size_t count );
 uint64_t lsmash_bs_get_byte_to_64( lsmash_bs_t *bs );
 uint64_t lsmash_bs_get_be16_to_64( lsmash_bs_t *bs );
 uint64_t lsmash_bs_get_be24_to_64( lsmash_bs_t *bs );
@@ -35,5 +35,9 @@
 #include "bits.h"
 #include "multibuf.h"
 #include "list.h"
+#include "vector.h"
+#include "arena.h"
+#include "recycler.h"
+#include "thread.h"
 
 #endif
@@ -20,12 +20,28 @@
 
 /* This file is available under an ISC license. */
 
+#ifdef __linux__
+/* for fallocate() and syscall() */
+#define _GNU_SOURCE
+#endif
+
 #include "internal.h" /* must be placed first */
 
 #include <stdlib.h>
 
 #ifdef _WIN32
 #include <windows.h>
+#include <io.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
 #endif
 
 #ifdef _WIN32
@@ -65,3 +81,178 @@ FILE *lsmash_win32_fopen( const char *name, const char *mode )
 
 #endif
 
+#ifdef _WIN32
+
+void *lsmash_map_file( FILE *fp, uint64_t *size )
+{
+    HANDLE file_handle = (HANDLE)_get_osfhandle( _fileno( fp ) );
+    LARGE_INTEGER file_size;
+    if( file_handle == INVALID_HANDLE_VALUE
+     || GetFileType( file_handle ) != FILE_TYPE_DISK
+     || !GetFileSizeEx( file_handle, &file_size )
+     || file_size.QuadPart <= 0
+     || (uint64_t)file_size.QuadPart > SIZE_MAX )
+        return NULL;
+    HANDLE map_handle = CreateFileMappingW( file_handle, NULL, PAGE_READONLY, 0, 0, NULL );
+    if( !map_handle )
+        return NULL;
+    void *data = MapViewOfFile( map_handle, FILE_MAP_READ, 0, 0, 0 );
+    /* The view keeps the mapping object alive. */
+    CloseHandle( map_handle );
+    if( !data )
+        return NULL;
+    *size = file_size.QuadPart;
+    return data;
+}
+
+void lsmash_unmap_file( void *data, uint64_t size )
+{
+    if( data )
+        UnmapViewOfFile( data );
+}
+
+#else
+
+void *lsmash_map_file( FILE *fp, uint64_t *size )
+{
+    struct stat st;
+    int fd = fileno( fp );
+    if( fd < 0
+     || fstat( fd, &st ) != 0
+     || !S_ISREG( st.st_mode )
+     || st.st_size <= 0
+     || (uint64_t)st.st_size > SIZE_MAX )
+        return NULL;
+    void *data = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if( data == MAP_FAILED )
+        return NULL;
+    *size = st.st_size;
+    return data;
+}
+
+void lsmash_unmap_file( void *data, uint64_t size )
+{
+    if( data )
+        munmap( data, (size_t)size );
+}
+
+#endif
+
+#ifdef _WIN32
+
+int lsmash_get_file_status( FILE *fp, uint64_t *size, int64_t *mtime )
+{
+    HANDLE file_handle = (HANDLE)_get_osfhandle( _fileno( fp ) );
+    LARGE_INTEGER file_size;
+    FILETIME      write_time;
+    if( file_handle == INVALID_HANDLE_VALUE
+     || GetFileType( file_handle ) != FILE_TYPE_DISK
+     || !GetFileSizeEx( file_handle, &file_size )
+     || !GetFileTime( file_handle, NULL, NULL, &write_time ) )
+        return LSMASH_ERR_PATCH_WELCOME;
+    *size  = file_size.QuadPart;
+    *mtime = ((int64_t)write_time.dwHighDateTime << 32) | write_time.dwLowDateTime;
+    return 0;
+}
+
+#else
+
+int lsmash_get_file_status( FILE *fp, uint64_t *size, int64_t *mtime )
+{
+    struct stat st;
+    int fd = fileno( fp );
+    if( fd < 0
+     || fstat( fd, &st ) != 0
+     || !S_ISREG( st.st_mode ) )
+        return LSMASH_ERR_PATCH_WELCOME;
+    *size  = st.st_size;
+    /* Take the nanoseconds where available since a file may be modified more than once in a second. */
+#if defined( __APPLE__ )
+    *mtime = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#elif defined( __linux__ ) || defined( __FreeBSD__ ) || defined( __NetBSD__ ) || defined( __OpenBSD__ )
+    *mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#else
+    *mtime = st.st_mtime;
+#endif
+    return 0;
+}
+
+#endif
+
+#if defined( __linux__ ) && defined( FALLOC_FL_INSERT_RANGE )
+
+uint64_t lsmash_get_file_insertion_unit( FILE *fp )
+{
+    struct stat st;
+    int fd = fileno( fp );
+    if( fd < 0
+     || fstat( fd, &st ) != 0
+     || !S_ISREG( st.st_mode )
+     || st.st_blksize <= 0 )
+        return 0;
+    return st.st_blksize;
+}
+
+int lsmash_insert_file_range( FILE *fp, uint64_t offset, uint64_t size )
+{
+    int fd = fileno( fp );
+    if( fd < 0 || offset > INT64_MAX || size > INT64_MAX )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    if( fallocate( fd, FALLOC_FL_INSERT_RANGE, (off_t)offset, (off_t)size ) != 0 )
+        /* EINVAL is also returned by the file systems which require the alignment to a unit other than the reported one. */
+        return errno == EOPNOTSUPP || errno == ENOSYS || errno == EINVAL ? LSMASH_ERR_PATCH_WELCOME : LSMASH_ERR_NAMELESS;
+    return 0;
+}
+
+#else
+
+uint64_t lsmash_get_file_insertion_unit( FILE *fp )
+{
+    return 0;
+}
+
+int lsmash_insert_file_range( FILE *fp, uint64_t offset, uint64_t size )
+{
+    return LSMASH_ERR_PATCH_WELCOME;
+}
+
+#endif
+
+#if defined( __linux__ ) && defined( SYS_copy_file_range )
+
+int64_t lsmash_copy_file_range( FILE *fp, uint64_t src, uint64_t dst, uint64_t size )
+{
+    int fd = fileno( fp );
+    if( fd < 0 || src > INT64_MAX || dst > INT64_MAX || size > SIZE_MAX )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    loff_t  src_offset = src;
+    loff_t  dst_offset = dst;
+    int64_t total      = 0;
+    while( size )
+    {
+        ssize_t copy_size = syscall( SYS_copy_file_range, fd, &src_offset, fd, &dst_offset, (size_t)size, 0 );
+        if( copy_size < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+            /* Report whether the copy is not supported or failed. */
+            if( total == 0 && (errno == ENOSYS || errno == EOPNOTSUPP || errno == EXDEV || errno == EINVAL) )
+                return LSMASH_ERR_PATCH_WELCOME;
+            return LSMASH_ERR_NAMELESS;
+        }
+        if( copy_size == 0 )
+            break;
+        total += copy_size;
+        size  -= copy_size;
+    }
+    return total;
+}
+
+#else
+
+int64_t lsmash_copy_file_range( FILE *fp, uint64_t src, uint64_t dst, uint64_t size )
+{
+    return LSMASH_ERR_PATCH_WELCOME;
+}
+
+#endif
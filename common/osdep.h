@@ -58,4 +58,34 @@
    int lsmash_string_from_wchar( int cp, const wchar_t *from, char **to );
 #endif
 
+#include <stdio.h>
+#include <stdint.h>
+/* Map the whole regular file 'fp' on memory for reading only.
+ * Return the address of the mapped data and set its size to 'size' if successful.
+ * Return NULL otherwise, e.g. if 'fp' is not a regular file or is empty. */
+void *lsmash_map_file( FILE *fp, uint64_t *size );
+void lsmash_unmap_file( void *data, uint64_t size );
+
+/* Get the size and the last modification time of the regular file 'fp'.
+ * The modification time is in the unit of the platform, e.g. nanoseconds where available, so it is meaningful only for
+ * the comparison on the same platform.
+ * Return LSMASH_ERR_PATCH_WELCOME if 'fp' is not a regular file. */
+int lsmash_get_file_status( FILE *fp, uint64_t *size, int64_t *mtime );
+
+/* Get the unit of the offset and the size for lsmash_insert_file_range() on the regular file 'fp'.
+ * The file system is not probed, so the insertion may still be unsupported even if not 0.
+ * Return 0 if the insertion is not available. */
+uint64_t lsmash_get_file_insertion_unit( FILE *fp );
+/* Insert 'size' bytes of zeros at 'offset' in the file 'fp' in place, i.e. move the data from 'offset' to the end by
+ * changing the block mapping of the file system instead of copying.
+ * Both 'offset' and 'size' must be multiples of the unit, and 'offset' must be less than the file size.
+ * The file position of 'fp' is not defined after this, so any buffered data must be flushed before.
+ * Return LSMASH_ERR_PATCH_WELCOME if not supported, and another negative value if failed. */
+int lsmash_insert_file_range( FILE *fp, uint64_t offset, uint64_t size );
+/* Copy 'size' bytes from 'src' to 'dst' in the file 'fp' inside the kernel.
+ * The two ranges must not overlap, and the file position of 'fp' is not changed.
+ * Return the number of the copied bytes if successful.
+ * Return LSMASH_ERR_PATCH_WELCOME if not supported, and another negative value if failed. */
+int64_t lsmash_copy_file_range( FILE *fp, uint64_t src, uint64_t dst, uint64_t size );
+
 #endif
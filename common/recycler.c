@@ -0,0 +1,258 @@
+/*****************************************************************************
+ * recycler.c
+ *****************************************************************************
+ * Copyright (C) 2010-2017 L-SMASH project
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *****************************************************************************/
+
+/* This file is available under an ISC license. */
+
+#include "internal.h" /* must be placed first */
+
+#include <stddef.h>
+
+/* The capacities of the size classes are 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, ... bytes,
+ * i.e. four classes per power of two, so at most 25% of a block is wasted.
+ * Blocks greater than the largest class are allocated by the exact size and never cached. */
+#define LSMASH_RECYCLER_MIN_ORDER   6
+#define LSMASH_RECYCLER_MAX_ORDER   24
+#define LSMASH_RECYCLER_CLASS_COUNT ((LSMASH_RECYCLER_MAX_ORDER - LSMASH_RECYCLER_MIN_ORDER) * 4 + 1)
+
+typedef union
+{
+    uint64_t    u;
+    long double f;
+    void       *p;
+} lsmash_recycler_align_t;
+
+typedef struct lsmash_recycler_block_tag lsmash_recycler_block_t;
+
+struct lsmash_recycler_block_tag
+{
+    lsmash_recycler_t       *recycler;      /* the recycler which this block belongs to */
+    lsmash_recycler_block_t *next;          /* the next block in the free list */
+    uint64_t                 capacity;      /* the size of the data */
+    int                      size_class;    /* the index of the size class, or -1 if never cached */
+    lsmash_recycler_align_t  data[];
+};
+
+struct lsmash_sample_pool_tag
+{
+    lsmash_mutex_t            *mutex;
+    uint32_t                   refcount;
+    uint64_t                   max_cached_size;
+    lsmash_sample_pool_stats_t stats;
+    lsmash_recycler_block_t   *free_list[LSMASH_RECYCLER_CLASS_COUNT];
+};
+
+static int recycler_get_size_class( size_t size, uint64_t *capacity )
+{
+    if( size <= ((size_t)1 << LSMASH_RECYCLER_MIN_ORDER) )
+    {
+        *capacity = (uint64_t)1 << LSMASH_RECYCLER_MIN_ORDER;
+        return 0;
+    }
+    if( size > ((size_t)1 << LSMASH_RECYCLER_MAX_ORDER) )
+    {
+        *capacity = size;
+        return -1;
+    }
+    int order = LSMASH_RECYCLER_MIN_ORDER;
+    while( ((size_t)1 << (order + 1)) < size )
+        ++order;
+    /* Here, 2^order < size <= 2^(order+1). */
+    uint64_t step = (uint64_t)1 << (order - 2);
+    *capacity = (size + step - 1) / step * step;
+    return (order - LSMASH_RECYCLER_MIN_ORDER) * 4 + (int)(*capacity / step) - 4;
+}
+
+static void recycler_free_blocks( lsmash_recycler_block_t *block )
+{
+    while( block )
+    {
+        lsmash_recycler_block_t *next = block->next;
+        lsmash_free( block );
+        block = next;
+    }
+}
+
+lsmash_recycler_t *lsmash_recycler_create
+(
+    uint64_t max_cached_size
+)
+{
+    lsmash_recycler_t *recycler = lsmash_malloc_zero( sizeof(lsmash_recycler_t) );
+    if( !recycler )
+        return NULL;
+    recycler->mutex = lsmash_mutex_create();
+    if( !recycler->mutex )
+    {
+        lsmash_free( recycler );
+        return NULL;
+    }
+    recycler->refcount        = 1;
+    recycler->max_cached_size = max_cached_size;
+    return recycler;
+}
+
+lsmash_recycler_t *lsmash_recycler_ref
+(
+    lsmash_recycler_t *recycler
+)
+{
+    if( !recycler )
+        return NULL;
+    lsmash_mutex_lock( recycler->mutex );
+    ++ recycler->refcount;
+    lsmash_mutex_unlock( recycler->mutex );
+    return recycler;
+}
+
+void lsmash_recycler_destroy
+(
+    lsmash_recycler_t *recycler
+)
+{
+    if( !recycler )
+        return;
+    lsmash_recycler_block_t *cached = NULL;
+    lsmash_mutex_lock( recycler->mutex );
+    int dead = (-- recycler->refcount == 0);
+    if( dead )
+    {
+        /* No more blocks are cached since nobody can allocate any more. */
+        for( int i = 0; i < LSMASH_RECYCLER_CLASS_COUNT; i++ )
+            while( recycler->free_list[i] )
+            {
+                lsmash_recycler_block_t *block = recycler->free_list[i];
+                recycler->free_list[i] = block->next;
+                block->next = cached;
+                cached      = block;
+            }
+        recycler->stats.cached_count = 0;
+        recycler->stats.cached_size  = 0;
+        dead = (recycler->stats.live_count == 0);
+    }
+    lsmash_mutex_unlock( recycler->mutex );
+    recycler_free_blocks( cached );
+    /* If any block is still in use, the recycler is deallocated when the last block is released. */
+    if( dead )
+    {
+        lsmash_mutex_destroy( recycler->mutex );
+        lsmash_free( recycler );
+    }
+}
+
+void *lsmash_recycler_alloc
+(
+    lsmash_recycler_t *recycler,
+    size_t             size
+)
+{
+    if( !recycler )
+        return NULL;
+    uint64_t capacity;
+    int size_class = recycler_get_size_class( size, &capacity );
+    lsmash_recycler_block_t *block = NULL;
+    lsmash_mutex_lock( recycler->mutex );
+    if( size_class >= 0 && recycler->free_list[size_class] )
+    {
+        block = recycler->free_list[size_class];
+        recycler->free_list[size_class] = block->next;
+        recycler->stats.cached_count -= 1;
+        recycler->stats.cached_size  -= capacity;
+        recycler->stats.reuse_count  += 1;
+    }
+    else
+    {
+        /* Allocate a new block in the lock so as to take the lock only once per allocation.
+         * The allocation is slower than the lock anyway, and steady-state allocations reuse cached blocks. */
+        block = capacity <= SIZE_MAX - sizeof(lsmash_recycler_block_t)
+              ? lsmash_malloc( sizeof(lsmash_recycler_block_t) + capacity )
+              : NULL;
+        if( !block )
+        {
+            lsmash_mutex_unlock( recycler->mutex );
+            return NULL;
+        }
+        block->recycler   = recycler;
+        block->capacity   = capacity;
+        block->size_class = size_class;
+    }
+    block->next = NULL;
+    recycler->stats.alloc_count += 1;
+    recycler->stats.live_count  += 1;
+    recycler->stats.live_size   += capacity;
+    recycler->stats.peak_live_size = LSMASH_MAX( recycler->stats.peak_live_size, recycler->stats.live_size );
+    lsmash_mutex_unlock( recycler->mutex );
+    return block->data;
+}
+
+void lsmash_recycler_free
+(
+    void *ptr
+)
+{
+    if( !ptr )
+        return;
+    lsmash_recycler_block_t *block    = (lsmash_recycler_block_t *)((uint8_t *)ptr - offsetof( lsmash_recycler_block_t, data ));
+    lsmash_recycler_t       *recycler = block->recycler;
+    lsmash_mutex_lock( recycler->mutex );
+    recycler->stats.live_count -= 1;
+    recycler->stats.live_size  -= block->capacity;
+    int cache = block->size_class >= 0
+             && recycler->refcount > 0
+             && (recycler->max_cached_size == 0
+              || recycler->stats.cached_size + block->capacity <= recycler->max_cached_size);
+    if( cache )
+    {
+        block->next = recycler->free_list[ block->size_class ];
+        recycler->free_list[ block->size_class ] = block;
+        recycler->stats.cached_count += 1;
+        recycler->stats.cached_size  += block->capacity;
+    }
+    else
+        recycler->stats.discard_count += 1;
+    int dead = (recycler->refcount == 0 && recycler->stats.live_count == 0);
+    lsmash_mutex_unlock( recycler->mutex );
+    if( !cache )
+        lsmash_free( block );
+    if( dead )
+    {
+        lsmash_mutex_destroy( recycler->mutex );
+        lsmash_free( recycler );
+    }
+}
+
+uint64_t lsmash_recycler_get_capacity
+(
+    const void *ptr
+)
+{
+    if( !ptr )
+        return 0;
+    const lsmash_recycler_block_t *block = (const lsmash_recycler_block_t *)((const uint8_t *)ptr - offsetof( lsmash_recycler_block_t, data ));
+    return block->capacity;
+}
+
+void lsmash_recycler_get_stats
+(
+    lsmash_recycler_t          *recycler,
+    lsmash_sample_pool_stats_t *stats
+)
+{
+    lsmash_mutex_lock( recycler->mutex );
+    *stats = recycler->stats;
+    lsmash_mutex_unlock( recycler->mutex );
+}
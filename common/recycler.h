@@ -0,0 +1,72 @@
+/*****************************************************************************
+ * recycler.h
+ *****************************************************************************
+ * Copyright (C) 2010-2017 L-SMASH project
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *****************************************************************************/
+
+/* This file is available under an ISC license. */
+
+/* The recycler keeps released memory blocks in free lists classified by size,
+ * and reuses them for later requests instead of allocating new blocks.
+ * Every block remembers its recycler, so it can be released anywhere, even on another thread.
+ * The recycler is alive until all of the references to it are dropped and all of the blocks are released.
+ * This is exposed as the sample pool through the public API. */
+typedef struct lsmash_sample_pool_tag lsmash_recycler_t;
+
+/* functions for internal usage */
+/* Create a recycler which caches released blocks up to 'max_cached_size' bytes in total.
+ * If 'max_cached_size' is set to 0, the total size of cached blocks is not limited. */
+lsmash_recycler_t *lsmash_recycler_create
+(
+    uint64_t max_cached_size
+);
+
+/* Add a reference to a recycler. */
+lsmash_recycler_t *lsmash_recycler_ref
+(
+    lsmash_recycler_t *recycler
+);
+
+/* Drop a reference to a recycler. */
+void lsmash_recycler_destroy
+(
+    lsmash_recycler_t *recycler
+);
+
+/* Allocate a memory block suitably aligned for any type. */
+void *lsmash_recycler_alloc
+(
+    lsmash_recycler_t *recycler,
+    size_t             size
+);
+
+/* Release a memory block allocated by lsmash_recycler_alloc() to its recycler. */
+void lsmash_recycler_free
+(
+    void *ptr
+);
+
+/* Get the size of a memory block allocated by lsmash_recycler_alloc(),
+ * which is equal to or greater than the requested size. */
+uint64_t lsmash_recycler_get_capacity
+(
+    const void *ptr
+);
+
+void lsmash_recycler_get_stats
+(
+    lsmash_recycler_t          *recycler,
+    lsmash_sample_pool_stats_t *stats
+);
@@ -0,0 +1,235 @@
+/*****************************************************************************
+ * thread.c
+ *****************************************************************************
+ * Copyright (C) 2010-2017 L-SMASH project
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *****************************************************************************/
+
+/* This file is available under an ISC license. */
+
+#include "internal.h" /* must be placed first */
+
+#ifdef _WIN32
+/* Condition variables are available on Windows Vista or later. */
+#if !defined( _WIN32_WINNT ) || _WIN32_WINNT < 0x0600
+#undef  _WIN32_WINNT
+#define _WIN32_WINNT 0x0600
+#endif
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+struct lsmash_mutex_tag
+{
+#ifdef _WIN32
+    CRITICAL_SECTION handle;
+#else
+    pthread_mutex_t  handle;
+#endif
+};
+
+struct lsmash_cond_tag
+{
+#ifdef _WIN32
+    CONDITION_VARIABLE handle;
+#else
+    pthread_cond_t     handle;
+#endif
+};
+
+struct lsmash_thread_tag
+{
+#ifdef _WIN32
+    HANDLE    handle;
+#else
+    pthread_t handle;
+#endif
+    void *(*func)( void * );
+    void   *arg;
+    void   *ret;
+};
+
+#ifdef _WIN32
+static unsigned __stdcall thread_main( void *opaque )
+#else
+static void *thread_main( void *opaque )
+#endif
+{
+    lsmash_thread_t *thread = (lsmash_thread_t *)opaque;
+    thread->ret = thread->func( thread->arg );
+    return 0;
+}
+
+lsmash_thread_t *lsmash_thread_create
+(
+    void *(*func)( void * ),
+    void   *arg
+)
+{
+    if( !func )
+        return NULL;
+    lsmash_thread_t *thread = lsmash_malloc_zero( sizeof(lsmash_thread_t) );
+    if( !thread )
+        return NULL;
+    thread->func = func;
+    thread->arg  = arg;
+#ifdef _WIN32
+    thread->handle = (HANDLE)_beginthreadex( NULL, 0, thread_main, thread, 0, NULL );
+    if( !thread->handle )
+#else
+    if( pthread_create( &thread->handle, NULL, thread_main, thread ) != 0 )
+#endif
+    {
+        lsmash_free( thread );
+        return NULL;
+    }
+    return thread;
+}
+
+void *lsmash_thread_join
+(
+    lsmash_thread_t *thread
+)
+{
+    if( !thread )
+        return NULL;
+#ifdef _WIN32
+    WaitForSingleObject( thread->handle, INFINITE );
+    CloseHandle( thread->handle );
+#else
+    pthread_join( thread->handle, NULL );
+#endif
+    void *ret = thread->ret;
+    lsmash_free( thread );
+    return ret;
+}
+
+lsmash_mutex_t *lsmash_mutex_create
+(
+    void
+)
+{
+    lsmash_mutex_t *mutex = lsmash_malloc( sizeof(lsmash_mutex_t) );
+    if( !mutex )
+        return NULL;
+#ifdef _WIN32
+    InitializeCriticalSection( &mutex->handle );
+#else
+    if( pthread_mutex_init( &mutex->handle, NULL ) != 0 )
+    {
+        lsmash_free( mutex );
+        return NULL;
+    }
+#endif
+    return mutex;
+}
+
+void lsmash_mutex_destroy
+(
+    lsmash_mutex_t *mutex
+)
+{
+    if( !mutex )
+        return;
+#ifdef _WIN32
+    DeleteCriticalSection( &mutex->handle );
+#else
+    pthread_mutex_destroy( &mutex->handle );
+#endif
+    lsmash_free( mutex );
+}
+
+void lsmash_mutex_lock
+(
+    lsmash_mutex_t *mutex
+)
+{
+#ifdef _WIN32
+    EnterCriticalSection( &mutex->handle );
+#else
+    pthread_mutex_lock( &mutex->handle );
+#endif
+}
+
+void lsmash_mutex_unlock
+(
+    lsmash_mutex_t *mutex
+)
+{
+#ifdef _WIN32
+    LeaveCriticalSection( &mutex->handle );
+#else
+    pthread_mutex_unlock( &mutex->handle );
+#endif
+}
+
+lsmash_cond_t *lsmash_cond_create
+(
+    void
+)
+{
+    lsmash_cond_t *cond = lsmash_malloc( sizeof(lsmash_cond_t) );
+    if( !cond )
+        return NULL;
+#ifdef _WIN32
+    InitializeConditionVariable( &cond->handle );
+#else
+    if( pthread_cond_init( &cond->handle, NULL ) != 0 )
+    {
+        lsmash_free( cond );
+        return NULL;
+    }
+#endif
+    return cond;
+}
+
+void lsmash_cond_destroy
+(
+    lsmash_cond_t *cond
+)
+{
+    if( !cond )
+        return;
+#ifndef _WIN32
+    pthread_cond_destroy( &cond->handle );
+#endif
+    lsmash_free( cond );
+}
+
+void lsmash_cond_wait
+(
+    lsmash_cond_t  *cond,
+    lsmash_mutex_t *mutex
+)
+{
+#ifdef _WIN32
+    SleepConditionVariableCS( &cond->handle, &mutex->handle, INFINITE );
+#else
+    pthread_cond_wait( &cond->handle, &mutex->handle );
+#endif
+}
+
+void lsmash_cond_broadcast
+(
+    lsmash_cond_t *cond
+)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable( &cond->handle );
+#else
+    pthread_cond_broadcast( &cond->handle );
+#endif
+}
@@ -0,0 +1,89 @@
+/*****************************************************************************
+ * thread.h
+ *****************************************************************************
+ * Copyright (C) 2010-2017 L-SMASH project
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *****************************************************************************/
+
+/* This file is available under an ISC license. */
+
+/* A minimal wrapper of the native threads of the platform.
+ * A thread runs a given function once and is waited for by lsmash_thread_join(),
+ * which also deallocates the handle of the thread. */
+typedef struct lsmash_thread_tag lsmash_thread_t;
+
+/* A mutex and a condition variable waited for with the mutex locked. */
+typedef struct lsmash_mutex_tag lsmash_mutex_t;
+typedef struct lsmash_cond_tag  lsmash_cond_t;
+
+/* functions for internal usage */
+/* Run 'func' with 'arg' on a new thread.
+ * Return the handle of the thread if successful.
+ * Return NULL otherwise. */
+lsmash_thread_t *lsmash_thread_create
+(
+    void *(*func)( void * ),
+    void   *arg
+);
+
+/* Wait for the termination of a thread and deallocate its handle.
+ * Return the return value of the function run on the thread. */
+void *lsmash_thread_join
+(
+    lsmash_thread_t *thread
+);
+
+lsmash_mutex_t *lsmash_mutex_create
+(
+    void
+);
+
+void lsmash_mutex_destroy
+(
+    lsmash_mutex_t *mutex
+);
+
+void lsmash_mutex_lock
+(
+    lsmash_mutex_t *mutex
+);
+
+void lsmash_mutex_unlock
+(
+    lsmash_mutex_t *mutex
+);
+
+lsmash_cond_t *lsmash_cond_create
+(
+    void
+);
+
+void lsmash_cond_destroy
+(
+    lsmash_cond_t *cond
+);
+
+/* Unlock 'mutex' and wait until 'cond' is signaled, and then lock 'mutex' again.
+ * Spurious wakeups may occur, so check the condition in a loop. */
+void lsmash_cond_wait
+(
+    lsmash_cond_t  *cond,
+    lsmash_mutex_t *mutex
+);
+
+/* Wake up all the threads waiting for 'cond'. */
+void lsmash_cond_broadcast
+(
+    lsmash_cond_t *cond
+);
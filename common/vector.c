@@ -0,0 +1,331 @@
+/*****************************************************************************
+ * vector.c
+ *****************************************************************************
+ * Copyright (C) 2010-2017 L-SMASH project
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *****************************************************************************/
+
+/* This file is available under an ISC license. */
+
+#include "internal.h" /* must be placed first */
+
+#include <string.h>
+
+void lsmash_vector_init_orig
+(
+    lsmash_vector_t             *vector,
+    lsmash_entry_data_eliminator eliminator
+)
+{
+    assert( eliminator != NULL );
+    vector->data        = NULL;
+    vector->entry_count = 0;
+    vector->alloc_count = 0;
+    vector->eliminator  = eliminator;
+}
+
+lsmash_vector_t *lsmash_vector_create_orig
+(
+    lsmash_entry_data_eliminator eliminator
+)
+{
+    lsmash_vector_t *vector = lsmash_malloc( sizeof(lsmash_vector_t) );
+    if( !vector )
+        return NULL;
+    lsmash_vector_init( vector, eliminator );
+    return vector;
+}
+
+void lsmash_vector_destroy
+(
+    lsmash_vector_t *vector
+)
+{
+    lsmash_vector_remove_entries( vector );
+    lsmash_free( vector );
+}
+
+int lsmash_vector_reserve
+(
+    lsmash_vector_t *vector,
+    uint32_t         alloc_count
+)
+{
+    if( !vector )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    if( alloc_count <= vector->alloc_count )
+        return 0;
+    if( (uint64_t)alloc_count * sizeof(void *) > SIZE_MAX )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    void **data = lsmash_realloc( vector->data, alloc_count * sizeof(void *) );
+    if( !data )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    vector->data        = data;
+    vector->alloc_count = alloc_count;
+    return 0;
+}
+
+int lsmash_vector_add_entry
+(
+    lsmash_vector_t *vector,
+    void            *data
+)
+{
+    if( !vector )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    if( vector->entry_count == vector->alloc_count )
+    {
+        if( vector->alloc_count == UINT32_MAX )
+            return LSMASH_ERR_MEMORY_ALLOC;
+        uint32_t alloc_count = vector->alloc_count == 0           ? 4
+                             : vector->alloc_count <= UINT32_MAX / 2 ? vector->alloc_count * 2
+                             :                                         UINT32_MAX;
+        int err = lsmash_vector_reserve( vector, alloc_count );
+        if( err < 0 )
+            return err;
+    }
+    vector->data[ vector->entry_count++ ] = data;
+    return 0;
+}
+
+int lsmash_vector_remove_entries_in_range
+(
+    lsmash_vector_t *vector,
+    uint32_t         entry_number,
+    uint32_t         count
+)
+{
+    if( !vector
+     || entry_number == 0
+     || entry_number > vector->entry_count
+     || count > vector->entry_count - entry_number + 1 )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    void **data = &vector->data[entry_number - 1];
+    if( vector->eliminator )
+        for( uint32_t i = 0; i < count; i++ )
+            if( data[i] )
+                vector->eliminator( data[i] );
+    memmove( data, data + count, (vector->entry_count - (entry_number - 1) - count) * sizeof(void *) );
+    vector->entry_count -= count;
+    return 0;
+}
+
+int lsmash_vector_remove_entry
+(
+    lsmash_vector_t *vector,
+    uint32_t         entry_number
+)
+{
+    return lsmash_vector_remove_entries_in_range( vector, entry_number, 1 );
+}
+
+void lsmash_vector_remove_entries
+(
+    lsmash_vector_t *vector
+)
+{
+    if( !vector )
+        return;
+    /* Note that it's valid that vector contain no entries or no data to be eliminated. */
+    if( vector->eliminator )
+        for( uint32_t i = 0; i < vector->entry_count; i++ )
+            if( vector->data[i] )
+                vector->eliminator( vector->data[i] );
+    lsmash_freep( &vector->data );
+    vector->entry_count = 0;
+    vector->alloc_count = 0;
+}
+
+void lsmash_vector_move_entries
+(
+    lsmash_vector_t *dst,
+    lsmash_vector_t *src
+)
+{
+    *dst = *src;
+    src->data        = NULL;
+    src->entry_count = 0;
+    src->alloc_count = 0;
+}
+
+uint32_t lsmash_vector_find_entry
+(
+    lsmash_vector_t *vector,
+    void            *data
+)
+{
+    if( !vector )
+        return 0;
+    for( uint32_t i = 0; i < vector->entry_count; i++ )
+        if( vector->data[i] == data )
+            return i + 1;
+    return 0;
+}
+
+/* The ID index uses open addressing with linear probing, and keeps its load factor at most 1/2. */
+static inline uint32_t lsmash_id_index_hash
+(
+    lsmash_id_index_t *index,
+    uint32_t           id
+)
+{
+    /* Fibonacci hashing */
+    uint32_t hash = id * UINT32_C(0x9E3779B1);
+    return (hash ^ (hash >> 16)) & (index->alloc_count - 1);
+}
+
+void lsmash_id_index_init
+(
+    lsmash_id_index_t *index
+)
+{
+    index->id          = NULL;
+    index->data        = NULL;
+    index->entry_count = 0;
+    index->alloc_count = 0;
+}
+
+void lsmash_id_index_cleanup
+(
+    lsmash_id_index_t *index
+)
+{
+    if( !index )
+        return;
+    lsmash_free( index->id );
+    lsmash_free( index->data );
+    lsmash_id_index_init( index );
+}
+
+void lsmash_id_index_clear
+(
+    lsmash_id_index_t *index
+)
+{
+    if( !index || index->entry_count == 0 )
+        return;
+    memset( index->id, 0, index->alloc_count * sizeof(uint32_t) );
+    index->entry_count = 0;
+}
+
+static int lsmash_id_index_resize
+(
+    lsmash_id_index_t *index,
+    uint32_t           alloc_count
+)
+{
+    uint32_t *id   = lsmash_malloc_zero( alloc_count * sizeof(uint32_t) );
+    void    **data = lsmash_malloc( alloc_count * sizeof(void *) );
+    if( !id || !data )
+    {
+        lsmash_free( id );
+        lsmash_free( data );
+        return LSMASH_ERR_MEMORY_ALLOC;
+    }
+    lsmash_id_index_t new_index = { id, data, 0, alloc_count };
+    for( uint32_t i = 0; i < index->alloc_count; i++ )
+        if( index->id[i] )
+        {
+            uint32_t slot = lsmash_id_index_hash( &new_index, index->id[i] );
+            while( new_index.id[slot] )
+                slot = (slot + 1) & (alloc_count - 1);
+            new_index.id  [slot] = index->id[i];
+            new_index.data[slot] = index->data[i];
+            ++ new_index.entry_count;
+        }
+    lsmash_free( index->id );
+    lsmash_free( index->data );
+    *index = new_index;
+    return 0;
+}
+
+int lsmash_id_index_set
+(
+    lsmash_id_index_t *index,
+    uint32_t           id,
+    void              *data
+)
+{
+    if( !index || id == 0 )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    if( (index->entry_count + 1) * 2 > index->alloc_count )
+    {
+        if( index->alloc_count > UINT32_MAX / 4 )
+            return LSMASH_ERR_MEMORY_ALLOC;
+        int err = lsmash_id_index_resize( index, index->alloc_count ? index->alloc_count * 2 : 8 );
+        if( err < 0 )
+            return err;
+    }
+    uint32_t slot = lsmash_id_index_hash( index, id );
+    while( index->id[slot] && index->id[slot] != id )
+        slot = (slot + 1) & (index->alloc_count - 1);
+    if( index->id[slot] == 0 )
+    {
+        index->id[slot] = id;
+        ++ index->entry_count;
+    }
+    index->data[slot] = data;
+    return 0;
+}
+
+void *lsmash_id_index_get
+(
+    lsmash_id_index_t *index,
+    uint32_t           id
+)
+{
+    if( !index || id == 0 || index->entry_count == 0 )
+        return NULL;
+    uint32_t slot = lsmash_id_index_hash( index, id );
+    while( index->id[slot] )
+    {
+        if( index->id[slot] == id )
+            return index->data[slot];
+        slot = (slot + 1) & (index->alloc_count - 1);
+    }
+    return NULL;
+}
+
+void lsmash_id_index_remove
+(
+    lsmash_id_index_t *index,
+    uint32_t           id
+)
+{
+    if( !index || id == 0 || index->entry_count == 0 )
+        return;
+    uint32_t mask = index->alloc_count - 1;
+    uint32_t slot = lsmash_id_index_hash( index, id );
+    while( index->id[slot] != id )
+    {
+        if( index->id[slot] == 0 )
+            return;
+        slot = (slot + 1) & mask;
+    }
+    index->id[slot] = 0;
+    -- index->entry_count;
+    /* Move back the following entries in the same cluster so that no entry gets unreachable. */
+    for( uint32_t next = (slot + 1) & mask; index->id[next]; next = (next + 1) & mask )
+    {
+        uint32_t home = lsmash_id_index_hash( index, index->id[next] );
+        /* Move the entry if its home slot is not in the cyclic range (slot, next]. */
+        if( slot <= next ? (home <= slot || home > next) : (home <= slot && home > next) )
+        {
+            index->id  [slot] = index->id  [next];
+            index->data[slot] = index->data[next];
+            index->id  [next] = 0;
+            slot = next;
+        }
+    }
+}
@@ -0,0 +1,162 @@
+/*****************************************************************************
+ * vector.h
+ *****************************************************************************
+ * Copyright (C) 2010-2017 L-SMASH project
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ *****************************************************************************/
+
+/* This file is available under an ISC license. */
+
+/* The vector is a growable array of pointers to data.
+ * Unlike lsmash_entry_list_t, any entry can be accessed in constant time by its entry number.
+ * The entry number is 1-origin as with lsmash_entry_list_t.
+ * A vector without the eliminator, e.g. a zero-initialized one, doesn't own the data. */
+typedef struct
+{
+    void                       **data;
+    uint32_t                     entry_count;
+    uint32_t                     alloc_count;
+    lsmash_entry_data_eliminator eliminator;
+} lsmash_vector_t;
+
+/* The ID index is a hash table to look up data by a non-zero 32-bit identifier such as track_ID.
+ * It doesn't own the data, so the owner must remove an entry before the data is freed. */
+typedef struct
+{
+    uint32_t  *id;      /* 0 means an empty slot. */
+    void     **data;
+    uint32_t   entry_count;
+    uint32_t   alloc_count;  /* a power of 2 or 0 */
+} lsmash_id_index_t;
+
+/* Utility macros to avoid 'lsmash_entry_data_eliminator' casts to the 'eliminator' argument */
+#define lsmash_vector_init( vector, eliminator ) \
+        lsmash_vector_init_orig( vector, (lsmash_entry_data_eliminator)(eliminator) )
+#define lsmash_vector_init_simple( vector ) \
+        lsmash_vector_init_orig( vector, (lsmash_entry_data_eliminator)lsmash_free )
+
+#define lsmash_vector_create( eliminator ) \
+        lsmash_vector_create_orig( (lsmash_entry_data_eliminator)(eliminator) )
+#define lsmash_vector_create_simple() \
+        lsmash_vector_create_orig( (lsmash_entry_data_eliminator)lsmash_free )
+
+/* functions for internal usage */
+void lsmash_vector_init_orig
+(
+    lsmash_vector_t             *vector,
+    lsmash_entry_data_eliminator eliminator
+);
+
+lsmash_vector_t *lsmash_vector_create_orig
+(
+    lsmash_entry_data_eliminator eliminator
+);
+
+void lsmash_vector_destroy
+(
+    lsmash_vector_t *vector
+);
+
+/* Make room for at least 'alloc_count' entries in total. */
+int lsmash_vector_reserve
+(
+    lsmash_vector_t *vector,
+    uint32_t         alloc_count
+);
+
+int lsmash_vector_add_entry
+(
+    lsmash_vector_t *vector,
+    void            *data
+);
+
+/* Remove the entries from the 'entry_number'-th to the ('entry_number' + 'count' - 1)-th,
+ * and move the following entries forward. */
+int lsmash_vector_remove_entries_in_range
+(
+    lsmash_vector_t *vector,
+    uint32_t         entry_number,
+    uint32_t         count
+);
+
+int lsmash_vector_remove_entry
+(
+    lsmash_vector_t *vector,
+    uint32_t         entry_number
+);
+
+void lsmash_vector_remove_entries
+(
+    lsmash_vector_t *vector
+);
+
+void lsmash_vector_move_entries
+(
+    lsmash_vector_t *dst,
+    lsmash_vector_t *src
+);
+
+static inline void *lsmash_vector_get_entry_data
+(
+    lsmash_vector_t *vector,
+    uint32_t         entry_number
+)
+{
+    if( !vector || !entry_number || entry_number > vector->entry_count )
+        return NULL;
+    return vector->data[entry_number - 1];
+}
+
+/* Return the entry number of given data, or 0 if not found. */
+uint32_t lsmash_vector_find_entry
+(
+    lsmash_vector_t *vector,
+    void            *data
+);
+
+void lsmash_id_index_init
+(
+    lsmash_id_index_t *index
+);
+
+void lsmash_id_index_cleanup
+(
+    lsmash_id_index_t *index
+);
+
+/* Remove all entries but keep the allocated slots. */
+void lsmash_id_index_clear
+(
+    lsmash_id_index_t *index
+);
+
+/* Associate 'data' with 'id'. If 'id' is already present, the data is replaced. */
+int lsmash_id_index_set
+(
+    lsmash_id_index_t *index,
+    uint32_t           id,
+    void              *data
+);
+
+void *lsmash_id_index_get
+(
+    lsmash_id_index_t *index,
+    uint32_t           id
+);
+
+void lsmash_id_index_remove
+(
+    lsmash_id_index_t *index,
+    uint32_t           id
+);
@@ -27,6 +27,7 @@
 
 #include "box.h"
 #include "box_default.h"
+#include "file.h"
 #include "write.h"
 #include "read.h"
 #include "print.h"
@@ -157,6 +158,74 @@ void isom_bs_put_box_common( lsmash_bs_t *bs, void *box )
         isom_bs_put_basebox_common( bs, (isom_box_t *)box );
 }
 
+void isom_table_init( isom_table_t *table, uint32_t entry_size )
+{
+    assert( entry_size > 0 );
+    table->data        = NULL;
+    table->entry_count = 0;
+    table->alloc_count = 0;
+    table->entry_size  = entry_size;
+}
+
+void isom_table_remove_entries( isom_table_t *table )
+{
+    if( !table )
+        return;
+    lsmash_freep( &table->data );
+    table->entry_count = 0;
+    table->alloc_count = 0;
+}
+
+int isom_table_reserve( isom_table_t *table, uint32_t entry_count )
+{
+    if( !table || table->entry_size == 0 )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    if( entry_count <= table->alloc_count )
+        return 0;
+    if( (uint64_t)entry_count * table->entry_size > SIZE_MAX )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    void *data = lsmash_realloc( table->data, (size_t)entry_count * table->entry_size );
+    if( !data )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    table->data        = data;
+    table->alloc_count = entry_count;
+    return 0;
+}
+
+void *isom_table_add_entry( isom_table_t *table )
+{
+    if( !table || table->entry_count == UINT32_MAX )
+        return NULL;
+    if( table->entry_count == table->alloc_count )
+    {
+        /* Grow geometrically so that appending is amortized constant time. */
+        uint32_t alloc_count = table->alloc_count == 0            ? 16
+                             : table->alloc_count <= UINT32_MAX / 2 ? table->alloc_count * 2
+                             :                                        UINT32_MAX;
+        if( isom_table_reserve( table, alloc_count ) < 0 )
+            return NULL;
+    }
+    void *entry = (uint8_t *)table->data + (size_t)table->entry_count * table->entry_size;
+    ++ table->entry_count;
+    return entry;
+}
+
+void isom_table_remove_entry_tail( isom_table_t *table )
+{
+    if( table && table->entry_count )
+        -- table->entry_count;
+}
+
+void isom_table_move_entries( isom_table_t *dst, isom_table_t *src )
+{
+    assert( dst->entry_size == src->entry_size );
+    lsmash_free( dst->data );
+    *dst = *src;
+    src->data        = NULL;
+    src->entry_count = 0;
+    src->alloc_count = 0;
+}
+
 /* Return 1 if the box is fullbox, Otherwise return 0. */
 int isom_is_fullbox( const void *box )
 {
@@ -422,6 +491,30 @@ int isom_add_extension_binary
     return 0;
 }
 
+/* Get the arena from which the children of a given box are allocated.
+ * Files are children of the ROOT, and never allocated from any arena. */
+static inline lsmash_arena_t *isom_get_arena_for_children( isom_box_t *parent )
+{
+    return (isom_box_t *)parent->root == parent ? NULL : parent->file->arena;
+}
+
+/* Deallocate the memory of a box itself.
+ * Boxes allocated from the arena of the file are released at a time when the file is freed,
+ * which must be the last since every box in the file is its descendant. */
+static void isom_free_box( isom_box_t *box )
+{
+    /* The ROOT is freed after all files. */
+    if( (isom_box_t *)box->root != box )
+    {
+        lsmash_file_t *file = box->file;
+        if( (isom_box_t *)file == box )
+            lsmash_arena_destroy( file->arena );
+        else if( LSMASH_IS_EXISTING_BOX( file ) && lsmash_arena_contains( file->arena, box ) )
+            return;
+    }
+    lsmash_free( box );
+}
+
 void isom_remove_extension_box( isom_box_t *ext )
 {
     if( LSMASH_IS_NON_EXISTING_BOX( ext ) )
@@ -429,7 +522,7 @@ void isom_remove_extension_box( isom_box_t *ext )
     if( ext->destruct )
         ext->destruct( ext );
     isom_remove_all_extension_boxes( &ext->extensions );
-    lsmash_free( ext );
+    isom_free_box( ext );
 }
 
 void isom_remove_all_extension_boxes( lsmash_entry_list_t *extensions )
@@ -513,6 +606,9 @@ lsmash_entry_t *isom_get_entry_of_box
 #define REMOVE_BOX_IN_LIST( box_name ) \
         isom_remove_box_in_predefined_list( box_name )
 
+#define REMOVE_BOX_IN_VECTOR( box_name ) \
+        isom_remove_box_in_predefined_vector( box_name )
+
 #define REMOVE_LIST_BOX_TEMPLATE( REMOVER, box_name ) \
     do                                                \
     {                                                 \
@@ -545,12 +641,25 @@ lsmash_entry_t *isom_get_entry_of_box
 #define DEFINE_SIMPLE_BOX_IN_LIST_REMOVER( func_name, box_name ) \
         DEFINE_SIMPLE_BOX_REMOVER_TEMPLATE( REMOVE_BOX_IN_LIST, box_name )
 
+#define DEFINE_SIMPLE_BOX_IN_VECTOR_REMOVER( func_name, box_name ) \
+        DEFINE_SIMPLE_BOX_REMOVER_TEMPLATE( REMOVE_BOX_IN_VECTOR, box_name )
+
 #define DEFINE_SIMPLE_LIST_BOX_REMOVER( func_name, box_name ) \
         DEFINE_SIMPLE_BOX_REMOVER_TEMPLATE( REMOVE_LIST_BOX, box_name )
 
 #define DEFINE_SIMPLE_LIST_BOX_IN_LIST_REMOVER( func_name, box_name ) \
         DEFINE_SIMPLE_BOX_REMOVER_TEMPLATE( REMOVE_LIST_BOX_IN_LIST, box_name )
 
+#define REMOVE_TABLE_BOX( box_name )                    \
+    do                                                  \
+    {                                                   \
+        isom_table_remove_entries( &box_name->table );  \
+        REMOVE_BOX( box_name );                         \
+    } while( 0 )
+
+#define DEFINE_SIMPLE_TABLE_BOX_REMOVER( func_name, box_name ) \
+        DEFINE_SIMPLE_BOX_REMOVER_TEMPLATE( REMOVE_TABLE_BOX, box_name )
+
 static void isom_remove_predefined_box( void *opaque_box )
 {
     isom_box_t *box = (isom_box_t *)opaque_box;
@@ -586,6 +695,25 @@ static void isom_remove_box_in_predefined_list( void *opaque_box )
     }
 }
 
+/* Same as isom_remove_box_in_predefined_list() but for a vector.
+ * The parent clears the vector before its children are freed, so nothing is found then. */
+static void isom_remove_box_in_predefined_vector( void *opaque_box )
+{
+    isom_box_t *box = (isom_box_t *)opaque_box;
+    if( LSMASH_IS_EXISTING_BOX( box )
+     && LSMASH_IS_EXISTING_BOX( box->parent ) )
+    {
+        lsmash_vector_t *vector = (lsmash_vector_t *)(((int8_t *)box->parent) + box->offset_in_parent);
+        uint32_t entry_number = lsmash_vector_find_entry( vector, box );
+        if( entry_number )
+        {
+            /* We don't free this box here since the vector doesn't own it. */
+            vector->data[entry_number - 1] = NULL;
+            lsmash_vector_remove_entry( vector, entry_number );
+        }
+    }
+}
+
 /* Remove a box by the pointer containing its address.
  * In addition, remove from the extension list of the parent box if possible.
  * Don't call this function within a function freeing one or more entries of any extension list because of double free.
@@ -620,6 +748,8 @@ static void isom_remove_file_abstract( isom_file_abstract_t *file_abstract )
     if( LSMASH_IS_NON_EXISTING_BOX( file_abstract ) )
         return;
     isom_printer_destory_list( file_abstract );
+    lsmash_vector_remove_entries( &file_abstract->moof_list );
+    lsmash_list_destroy( file_abstract->fragment_extents );
     isom_remove_timelines( file_abstract );
     lsmash_free( file_abstract->compatible_brands );
     lsmash_bs_cleanup( file_abstract->bs );
@@ -656,6 +786,9 @@ static void isom_remove_trak( isom_trak_t *trak )
         lsmash_free( trak->cache->fragment );
         lsmash_free( trak->cache );
     }
+    if( LSMASH_IS_EXISTING_BOX( trak->parent ) )
+        /* The index might contain this track under its previous track_ID. */
+        lsmash_id_index_clear( &((isom_moov_t *)trak->parent)->trak_index );
     REMOVE_BOX_IN_LIST( trak );
 }
 
@@ -725,46 +858,50 @@ static void isom_remove_must( isom_must_t *must )
     lsmash_free( must->required_box_types );
 }
 
-DEFINE_SIMPLE_BOX_REMOVER( isom_remove_stsd, stsd )
+static void isom_remove_stsd( isom_stsd_t *stsd )
+{
+    lsmash_vector_remove_entries( &stsd->list );
+    REMOVE_BOX( stsd );
+}
 
 static void isom_remove_visual_description( isom_sample_entry_t *description )
 {
     isom_visual_entry_t *visual = (isom_visual_entry_t *)description;
     lsmash_free( visual->color_table.array );
-    isom_remove_box_in_predefined_list( visual );
+    isom_remove_box_in_predefined_vector( visual );
 }
 
 static void isom_remove_audio_description( isom_sample_entry_t *description )
 {
-    isom_remove_box_in_predefined_list( description );
+    isom_remove_box_in_predefined_vector( description );
 }
 
 static void isom_remove_hint_description( isom_sample_entry_t *description )
 {
     isom_hint_entry_t *hint = (isom_hint_entry_t *)description;
-    isom_remove_box_in_predefined_list( hint );
+    isom_remove_box_in_predefined_vector( hint );
 }
 
 static void isom_remove_metadata_description( isom_sample_entry_t *description )
 {
-    isom_remove_box_in_predefined_list( description );
+    isom_remove_box_in_predefined_vector( description );
 }
 
 static void isom_remove_tx3g_description( isom_sample_entry_t *description )
 {
-    isom_remove_box_in_predefined_list( description );
+    isom_remove_box_in_predefined_vector( description );
 }
 
 static void isom_remove_qt_text_description( isom_sample_entry_t *description )
 {
     isom_qt_text_entry_t *text = (isom_qt_text_entry_t *)description;
     lsmash_free( text->font_name );
-    isom_remove_box_in_predefined_list( text );
+    isom_remove_box_in_predefined_vector( text );
 }
 
 static void isom_remove_mp4s_description( isom_sample_entry_t *description )
 {
-    isom_remove_box_in_predefined_list( description );
+    isom_remove_box_in_predefined_vector( description );
 }
 
 void isom_remove_sample_description( isom_sample_entry_t *sample )
@@ -943,21 +1080,21 @@ void isom_remove_sample_description( isom_sample_entry_t *sample )
         }
 }
 
-DEFINE_SIMPLE_LIST_BOX_REMOVER( isom_remove_stts, stts )
-DEFINE_SIMPLE_LIST_BOX_REMOVER( isom_remove_ctts, ctts )
+DEFINE_SIMPLE_TABLE_BOX_REMOVER( isom_remove_stts, stts )
+DEFINE_SIMPLE_TABLE_BOX_REMOVER( isom_remove_ctts, ctts )
 DEFINE_SIMPLE_BOX_REMOVER( isom_remove_cslg, cslg )
-DEFINE_SIMPLE_LIST_BOX_REMOVER( isom_remove_stsc, stsc )
-DEFINE_SIMPLE_LIST_BOX_REMOVER( isom_remove_stsz, stsz )
-DEFINE_SIMPLE_LIST_BOX_REMOVER( isom_remove_stz2, stz2 )
-DEFINE_SIMPLE_LIST_BOX_REMOVER( isom_remove_stss, stss )
-DEFINE_SIMPLE_LIST_BOX_REMOVER( isom_remove_stps, stps )
-DEFINE_SIMPLE_LIST_BOX_REMOVER( isom_remove_stco, stco )
+DEFINE_SIMPLE_TABLE_BOX_REMOVER( isom_remove_stsc, stsc )
+DEFINE_SIMPLE_TABLE_BOX_REMOVER( isom_remove_stsz, stsz )
+DEFINE_SIMPLE_TABLE_BOX_REMOVER( isom_remove_stz2, stz2 )
+DEFINE_SIMPLE_TABLE_BOX_REMOVER( isom_remove_stss, stss )
+DEFINE_SIMPLE_TABLE_BOX_REMOVER( isom_remove_stps, stps )
+DEFINE_SIMPLE_TABLE_BOX_REMOVER( isom_remove_stco, stco )
 
 static void isom_remove_sdtp( isom_sdtp_t *sdtp )
 {
     if( LSMASH_IS_NON_EXISTING_BOX( sdtp ) )
         return;
-    lsmash_list_destroy( sdtp->list );
+    isom_table_remove_entries( &sdtp->table );
     REMOVE_BOX( sdtp );
 }
 
@@ -1046,11 +1183,21 @@ static void isom_remove_ctab( isom_ctab_t *ctab )
     REMOVE_BOX( ctab );
 }
 
-DEFINE_SIMPLE_BOX_REMOVER( isom_remove_mvex, mvex )
+static void isom_remove_mvex( isom_mvex_t *mvex )
+{
+    lsmash_vector_remove_entries( &mvex->trex_list );
+    REMOVE_BOX( mvex );
+}
+
 DEFINE_SIMPLE_BOX_REMOVER( isom_remove_mvhd, mvhd )
 DEFINE_SIMPLE_BOX_REMOVER( isom_remove_mehd, mehd )
-DEFINE_SIMPLE_BOX_IN_LIST_REMOVER( isom_remove_trex, trex )
-DEFINE_SIMPLE_BOX_REMOVER( isom_remove_moov, moov )
+DEFINE_SIMPLE_BOX_IN_VECTOR_REMOVER( isom_remove_trex, trex )
+static void isom_remove_moov( isom_moov_t *moov )
+{
+    lsmash_id_index_cleanup( &moov->trak_index );
+    REMOVE_BOX( moov );
+}
+
 DEFINE_SIMPLE_BOX_REMOVER( isom_remove_mdat, mdat )
 DEFINE_SIMPLE_BOX_REMOVER( isom_remove_mfhd, mfhd )
 DEFINE_SIMPLE_BOX_REMOVER( isom_remove_tfhd, tfhd )
@@ -1062,8 +1209,19 @@ static void isom_remove_trun( isom_trun_t *trun )
     REMOVE_BOX_IN_LIST( trun );
 }
 
-DEFINE_SIMPLE_BOX_IN_LIST_REMOVER( isom_remove_traf, traf )
-DEFINE_SIMPLE_BOX_IN_LIST_REMOVER( isom_remove_moof, moof )
+static void isom_remove_traf( isom_traf_t *traf )
+{
+    if( LSMASH_IS_EXISTING_BOX( traf->parent ) )
+        lsmash_id_index_clear( &((isom_moof_t *)traf->parent)->traf_index );
+    REMOVE_BOX_IN_VECTOR( traf );
+}
+
+static void isom_remove_moof( isom_moof_t *moof )
+{
+    lsmash_id_index_cleanup( &moof->traf_index );
+    lsmash_vector_remove_entries( &moof->traf_list );
+    REMOVE_BOX_IN_VECTOR( moof );
+}
 
 static void isom_remove_free( isom_free_t *skip )
 {
@@ -1071,9 +1229,20 @@ static void isom_remove_free( isom_free_t *skip )
 }
 #define isom_remove_skip isom_remove_free
 
-DEFINE_SIMPLE_BOX_REMOVER( isom_remove_mfra, mfra )
+static void isom_remove_mfra( isom_mfra_t *mfra )
+{
+    lsmash_id_index_cleanup( &mfra->tfra_index );
+    REMOVE_BOX( mfra );
+}
+
 DEFINE_SIMPLE_BOX_REMOVER( isom_remove_mfro, mfro )
-DEFINE_SIMPLE_LIST_BOX_IN_LIST_REMOVER( isom_remove_tfra, tfra )
+
+static void isom_remove_tfra( isom_tfra_t *tfra )
+{
+    if( LSMASH_IS_EXISTING_BOX( tfra->parent ) )
+        lsmash_id_index_clear( &((isom_mfra_t *)tfra->parent)->tfra_index );
+    REMOVE_LIST_BOX_IN_LIST( tfra );
+}
 DEFINE_SIMPLE_LIST_BOX_IN_LIST_REMOVER( isom_remove_sidx, sidx )
 
 static void isom_remove_styp( isom_styp_t *styp )
@@ -1083,16 +1252,6 @@ static void isom_remove_styp( isom_styp_t *styp )
 }
 
 #define isom_remove_elst_entry lsmash_free
-#define isom_remove_stts_entry lsmash_free
-#define isom_remove_ctts_entry lsmash_free
-#define isom_remove_stsz_entry lsmash_free
-#define isom_remove_stz2_entry lsmash_free
-#define isom_remove_stss_entry lsmash_free
-#define isom_remove_stps_entry lsmash_free
-#define isom_remove_sdtp_entry lsmash_free
-#define isom_remove_stsc_entry lsmash_free
-#define isom_remove_stco_entry lsmash_free
-#define isom_remove_co64_entry lsmash_free
 #define isom_remove_sgpd_entry lsmash_free
 #define isom_remove_sbgp_entry lsmash_free
 #define isom_remove_trun_entry lsmash_free
@@ -1189,6 +1348,14 @@ uint64_t isom_update_box_size( void *opaque_box )
     }                                                                          \
     box_name->offset_in_parent = offsetof( isom_##parent_name##_t, box_name##_list )
 
+#define ADD_BOX_TO_PREDEFINED_VECTOR( box_name, parent_name )                    \
+    if( lsmash_vector_add_entry( &parent_name->box_name##_list, box_name ) < 0 ) \
+    {                                                                            \
+        lsmash_list_remove_entry_tail( &parent_name->extensions );               \
+        return isom_non_existing_##box_name();                                   \
+    }                                                                            \
+    box_name->offset_in_parent = offsetof( isom_##parent_name##_t, box_name##_list )
+
 #define INIT_BOX_COMMON0( box_name, parent_name, box_type, precedence )  \
         const isom_extension_destructor_t isom_remove_##box_name = NULL; \
         isom_init_box_common( box_name, parent_name, box_type, precedence, isom_remove_##box_name )
@@ -1198,13 +1365,14 @@ uint64_t isom_update_box_size( void *opaque_box )
 #define CREATE_BOX( box_name, parent_name, box_type, precedence, has_destructor )      \
     if( LSMASH_IS_NON_EXISTING_BOX( (isom_box_t *)parent_name ) )                      \
         return isom_non_existing_##box_name();                                         \
-    isom_##box_name##_t *box_name = ALLOCATE_BOX( box_name );                          \
+    isom_##box_name##_t *box_name = ALLOCATE_BOX_IN_ARENA( box_name,                   \
+        isom_get_arena_for_children( (isom_box_t *)parent_name ) );                    \
     if( LSMASH_IS_NON_EXISTING_BOX( box_name ) )                                       \
         return box_name;                                                               \
     INIT_BOX_COMMON ## has_destructor( box_name, parent_name, box_type, precedence );  \
     if( isom_add_box_to_extension_list( parent_name, box_name ) < 0 )                  \
     {                                                                                  \
-        lsmash_free( box_name );                                                       \
+        isom_free_box( (isom_box_t *)box_name );                                       \
         return isom_non_existing_##box_name();                                         \
     }
 #define CREATE_LIST_BOX( box_name, parent_name, box_type, precedence, has_destructor )  \
@@ -1227,6 +1395,10 @@ uint64_t isom_update_box_size( void *opaque_box )
     BOX_CREATOR( box_name, parent_name, box_type, precedence, 1 );                           \
     ADD_BOX_TO_PREDEFINED_LIST( box_name, parent_name )
 
+#define ADD_BOX_IN_VECTOR( box_name, parent_name, box_type, precedence ) \
+    CREATE_BOX( box_name, parent_name, box_type, precedence, 1 );           \
+    ADD_BOX_TO_PREDEFINED_VECTOR( box_name, parent_name )
+
 #define ADD_BOX( box_name, parent_name, box_type, precedence ) \
         ADD_BOX_TEMPLATE( box_name, parent_name, box_type, precedence, CREATE_BOX )
 #define ADD_BOX_IN_LIST( box_name, parent_name, box_type, precedence ) \
@@ -1251,9 +1423,19 @@ uint64_t isom_update_box_size( void *opaque_box )
         DEFINE_SIMPLE_BOX_ADDER_TEMPLATE( ADD_BOX, __VA_ARGS__ )
 #define DEFINE_SIMPLE_BOX_IN_LIST_ADDER( func_name, ... ) \
         DEFINE_SIMPLE_BOX_ADDER_TEMPLATE( ADD_BOX_IN_LIST, __VA_ARGS__ )
+#define DEFINE_SIMPLE_BOX_IN_VECTOR_ADDER( func_name, ... ) \
+        DEFINE_SIMPLE_BOX_ADDER_TEMPLATE( ADD_BOX_IN_VECTOR, __VA_ARGS__ )
 #define DEFINE_SIMPLE_LIST_BOX_ADDER( func_name, ... ) \
         DEFINE_SIMPLE_BOX_ADDER_TEMPLATE( ADD_LIST_BOX, __VA_ARGS__ )
 
+#define ADD_TABLE_BOX( box_name, parent_name, box_type, precedence, entry_type ) \
+    ADD_BOX( box_name, parent_name, box_type, precedence );                      \
+    isom_table_init( &box_name->table, sizeof(entry_type) )
+
+#define DEFINE_SIMPLE_TABLE_BOX_ADDER( func_name, box_name, parent_name, box_type, precedence, entry_type ) \
+        DEFINE_SIMPLE_BOX_ADDER_TEMPLATE( ADD_BOX, box_name, parent_name, box_type, precedence,             \
+                                          isom_table_init( &box_name->table, sizeof(entry_type) ); )
+
 #define DEFINE_SIMPLE_SAMPLE_EXTENSION_ADDER( func_name, box_name, parent_name, box_type, precedence, has_destructor, parent_type ) \
     isom_##box_name##_t *isom_add_##box_name( parent_type *parent_name )                                                            \
     {                                                                                                                               \
@@ -1445,7 +1627,7 @@ static void *isom_add_sample_description_entry
         isom_remove_box_by_itself( description );
         return description;
     }
-    if( lsmash_list_add_entry( &stsd->list, description ) < 0 )
+    if( lsmash_vector_add_entry( &stsd->list, description ) < 0 )
     {
         lsmash_list_remove_entry_tail( &stsd->extensions );
         return description;
@@ -1556,25 +1738,25 @@ DEFINE_SIMPLE_SAMPLE_EXTENSION_ADDER( isom_add_tims, tims, hint,   ISOM_BOX_TYPE
 DEFINE_SIMPLE_SAMPLE_EXTENSION_ADDER( isom_add_tsro, tsro, hint,   ISOM_BOX_TYPE_TSRO, LSMASH_BOX_PRECEDENCE_ISOM_TSRO, 0, isom_hint_entry_t )
 DEFINE_SIMPLE_SAMPLE_EXTENSION_ADDER( isom_add_tssy, tssy, hint,   ISOM_BOX_TYPE_TSSY, LSMASH_BOX_PRECEDENCE_ISOM_TSSY, 0, isom_hint_entry_t )
 
-DEFINE_SIMPLE_LIST_BOX_ADDER( isom_add_stts, stts, stbl, ISOM_BOX_TYPE_STTS, LSMASH_BOX_PRECEDENCE_ISOM_STTS )
-DEFINE_SIMPLE_LIST_BOX_ADDER( isom_add_ctts, ctts, stbl, ISOM_BOX_TYPE_CTTS, LSMASH_BOX_PRECEDENCE_ISOM_CTTS )
-DEFINE_SIMPLE_BOX_ADDER     ( isom_add_cslg, cslg, stbl, ISOM_BOX_TYPE_CSLG, LSMASH_BOX_PRECEDENCE_ISOM_CSLG )
-DEFINE_SIMPLE_LIST_BOX_ADDER( isom_add_stsc, stsc, stbl, ISOM_BOX_TYPE_STSC, LSMASH_BOX_PRECEDENCE_ISOM_STSC )
-DEFINE_SIMPLE_BOX_ADDER     ( isom_add_stsz, stsz, stbl, ISOM_BOX_TYPE_STSZ, LSMASH_BOX_PRECEDENCE_ISOM_STSZ )  /* We don't create a list here. */
-DEFINE_SIMPLE_LIST_BOX_ADDER( isom_add_stz2, stz2, stbl, ISOM_BOX_TYPE_STZ2, LSMASH_BOX_PRECEDENCE_ISOM_STZ2 )
-DEFINE_SIMPLE_LIST_BOX_ADDER( isom_add_stss, stss, stbl, ISOM_BOX_TYPE_STSS, LSMASH_BOX_PRECEDENCE_ISOM_STSS )
-DEFINE_SIMPLE_LIST_BOX_ADDER( isom_add_stps, stps, stbl,   QT_BOX_TYPE_STPS, LSMASH_BOX_PRECEDENCE_QTFF_STPS )
+DEFINE_SIMPLE_TABLE_BOX_ADDER( isom_add_stts, stts, stbl, ISOM_BOX_TYPE_STTS, LSMASH_BOX_PRECEDENCE_ISOM_STTS, isom_stts_entry_t )
+DEFINE_SIMPLE_TABLE_BOX_ADDER( isom_add_ctts, ctts, stbl, ISOM_BOX_TYPE_CTTS, LSMASH_BOX_PRECEDENCE_ISOM_CTTS, isom_ctts_entry_t )
+DEFINE_SIMPLE_BOX_ADDER      ( isom_add_cslg, cslg, stbl, ISOM_BOX_TYPE_CSLG, LSMASH_BOX_PRECEDENCE_ISOM_CSLG )
+DEFINE_SIMPLE_TABLE_BOX_ADDER( isom_add_stsc, stsc, stbl, ISOM_BOX_TYPE_STSC, LSMASH_BOX_PRECEDENCE_ISOM_STSC, isom_stsc_entry_t )
+DEFINE_SIMPLE_TABLE_BOX_ADDER( isom_add_stsz, stsz, stbl, ISOM_BOX_TYPE_STSZ, LSMASH_BOX_PRECEDENCE_ISOM_STSZ, isom_stsz_entry_t )
+DEFINE_SIMPLE_TABLE_BOX_ADDER( isom_add_stz2, stz2, stbl, ISOM_BOX_TYPE_STZ2, LSMASH_BOX_PRECEDENCE_ISOM_STZ2, isom_stsz_entry_t )
+DEFINE_SIMPLE_TABLE_BOX_ADDER( isom_add_stss, stss, stbl, ISOM_BOX_TYPE_STSS, LSMASH_BOX_PRECEDENCE_ISOM_STSS, isom_stss_entry_t )
+DEFINE_SIMPLE_TABLE_BOX_ADDER( isom_add_stps, stps, stbl,   QT_BOX_TYPE_STPS, LSMASH_BOX_PRECEDENCE_QTFF_STPS, isom_stps_entry_t )
 
 isom_stco_t *isom_add_stco( isom_stbl_t *stbl )
 {
-    ADD_LIST_BOX( stco, stbl, ISOM_BOX_TYPE_STCO, LSMASH_BOX_PRECEDENCE_ISOM_STCO );
+    ADD_TABLE_BOX( stco, stbl, ISOM_BOX_TYPE_STCO, LSMASH_BOX_PRECEDENCE_ISOM_STCO, isom_stco_entry_t );
     stco->large_presentation = 0;
     return stco;
 }
 
 isom_stco_t *isom_add_co64( isom_stbl_t *stbl )
 {
-    ADD_LIST_BOX( stco, stbl, ISOM_BOX_TYPE_CO64, LSMASH_BOX_PRECEDENCE_ISOM_CO64 );
+    ADD_TABLE_BOX( stco, stbl, ISOM_BOX_TYPE_CO64, LSMASH_BOX_PRECEDENCE_ISOM_CO64, isom_co64_entry_t );
     stco->large_presentation = 1;
     return stco;
 }
@@ -1586,13 +1768,13 @@ isom_sdtp_t *isom_add_sdtp( isom_box_t *parent )
     if( lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL ) )
     {
         isom_stbl_t *stbl = (isom_stbl_t *)parent;
-        ADD_LIST_BOX( sdtp, stbl, ISOM_BOX_TYPE_SDTP, LSMASH_BOX_PRECEDENCE_ISOM_SDTP );
+        ADD_TABLE_BOX( sdtp, stbl, ISOM_BOX_TYPE_SDTP, LSMASH_BOX_PRECEDENCE_ISOM_SDTP, isom_sdtp_entry_t );
         return sdtp;
     }
     else if( lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_TRAF ) )
     {
         isom_traf_t *traf = (isom_traf_t *)parent;
-        ADD_LIST_BOX( sdtp, traf, ISOM_BOX_TYPE_SDTP, LSMASH_BOX_PRECEDENCE_ISOM_SDTP );
+        ADD_TABLE_BOX( sdtp, traf, ISOM_BOX_TYPE_SDTP, LSMASH_BOX_PRECEDENCE_ISOM_SDTP, isom_sdtp_entry_t );
         return sdtp;
     }
     assert( 0 );
@@ -1709,10 +1891,10 @@ DEFINE_SIMPLE_BOX_ADDER        ( isom_add_SelO, SelO, udta,   QT_BOX_TYPE_SELO,
 DEFINE_SIMPLE_BOX_ADDER        ( isom_add_AllF, AllF, udta,   QT_BOX_TYPE_ALLF, LSMASH_BOX_PRECEDENCE_QTFF_ALLF )
 DEFINE_SIMPLE_BOX_ADDER        ( isom_add_mvex, mvex, moov, ISOM_BOX_TYPE_MVEX, LSMASH_BOX_PRECEDENCE_ISOM_MVEX )
 DEFINE_SIMPLE_BOX_ADDER        ( isom_add_mehd, mehd, mvex, ISOM_BOX_TYPE_MEHD, LSMASH_BOX_PRECEDENCE_ISOM_MEHD )
-DEFINE_SIMPLE_BOX_IN_LIST_ADDER( isom_add_trex, trex, mvex, ISOM_BOX_TYPE_TREX, LSMASH_BOX_PRECEDENCE_ISOM_TREX )
-DEFINE_SIMPLE_BOX_IN_LIST_ADDER( isom_add_moof, moof, file_abstract, ISOM_BOX_TYPE_MOOF, LSMASH_BOX_PRECEDENCE_ISOM_MOOF )
+DEFINE_SIMPLE_BOX_IN_VECTOR_ADDER( isom_add_trex, trex, mvex, ISOM_BOX_TYPE_TREX, LSMASH_BOX_PRECEDENCE_ISOM_TREX )
+DEFINE_SIMPLE_BOX_IN_VECTOR_ADDER( isom_add_moof, moof, file_abstract, ISOM_BOX_TYPE_MOOF, LSMASH_BOX_PRECEDENCE_ISOM_MOOF )
 DEFINE_SIMPLE_BOX_ADDER        ( isom_add_mfhd, mfhd, moof, ISOM_BOX_TYPE_MFHD, LSMASH_BOX_PRECEDENCE_ISOM_MFHD )
-DEFINE_SIMPLE_BOX_IN_LIST_ADDER( isom_add_traf, traf, moof, ISOM_BOX_TYPE_TRAF, LSMASH_BOX_PRECEDENCE_ISOM_TRAF )
+DEFINE_SIMPLE_BOX_IN_VECTOR_ADDER( isom_add_traf, traf, moof, ISOM_BOX_TYPE_TRAF, LSMASH_BOX_PRECEDENCE_ISOM_TRAF )
 DEFINE_SIMPLE_BOX_ADDER        ( isom_add_tfhd, tfhd, traf, ISOM_BOX_TYPE_TFHD, LSMASH_BOX_PRECEDENCE_ISOM_TFHD )
 DEFINE_SIMPLE_BOX_ADDER        ( isom_add_tfdt, tfdt, traf, ISOM_BOX_TYPE_TFDT, LSMASH_BOX_PRECEDENCE_ISOM_TFDT )
 DEFINE_SIMPLE_BOX_IN_LIST_ADDER( isom_add_trun, trun, traf, ISOM_BOX_TYPE_TRUN, LSMASH_BOX_PRECEDENCE_ISOM_TRUN )
@@ -1753,6 +1935,7 @@ isom_sidx_t *isom_add_sidx( isom_file_abstract_t *file_abstract )
 #undef ADD_BOX_IN_LIST_TEMPLATE
 #undef ADD_BOX
 #undef ADD_BOX_IN_LIST
+#undef ADD_BOX_IN_VECTOR
 #undef ADD_LIST_BOX
 #undef ADD_LIST_BOX_IN_LIST
 #undef DEFINE_SIMPLE_BOX_ADDER_TEMPLATE
@@ -1760,6 +1943,7 @@ isom_sidx_t *isom_add_sidx( isom_file_abstract_t *file_abstract )
 #undef DEFINE_SIMPLE_BOX_ADDER_TEMPLATE_5
 #undef DEFINE_SIMPLE_BOX_ADDER
 #undef DEFINE_SIMPLE_BOX_IN_LIST_ADDER
+#undef DEFINE_SIMPLE_BOX_IN_VECTOR_ADDER
 #undef DEFINE_SIMPLE_LIST_BOX_ADDER
 
 static int fake_file_read
@@ -1798,12 +1982,19 @@ static int64_t fake_file_seek
 }
 
 /* Public functions */
+static void isom_remove_root_abstract( isom_root_abstract_t *root_abstract )
+{
+    lsmash_recycler_destroy( root_abstract->sample_pool );
+    isom_destroy_file_handle_cache( root_abstract->file_handle_cache );
+}
+
 lsmash_root_t *lsmash_create_root( void )
 {
     lsmash_root_t *root = ALLOCATE_BOX( root_abstract );
     if( LSMASH_IS_NON_EXISTING_BOX( root ) )
         return NULL;
-    root->root = root;
+    root->root     = root;
+    root->destruct = (isom_extension_destructor_t)isom_remove_root_abstract;
     return root;
 }
 
@@ -90,6 +90,7 @@ typedef int (*isom_bitrate_updater_t)( isom_stbl_t *stbl, isom_mdhd_t *mdhd, uin
 #define LSMASH_NON_EXISTING_BOX  0x800  /* This flag indicates a read only non-existing box constant.
                                          * Don't use for wild boxes other than non-existing box constants
                                          * because this flags prevents attempting to freeing its box. */
+#define LSMASH_DEFERRED_BOX      0x1000 /* The entries of this box are not read from the file yet. */
 
 /* Use these macros for checking existences of boxes.
  * If the result of LSMASH_IS_EXISTING_BOX is 0, the evaluated box is read only.
@@ -1121,10 +1122,24 @@ typedef struct
 {
     ISOM_FULLBOX_COMMON;
     uint32_t entry_count;   /* print only */
-    lsmash_entry_list_t list;
+    lsmash_vector_t list;
 } isom_stsd_t;
 /** **/
 
+/* Sample table entries
+ * The tables in the sample table can have a huge number of tiny entries, e.g. a sample size per sample.
+ * They are stored in a contiguous array growing on demand instead of a list of separately allocated entries.
+ * Entries are accessed by casting 'data' to the entry type of the table.
+ * The entries of a table consisting only of 32-bit or 64-bit fields are read and written as an array of the fields at once,
+ * so such an entry type shall have its fields in the order in the box and no padding. */
+typedef struct
+{
+    void    *data;          /* the array of entries */
+    uint32_t entry_count;   /* the number of entries in the array */
+    uint32_t alloc_count;   /* the number of entries which can be stored without reallocation */
+    uint32_t entry_size;    /* the size of an entry in bytes */
+} isom_table_t;
+
 /* Decoding Time to Sample Box
  * This box contains a compact version of a table that allows indexing from decoding time to sample number.
  * Each entry in the table gives the number of consecutive samples with the same time delta, and the delta of those samples.
@@ -1141,7 +1156,7 @@ typedef struct
 typedef struct
 {
     ISOM_FULLBOX_COMMON;
-    lsmash_entry_list_t *list;
+    isom_table_t table;
 } isom_stts_t;
 
 /* Composition Time to Sample Box
@@ -1160,7 +1175,7 @@ typedef struct
 typedef struct
 {
     ISOM_FULLBOX_COMMON;
-    lsmash_entry_list_t *list;
+    isom_table_t table;
 } isom_ctts_t;
 
 /* Composition to Decode Box (Composition Shift Least Greatest Box)
@@ -1196,7 +1211,7 @@ typedef struct
     uint32_t sample_size;           /* the default sample size
                                      * If this field is set to 0, then the samples have different sizes. */
     uint32_t sample_count;          /* the number of samples in the media within the initial movie */
-    lsmash_entry_list_t *list;      /* available if sample_size == 0 */
+    isom_table_t table;             /* available if sample_size == 0 */
 } isom_stsz_t;
 
 typedef struct
@@ -1208,7 +1223,7 @@ typedef struct
                                      * entry[i]<<4 + entry[i+1]; if the sizes do not fill an integral number of bytes, the last byte is
                                      * padded with zero. */
     uint32_t     sample_count;      /* the number of entries in the following table */
-    lsmash_entry_list_t *list;      /* L-SMASH uses isom_stsz_entry_t for its internal processes. */
+    isom_table_t table;             /* L-SMASH uses isom_stsz_entry_t for its internal processes. */
 } isom_stz2_t;
 
 /* Sync Sample Box
@@ -1223,7 +1238,7 @@ typedef struct
 typedef struct
 {
     ISOM_FULLBOX_COMMON;
-    lsmash_entry_list_t *list;
+    isom_table_t table;
 } isom_stss_t;
 
 /* Partial Sync Sample Box
@@ -1239,7 +1254,7 @@ typedef struct
 typedef struct
 {
     ISOM_FULLBOX_COMMON;
-    lsmash_entry_list_t *list;
+    isom_table_t table;
 } isom_stps_t;
 
 /* Independent and Disposable Samples Box */
@@ -1256,7 +1271,7 @@ typedef struct
     ISOM_FULLBOX_COMMON;
     /* According to the specification, the size of the table, sample_count, doesn't exist in this box.
      * Instead of this, it is taken from the sample_count in the stsz or the stz2 box. */
-    lsmash_entry_list_t *list;
+    isom_table_t table;
 } isom_sdtp_t;
 
 /* Sample To Chunk Box
@@ -1274,7 +1289,7 @@ typedef struct
 typedef struct
 {
     ISOM_FULLBOX_COMMON;
-    lsmash_entry_list_t *list;
+    isom_table_t table;
 } isom_stsc_t;
 
 /* Chunk Offset Box
@@ -1294,7 +1309,7 @@ typedef struct
 typedef struct
 {
     ISOM_FULLBOX_COMMON;        /* type = 'stco': 32-bit chunk offsets / type = 'co64': 64-bit chunk offsets */
-    lsmash_entry_list_t *list;
+    isom_table_t table;
 
         uint8_t large_presentation;     /* Set 1 to this if 64-bit chunk-offset are needed. */
 } isom_stco_t;      /* share with co64 box */
@@ -1665,10 +1680,12 @@ typedef struct
 /** Caches for handling tracks **/
 typedef struct
 {
-    uint64_t alloc;             /* total buffer size for the pool */
-    uint64_t size;              /* total size of samples in the pool */
-    uint32_t sample_count;      /* number of samples in the pool */
-    uint8_t *data;              /* actual data of samples in the pool */
+    uint64_t           size;            /* total size of samples in the pool */
+    uint32_t           sample_count;    /* number of samples in the pool */
+    uint32_t           entry_count;     /* number of data blocks of samples in the pool */
+    uint32_t           alloc;           /* number of allocated entries for the data blocks */
+    lsmash_bs_iovec_t *data;            /* actual data of samples in the pool
+                                         * The data blocks of appended samples are held as they are without copying. */
 } isom_sample_pool_t;
 
 typedef struct
@@ -1848,7 +1865,7 @@ typedef struct
 {
     ISOM_BASEBOX_COMMON;
     isom_mehd_t         *mehd;          /* Movie Extends Header Box / omitted when used in live streaming */
-    lsmash_entry_list_t  trex_list;     /* Track Extends Box */
+    lsmash_vector_t      trex_list;     /* Track Extends Box */
 } isom_mvex_t;
 
 /* Movie Fragment Header Box
@@ -1942,7 +1959,9 @@ typedef struct
 {
     ISOM_BASEBOX_COMMON;
     isom_mfhd_t         *mfhd;          /* Movie Fragment Header Box */
-    lsmash_entry_list_t  traf_list;     /* Track Fragment Box List */
+    lsmash_vector_t      traf_list;     /* Track Fragment Box List */
+
+        lsmash_id_index_t traf_index;   /* Track Fragment Boxes looked up by track_ID */
 } isom_moof_t;
 
 /* Track Fragment Random Access Box
@@ -2003,6 +2022,8 @@ typedef struct
     ISOM_BASEBOX_COMMON;
     lsmash_entry_list_t  tfra_list;     /* Track Fragment Random Access Box */
     isom_mfro_t         *mfro;          /* Movie Fragment Random Access Offset Box */
+
+        lsmash_id_index_t tfra_index;   /* Track Fragment Random Access Boxes looked up by track_ID */
 } isom_mfra_t;
 
 /* Movie fragment manager
@@ -2047,6 +2068,8 @@ typedef struct
     isom_ctab_t         *ctab;          /* ISOM: null / QTFF: Color Table Box */
     isom_meta_t         *meta;          /* Meta Box */
     isom_mvex_t         *mvex;          /* Movie Extends Box */
+
+        lsmash_id_index_t trak_index;   /* Track Boxes looked up by track_ID */
 } isom_moov_t;
 
 /** Segments
@@ -2205,6 +2228,13 @@ typedef struct
 
 /** **/
 
+/* Extent of movie fragments indexed by the Segment Index Box or the Movie Fragment Random Access Box */
+typedef struct
+{
+    uint64_t pos;
+    uint64_t size;
+} isom_fragment_extent_t;
+
 /* File */
 struct lsmash_file_tag
 {
@@ -2214,7 +2244,7 @@ struct lsmash_file_tag
     lsmash_entry_list_t  styp_list;     /* Segment Type Box List */
     isom_moov_t         *moov;          /* Movie Box */
     lsmash_entry_list_t  sidx_list;     /* Segment Index Box List */
-    lsmash_entry_list_t  moof_list;     /* Movie Fragment Box List */
+    lsmash_vector_t      moof_list;     /* Movie Fragment Box List */
     lsmash_entry_list_t  emsg_list;     /* Event Message Box List */
     isom_mdat_t         *mdat;          /* Media Data Box */
     isom_meta_t         *meta;          /* Meta Box */
@@ -2223,7 +2253,10 @@ struct lsmash_file_tag
         lsmash_bs_t             *bs;        /* bytestream manager */
         isom_fragment_manager_t *fragment;  /* movie fragment manager */
         lsmash_entry_list_t     *print;
-        lsmash_entry_list_t     *timeline;
+        lsmash_entry_list_t     *fragment_extents;  /* list of the extents of movie fragments indexed but not read yet */
+        lsmash_arena_t          *arena;     /* allocator of the boxes in this file, present only for reading */
+        lsmash_vector_t         *timeline;
+        lsmash_id_index_t        timeline_index;    /* timelines looked up by track_ID */
         lsmash_file_t           *initializer;   /* A file containing the initialization information of whole movie including subsequent segments
                                                  * For ISOBMFF, an initializer corresponds to a file containing the 'moov' box.
                                                  * ROOT-to-initializer is designed to be a one-to-one relationship while initializer-to-file
@@ -2234,9 +2267,13 @@ struct lsmash_file_tag
         double    max_chunk_duration;       /* max duration per chunk in seconds */
         double    max_async_tolerance;      /* max tolerance, in seconds, for amount of interleaving asynchronization between tracks */
         uint64_t  max_chunk_size;           /* max size per chunk in bytes. */
+        uint64_t  movie_reserved_size;      /* the size of the space reserved for the Movie Box in front of the Media Data Box */
+        uint64_t  movie_reserved_pos;       /* the position of the reserved space */
         uint32_t  brand_count;
         uint32_t *compatible_brands;        /* the backup of the compatible brands in the File Type Box or the valid Segment Type Box */
         uint8_t   fake_file_mode;           /* If set to 1, the bytestream manager handles fake-file stream. */
+        uint8_t   read_lazily;              /* If set to 1, the entries of large table boxes and indexed movie fragments are read on demand. */
+        uint8_t   read_minimally;           /* If set to 1, each top-level box is read by the exact size, or only its header if skipped. */
         /* flags for compatibility */
 #define COMPAT_FLAGS_OFFSET offsetof( lsmash_file_t, qt_compatible )
         uint8_t qt_compatible;              /* compatibility with QuickTime file format */
@@ -2263,10 +2300,14 @@ typedef struct
 } fake_file_stream_t;
 
 /* ROOT */
+typedef struct isom_file_handle_cache_tag isom_file_handle_cache_t;
+
 struct lsmash_root_tag
 {
     ISOM_FULLBOX_COMMON;                    /* The 'file' field contains the address of the current active file. */
     lsmash_entry_list_t file_abstract_list; /* the list of all files the ROOT contains */
+    lsmash_sample_pool_t *sample_pool;      /* the pool of samples allocated for the ROOT */
+    isom_file_handle_cache_t *file_handle_cache;    /* the cache of the handles of the referenced files if any */
 };
 
 /** **/
@@ -2627,6 +2668,27 @@ void isom_bs_put_basebox_common( lsmash_bs_t *bs, isom_box_t *box );
 void isom_bs_put_fullbox_common( lsmash_bs_t *bs, isom_box_t *box );
 void isom_bs_put_box_common( lsmash_bs_t *bs, void *box );
 
+/* Sample table entries */
+void isom_table_init( isom_table_t *table, uint32_t entry_size );
+void isom_table_remove_entries( isom_table_t *table );
+int isom_table_reserve( isom_table_t *table, uint32_t entry_count );
+void *isom_table_add_entry( isom_table_t *table );
+void isom_table_remove_entry_tail( isom_table_t *table );
+void isom_table_move_entries( isom_table_t *dst, isom_table_t *src );
+
+/* Get the entry corresponding to a given entry number (1-origin) like lsmash_list_get_entry_data(). */
+static inline void *isom_table_get_entry( isom_table_t *table, uint32_t entry_number )
+{
+    if( !table || entry_number == 0 || entry_number > table->entry_count )
+        return NULL;
+    return (uint8_t *)table->data + (size_t)(entry_number - 1) * table->entry_size;
+}
+
+static inline void *isom_table_get_tail( isom_table_t *table )
+{
+    return table ? isom_table_get_entry( table, table->entry_count ) : NULL;
+}
+
 #define isom_is_printable_char( c ) ((c) >= 32 && (c) < 128)
 #define isom_is_printable_4cc( fourcc )                \
     (isom_is_printable_char( ((fourcc) >> 24) & 0xff ) \
@@ -2662,7 +2724,7 @@ uint32_t isom_get_sample_count
 
 isom_sample_pool_t *isom_create_sample_pool
 (
-    uint64_t size
+    uint32_t alloc
 );
 
 int isom_update_sample_tables
@@ -2673,6 +2735,12 @@ int isom_update_sample_tables
     isom_sample_entry_t *sample_entry
 );
 
+lsmash_sample_t *isom_create_sample
+(
+    lsmash_sample_pool_t *pool,
+    uint32_t              size
+);
+
 int isom_pool_sample
 (
     isom_sample_pool_t *pool,
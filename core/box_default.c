@@ -280,16 +280,19 @@ DEFINE_SIMPLE_CONTAINER_BOX_DEFAULT_CONSTANT( file_abstract, ftyp, moov, mdat, m
 
 
 /* Allocate box by default settings.
+ * If 'arena' is not NULL, the box is allocated from it instead of the heap.
  *
  * Use this function to allocate boxes as much as possible, it covers forgetful settings. */
 void *allocate_box_by_default
 (
-    const void  *nonexist_ptr,
-    const size_t data_type_size
+    const void     *nonexist_ptr,
+    const size_t    data_type_size,
+    lsmash_arena_t *arena
 )
 {
     assert( data_type_size >= offsetof( isom_box_t, manager ) + sizeof(((isom_box_t *)0)->manager) );
-    isom_box_t *box = (isom_box_t *)lsmash_memdup( nonexist_ptr, data_type_size );
+    isom_box_t *box = arena ? (isom_box_t *)lsmash_arena_memdup( arena, nonexist_ptr, data_type_size )
+                            : (isom_box_t *)lsmash_memdup( nonexist_ptr, data_type_size );
     if( !box )
         return (void *)nonexist_ptr;
     box->manager &= ~LSMASH_NON_EXISTING_BOX;
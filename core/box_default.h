@@ -21,8 +21,11 @@
 /* This file is available under an ISC license. */
 
 #define ALLOCATE_BOX( box_name ) \
+        ALLOCATE_BOX_IN_ARENA( box_name, NULL )
+#define ALLOCATE_BOX_IN_ARENA( box_name, arena ) \
     (isom_##box_name##_t *)allocate_box_by_default( &isom_##box_name##_box_default, \
-                                                    sizeof(isom_##box_name##_box_default) )
+                                                    sizeof(isom_##box_name##_box_default), \
+                                                    arena )
 
 #define  DEFINE_BOX_DEFAULT_CONSTANT( box_name )                            \
     extern const isom_##box_name##_t isom_##box_name##_box_default;         \
@@ -168,6 +171,7 @@ DEFINE_BOX_DEFAULT_CONSTANT( root_abstract )
 
 void *allocate_box_by_default
 (
-    const void  *nonexist_ptr,
-    const size_t data_type_size
+    const void     *nonexist_ptr,
+    const size_t    data_type_size,
+    lsmash_arena_t *arena
 );
@@ -25,14 +25,21 @@
 /* for _setmode() */
 #ifdef _WIN32
 #include <io.h>
+#else
+/* for writev() */
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
 #endif
 
 #include <string.h>
+#include <limits.h>
 #include <fcntl.h>
 
 #include "box.h"
 #include "read.h"
 #include "fragment.h"
+#include "timeline.h"
 
 #include "importer/importer.h"
 
@@ -233,21 +240,21 @@ int isom_check_mandatory_boxes
         if( file->qt_compatible && LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->hdlr ) )
             return LSMASH_ERR_INVALID_DATA;
         isom_stbl_t *stbl = trak->mdia->minf->stbl;
-        if( !stbl->stsd->list.head )
+        if( stbl->stsd->list.entry_count == 0 )
             return LSMASH_ERR_INVALID_DATA;
         if( !file->fragment
-         && (!stbl->stsd->list.head
-          || !stbl->stts->list || !stbl->stts->list->head
-          || !stbl->stsc->list || !stbl->stsc->list->head
-          || !stbl->stco->list || !stbl->stco->list->head) )
+         && (stbl->stsd->list.entry_count == 0
+          || stbl->stts->table.entry_count == 0
+          || stbl->stsc->table.entry_count == 0
+          || stbl->stco->table.entry_count == 0) )
             return LSMASH_ERR_INVALID_DATA;
     }
     if( !file->fragment )
         return 0;
     if( LSMASH_IS_NON_EXISTING_BOX( file->moov->mvex ) )
         return LSMASH_ERR_INVALID_DATA;
-    for( lsmash_entry_t *entry = file->moov->mvex->trex_list.head; entry; entry = entry->next )
-        if( LSMASH_IS_NON_EXISTING_BOX( (isom_trex_t *)entry->data ) )
+    for( uint32_t i = 1; i <= file->moov->mvex->trex_list.entry_count; i++ )
+        if( LSMASH_IS_NON_EXISTING_BOX( (isom_trex_t *)lsmash_vector_get_entry_data( &file->moov->mvex->trex_list, i ) ) )
             return LSMASH_ERR_INVALID_DATA;
     return 0;
 }
@@ -404,13 +411,152 @@ static int isom_set_brands
 }
 
 /*---- default I/O ----*/
-typedef struct
+typedef struct default_io_stream_tag default_io_stream_t;
+
+struct default_io_stream_tag
 {
-    FILE *file_ptr;
+    FILE *file_ptr;             /* NULL if closed by the file handle cache until the next access */
     int   is_standard_stream;   /* If set to 1, 'file_ptr' points to standard stream (i.e. stdin, stdout or stderr).
                                  * This flag prevents from accidentally closing standard streams. */
     lsmash_file_mode file_mode;
-} default_io_stream_t;
+    void    *map;               /* the mapped file if any */
+    uint64_t map_size;
+    lsmash_bs_readahead_t *readahead;   /* the read-ahead of the file if any */
+    lsmash_bs_writer_t    *writer;      /* the asynchronous writer of the file if any */
+    /* for reopening the file closed by the file handle cache */
+    char                     *filename;     /* the name of the file opened for reading */
+    uint64_t                  reopen_pos;   /* the position of the file when closed */
+    isom_file_handle_cache_t *cache;        /* the file handle cache managing the file if any */
+    lsmash_bs_t              *bs;           /* the bytestream whose buffer is released together when the file is closed */
+    default_io_stream_t      *prev;         /* the file accessed just more recently in the cache */
+    default_io_stream_t      *next;         /* the file accessed just less recently in the cache */
+};
+
+/* The file handle cache keeps at most 'max_open_count' referenced files open in the order of the access.
+ * The least recently accessed file is closed and its buffer is released when another file is reopened beyond the limit.
+ * The files must not be accessed concurrently since any access may close another file. */
+struct isom_file_handle_cache_tag
+{
+    uint32_t                         max_open_count;
+    default_io_stream_t             *head;  /* the most recently accessed file */
+    default_io_stream_t             *tail;  /* the least recently accessed file */
+    lsmash_file_handle_cache_stats_t stats;
+};
+
+static void file_handle_cache_unlink( isom_file_handle_cache_t *cache, default_io_stream_t *stream )
+{
+    if( stream->prev )
+        stream->prev->next = stream->next;
+    else
+        cache->head = stream->next;
+    if( stream->next )
+        stream->next->prev = stream->prev;
+    else
+        cache->tail = stream->prev;
+    stream->prev = NULL;
+    stream->next = NULL;
+}
+
+static void file_handle_cache_push_front( isom_file_handle_cache_t *cache, default_io_stream_t *stream )
+{
+    stream->prev = NULL;
+    stream->next = cache->head;
+    if( cache->head )
+        cache->head->prev = stream;
+    else
+        cache->tail = stream;
+    cache->head = stream;
+}
+
+/* Close a file managed by the file handle cache and release the buffer of its bytestream until the next access. */
+static void default_io_stream_suspend( default_io_stream_t *stream )
+{
+    isom_file_handle_cache_t *cache = stream->cache;
+    assert( cache && stream->file_ptr );
+    stream->reopen_pos = stream->bs ? lsmash_bs_release_buffer( stream->bs ) : (uint64_t)lsmash_ftell( stream->file_ptr );
+    fclose( stream->file_ptr );
+    stream->file_ptr = NULL;
+    cache->stats.open_count     -= 1;
+    cache->stats.eviction_count += 1;
+}
+
+/* Make a file available for the access, reopening it if closed by the file handle cache. */
+static int default_io_stream_resume( default_io_stream_t *stream )
+{
+    isom_file_handle_cache_t *cache = stream->cache;
+    if( cache && cache->head != stream )
+    {
+        file_handle_cache_unlink( cache, stream );
+        file_handle_cache_push_front( cache, stream );
+    }
+    if( stream->file_ptr )
+    {
+        if( cache )
+            cache->stats.hit_count += 1;
+        return 0;
+    }
+    if( !stream->filename )
+        return LSMASH_ERR_NAMELESS;
+    if( cache )
+    {
+        cache->stats.miss_count += 1;
+        /* Close the least recently accessed files to keep the limit. */
+        for( default_io_stream_t *lru = cache->tail; lru && cache->stats.open_count >= cache->max_open_count; lru = lru->prev )
+            if( lru->file_ptr )
+                default_io_stream_suspend( lru );
+    }
+    FILE *fp = lsmash_fopen( stream->filename, "rb" );
+    if( !fp )
+        return LSMASH_ERR_NAMELESS;
+    if( lsmash_fseek( fp, stream->reopen_pos, SEEK_SET ) != 0 )
+    {
+        fclose( fp );
+        return LSMASH_ERR_NAMELESS;
+    }
+    stream->file_ptr = fp;
+    if( cache )
+        cache->stats.open_count += 1;
+    return 0;
+}
+
+/* Let the file handle cache manage a file opened for reading.
+ * The file is closed here, and opened on the first access. */
+static void default_io_stream_enroll( default_io_stream_t *stream, isom_file_handle_cache_t *cache, lsmash_bs_t *bs )
+{
+    assert( !stream->cache && stream->file_ptr && stream->filename );
+    stream->reopen_pos = lsmash_ftell( stream->file_ptr );
+    fclose( stream->file_ptr );
+    stream->file_ptr = NULL;
+    stream->cache    = cache;
+    stream->bs       = bs;
+    file_handle_cache_push_front( cache, stream );
+    cache->stats.file_count += 1;
+}
+
+static void default_io_stream_withdraw( default_io_stream_t *stream )
+{
+    isom_file_handle_cache_t *cache = stream->cache;
+    if( !cache )
+        return;
+    file_handle_cache_unlink( cache, stream );
+    cache->stats.file_count -= 1;
+    if( stream->file_ptr )
+        cache->stats.open_count -= 1;
+    stream->cache = NULL;
+    stream->bs    = NULL;
+}
+
+void isom_destroy_file_handle_cache
+(
+    isom_file_handle_cache_t *cache
+)
+{
+    if( !cache )
+        return;
+    while( cache->head )
+        default_io_stream_withdraw( cache->head );
+    lsmash_free( cache );
+}
 
 static default_io_stream_t *default_io_stream_open( const char *filename, int open_mode )
 {
@@ -453,7 +599,20 @@ static default_io_stream_t *default_io_stream_open( const char *filename, int op
         }
     }
     else
+    {
         stream->file_ptr = lsmash_fopen( filename, mode );
+        /* Keep the name so that the file can be reopened after closed by the file handle cache. */
+        if( stream->file_ptr && open_mode == 1 )
+        {
+            size_t length = strlen( filename );
+            stream->filename = lsmash_memdup( filename, length + 1 );
+            if( !stream->filename )
+            {
+                fclose( stream->file_ptr );
+                stream->file_ptr = NULL;
+            }
+        }
+    }
     if( stream->file_ptr == NULL )
         lsmash_freep( &stream );
     return stream;
@@ -463,15 +622,30 @@ static int default_io_stream_close( default_io_stream_t *stream )
 {
     if( !stream )
         return 0;
-    int ret = stream->is_standard_stream ? 0 : fclose( stream->file_ptr );
+    lsmash_unmap_file( stream->map, stream->map_size );
+    /* Stop the read-ahead before closing the file. */
+    lsmash_bs_readahead_destroy( stream->readahead );
+    /* Complete the writes in background before closing the file. */
+    int ret = lsmash_bs_writer_destroy( stream->writer );
+    default_io_stream_withdraw( stream );
+    if( !stream->is_standard_stream && stream->file_ptr && fclose( stream->file_ptr ) != 0 )
+        ret = -1;
+    lsmash_free( stream->filename );
     lsmash_free( stream );
     return ret;
 }
 
 static int default_io_stream_read( void *opaque, uint8_t *buf, int size )
 {
-    int read_size = fread( buf, 1, size, ((default_io_stream_t *)opaque)->file_ptr );
-    return ferror( ((default_io_stream_t *)opaque)->file_ptr ) ? LSMASH_ERR_NAMELESS : read_size;
+    default_io_stream_t *stream = (default_io_stream_t *)opaque;
+    if( !stream->file_ptr || stream->cache )
+    {
+        int ret = default_io_stream_resume( stream );
+        if( ret < 0 )
+            return ret;
+    }
+    int read_size = fread( buf, 1, size, stream->file_ptr );
+    return ferror( stream->file_ptr ) ? LSMASH_ERR_NAMELESS : read_size;
 }
 
 static int default_io_stream_write( void *opaque, uint8_t *buf, int size )
@@ -481,11 +655,272 @@ static int default_io_stream_write( void *opaque, uint8_t *buf, int size )
 
 static int64_t default_io_stream_seek( void *opaque, int64_t offset, int whence )
 {
-    if( lsmash_fseek( ((default_io_stream_t *)opaque)->file_ptr, offset, whence ) != 0 )
+    default_io_stream_t *stream = (default_io_stream_t *)opaque;
+    if( !stream->file_ptr || stream->cache )
+    {
+        int ret = default_io_stream_resume( stream );
+        if( ret < 0 )
+            return ret;
+    }
+    if( lsmash_fseek( stream->file_ptr, offset, whence ) != 0 )
         return LSMASH_ERR_NAMELESS;
-    return lsmash_ftell( ((default_io_stream_t *)opaque)->file_ptr );
+    return lsmash_ftell( stream->file_ptr );
 }
 
+#ifndef _WIN32
+#define DEFAULT_IO_STREAM_IOV_COUNT 64
+static int64_t default_io_stream_writev( void *opaque, const lsmash_bs_iovec_t *vec, int count )
+{
+    /* Switch the active handle from the stream to the file descriptor, and get back after gather output.
+     * The stream must be flushed before the switch and repositioned after it. */
+    FILE   *fp     = ((default_io_stream_t *)opaque)->file_ptr;
+    int64_t offset = fflush( fp ) == 0 ? lsmash_ftell( fp ) : -1;
+    if( offset < 0 )
+        return LSMASH_ERR_NAMELESS;
+    int     fd    = fileno( fp );
+    int64_t total = 0;
+    struct iovec iov[DEFAULT_IO_STREAM_IOV_COUNT];
+    while( count > 0 )
+    {
+        int iov_count = LSMASH_MIN( count, DEFAULT_IO_STREAM_IOV_COUNT );
+        for( int i = 0; i < iov_count; i++ )
+        {
+            iov[i].iov_base = vec[i].data;
+            iov[i].iov_len  = vec[i].size;
+        }
+        vec   += iov_count;
+        count -= iov_count;
+        /* Retry until all the blocks in this batch are written. */
+        struct iovec *remain       = iov;
+        int           remain_count = iov_count;
+        while( remain_count > 0 )
+        {
+            ssize_t write_size = writev( fd, remain, remain_count );
+            if( write_size < 0 )
+            {
+                if( errno == EINTR )
+                    continue;
+                goto fail;
+            }
+            total += write_size;
+            while( remain_count > 0 && (size_t)write_size >= remain->iov_len )
+            {
+                write_size -= remain->iov_len;
+                ++remain;
+                --remain_count;
+            }
+            if( remain_count > 0 )
+            {
+                remain->iov_base = (uint8_t *)remain->iov_base + write_size;
+                remain->iov_len -= write_size;
+            }
+        }
+    }
+    if( lsmash_fseek( fp, offset + total, SEEK_SET ) != 0 )
+        return LSMASH_ERR_NAMELESS;
+    return total;
+fail:
+    lsmash_fseek( fp, offset + total, SEEK_SET );
+    return LSMASH_ERR_NAMELESS;
+}
+#undef DEFAULT_IO_STREAM_IOV_COUNT
+#endif
+
+static const uint8_t *default_io_stream_map( default_io_stream_t *stream, uint64_t *size )
+{
+    if( !stream->map )
+    {
+        if( stream->is_standard_stream
+         || stream->cache
+         || !(stream->file_mode & LSMASH_FILE_MODE_READ) )
+            return NULL;
+        stream->map = lsmash_map_file( stream->file_ptr, &stream->map_size );
+        if( !stream->map )
+            return NULL;
+    }
+    *size = stream->map_size;
+    return (const uint8_t *)stream->map;
+}
+
+/* Copy 'size' bytes from 'src' to 'dst' in the file through 'buf'. */
+static int default_io_stream_copy( FILE *fp, uint64_t src, uint64_t dst, size_t size, uint8_t *buf )
+{
+    if( lsmash_fseek( fp, src, SEEK_SET ) != 0
+     || fread( buf, 1, size, fp ) != size
+     || lsmash_fseek( fp, dst, SEEK_SET ) != 0
+     || fwrite( buf, 1, size, fp ) != size )
+        return LSMASH_ERR_NAMELESS;
+    return 0;
+}
+
+static default_io_stream_t *isom_get_default_io_stream( lsmash_file_t *file )
+{
+    lsmash_bs_t *bs = file->bs;
+    if( !bs
+     || bs->write != default_io_stream_write
+     || ((default_io_stream_t *)bs->stream)->is_standard_stream )
+        return NULL;
+    return (default_io_stream_t *)bs->stream;
+}
+
+uint64_t isom_get_data_insertion_unit
+(
+    lsmash_file_t *file
+)
+{
+    default_io_stream_t *stream = isom_get_default_io_stream( file );
+    return stream ? lsmash_get_file_insertion_unit( stream->file_ptr ) : 0;
+}
+
+int isom_get_file_status
+(
+    lsmash_file_t *file,
+    uint64_t      *size,
+    int64_t       *mtime
+)
+{
+    default_io_stream_t *stream = isom_get_default_io_stream( file );
+    if( !stream || !stream->file_ptr )
+        return LSMASH_ERR_PATCH_WELCOME;
+    return lsmash_get_file_status( stream->file_ptr, size, mtime );
+}
+
+int isom_remap_file
+(
+    lsmash_file_t *file
+)
+{
+    lsmash_bs_t *bs = file->bs;
+    if( !bs || !bs->buffer.mapped )
+        return 0;
+    default_io_stream_t *stream = isom_get_default_io_stream( file );
+    if( !stream || !stream->map || !stream->file_ptr )
+        return LSMASH_ERR_PATCH_WELCOME;
+    uint64_t size;
+    int64_t  mtime;
+    int err = lsmash_get_file_status( stream->file_ptr, &size, &mtime );
+    if( err < 0 )
+        return err;
+    if( size == stream->map_size )
+        return 0;
+    /* Map the new one before unmapping the current one so that the current one is kept if failed. */
+    void *map = lsmash_map_file( stream->file_ptr, &size );
+    if( !map )
+        return LSMASH_ERR_NAMELESS;
+    lsmash_unmap_file( stream->map, stream->map_size );
+    stream->map      = map;
+    stream->map_size = size;
+    return lsmash_bs_set_mapped_stream( bs, map, size );
+}
+
+#define ISOM_SHIFT_DATA_MIN_COPY_SIZE    ( 1 * 1024 * 1024)
+#define ISOM_SHIFT_DATA_MAX_COPY_SIZE    (64 * 1024 * 1024)
+#define ISOM_SHIFT_DATA_BUFFER_SIZE      ( 4 * 1024 * 1024)
+int isom_shift_data
+(
+    lsmash_file_t        *file,
+    lsmash_adhoc_remux_t *remux,
+    uint64_t              pos,
+    uint64_t              size,
+    int                   in_place_only
+)
+{
+    assert( remux );
+    default_io_stream_t *stream = isom_get_default_io_stream( file );
+    if( !stream )
+        return 0;
+    /* Complete all the writes through the bytestream, and then get the end of the file. */
+    lsmash_bs_t *bs  = file->bs;
+    FILE        *fp  = stream->file_ptr;
+    int          err = lsmash_bs_flush_buffer( bs );
+    if( err < 0 )
+        return err;
+    int64_t end = lsmash_bs_write_seek( bs, 0, SEEK_END );
+    if( end < 0 )
+        return end;
+    if( fflush( fp ) != 0 )
+        return LSMASH_ERR_NAMELESS;
+    if( size == 0 || pos >= (uint64_t)end )
+        return 1;
+    uint64_t total = end - pos;
+    uint64_t unit  = lsmash_get_file_insertion_unit( fp );
+    uint8_t *buf   = NULL;
+    if( unit && size % unit == 0 )
+    {
+        /* Insert the room at the offset aligned to the unit in place,
+         * and then get back the data which was between the offset and 'pos' but moved together. */
+        uint64_t head = pos % unit;
+        err = lsmash_insert_file_range( fp, pos - head, size );
+        if( err == 0 )
+        {
+            if( head )
+            {
+                if( (buf = lsmash_malloc( head )) == NULL )
+                    return LSMASH_ERR_MEMORY_ALLOC;
+                if( (err = default_io_stream_copy( fp, pos - head + size, pos - head, head, buf )) < 0 )
+                    goto fail;
+            }
+            if( remux->func )
+                remux->func( remux->param, total, total );
+            goto done;
+        }
+        else if( err != LSMASH_ERR_PATCH_WELCOME )
+            return err;
+    }
+    if( in_place_only )
+        return 0;
+    /* Copy backward from the end so that no data is overwritten before copied.
+     * Each piece is aligned to the unit if available.
+     * The pieces copied inside the kernel are no larger than 'size' since their source and destination must not overlap,
+     * so too small 'size' makes too many copies, and then copy through the memory instead. */
+    int      in_kernel = size >= ISOM_SHIFT_DATA_MIN_COPY_SIZE;
+    uint64_t piece     = LSMASH_MIN( size, ISOM_SHIFT_DATA_MAX_COPY_SIZE );
+    uint64_t src_end   = end;
+    while( src_end > pos )
+    {
+        if( !in_kernel && !buf )
+        {
+            piece = LSMASH_MIN( remux->buffer_size ? remux->buffer_size : ISOM_SHIFT_DATA_BUFFER_SIZE, SIZE_MAX );
+            if( (buf = lsmash_malloc( piece )) == NULL )
+                return LSMASH_ERR_MEMORY_ALLOC;
+        }
+        if( unit && piece > unit )
+            piece -= piece % unit;
+        uint64_t src      = LSMASH_MAX( pos, ((src_end - 1) / piece) * piece );
+        uint64_t src_size = src_end - src;
+        if( in_kernel )
+        {
+            int64_t ret = lsmash_copy_file_range( fp, src, src + size, src_size );
+            if( ret == LSMASH_ERR_PATCH_WELCOME )
+            {
+                /* Fall back to the copies through the memory. */
+                in_kernel = 0;
+                continue;
+            }
+            if( ret < 0 || (uint64_t)ret != src_size )
+                return ret < 0 ? ret : LSMASH_ERR_NAMELESS;
+        }
+        else if( (err = default_io_stream_copy( fp, src, src + size, src_size, buf )) < 0 )
+            goto fail;
+        src_end = src;
+        if( remux->func )
+            remux->func( remux->param, end - src_end, total );
+    }
+done:
+    lsmash_free( buf );
+    if( fflush( fp ) != 0 )
+        return LSMASH_ERR_NAMELESS;
+    /* The file got larger. */
+    bs->written = LSMASH_MAX( bs->written, end + size );
+    return 1;
+fail:
+    lsmash_free( buf );
+    return err;
+}
+#undef ISOM_SHIFT_DATA_MIN_COPY_SIZE
+#undef ISOM_SHIFT_DATA_MAX_COPY_SIZE
+#undef ISOM_SHIFT_DATA_BUFFER_SIZE
+
 /*******************************
     public interfaces
 *******************************/
@@ -498,6 +933,8 @@ void lsmash_discard_boxes
     if( LSMASH_IS_NON_EXISTING_BOX( root )
      || LSMASH_IS_NON_EXISTING_BOX( root->file ) )
         return;
+    /* The lazy timelines refer to the sample tables which are going to be deallocated. */
+    isom_expand_lazy_timelines( root->file );
     isom_remove_all_extension_boxes( &root->file->extensions );
 }
 
@@ -526,7 +963,50 @@ int lsmash_open_file
     param->max_chunk_duration  = 0.5;
     param->max_async_tolerance = 2.0;
     param->max_chunk_size      = 4 * 1024 * 1024;
+    param->write_async         = 0;
     param->max_read_size       = 4 * 1024 * 1024;
+    param->read_mmap           = 0;
+    param->read_ahead          = 0;
+    param->read_lazily         = 0;
+    param->read_minimally      = 0;
+    return 0;
+}
+
+int lsmash_set_file_handle_cache
+(
+    lsmash_root_t *root,
+    uint32_t       max_open_files
+)
+{
+    if( LSMASH_IS_NON_EXISTING_BOX( root ) || max_open_files == 0 )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    isom_file_handle_cache_t *cache = root->file_handle_cache;
+    if( !cache )
+    {
+        cache = lsmash_malloc_zero( sizeof(isom_file_handle_cache_t) );
+        if( !cache )
+            return LSMASH_ERR_MEMORY_ALLOC;
+        root->file_handle_cache = cache;
+    }
+    cache->max_open_count = max_open_files;
+    /* Close the least recently accessed files beyond the new limit. */
+    for( default_io_stream_t *lru = cache->tail; lru && cache->stats.open_count > cache->max_open_count; lru = lru->prev )
+        if( lru->file_ptr )
+            default_io_stream_suspend( lru );
+    return 0;
+}
+
+int lsmash_get_file_handle_cache_stats
+(
+    lsmash_root_t                    *root,
+    lsmash_file_handle_cache_stats_t *stats
+)
+{
+    if( LSMASH_IS_NON_EXISTING_BOX( root ) || !stats )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    if( !root->file_handle_cache )
+        return LSMASH_ERR_NAMELESS;
+    *stats = root->file_handle_cache->stats;
     return 0;
 }
 
@@ -563,10 +1043,64 @@ lsmash_file_t *lsmash_set_file
     file->bs->write           = param->write;
     file->bs->seek            = param->seek;
     file->bs->unseekable      = (param->seek == NULL);
+#ifndef _WIN32
+    if( param->write == default_io_stream_write
+     && !((default_io_stream_t *)param->opaque)->is_standard_stream )
+        file->bs->writev = default_io_stream_writev;
+#endif
     file->bs->buffer.max_size = param->max_read_size;
     file->max_chunk_duration  = param->max_chunk_duration;
     file->max_async_tolerance = LSMASH_MAX( param->max_async_tolerance, 2 * param->max_chunk_duration );
     file->max_chunk_size      = param->max_chunk_size;
+    file->read_lazily         = param->read_lazily && !file->bs->unseekable;
+    /* A file referenced by the ROOT is opened only while accessed recently if the file handle cache is set. */
+    int cached = root->file_handle_cache
+              && LSMASH_IS_EXISTING_BOX( root->file )
+              && param->read == default_io_stream_read
+              && (file->flags & LSMASH_FILE_MODE_MEDIA)
+              && !(file->flags & LSMASH_FILE_MODE_WRITE)
+              && ((default_io_stream_t *)param->opaque)->filename
+              && !((default_io_stream_t *)param->opaque)->cache;
+    if( (file->flags & (LSMASH_FILE_MODE_READ | LSMASH_FILE_MODE_DUMP))
+     && !(file->flags & LSMASH_FILE_MODE_WRITE) )
+    {
+        if( param->read_mmap && param->read == default_io_stream_read && !cached )
+        {
+            /* Read the file opened by lsmash_open_file() through its mapping if available.
+             * Otherwise, fall back to buffered reads. */
+            uint64_t       map_size;
+            const uint8_t *map = default_io_stream_map( (default_io_stream_t *)param->opaque, &map_size );
+            if( map && lsmash_bs_set_mapped_stream( bs, map, map_size ) < 0 )
+                goto fail;
+        }
+        /* Nothing to be minimized if the file is mapped since it is never read. */
+        file->read_minimally = param->read_minimally && !bs->unseekable && !bs->buffer.mapped;
+        if( param->read_ahead && param->read == default_io_stream_read && !bs->buffer.mapped && !cached
+         && !file->read_minimally )
+        {
+            /* The read-ahead is owned by the file opened by lsmash_open_file() so that it is stopped before closing.
+             * If failed to create, just read synchronously. */
+            default_io_stream_t *stream = (default_io_stream_t *)param->opaque;
+            if( !stream->readahead )
+                stream->readahead = lsmash_bs_readahead_create( LSMASH_MIN( param->max_read_size, INT_MAX ) );
+            bs->readahead = stream->readahead;
+        }
+        /* Boxes read from a file basically live until the file is freed,
+         * so allocate them from the arena of the file instead of one by one from the heap. */
+        file->arena = lsmash_arena_create();
+        if( !file->arena )
+            goto fail;
+    }
+    if( (file->flags & LSMASH_FILE_MODE_WRITE)
+     && param->write_async && param->write == default_io_stream_write )
+    {
+        /* The writer is owned by the file opened by lsmash_open_file() so that all the writes are completed before closing.
+         * If failed to create, just write synchronously. */
+        default_io_stream_t *stream = (default_io_stream_t *)param->opaque;
+        if( !stream->writer )
+            stream->writer = lsmash_bs_writer_create( LSMASH_MIN( 4 * param->max_chunk_size, SIZE_MAX ) );
+        bs->writer = stream->writer;
+    }
     if( (file->flags & LSMASH_FILE_MODE_WRITE)
      && (file->flags & LSMASH_FILE_MODE_BOX) )
     {
@@ -599,6 +1133,8 @@ lsmash_file_t *lsmash_set_file
         if( (file->flags & LSMASH_FILE_MODE_INITIALIZATION) && !isom_movie_create( file ) )
             goto fail;
     }
+    if( cached )
+        default_io_stream_enroll( (default_io_stream_t *)param->opaque, root->file_handle_cache, bs );
     if( LSMASH_IS_NON_EXISTING_BOX( root->file ) )
         root->file = file;
     return file;
@@ -624,7 +1160,8 @@ int64_t lsmash_read_file
         if( !importer )
             return (int64_t)LSMASH_ERR_MEMORY_ALLOC;
         lsmash_importer_set_file( importer, file );
-        ret = lsmash_importer_find( importer, "ISOBMFF/QTFF", !file->bs->unseekable );
+        /* Any detection of the other formats is skipped to avoid the reads for it if minimal reads are requested. */
+        ret = lsmash_importer_find( importer, "ISOBMFF/QTFF", !file->bs->unseekable && !file->read_minimally );
         if( ret < 0 )
             return ret;
         if( param )
@@ -659,6 +1196,16 @@ int64_t lsmash_read_file
     return ret;
 }
 
+uint64_t lsmash_count_read_bytes
+(
+    lsmash_file_t *file
+)
+{
+    if( LSMASH_IS_NON_EXISTING_BOX( file ) || !file->bs )
+        return 0;
+    return file->bs->read_size;
+}
+
 int lsmash_activate_file
 (
     lsmash_root_t *root,
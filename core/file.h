@@ -41,3 +41,50 @@ int isom_rearrange_data
     uint64_t              write_pos,
     uint64_t              file_size
 );
+
+/* Get the unit of the size by which isom_shift_data() may move the data in place, i.e. without any copy.
+ * The move in place may still fail even if not 0.
+ * Return 0 if not available. */
+uint64_t isom_get_data_insertion_unit
+(
+    lsmash_file_t *file
+);
+
+/* Map the file read through its mapping again if its size has changed, so that the data appended to it can be read.
+ * The current mapping is kept if failed.
+ * Return 0 if successful or the file is not mapped. */
+int isom_remap_file
+(
+    lsmash_file_t *file
+);
+
+/* Get the size and the last modification time of the file opened by lsmash_open_file().
+ * Return LSMASH_ERR_PATCH_WELCOME if not available, e.g. for a standard stream. */
+int isom_get_file_status
+(
+    lsmash_file_t *file,
+    uint64_t      *size,
+    int64_t       *mtime
+);
+
+/* Move the data from 'pos' to the end of the file toward the end by 'size' bytes,
+ * so that the room of 'size' bytes from 'pos' can be overwritten.
+ * The data is moved in place by the file system if available and 'size' is a multiple of its unit,
+ * by copies inside the kernel if available, and by large backward copies through the memory otherwise.
+ * If 'in_place_only' is set to 1, nothing is done unless the data is moved in place.
+ * Return 1 if done, 0 if the file is not the one opened by lsmash_open_file() or nothing is done, and a negative value if failed. */
+int isom_shift_data
+(
+    lsmash_file_t        *file,
+    lsmash_adhoc_remux_t *remux,
+    uint64_t              pos,
+    uint64_t              size,
+    int                   in_place_only
+);
+
+/* Destroy a file handle cache of a ROOT.
+ * The files managed by the cache are left as they are, and reopened by themselves if needed. */
+void isom_destroy_file_handle_cache
+(
+    isom_file_handle_cache_t *cache
+);
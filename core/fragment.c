@@ -76,8 +76,8 @@ int lsmash_create_fragment_movie( lsmash_root_t *root )
         if( file->moof_list.entry_count == 1 )
             return 0;
         /* Remove the previous movie fragment. */
-        if( file->moof_list.head )
-            isom_remove_box_by_itself( file->moof_list.head->data );
+        if( file->moof_list.entry_count )
+            isom_remove_box_by_itself( lsmash_vector_get_entry_data( &file->moof_list, 1 ) );
     }
     return 0;
 }
@@ -152,9 +152,9 @@ static int isom_write_fragment_random_access_info( lsmash_file_t *file )
     uint32_t movie_timescale = lsmash_get_movie_timescale( file->root );
     if( movie_timescale == 0 )
         return LSMASH_ERR_NAMELESS; /* Division by zero will occur. */
-    for( lsmash_entry_t *trex_entry = file->moov->mvex->trex_list.head; trex_entry; trex_entry = trex_entry->next )
+    for( uint32_t i = 1; i <= file->moov->mvex->trex_list.entry_count; i++ )
     {
-        isom_trex_t *trex = (isom_trex_t *)trex_entry->data;
+        isom_trex_t *trex = (isom_trex_t *)lsmash_vector_get_entry_data( &file->moov->mvex->trex_list, i );
         if( LSMASH_IS_NON_EXISTING_BOX( trex ) )
             return LSMASH_ERR_NAMELESS;
         /* Get the edit list of the track associated with the trex->track_ID.
@@ -274,6 +274,30 @@ static int isom_update_indexed_material_offset
     return 0;
 }
 
+/* Update 'moof_offset' of each entry within the Track Fragment Random Access Boxes. */
+static void isom_add_preceding_size_to_tfra
+(
+    lsmash_file_t *file,
+    uint64_t       preceding_size
+)
+{
+    if( !file->mfra )
+        return;
+    for( lsmash_entry_t *entry = file->mfra->tfra_list.head; entry; entry = entry->next )
+    {
+        isom_tfra_t *tfra = (isom_tfra_t *)entry->data;
+        if( LSMASH_IS_NON_EXISTING_BOX( tfra ) )
+            continue;
+        for( lsmash_entry_t *rap_entry = tfra->list->head; rap_entry; rap_entry = rap_entry->next )
+        {
+            isom_tfra_location_time_entry_t *rap = (isom_tfra_location_time_entry_t *)rap_entry->data;
+            if( !rap )
+                continue;
+            rap->moof_offset += preceding_size;
+        }
+    }
+}
+
 static int isom_write_segment_indexes
 (
     lsmash_file_t        *file,
@@ -293,6 +317,30 @@ static int isom_write_segment_indexes
             continue;
         total_sidx_size += sidx->size;
     }
+    /* Move the subsequent data outside the bytestream if available. */
+    lsmash_bs_t *bs = file->bs;
+    int64_t ret64;
+    if( (ret = isom_shift_data( file, remux, file->fragment->first_moof_pos, total_sidx_size, 0 )) < 0 )
+        return ret;
+    if( ret == 1 )
+    {
+        if( (ret64 = lsmash_bs_write_seek( bs, file->fragment->first_moof_pos, SEEK_SET )) < 0 )
+            return ret64;
+        for( lsmash_entry_t *entry = file->sidx_list.head; entry; entry = entry->next )
+        {
+            isom_sidx_t *sidx = (isom_sidx_t *)entry->data;
+            if( LSMASH_IS_NON_EXISTING_BOX( sidx ) )
+                continue;
+            if( (ret = isom_write_box( bs, (isom_box_t *)sidx )) < 0 )
+                return ret;
+        }
+        /* Get back to the end of the file for boxes written later. */
+        if( (ret64 = lsmash_bs_write_seek( bs, 0, SEEK_END )) < 0 )
+            return ret64;
+        file->size += total_sidx_size;
+        isom_add_preceding_size_to_tfra( file, total_sidx_size );
+        return 0;
+    }
     /* The buffer size must be at least total_sidx_size * 2. */
     size_t buffer_size = total_sidx_size * 2;
     if( remux->buffer_size > buffer_size )
@@ -304,8 +352,6 @@ static int isom_write_segment_indexes
     size_t size = buffer_size / 2;
     buf[1] = buf[0] + size;
     /* Seek to the beginning of the first Movie Fragment Box i.e. the first subsegment within this media segment. */
-    lsmash_bs_t *bs = file->bs;
-    int64_t ret64;
     if( (ret64 = lsmash_bs_write_seek( bs, file->fragment->first_moof_pos, SEEK_SET )) < 0 )
     {
         ret = ret64;
@@ -335,21 +381,7 @@ static int isom_write_segment_indexes
         goto fail;
     file->size += total_sidx_size;
     lsmash_freep( &buf[0] );
-    /* Update 'moof_offset' of each entry within the Track Fragment Random Access Boxes. */
-    if( file->mfra )
-        for( lsmash_entry_t *entry = file->mfra->tfra_list.head; entry; entry = entry->next )
-        {
-            isom_tfra_t *tfra = (isom_tfra_t *)entry->data;
-            if( LSMASH_IS_NON_EXISTING_BOX( tfra ) )
-                continue;
-            for( lsmash_entry_t *rap_entry = tfra->list->head; rap_entry; rap_entry = rap_entry->next )
-            {
-                isom_tfra_location_time_entry_t *rap = (isom_tfra_location_time_entry_t *)rap_entry->data;
-                if( !rap )
-                    continue;
-                rap->moof_offset += total_sidx_size;
-            }
-        }
+    isom_add_preceding_size_to_tfra( file, total_sidx_size );
     return 0;
 fail:
     lsmash_free( buf[0] );
@@ -416,11 +448,8 @@ static int isom_create_fragment_overall_default_settings( lsmash_file_t *file )
          || !trak->cache )
             return LSMASH_ERR_NAMELESS;
         isom_stbl_t *stbl = trak->mdia->minf->stbl;
-        if( !stbl->stts->list
-         || (stbl->stts->list->tail && !stbl->stts->list->tail->data)
-         || (LSMASH_IS_NON_EXISTING_BOX( stbl->stsz ) && LSMASH_IS_NON_EXISTING_BOX( stbl->stz2 ))
-         || (LSMASH_IS_EXISTING_BOX( stbl->stsz ) && stbl->stsz->list && stbl->stsz->list->head && !stbl->stsz->list->head->data)
-         || (LSMASH_IS_EXISTING_BOX( stbl->stz2 ) && stbl->stz2->list && stbl->stz2->list->head && !stbl->stz2->list->head->data))
+        if( LSMASH_IS_NON_EXISTING_BOX( stbl->stts )
+         || (LSMASH_IS_NON_EXISTING_BOX( stbl->stsz ) && LSMASH_IS_NON_EXISTING_BOX( stbl->stz2 )) )
             return LSMASH_ERR_NAMELESS;
         isom_trex_t *trex = isom_add_trex( file->moov->mvex );
         if( LSMASH_IS_NON_EXISTING_BOX( trex ) )
@@ -430,11 +459,12 @@ static int isom_create_fragment_overall_default_settings( lsmash_file_t *file )
         trex->default_sample_description_index = trak->cache->chunk.sample_description_index
                                                ? trak->cache->chunk.sample_description_index
                                                : 1;
-        trex->default_sample_duration          = stbl->stts->list->tail
-                                               ? ((isom_stts_entry_t *)stbl->stts->list->tail->data)->sample_delta
+        isom_stts_entry_t *last_stts_data      = isom_table_get_tail( &stbl->stts->table );
+        trex->default_sample_duration          = last_stts_data
+                                               ? last_stts_data->sample_delta
                                                : 1;
         trex->default_sample_size              = isom_get_first_sample_size( stbl );
-        if( stbl->sdtp->list )
+        if( LSMASH_IS_EXISTING_BOX( stbl->sdtp ) )
         {
             struct sample_flags_stats_t
             {
@@ -443,15 +473,13 @@ static int isom_create_fragment_overall_default_settings( lsmash_file_t *file )
                 uint32_t sample_is_depended_on[4];
                 uint32_t sample_has_redundancy[4];
             } stats = { { 0 }, { 0 }, { 0 }, { 0 } };
-            for( lsmash_entry_t *sdtp_entry = stbl->sdtp->list->head; sdtp_entry; sdtp_entry = sdtp_entry->next )
+            isom_sdtp_entry_t *data = (isom_sdtp_entry_t *)stbl->sdtp->table.data;
+            for( uint32_t n = 0; n < stbl->sdtp->table.entry_count; n++ )
             {
-                isom_sdtp_entry_t *data = (isom_sdtp_entry_t *)sdtp_entry->data;
-                if( !data )
-                    return LSMASH_ERR_NAMELESS;
-                ++ stats.is_leading           [ data->is_leading            ];
-                ++ stats.sample_depends_on    [ data->sample_depends_on     ];
-                ++ stats.sample_is_depended_on[ data->sample_is_depended_on ];
-                ++ stats.sample_has_redundancy[ data->sample_has_redundancy ];
+                ++ stats.is_leading           [ data[n].is_leading            ];
+                ++ stats.sample_depends_on    [ data[n].sample_depends_on     ];
+                ++ stats.sample_is_depended_on[ data[n].sample_is_depended_on ];
+                ++ stats.sample_has_redundancy[ data[n].sample_has_redundancy ];
             }
             uint32_t most_used[4] = { 0, 0, 0, 0 };
             for( int i = 0; i < 4; i++ )
@@ -629,9 +657,9 @@ static int isom_make_segment_index_entry
 )
 {
     /* Make the index of this subsegment. */
-    for( lsmash_entry_t *entry = moof->traf_list.head; entry; entry = entry->next )
+    for( uint32_t i = 1; i <= moof->traf_list.entry_count; i++ )
     {
-        isom_traf_t       *traf           = (isom_traf_t *)entry->data;
+        isom_traf_t       *traf           = (isom_traf_t *)lsmash_vector_get_entry_data( &moof->traf_list, i );
         isom_tfhd_t       *tfhd           = traf->tfhd;
         isom_fragment_t   *track_fragment = traf->cache->fragment;
         isom_subsegment_t *subsegment     = &track_fragment->subsegment;
@@ -837,14 +865,13 @@ static int isom_finish_fragment_movie
     }
     /* Don't write the current movie fragment if containing no track fragments.
      * This is a requirement of DASH Media Segment. */
-    if( !moof->traf_list.head
-     || !moof->traf_list.head->data )
+    if( !lsmash_vector_get_entry_data( &moof->traf_list, 1 ) )
         return 0;
     /* Calculate appropriate default_sample_flags of each Track Fragment Header Box.
      * And check whether that default_sample_flags is useful or not. */
-    for( lsmash_entry_t *entry = moof->traf_list.head; entry; entry = entry->next )
+    for( uint32_t traf_number = 1; traf_number <= moof->traf_list.entry_count; traf_number++ )
     {
-        isom_traf_t *traf = (isom_traf_t *)entry->data;
+        isom_traf_t *traf = (isom_traf_t *)lsmash_vector_get_entry_data( &moof->traf_list, traf_number );
         if( LSMASH_IS_NON_EXISTING_BOX( traf )
          || LSMASH_IS_NON_EXISTING_BOX( traf->tfhd )
          || LSMASH_IS_NON_EXISTING_BOX( traf->file->initializer->moov->mvex ) )
@@ -973,9 +1000,9 @@ static int isom_finish_fragment_movie
     }
     /* Complete the last sample groups in the previous track fragments. */
     int ret;
-    for( lsmash_entry_t *entry = moof->traf_list.head; entry; entry = entry->next )
+    for( uint32_t i = 1; i <= moof->traf_list.entry_count; i++ )
     {
-        isom_traf_t *traf = (isom_traf_t *)entry->data;
+        isom_traf_t *traf = (isom_traf_t *)lsmash_vector_get_entry_data( &moof->traf_list, i );
         assert( LSMASH_IS_EXISTING_BOX( traf ) );
         if( traf->cache->rap )
         {
@@ -1032,9 +1059,9 @@ static int isom_finish_fragment_movie
          * In contrast, implicit base_data_offsets indicated by default-base-is-moof are simple since the base_data_offset
          * of each track fragment is always constant for that pair and has no dependency on other track fragments.
          */
-        for( lsmash_entry_t *entry = moof->traf_list.head; entry; entry = entry->next )
+        for( uint32_t i = 1; i <= moof->traf_list.entry_count; i++ )
         {
-            isom_traf_t *traf = (isom_traf_t *)entry->data;
+            isom_traf_t *traf = (isom_traf_t *)lsmash_vector_get_entry_data( &moof->traf_list, i );
             assert( LSMASH_IS_EXISTING_BOX( traf ) );
             traf->tfhd->flags           |= ISOM_TF_FLAGS_DEFAULT_BASE_IS_MOOF;
             traf->tfhd->base_data_offset = file->size;  /* not written actually though */
@@ -1050,9 +1077,9 @@ static int isom_finish_fragment_movie
         if( isom_update_box_size( moof ) == 0 )
             return LSMASH_ERR_NAMELESS;
         /* Now, we can calculate offsets in the current movie fragment, so do it. */
-        for( lsmash_entry_t *entry = moof->traf_list.head; entry; entry = entry->next )
+        for( uint32_t i = 1; i <= moof->traf_list.entry_count; i++ )
         {
-            isom_traf_t *traf = (isom_traf_t *)entry->data;
+            isom_traf_t *traf = (isom_traf_t *)lsmash_vector_get_entry_data( &moof->traf_list, i );
             assert( LSMASH_IS_EXISTING_BOX( traf ) );
             for( lsmash_entry_t *trun_entry = traf->trun_list.head; trun_entry; trun_entry = trun_entry->next )
             {
@@ -1065,9 +1092,9 @@ static int isom_finish_fragment_movie
     else
     {
         /* In this branch, we use explicit base_data_offset. */
-        for( lsmash_entry_t *entry = moof->traf_list.head; entry; entry = entry->next )
+        for( uint32_t i = 1; i <= moof->traf_list.entry_count; i++ )
         {
-            isom_traf_t *traf = (isom_traf_t *)entry->data;
+            isom_traf_t *traf = (isom_traf_t *)lsmash_vector_get_entry_data( &moof->traf_list, i );
             assert( LSMASH_IS_EXISTING_BOX( traf ) );
             traf->tfhd->flags |= ISOM_TF_FLAGS_BASE_DATA_OFFSET_PRESENT;
         }
@@ -1075,9 +1102,9 @@ static int isom_finish_fragment_movie
         if( isom_update_box_size( moof ) == 0 )
             return LSMASH_ERR_NAMELESS;
         /* Now, we can calculate offsets in the current movie fragment, so do it. */
-        for( lsmash_entry_t *entry = moof->traf_list.head; entry; entry = entry->next )
+        for( uint32_t i = 1; i <= moof->traf_list.entry_count; i++ )
         {
-            isom_traf_t *traf = (isom_traf_t *)entry->data;
+            isom_traf_t *traf = (isom_traf_t *)lsmash_vector_get_entry_data( &moof->traf_list, i );
             assert( LSMASH_IS_EXISTING_BOX( traf ) );
             traf->tfhd->base_data_offset = file->size + moof->size + ISOM_BASEBOX_COMMON_SIZE;
         }
@@ -1093,9 +1120,9 @@ static int isom_finish_fragment_movie
     if( (ret = isom_output_fragment_media_data( file )) < 0 )
         return ret;
     /* Revert the number of samples in track fragments to 0. */
-    for( lsmash_entry_t *entry = moof->traf_list.head; entry; entry = entry->next )
+    for( uint32_t i = 1; i <= moof->traf_list.entry_count; i++ )
     {
-        isom_traf_t *traf = (isom_traf_t *)entry->data;
+        isom_traf_t *traf = (isom_traf_t *)lsmash_vector_get_entry_data( &moof->traf_list, i );
         assert( LSMASH_IS_EXISTING_BOX( traf ) );
         if( traf->cache->fragment )
             isom_fragment_reset_sample_counts( traf->cache );
@@ -1248,7 +1275,7 @@ int isom_append_fragment_track_run
         return LSMASH_ERR_MEMORY_ALLOC;
     frag_manager->sample_count += chunk->pool->sample_count;
     frag_manager->pool_size    += chunk->pool->size;
-    chunk->pool = isom_create_sample_pool( chunk->pool->size );
+    chunk->pool = isom_create_sample_pool( chunk->pool->entry_count );
     return chunk->pool ? 0 : LSMASH_ERR_MEMORY_ALLOC;
 }
 
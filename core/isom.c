@@ -24,6 +24,7 @@
 #include "common/internal.h" /* must be placed first */
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <inttypes.h>
 
@@ -61,14 +62,23 @@ isom_trak_t *isom_get_trak( lsmash_file_t *file, uint32_t track_ID )
      || LSMASH_IS_NON_EXISTING_BOX( file->moov )
      || file != file->initializer )
         return isom_non_existing_trak();
-    for( lsmash_entry_t *entry = file->moov->trak_list.head; entry; entry = entry->next )
+    isom_moov_t *moov = file->moov;
+    isom_trak_t *trak = (isom_trak_t *)lsmash_id_index_get( &moov->trak_index, track_ID );
+    if( trak && trak->tkhd->track_ID == track_ID )
+        return trak;
+    /* The track is not indexed yet, or its track_ID has been changed. */
+    for( lsmash_entry_t *entry = moov->trak_list.head; entry; entry = entry->next )
     {
-        isom_trak_t *trak = (isom_trak_t *)entry->data;
+        trak = (isom_trak_t *)entry->data;
         if( LSMASH_IS_NON_EXISTING_BOX( trak )
          || LSMASH_IS_NON_EXISTING_BOX( trak->tkhd ) )
             return isom_non_existing_trak();
         if( trak->tkhd->track_ID == track_ID )
+        {
+            /* The index is just a cache, so a failure to update it is harmless. */
+            lsmash_id_index_set( &moov->trak_index, track_ID, trak );
             return trak;
+        }
     }
     return isom_non_existing_trak();
 }
@@ -77,9 +87,9 @@ isom_trex_t *isom_get_trex( isom_mvex_t *mvex, uint32_t track_ID )
 {
     if( track_ID == 0 || LSMASH_IS_NON_EXISTING_BOX( mvex ) )
         return isom_non_existing_trex();
-    for( lsmash_entry_t *entry = mvex->trex_list.head; entry; entry = entry->next )
+    for( uint32_t i = 1; i <= mvex->trex_list.entry_count; i++ )
     {
-        isom_trex_t *trex = (isom_trex_t *)entry->data;
+        isom_trex_t *trex = (isom_trex_t *)lsmash_vector_get_entry_data( &mvex->trex_list, i );
         if( LSMASH_IS_NON_EXISTING_BOX( trex ) )
             return isom_non_existing_trex();
         if( trex->track_ID == track_ID )
@@ -92,14 +102,20 @@ isom_traf_t *isom_get_traf( isom_moof_t *moof, uint32_t track_ID )
 {
     if( track_ID == 0 || LSMASH_IS_NON_EXISTING_BOX( moof ) )
         return isom_non_existing_traf();
-    for( lsmash_entry_t *entry = moof->traf_list.head; entry; entry = entry->next )
+    isom_traf_t *traf = (isom_traf_t *)lsmash_id_index_get( &moof->traf_index, track_ID );
+    if( traf && traf->tfhd->track_ID == track_ID )
+        return traf;
+    for( uint32_t i = 1; i <= moof->traf_list.entry_count; i++ )
     {
-        isom_traf_t *traf = (isom_traf_t *)entry->data;
+        traf = (isom_traf_t *)lsmash_vector_get_entry_data( &moof->traf_list, i );
         if( LSMASH_IS_NON_EXISTING_BOX( traf )
          || LSMASH_IS_NON_EXISTING_BOX( traf->tfhd ) )
             return isom_non_existing_traf();
         if( traf->tfhd->track_ID == track_ID )
+        {
+            lsmash_id_index_set( &moof->traf_index, track_ID, traf );
             return traf;
+        }
     }
     return isom_non_existing_traf();
 }
@@ -108,13 +124,19 @@ isom_tfra_t *isom_get_tfra( isom_mfra_t *mfra, uint32_t track_ID )
 {
     if( track_ID == 0 || LSMASH_IS_NON_EXISTING_BOX( mfra ) )
         return isom_non_existing_tfra();
+    isom_tfra_t *tfra = (isom_tfra_t *)lsmash_id_index_get( &mfra->tfra_index, track_ID );
+    if( tfra && tfra->track_ID == track_ID )
+        return tfra;
     for( lsmash_entry_t *entry = mfra->tfra_list.head; entry; entry = entry->next )
     {
-        isom_tfra_t *tfra = (isom_tfra_t *)entry->data;
+        tfra = (isom_tfra_t *)entry->data;
         if( LSMASH_IS_NON_EXISTING_BOX( tfra ) )
             return isom_non_existing_tfra();
         if( tfra->track_ID == track_ID )
+        {
+            lsmash_id_index_set( &mfra->tfra_index, track_ID, tfra );
             return tfra;
+        }
     }
     return isom_non_existing_tfra();
 }
@@ -165,55 +187,34 @@ int lsmash_add_sample_entry( lsmash_root_t *root, uint32_t track_ID, void *summa
 static int isom_add_stts_entry( isom_stbl_t *stbl, uint32_t sample_delta )
 {
     assert( LSMASH_IS_EXISTING_BOX( stbl->stts ) );
-    if( !stbl->stts->list )
-        return LSMASH_ERR_NAMELESS;
-    isom_stts_entry_t *data = lsmash_malloc( sizeof(isom_stts_entry_t) );
+    isom_stts_entry_t *data = isom_table_add_entry( &stbl->stts->table );
     if( !data )
         return LSMASH_ERR_MEMORY_ALLOC;
     data->sample_count = 1;
     data->sample_delta = sample_delta;
-    if( lsmash_list_add_entry( stbl->stts->list, data ) < 0 )
-    {
-        lsmash_free( data );
-        return LSMASH_ERR_MEMORY_ALLOC;
-    }
     return 0;
 }
 
 static int isom_add_ctts_entry( isom_stbl_t *stbl, uint32_t sample_count, uint32_t sample_offset )
 {
     assert( LSMASH_IS_EXISTING_BOX( stbl->ctts ) );
-    if( !stbl->ctts->list )
-        return LSMASH_ERR_NAMELESS;
-    isom_ctts_entry_t *data = lsmash_malloc( sizeof(isom_ctts_entry_t) );
+    isom_ctts_entry_t *data = isom_table_add_entry( &stbl->ctts->table );
     if( !data )
         return LSMASH_ERR_MEMORY_ALLOC;
     data->sample_count  = sample_count;
     data->sample_offset = sample_offset;
-    if( lsmash_list_add_entry( stbl->ctts->list, data ) < 0 )
-    {
-        lsmash_free( data );
-        return LSMASH_ERR_MEMORY_ALLOC;
-    }
     return 0;
 }
 
 static int isom_add_stsc_entry( isom_stbl_t *stbl, uint32_t first_chunk, uint32_t samples_per_chunk, uint32_t sample_description_index )
 {
     assert( LSMASH_IS_EXISTING_BOX( stbl->stsc ) );
-    if( !stbl->stsc->list )
-        return LSMASH_ERR_NAMELESS;
-    isom_stsc_entry_t *data = lsmash_malloc( sizeof(isom_stsc_entry_t) );
+    isom_stsc_entry_t *data = isom_table_add_entry( &stbl->stsc->table );
     if( !data )
         return LSMASH_ERR_MEMORY_ALLOC;
     data->first_chunk              = first_chunk;
     data->samples_per_chunk        = samples_per_chunk;
     data->sample_description_index = sample_description_index;
-    if( lsmash_list_add_entry( stbl->stsc->list, data ) < 0 )
-    {
-        lsmash_free( data );
-        return LSMASH_ERR_MEMORY_ALLOC;
-    }
     return 0;
 }
 
@@ -227,40 +228,28 @@ static int isom_add_stsz_entry( isom_stbl_t *stbl, uint32_t entry_size )
     if( stsz->sample_count == 0 )
         stsz->sample_size = entry_size;
     /* if it seems constant sample size at present, update sample_count only */
-    if( !stsz->list && stsz->sample_size == entry_size )
+    if( stsz->table.entry_count == 0 && stsz->sample_size == entry_size )
     {
         ++ stsz->sample_count;
         return 0;
     }
-    /* found sample_size varies, create sample_size list */
-    if( !stsz->list )
+    /* found sample_size varies, create sample_size table */
+    if( stsz->table.entry_count == 0 )
     {
-        stsz->list = lsmash_list_create_simple();
-        if( !stsz->list )
-            return LSMASH_ERR_MEMORY_ALLOC;
+        int err = isom_table_reserve( &stsz->table, stsz->sample_count + 1 );
+        if( err < 0 )
+            return err;
         for( uint32_t i = 0; i < stsz->sample_count; i++ )
         {
-            isom_stsz_entry_t *data = lsmash_malloc( sizeof(isom_stsz_entry_t) );
-            if( !data )
-                return LSMASH_ERR_MEMORY_ALLOC;
+            isom_stsz_entry_t *data = isom_table_add_entry( &stsz->table );
             data->entry_size = stsz->sample_size;
-            if( lsmash_list_add_entry( stsz->list, data ) < 0 )
-            {
-                lsmash_free( data );
-                return LSMASH_ERR_MEMORY_ALLOC;
-            }
         }
         stsz->sample_size = 0;
     }
-    isom_stsz_entry_t *data = lsmash_malloc( sizeof(isom_stsz_entry_t) );
+    isom_stsz_entry_t *data = isom_table_add_entry( &stsz->table );
     if( !data )
         return LSMASH_ERR_MEMORY_ALLOC;
     data->entry_size = entry_size;
-    if( lsmash_list_add_entry( stsz->list, data ) < 0 )
-    {
-        lsmash_free( data );
-        return LSMASH_ERR_MEMORY_ALLOC;
-    }
     ++ stsz->sample_count;
     return 0;
 }
@@ -268,34 +257,20 @@ static int isom_add_stsz_entry( isom_stbl_t *stbl, uint32_t entry_size )
 static int isom_add_stss_entry( isom_stbl_t *stbl, uint32_t sample_number )
 {
     assert( LSMASH_IS_EXISTING_BOX( stbl->stss ) );
-    if( !stbl->stss->list )
-        return LSMASH_ERR_NAMELESS;
-    isom_stss_entry_t *data = lsmash_malloc( sizeof(isom_stss_entry_t) );
+    isom_stss_entry_t *data = isom_table_add_entry( &stbl->stss->table );
     if( !data )
         return LSMASH_ERR_MEMORY_ALLOC;
     data->sample_number = sample_number;
-    if( lsmash_list_add_entry( stbl->stss->list, data ) < 0 )
-    {
-        lsmash_free( data );
-        return LSMASH_ERR_MEMORY_ALLOC;
-    }
     return 0;
 }
 
 static int isom_add_stps_entry( isom_stbl_t *stbl, uint32_t sample_number )
 {
     assert( LSMASH_IS_EXISTING_BOX( stbl->stps ) );
-    if( !stbl->stps->list )
-        return LSMASH_ERR_NAMELESS;
-    isom_stps_entry_t *data = lsmash_malloc( sizeof(isom_stps_entry_t) );
+    isom_stps_entry_t *data = isom_table_add_entry( &stbl->stps->table );
     if( !data )
         return LSMASH_ERR_MEMORY_ALLOC;
     data->sample_number = sample_number;
-    if( lsmash_list_add_entry( stbl->stps->list, data ) < 0 )
-    {
-        lsmash_free( data );
-        return LSMASH_ERR_MEMORY_ALLOC;
-    }
     return 0;
 }
 
@@ -317,10 +292,9 @@ static int isom_add_sdtp_entry( isom_box_t *parent, lsmash_sample_property_t *pr
         sdtp = ((isom_traf_t *)parent)->sdtp;
     else
         assert( 0 );
-    if( LSMASH_IS_NON_EXISTING_BOX( sdtp )
-     || !sdtp->list )
+    if( LSMASH_IS_NON_EXISTING_BOX( sdtp ) )
         return LSMASH_ERR_NAMELESS;
-    isom_sdtp_entry_t *data = lsmash_malloc( sizeof(isom_sdtp_entry_t) );
+    isom_sdtp_entry_t *data = isom_table_add_entry( &sdtp->table );
     if( !data )
         return LSMASH_ERR_MEMORY_ALLOC;
     if( compatibility == 1 )
@@ -335,28 +309,16 @@ static int isom_add_sdtp_entry( isom_box_t *parent, lsmash_sample_property_t *pr
     data->sample_depends_on     = prop->independent & 0x03;
     data->sample_is_depended_on = prop->disposable  & 0x03;
     data->sample_has_redundancy = prop->redundant   & 0x03;
-    if( lsmash_list_add_entry( sdtp->list, data ) < 0 )
-    {
-        lsmash_free( data );
-        return LSMASH_ERR_MEMORY_ALLOC;
-    }
     return 0;
 }
 
 static int isom_add_co64_entry( isom_stbl_t *stbl, uint64_t chunk_offset )
 {
     assert( LSMASH_IS_EXISTING_BOX( stbl->stco ) );
-    if( !stbl->stco->list )
-        return LSMASH_ERR_NAMELESS;
-    isom_co64_entry_t *data = lsmash_malloc( sizeof(isom_co64_entry_t) );
+    isom_co64_entry_t *data = isom_table_add_entry( &stbl->stco->table );
     if( !data )
         return LSMASH_ERR_MEMORY_ALLOC;
     data->chunk_offset = chunk_offset;
-    if( lsmash_list_add_entry( stbl->stco->list, data ) < 0 )
-    {
-        lsmash_free( data );
-        return LSMASH_ERR_MEMORY_ALLOC;
-    }
     return 0;
 }
 
@@ -373,12 +335,12 @@ static int isom_convert_stco_to_co64( isom_stbl_t *stbl )
         goto fail;
     }
     /* move chunk_offset to co64 from stco */
-    for( lsmash_entry_t *entry = stco->list->head; entry; entry = entry->next )
-    {
-        isom_stco_entry_t *data = (isom_stco_entry_t*)entry->data;
-        if( (err = isom_add_co64_entry( stbl, data->chunk_offset )) < 0 )
+    if( (err = isom_table_reserve( &stbl->stco->table, stco->table.entry_count + 1 )) < 0 )
+        goto fail;
+    isom_stco_entry_t *stco_data = (isom_stco_entry_t *)stco->table.data;
+    for( uint32_t i = 0; i < stco->table.entry_count; i++ )
+        if( (err = isom_add_co64_entry( stbl, stco_data[i].chunk_offset )) < 0 )
             goto fail;
-    }
 fail:
     isom_remove_box_by_itself( stco );
     return err;
@@ -386,8 +348,6 @@ fail:
 
 static int isom_add_stco_entry( isom_stbl_t *stbl, uint64_t chunk_offset )
 {
-    if( !stbl->stco->list )
-        return LSMASH_ERR_NAMELESS;
     if( stbl->stco->large_presentation )
         return isom_add_co64_entry( stbl, chunk_offset );
     if( chunk_offset > UINT32_MAX )
@@ -397,15 +357,10 @@ static int isom_add_stco_entry( isom_stbl_t *stbl, uint64_t chunk_offset )
             return err;
         return isom_add_co64_entry( stbl, chunk_offset );
     }
-    isom_stco_entry_t *data = lsmash_malloc( sizeof(isom_stco_entry_t) );
+    isom_stco_entry_t *data = isom_table_add_entry( &stbl->stco->table );
     if( !data )
         return LSMASH_ERR_MEMORY_ALLOC;
     data->chunk_offset = (uint32_t)chunk_offset;
-    if( lsmash_list_add_entry( stbl->stco->list, data ) < 0 )
-    {
-        lsmash_free( data );
-        return LSMASH_ERR_MEMORY_ALLOC;
-    }
     return 0;
 }
 
@@ -544,63 +499,44 @@ uint32_t isom_get_sample_count( isom_trak_t *trak )
 
 static uint64_t isom_get_dts( isom_stts_t *stts, uint32_t sample_number )
 {
-    if( !stts->list )
-        return 0;
     uint64_t dts = 0;
     uint32_t i   = 1;
-    lsmash_entry_t    *entry;
-    isom_stts_entry_t *data = NULL;
-    for( entry = stts->list->head; entry; entry = entry->next )
+    isom_stts_entry_t *data = (isom_stts_entry_t *)stts->table.data;
+    for( uint32_t n = 0; n < stts->table.entry_count; n++ )
     {
-        data = (isom_stts_entry_t *)entry->data;
-        if( !data )
-            return 0;
-        if( i + data->sample_count > sample_number )
-            break;
-        dts += (uint64_t)data->sample_delta * data->sample_count;
-        i   += data->sample_count;
+        if( i + data[n].sample_count > sample_number )
+            return dts + (uint64_t)data[n].sample_delta * (sample_number - i);
+        dts += (uint64_t)data[n].sample_delta * data[n].sample_count;
+        i   += data[n].sample_count;
     }
-    if( !entry )
-        return 0;
-    dts += (uint64_t)data->sample_delta * (sample_number - i);
-    return dts;
+    return 0;
 }
 
 #if 0
 static uint64_t isom_get_cts( isom_stts_t *stts, isom_ctts_t *ctts, uint32_t sample_number )
 {
-    if( !stts->list )
-        return 0;
     if( LSMASH_IS_NON_EXISTING_BOX( ctts ) )
         return isom_get_dts( stts, sample_number );
     uint32_t i = 1;     /* This can be 0 (and then condition below shall be changed) but I dare use same algorithm with isom_get_dts. */
-    lsmash_entry_t    *entry;
-    isom_ctts_entry_t *data = NULL;
     if( sample_number == 0 )
         return 0;
-    for( entry = ctts->list->head; entry; entry = entry->next )
+    isom_ctts_entry_t *data = (isom_ctts_entry_t *)ctts->table.data;
+    for( uint32_t n = 0; n < ctts->table.entry_count; n++ )
     {
-        data = (isom_ctts_entry_t *)entry->data;
-        if( !data )
-            return 0;
-        if( i + data->sample_count > sample_number )
-            break;
-        i += data->sample_count;
+        if( i + data[n].sample_count > sample_number )
+            return isom_get_dts( stts, sample_number ) + data[n].sample_offset;
+        i += data[n].sample_count;
     }
-    if( !entry )
-        return 0;
-    return isom_get_dts( stts, sample_number ) + data->sample_offset;
+    return 0;
 }
 #endif
 
 static int isom_replace_last_sample_delta( isom_stbl_t *stbl, uint32_t sample_delta )
 {
     assert( LSMASH_IS_EXISTING_BOX( stbl->stts ) );
-    if( !stbl->stts->list
-     || !stbl->stts->list->tail
-     || !stbl->stts->list->tail->data )
+    isom_stts_entry_t *last_stts_data = isom_table_get_tail( &stbl->stts->table );
+    if( !last_stts_data )
         return LSMASH_ERR_NAMELESS;
-    isom_stts_entry_t *last_stts_data = (isom_stts_entry_t *)stbl->stts->list->tail->data;
     if( sample_delta != last_stts_data->sample_delta )
     {
         if( last_stts_data->sample_count > 1 )
@@ -622,7 +558,7 @@ static int isom_update_mdhd_duration( isom_trak_t *trak, uint32_t last_sample_de
     if( LSMASH_IS_NON_EXISTING_BOX( trak->file )
      || LSMASH_IS_NON_EXISTING_BOX( trak->mdia->mdhd )
      || !trak->cache
-     || !trak->mdia->minf->stbl->stts->list )
+     || LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->stbl->stts ) )
         return LSMASH_ERR_INVALID_DATA;
     lsmash_file_t *file = trak->file;
     isom_mdhd_t *mdhd = trak->mdia->mdhd;
@@ -635,13 +571,14 @@ static int isom_update_mdhd_duration( isom_trak_t *trak, uint32_t last_sample_de
     if( sample_count == 0 )
     {
         /* Return error if non-fragmented movie has no samples. */
-        if( !file->fragment && !stts->list->entry_count )
+        if( !file->fragment && !stts->table.entry_count )
             return LSMASH_ERR_INVALID_DATA;
         return 0;
     }
     /* Now we have at least 1 sample, so do stts_entry. */
-    lsmash_entry_t    *last_stts      = stts->list->tail;
-    isom_stts_entry_t *last_stts_data = (isom_stts_entry_t *)last_stts->data;
+    isom_stts_entry_t *last_stts_data = isom_table_get_tail( &stts->table );
+    if( !last_stts_data )
+        return LSMASH_ERR_INVALID_DATA;
     if( sample_count == 1 )
         mdhd->duration = last_stts_data->sample_delta;
     /* Now we have at least 2 samples,
@@ -662,17 +599,18 @@ static int isom_update_mdhd_duration( isom_trak_t *trak, uint32_t last_sample_de
         else
         {
             /* Remove the last entry. */
-            if( (err = lsmash_list_remove_entry_tail( stts->list )) < 0 )
-                return err;
+            isom_table_remove_entry_tail( &stts->table );
             /* copy the previous sample_delta. */
-            ++ ((isom_stts_entry_t *)stts->list->tail->data)->sample_count;
-            mdhd->duration += ((isom_stts_entry_t *)stts->list->tail->data)->sample_delta;
+            last_stts_data = isom_table_get_tail( &stts->table );
+            if( !last_stts_data )
+                return LSMASH_ERR_INVALID_DATA;
+            ++ last_stts_data->sample_count;
+            mdhd->duration += last_stts_data->sample_delta;
         }
     }
     else
     {
-        if( !ctts->list
-         ||  ctts->list->entry_count == 0 )
+        if( ctts->table.entry_count == 0 )
             return LSMASH_ERR_INVALID_DATA;
         uint64_t dts        = 0;
         uint64_t max_cts    = 0;
@@ -683,14 +621,12 @@ static int isom_update_mdhd_duration( isom_trak_t *trak, uint32_t last_sample_de
         int32_t  ctd_shift  = trak->cache->timestamp.ctd_shift;
         uint32_t j = 0;
         uint32_t k = 0;
-        lsmash_entry_t *stts_entry = stts->list->head;
-        lsmash_entry_t *ctts_entry = ctts->list->head;
+        uint32_t stts_entry_number = 1;
+        uint32_t ctts_entry_number = 1;
         for( uint32_t i = 0; i < sample_count; i++ )
         {
-            if( !ctts_entry || !stts_entry )
-                return LSMASH_ERR_INVALID_DATA;
-            isom_stts_entry_t *stts_data = (isom_stts_entry_t *)stts_entry->data;
-            isom_ctts_entry_t *ctts_data = (isom_ctts_entry_t *)ctts_entry->data;
+            isom_stts_entry_t *stts_data = isom_table_get_entry( &stts->table, stts_entry_number );
+            isom_ctts_entry_t *ctts_data = isom_table_get_entry( &ctts->table, ctts_entry_number );
             if( !stts_data || !ctts_data )
                 return LSMASH_ERR_INVALID_DATA;
             if( ctts_data->sample_offset != ISOM_NON_OUTPUT_SAMPLE_OFFSET )
@@ -723,12 +659,12 @@ static int isom_update_mdhd_duration( isom_trak_t *trak, uint32_t last_sample_de
             /* If finished sample_count of current entry, move to next. */
             if( ++j == ctts_data->sample_count )
             {
-                ctts_entry = ctts_entry->next;
+                ++ctts_entry_number;
                 j = 0;
             }
             if( ++k == stts_data->sample_count )
             {
-                stts_entry = stts_entry->next;
+                ++stts_entry_number;
                 k = 0;
             }
         }
@@ -882,27 +818,21 @@ int lsmash_update_track_duration( lsmash_root_t *root, uint32_t track_ID, uint32
     return err;
 }
 
-static inline int isom_increment_sample_number_in_entry
+static inline void isom_increment_sample_number_in_entry
 (
-    uint32_t        *sample_number_in_entry,
-    uint32_t         sample_count_in_entry,
-    lsmash_entry_t **entry
+    uint32_t *sample_number_in_entry,
+    uint32_t  sample_count_in_entry,
+    uint32_t *entry_number
 )
 {
     if( *sample_number_in_entry != sample_count_in_entry )
     {
         *sample_number_in_entry += 1;
-        return 0;
+        return;
     }
     /* Precede the next entry. */
     *sample_number_in_entry = 1;
-    if( *entry )
-    {
-        *entry = (*entry)->next;
-        if( *entry && !(*entry)->data )
-            return LSMASH_ERR_INVALID_DATA;
-    }
-    return 0;
+    *entry_number += 1;
 }
 
 int isom_calculate_bitrate_description
@@ -915,16 +845,19 @@ int isom_calculate_bitrate_description
     uint32_t     sample_description_index
 )
 {
-    isom_stsz_t *stsz = stbl->stsz;
-    lsmash_entry_list_t *stsz_list  = LSMASH_IS_EXISTING_BOX( stsz ) ? stsz->list : stbl->stz2->list;
-    lsmash_entry_t *stsz_entry      = stsz_list ? stsz_list->head : NULL;
-    lsmash_entry_t *stts_entry      = stbl->stts->list->head;
-    lsmash_entry_t *stsc_entry      = NULL;
-    lsmash_entry_t *next_stsc_entry = stbl->stsc->list->head;
+    isom_stsz_t  *stsz = stbl->stsz;
+    isom_table_t *stsz_table = LSMASH_IS_EXISTING_BOX( stsz ) ? &stsz->table : &stbl->stz2->table;
+    isom_table_t *stts_table = &stbl->stts->table;
+    isom_table_t *stsc_table = &stbl->stsc->table;
+    isom_stsz_entry_t *stsz_entries = (isom_stsz_entry_t *)stsz_table->data;
+    isom_stts_entry_t *stts_entries = (isom_stts_entry_t *)stts_table->data;
+    isom_stsc_entry_t *stsc_entries = (isom_stsc_entry_t *)stsc_table->data;
     isom_stts_entry_t *stts_data    = NULL;
     isom_stsc_entry_t *stsc_data    = NULL;
-    if( next_stsc_entry && !next_stsc_entry->data )
-        return LSMASH_ERR_INVALID_DATA;
+    int      variable_size          = stsz_table->entry_count > 0;
+    uint32_t stsz_index             = 0;
+    uint32_t stts_entry_number      = 1;
+    uint32_t next_stsc_index        = 0;
     uint32_t rate                   = 0;
     uint64_t dts                    = 0;
     uint32_t time_wnd               = 0;
@@ -935,30 +868,21 @@ int isom_calculate_bitrate_description
     *bufferSizeDB = 0;
     *maxBitrate   = 0;
     *avgBitrate   = 0;
-    while( stts_entry )
+    while( stts_entry_number <= stts_table->entry_count )
     {
-        int err;
         if( !stsc_data || sample_number_in_chunk == stsc_data->samples_per_chunk )
         {
             /* Move the next chunk. */
             sample_number_in_chunk = 1;
             ++chunk_number;
             /* Check if the next entry is broken. */
-            while( next_stsc_entry && ((isom_stsc_entry_t *)next_stsc_entry->data)->first_chunk < chunk_number )
-            {
+            while( next_stsc_index < stsc_table->entry_count && stsc_entries[next_stsc_index].first_chunk < chunk_number )
                 /* Just skip broken next entry. */
-                next_stsc_entry = next_stsc_entry->next;
-                if( next_stsc_entry && !next_stsc_entry->data )
-                    return LSMASH_ERR_INVALID_DATA;
-            }
+                ++next_stsc_index;
             /* Check if the next chunk belongs to the next sequence of chunks. */
-            if( next_stsc_entry && ((isom_stsc_entry_t *)next_stsc_entry->data)->first_chunk == chunk_number )
+            if( next_stsc_index < stsc_table->entry_count && stsc_entries[next_stsc_index].first_chunk == chunk_number )
             {
-                stsc_entry = next_stsc_entry;
-                next_stsc_entry = next_stsc_entry->next;
-                if( next_stsc_entry && !next_stsc_entry->data )
-                    return LSMASH_ERR_INVALID_DATA;
-                stsc_data = (isom_stsc_entry_t *)stsc_entry->data;
+                stsc_data = &stsc_entries[next_stsc_index ++];
                 /* Check if the next contiguous chunks belong to given sample description. */
                 if( stsc_data->sample_description_index != sample_description_index )
                 {
@@ -966,43 +890,41 @@ int isom_calculate_bitrate_description
                     uint32_t number_of_skips   = 0;
                     uint32_t first_chunk       = stsc_data->first_chunk;
                     uint32_t samples_per_chunk = stsc_data->samples_per_chunk;
-                    while( next_stsc_entry )
+                    while( next_stsc_index < stsc_table->entry_count )
                     {
-                        if( ((isom_stsc_entry_t *)next_stsc_entry->data)->sample_description_index != sample_description_index )
+                        if( stsc_entries[next_stsc_index].sample_description_index != sample_description_index )
                         {
-                            stsc_data = (isom_stsc_entry_t *)next_stsc_entry->data;
+                            stsc_data = &stsc_entries[next_stsc_index];
                             number_of_skips  += (stsc_data->first_chunk - first_chunk) * samples_per_chunk;
                             first_chunk       = stsc_data->first_chunk;
                             samples_per_chunk = stsc_data->samples_per_chunk;
                         }
-                        else if( ((isom_stsc_entry_t *)next_stsc_entry->data)->first_chunk <= first_chunk )
+                        else if( stsc_entries[next_stsc_index].first_chunk <= first_chunk )
                             ;   /* broken entry */
                         else
                             break;
                         /* Just skip the next entry. */
-                        next_stsc_entry = next_stsc_entry->next;
-                        if( next_stsc_entry && !next_stsc_entry->data )
-                            return LSMASH_ERR_INVALID_DATA;
+                        ++next_stsc_index;
                     }
-                    if( !next_stsc_entry )
+                    if( next_stsc_index >= stsc_table->entry_count )
                         break;      /* There is no more chunks which don't belong to given sample description. */
-                    number_of_skips += (((isom_stsc_entry_t *)next_stsc_entry->data)->first_chunk - first_chunk) * samples_per_chunk;
+                    number_of_skips += (stsc_entries[next_stsc_index].first_chunk - first_chunk) * samples_per_chunk;
                     for( uint32_t i = 0; i < number_of_skips; i++ )
                     {
-                        if( stsz_list )
+                        if( variable_size )
                         {
-                            if( !stsz_entry )
+                            if( stsz_index >= stsz_table->entry_count )
                                 break;
-                            stsz_entry = stsz_entry->next;
+                            ++stsz_index;
                         }
-                        if( !stts_entry )
+                        if( stts_entry_number > stts_table->entry_count )
                             break;
-                        if( (err = isom_increment_sample_number_in_entry( &sample_number_in_stts,
-                                                                          ((isom_stts_entry_t *)stts_entry->data)->sample_count,
-                                                                          &stts_entry )) < 0 )
-                            return err;
+                        isom_increment_sample_number_in_entry( &sample_number_in_stts,
+                                                               stts_entries[stts_entry_number - 1].sample_count,
+                                                               &stts_entry_number );
                     }
-                    if( (stsz_list && !stsz_entry) || !stts_entry )
+                    if( (variable_size && stsz_index >= stsz_table->entry_count)
+                     || stts_entry_number > stts_table->entry_count )
                         break;
                     chunk_number = stsc_data->first_chunk;
                 }
@@ -1012,26 +934,19 @@ int isom_calculate_bitrate_description
             ++sample_number_in_chunk;
         /* Get current sample's size. */
         uint32_t size;
-        if( stsz_list )
+        if( variable_size )
         {
-            if( !stsz_entry )
+            if( stsz_index >= stsz_table->entry_count )
                 break;
-            isom_stsz_entry_t *stsz_data = (isom_stsz_entry_t *)stsz_entry->data;
-            if( !stsz_data )
-                return LSMASH_ERR_INVALID_DATA;
-            size = stsz_data->entry_size;
-            stsz_entry = stsz_entry->next;
+            size = stsz_entries[stsz_index ++].entry_size;
         }
         else
             size = constant_sample_size;
         /* Get current sample's DTS. */
         if( stts_data )
             dts += stts_data->sample_delta;
-        stts_data = (isom_stts_entry_t *)stts_entry->data;
-        if( !stts_data )
-            return LSMASH_ERR_INVALID_DATA;
-        if( (err = isom_increment_sample_number_in_entry( &sample_number_in_stts, stts_data->sample_count, &stts_entry )) < 0 )
-            return err;
+        stts_data = &stts_entries[stts_entry_number - 1];
+        isom_increment_sample_number_in_entry( &sample_number_in_stts, stts_data->sample_count, &stts_entry_number );
         /* Calculate bitrate description. */
         if( *bufferSizeDB < size )
             *bufferSizeDB = size;
@@ -1071,16 +986,16 @@ uint32_t isom_get_first_sample_size( isom_stbl_t *stbl )
         /* 'stsz' */
         if( stbl->stsz->sample_size )
             return stbl->stsz->sample_size;
-        else if( stbl->stsz->list && stbl->stsz->list->head && stbl->stsz->list->head->data )
-            return ((isom_stsz_entry_t *)stbl->stsz->list->head->data)->entry_size;
+        else if( stbl->stsz->table.entry_count )
+            return ((isom_stsz_entry_t *)stbl->stsz->table.data)[0].entry_size;
         else
             return 0;
     }
     else if( LSMASH_IS_EXISTING_BOX( stbl->stz2 ) )
     {
         /* stz2 */
-        if( stbl->stz2->list && stbl->stz2->list->head && stbl->stz2->list->head->data )
-            return ((isom_stsz_entry_t *)stbl->stz2->list->head->data)->entry_size;
+        if( stbl->stz2->table.entry_count )
+            return ((isom_stsz_entry_t *)stbl->stz2->table.data)[0].entry_size;
         else
             return 0;
     }
@@ -1095,13 +1010,13 @@ int isom_update_bitrate_description( isom_mdia_t *mdia )
     isom_stbl_t *stbl = mdia->minf->stbl;
     if( LSMASH_IS_NON_EXISTING_BOX( stbl->stsd )
      || (LSMASH_IS_NON_EXISTING_BOX( stbl->stsz ) && LSMASH_IS_NON_EXISTING_BOX( stbl->stz2 ))
-     || !stbl->stsc->list
-     || !stbl->stts->list )
+     || LSMASH_IS_NON_EXISTING_BOX( stbl->stsc )
+     || LSMASH_IS_NON_EXISTING_BOX( stbl->stts ) )
         return LSMASH_ERR_INVALID_DATA;
     uint32_t sample_description_index = 0;
-    for( lsmash_entry_t *entry = stbl->stsd->list.head; entry; entry = entry->next )
+    for( uint32_t i = 1; i <= stbl->stsd->list.entry_count; i++ )
     {
-        isom_sample_entry_t *sample_entry = (isom_sample_entry_t *)entry->data;
+        isom_sample_entry_t *sample_entry = (isom_sample_entry_t *)lsmash_vector_get_entry_data( &stbl->stsd->list, i );
         if( !sample_entry )
             return LSMASH_ERR_INVALID_DATA;
         ++sample_description_index;
@@ -1732,11 +1647,10 @@ uint32_t lsmash_get_last_sample_delta( lsmash_root_t *root, uint32_t track_ID )
     if( isom_check_initializer_present( root ) < 0 )
         return 0;
     isom_trak_t *trak = isom_get_trak( root->file, track_ID );
-    if( !trak->mdia->minf->stbl->stts->list
-     || !trak->mdia->minf->stbl->stts->list->tail
-     || !trak->mdia->minf->stbl->stts->list->tail->data )
+    if( isom_load_deferred_box( trak->mdia->minf->stbl->stts ) < 0 )
         return 0;
-    return ((isom_stts_entry_t *)trak->mdia->minf->stbl->stts->list->tail->data)->sample_delta;
+    isom_stts_entry_t *data = isom_table_get_tail( &trak->mdia->minf->stbl->stts->table );
+    return data ? data->sample_delta : 0;
 }
 
 uint32_t lsmash_get_start_time_offset( lsmash_root_t *root, uint32_t track_ID )
@@ -1744,11 +1658,10 @@ uint32_t lsmash_get_start_time_offset( lsmash_root_t *root, uint32_t track_ID )
     if( isom_check_initializer_present( root ) < 0 )
         return 0;
     isom_trak_t *trak = isom_get_trak( root->file, track_ID );
-    if( !trak->mdia->minf->stbl->ctts->list
-     || !trak->mdia->minf->stbl->ctts->list->head
-     || !trak->mdia->minf->stbl->ctts->list->head->data )
+    if( isom_load_deferred_box( trak->mdia->minf->stbl->ctts ) < 0 )
         return 0;
-    return ((isom_ctts_entry_t *)trak->mdia->minf->stbl->ctts->list->head->data)->sample_offset;
+    isom_ctts_entry_t *data = isom_table_get_entry( &trak->mdia->minf->stbl->ctts->table, 1 );
+    return data ? data->sample_offset : 0;
 }
 
 uint32_t lsmash_get_composition_to_decode_shift( lsmash_root_t *root, uint32_t track_ID )
@@ -1761,15 +1674,17 @@ uint32_t lsmash_get_composition_to_decode_shift( lsmash_root_t *root, uint32_t t
     if( sample_count == 0 )
         return 0;
     isom_stbl_t *stbl = trak->mdia->minf->stbl;
-    if( !stbl->stts->list
-     || !stbl->ctts->list )
+    if( isom_load_deferred_box( stbl->stts ) < 0
+     || isom_load_deferred_box( stbl->ctts ) < 0
+     || stbl->stts->table.entry_count == 0
+     || stbl->ctts->table.entry_count == 0 )
         return 0;
     if( !(file->max_isom_version >= 4 && stbl->ctts->version == 1) && !file->qt_compatible )
         return 0;   /* This movie shall not have composition to decode timeline shift. */
-    lsmash_entry_t *stts_entry = stbl->stts->list->head;
-    lsmash_entry_t *ctts_entry = stbl->ctts->list->head;
-    if( !stts_entry || !ctts_entry )
-        return 0;
+    isom_stts_entry_t *stts_data = (isom_stts_entry_t *)stbl->stts->table.data;
+    isom_ctts_entry_t *ctts_data = (isom_ctts_entry_t *)stbl->ctts->table.data;
+    isom_stts_entry_t *stts_end  = stts_data + stbl->stts->table.entry_count;
+    isom_ctts_entry_t *ctts_end  = ctts_data + stbl->ctts->table.entry_count;
     uint64_t dts       = 0;
     uint64_t cts       = 0;
     uint32_t ctd_shift = 0;
@@ -1777,10 +1692,6 @@ uint32_t lsmash_get_composition_to_decode_shift( lsmash_root_t *root, uint32_t t
     uint32_t j         = 0;
     for( uint32_t k = 0; k < sample_count; k++ )
     {
-        isom_stts_entry_t *stts_data = (isom_stts_entry_t *)stts_entry->data;
-        isom_ctts_entry_t *ctts_data = (isom_ctts_entry_t *)ctts_entry->data;
-        if( !stts_data || !ctts_data )
-            return 0;
         if( ctts_data->sample_offset != ISOM_NON_OUTPUT_SAMPLE_OFFSET )
         {
             cts = dts + (int32_t)ctts_data->sample_offset;
@@ -1790,15 +1701,13 @@ uint32_t lsmash_get_composition_to_decode_shift( lsmash_root_t *root, uint32_t t
         dts += stts_data->sample_delta;
         if( ++i == stts_data->sample_count )
         {
-            stts_entry = stts_entry->next;
-            if( !stts_entry )
+            if( ++stts_data == stts_end )
                 return 0;
             i = 0;
         }
         if( ++j == ctts_data->sample_count )
         {
-            ctts_entry = ctts_entry->next;
-            if( !ctts_entry )
+            if( ++ctts_data == ctts_end )
                 return 0;
             j = 0;
         }
@@ -1942,9 +1851,9 @@ static int isom_compress_sample_size_table( isom_stbl_t *stbl )
         /* 3GPP: Limitations to the ISO base media file format
          *  - compact sample sizes ('stz2') shall not be used for tracks containing H.263, MPEG-4 video, AMR, AMR-WB, AAC or Timed text.
          * Note that 'mp4a' check is incomplete here since this restriction is not applied to Enhanced aacPlus audio (HE-AAC v2). */
-        for( lsmash_entry_t *entry = stbl->stsd->list.head; entry; entry = entry->next )
+        for( uint32_t i = 1; i <= stbl->stsd->list.entry_count; i++ )
         {
-            isom_sample_entry_t *sample_entry = (isom_sample_entry_t *)entry->data;
+            isom_sample_entry_t *sample_entry = (isom_sample_entry_t *)lsmash_vector_get_entry_data( &stbl->stsd->list, i );
             if( LSMASH_IS_NON_EXISTING_BOX( sample_entry ) )
                 return LSMASH_ERR_INVALID_DATA;
             lsmash_codec_type_t sample_type = sample_entry->type;
@@ -1959,13 +1868,11 @@ static int isom_compress_sample_size_table( isom_stbl_t *stbl )
     if( LSMASH_IS_EXISTING_BOX( stbl->stsz ) && isom_is_variable_size( stbl ) )
     {
         int max_num_bits = 0;
-        for( lsmash_entry_t *entry = stbl->stsz->list->head; entry; entry = entry->next )
+        isom_stsz_entry_t *data = (isom_stsz_entry_t *)stbl->stsz->table.data;
+        for( uint32_t i = 0; i < stbl->stsz->table.entry_count; i++ )
         {
-            isom_stsz_entry_t *data = (isom_stsz_entry_t *)entry->data;
-            if( !data )
-                return LSMASH_ERR_INVALID_DATA;
             int num_bits;
-            for( num_bits = 1; data->entry_size >> num_bits; num_bits++ );
+            for( num_bits = 1; data[i].entry_size >> num_bits; num_bits++ );
             if( max_num_bits < num_bits )
             {
                 max_num_bits = num_bits;
@@ -1985,7 +1892,7 @@ static int isom_compress_sample_size_table( isom_stbl_t *stbl )
                 stz2->field_size = 8;
             else
                 stz2->field_size = 16;
-            lsmash_list_move_entries( stz2->list, stsz->list );
+            isom_table_move_entries( &stz2->table, &stsz->table );
             isom_remove_box_by_itself( stsz );
         }
     }
@@ -2248,6 +2155,64 @@ int lsmash_reserve_media_data_size
     return 0;
 }
 
+int lsmash_reserve_movie_size
+(
+    lsmash_root_t *root,
+    uint64_t       movie_size
+)
+{
+    if( isom_check_initializer_present( root ) < 0
+     || movie_size < ISOM_BASEBOX_COMMON_SIZE
+     || movie_size > UINT32_MAX )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    lsmash_file_t *file = root->file->initializer;
+    if( (LSMASH_IS_EXISTING_BOX( file->mdat ) && (file->mdat->manager & LSMASH_INCOMPLETE_BOX))  /* already written */
+     || file->fragment                  /* For fragmented movies, the Movie Box is written before any media data. */
+     || !file->bs
+     || file->bs->unseekable )
+        return LSMASH_ERR_NAMELESS;
+    file->movie_reserved_size = movie_size;
+    return 0;
+}
+
+/* the maximum size of the entries per sample in the sample tables:
+ * stts, ctts, stsz, stss, stps, sdtp, stsc and co64 for a chunk per sample, and sbgp for two grouping types */
+#define ISOM_MAX_SAMPLE_TABLE_SIZE_PER_SAMPLE (8 + 8 + 4 + 4 + 4 + 1 + 12 + 8 + 2 * 8)
+/* the margin for boxes added or enlarged when finishing a movie, e.g. Edit Box, Object Descriptor Box and 64-bit versions */
+#define ISOM_MOVIE_SIZE_MARGIN 1024
+#define ISOM_TRACK_SIZE_MARGIN 1024
+uint64_t lsmash_estimate_movie_size
+(
+    lsmash_root_t *root,
+    uint32_t       sample_count
+)
+{
+    if( isom_check_initializer_present( root ) < 0 )
+        return 0;
+    lsmash_file_t *file = root->file->initializer;
+    if( !(file->flags & LSMASH_FILE_MODE_WRITE)
+     || LSMASH_IS_NON_EXISTING_BOX( file->moov ) )
+        return 0;
+    uint64_t size = isom_update_box_size( file->moov ) + ISOM_MOVIE_SIZE_MARGIN;
+    if( LSMASH_IS_EXISTING_BOX( file->meta ) )
+        size += isom_update_box_size( file->meta );
+    for( lsmash_entry_t *entry = file->moov->trak_list.head; entry; entry = entry->next )
+    {
+        isom_trak_t *trak = (isom_trak_t *)entry->data;
+        if( LSMASH_IS_NON_EXISTING_BOX( trak ) )
+            continue;
+        size += ISOM_TRACK_SIZE_MARGIN;
+        /* For fragmented movies, samples are described in movie fragments.
+         * The samples already in the tables are counted twice to cover the entries added when finishing the movie. */
+        if( !file->fragment )
+            size += (uint64_t)LSMASH_MAX( sample_count, isom_get_sample_count( trak ) ) * ISOM_MAX_SAMPLE_TABLE_SIZE_PER_SAMPLE;
+    }
+    return size;
+}
+#undef ISOM_MAX_SAMPLE_TABLE_SIZE_PER_SAMPLE
+#undef ISOM_MOVIE_SIZE_MARGIN
+#undef ISOM_TRACK_SIZE_MARGIN
+
 static int isom_scan_trak_profileLevelIndication
 (
     isom_trak_t                         *trak,
@@ -2256,11 +2221,11 @@ static int isom_scan_trak_profileLevelIndication
 )
 {
     isom_stsd_t *stsd = trak->mdia->minf->stbl->stsd;
-    if( !stsd->list.head )
+    if( stsd->list.entry_count == 0 )
         return LSMASH_ERR_INVALID_DATA;
-    for( lsmash_entry_t *entry = stsd->list.head; entry; entry = entry->next )
+    for( uint32_t i = 1; i <= stsd->list.entry_count; i++ )
     {
-        isom_sample_entry_t *sample_entry = (isom_sample_entry_t *)entry->data;
+        isom_sample_entry_t *sample_entry = (isom_sample_entry_t *)lsmash_vector_get_entry_data( &stsd->list, i );
         if( LSMASH_IS_NON_EXISTING_BOX( sample_entry ) )
             return LSMASH_ERR_INVALID_DATA;
         lsmash_codec_type_t sample_type = sample_entry->type;
@@ -2379,7 +2344,7 @@ static lsmash_file_t *isom_get_written_media_file
 )
 {
     isom_minf_t         *minf        = trak->mdia->minf;
-    isom_sample_entry_t *description = (isom_sample_entry_t *)lsmash_list_get_entry_data( &minf->stbl->stsd->list, sample_description_index );
+    isom_sample_entry_t *description = (isom_sample_entry_t *)lsmash_vector_get_entry_data( &minf->stbl->stsd->list, sample_description_index );
     isom_dref_entry_t   *dref_entry  = (isom_dref_entry_t *)lsmash_list_get_entry_data( &minf->dinf->dref->list, description ? description->data_reference_index : 1 );
     lsmash_file_t       *file        = (!dref_entry || LSMASH_IS_NON_EXISTING_BOX( dref_entry->ref_file )) ? trak->file : dref_entry->ref_file;
     if( !(file->flags & LSMASH_FILE_MODE_MEDIA)
@@ -2398,9 +2363,9 @@ int isom_check_large_offset_requirement
     {
         isom_trak_t *trak = (isom_trak_t *)entry->data;
         isom_stco_t *stco = trak->mdia->minf->stbl->stco;
-        if( !stco->list->tail   /* no samples */
+        if( stco->table.entry_count == 0    /* no samples */
          || stco->large_presentation
-         || (((isom_stco_entry_t *)stco->list->tail->data)->chunk_offset + moov->size + meta_size) <= UINT32_MAX )
+         || (((isom_stco_entry_t *)isom_table_get_tail( &stco->table ))->chunk_offset + moov->size + meta_size) <= UINT32_MAX )
         {
             entry = entry->next;
             continue;   /* no need to convert stco into co64 */
@@ -2416,6 +2381,26 @@ int isom_check_large_offset_requirement
     return 0;
 }
 
+/* Check if the last chunk offset in any Chunk Offset Box overflows by adding 'preceding_size'.
+ * Return 1 if overflows, 0 otherwise. */
+static int isom_check_large_offset_overflow
+(
+    isom_moov_t *moov,
+    uint64_t     preceding_size
+)
+{
+    for( lsmash_entry_t *entry = moov->trak_list.head; entry; entry = entry->next )
+    {
+        isom_trak_t *trak = (isom_trak_t *)entry->data;
+        isom_stco_t *stco = trak->mdia->minf->stbl->stco;
+        if( stco->table.entry_count
+         && !stco->large_presentation
+         && (((isom_stco_entry_t *)isom_table_get_tail( &stco->table ))->chunk_offset + preceding_size) > UINT32_MAX )
+            return 1;
+    }
+    return 0;
+}
+
 void isom_add_preceding_box_size
 (
     isom_moov_t *moov,
@@ -2428,36 +2413,31 @@ void isom_add_preceding_box_size
         isom_trak_t *trak = (isom_trak_t *)entry->data;
         isom_stsc_t *stsc = trak->mdia->minf->stbl->stsc;
         isom_stco_t *stco = trak->mdia->minf->stbl->stco;
-        lsmash_entry_t    *stsc_entry = stsc->list->head;
-        isom_stsc_entry_t *stsc_data  = stsc_entry ? (isom_stsc_entry_t *)stsc_entry->data : NULL;
+        uint32_t           stsc_entry_number = 1;
+        isom_stsc_entry_t *stsc_data         = isom_table_get_entry( &stsc->table, stsc_entry_number );
         uint32_t chunk_number = 1;
-        for( lsmash_entry_t *stco_entry = stco->list->head; stco_entry; )
+        while( chunk_number <= stco->table.entry_count )
         {
             if( stsc_data
              && stsc_data->first_chunk == chunk_number )
             {
                 lsmash_file_t *ref_file = isom_get_written_media_file( trak, stsc_data->sample_description_index );
-                stsc_entry = stsc_entry->next;
-                stsc_data  = stsc_entry ? (isom_stsc_entry_t *)stsc_entry->data : NULL;
+                stsc_data = isom_table_get_entry( &stsc->table, ++stsc_entry_number );
                 if( ref_file != trak->file )
                 {
                     /* The chunks are not contained in the same file. Skip applying the offset.
                      * If no more stsc entries, the rest of the chunks is not contained in the same file. */
-                    if( !stsc_entry || !stsc_data )
+                    if( !stsc_data )
                         break;
-                    while( stco_entry && chunk_number < stsc_data->first_chunk )
-                    {
-                        stco_entry = stco_entry->next;
+                    while( chunk_number <= stco->table.entry_count && chunk_number < stsc_data->first_chunk )
                         ++chunk_number;
-                    }
                     continue;
                 }
             }
             if( stco->large_presentation )
-                ((isom_co64_entry_t *)stco_entry->data)->chunk_offset += preceding_size;
+                ((isom_co64_entry_t *)stco->table.data)[chunk_number - 1].chunk_offset += preceding_size;
             else
-                ((isom_stco_entry_t *)stco_entry->data)->chunk_offset += preceding_size;
-            stco_entry = stco_entry->next;
+                ((isom_stco_entry_t *)stco->table.data)[chunk_number - 1].chunk_offset += preceding_size;
             ++chunk_number;
         }
     }
@@ -2475,6 +2455,64 @@ int isom_establish_movie( lsmash_file_t *file )
     return 0;
 }
 
+/* Get the number of bytes by which the room of 'room_size' bytes must be enlarged to contain 'mtf_size' bytes.
+ * The rest of the room must be able to be a Free Space Box, and the enlargement is a multiple of 'unit' if not 0. */
+static uint64_t isom_get_room_expansion( uint64_t mtf_size, uint64_t room_size, uint64_t unit )
+{
+    uint64_t expansion = mtf_size > room_size ? mtf_size - room_size : 0;
+    if( unit )
+        expansion = ((expansion + unit - 1) / unit) * unit;
+    uint64_t rest = room_size + expansion - mtf_size;
+    if( rest && rest < ISOM_BASEBOX_COMMON_SIZE )
+        expansion += unit ? unit : ISOM_BASEBOX_COMMON_SIZE - rest;
+    return expansion;
+}
+
+/* Write the Movie Box and a Meta Box if any into the room of 'room_size' bytes at 'room_pos',
+ * and make the rest of the room a Free Space Box.
+ * The first 'reserved_size' bytes of the room are zeros written for the reservation, and the rest are filled with zeros here.
+ * If 'seek_end' is set to 1, get back to the end of the file. Otherwise, stay at the end of the room. */
+static int isom_write_movie_into_room
+(
+    lsmash_file_t *file,
+    uint64_t       room_pos,
+    uint64_t       room_size,
+    uint64_t       reserved_size,
+    int            seek_end
+)
+{
+    lsmash_bs_t *bs = file->bs;
+    int          err;
+    if( (err = lsmash_bs_write_seek( bs, room_pos, SEEK_SET ))  < 0
+     || (err = isom_write_box( bs, (isom_box_t *)file->moov )) < 0
+     || (err = isom_write_box( bs, (isom_box_t *)file->meta )) < 0 )
+        return err;
+    uint64_t room_end = room_pos + room_size;
+    if( bs->offset < room_end )
+    {
+        assert( room_end - bs->offset >= ISOM_BASEBOX_COMMON_SIZE );
+        lsmash_bs_put_be32( bs, room_end - bs->offset );
+        lsmash_bs_put_be32( bs, ISOM_BOX_TYPE_FREE.fourcc );
+        if( (err = lsmash_bs_flush_buffer( bs )) < 0 )
+            return err;
+        uint64_t zero_pos = LSMASH_MAX( bs->offset, room_pos + reserved_size );
+        if( (err = lsmash_bs_write_seek( bs, zero_pos, SEEK_SET )) < 0 )
+            return err;
+        uint64_t padding_size = room_end - zero_pos;
+        static const uint8_t zero_bytes[64] = { 0 };
+        while( padding_size )
+        {
+            uint64_t write_size = LSMASH_MIN( padding_size, sizeof(zero_bytes) );
+            if( (err = lsmash_bs_write_data( bs, zero_bytes, write_size )) < 0 )
+                return err;
+            padding_size -= write_size;
+        }
+    }
+    if( seek_end && (err = lsmash_bs_write_seek( bs, 0, SEEK_END )) < 0 )
+        return err;
+    return 0;
+}
+
 int lsmash_finish_movie
 (
     lsmash_root_t        *root,
@@ -2499,10 +2537,8 @@ int lsmash_finish_movie
         if( LSMASH_IS_NON_EXISTING_BOX( trak )
          || LSMASH_IS_NON_EXISTING_BOX( trak->tkhd )
          || !trak->cache
-         || !trak->mdia->minf->stbl->stsd->list.head
-         || !trak->mdia->minf->stbl->stsd->list.head->data
-         || !trak->mdia->minf->stbl->stco->list
-         || !trak->mdia->minf->stbl->stco->list->tail )
+         || !lsmash_vector_get_entry_data( &trak->mdia->minf->stbl->stsd->list, 1 )
+         || trak->mdia->minf->stbl->stco->table.entry_count == 0 )
             return LSMASH_ERR_INVALID_DATA;
         if( (err = isom_complement_data_reference( trak->mdia->minf )) < 0 )
             return err;
@@ -2542,10 +2578,17 @@ int lsmash_finish_movie
     file->mdat->manager &= ~LSMASH_INCOMPLETE_BOX;
     if( (err = isom_write_box( bs, (isom_box_t *)file->mdat )) < 0 )
         return err;
-    /* Write the Movie Box and a Meta Box if no optimization for progressive download. */
-    uint64_t meta_size = LSMASH_IS_EXISTING_BOX( file->meta ) ? file->meta->size : 0;
+    /* The boxes moved to front are written into the room in front of the Media Data Box.
+     * The room is the space reserved by lsmash_reserve_movie_size() if any, and is enlarged only if short. */
+    uint64_t meta_size     = LSMASH_IS_EXISTING_BOX( file->meta ) ? file->meta->size : 0;
+    uint64_t reserved_size = bs->unseekable ? 0 : file->movie_reserved_size;
+    uint64_t room_pos      = reserved_size ? file->movie_reserved_pos : file->mdat->pos;
     if( !remux )
     {
+        /* Without rearrangement, use the room only if large enough.
+         * Otherwise, write the Movie Box and a Meta Box at the end. */
+        if( reserved_size && isom_get_room_expansion( moov->size + meta_size, reserved_size, 0 ) == 0 )
+            return isom_write_movie_into_room( file, room_pos, reserved_size, reserved_size, 1 );
         if( (err = isom_write_box( bs, (isom_box_t *)file->moov )) < 0
          || (err = isom_write_box( bs, (isom_box_t *)file->meta )) < 0 )
             return err;
@@ -2556,7 +2599,37 @@ int lsmash_finish_movie
     if( (err = isom_check_large_offset_requirement( moov, meta_size )) < 0 )
         return err;
     /* now the amount of offset is fixed. */
-    uint64_t mtf_size = moov->size + meta_size;     /* sum of size of boxes moved to front */
+    uint64_t mtf_size  = moov->size + meta_size;    /* sum of size of boxes moved to front */
+    uint64_t expansion = isom_get_room_expansion( mtf_size, reserved_size, 0 );
+    if( expansion == 0 )
+        return isom_write_movie_into_room( file, room_pos, reserved_size, reserved_size, 1 );
+    /* If the file system may insert data in place, try it first with the enlargement rounded up to its unit.
+     * The rounding is kept only if the insertion succeeds and the chunk offsets still fit without any conversion. */
+    uint64_t unit = isom_get_data_insertion_unit( file );
+    err = 0;
+    if( unit )
+    {
+        uint64_t aligned_expansion = isom_get_room_expansion( mtf_size, reserved_size, unit );
+        if( !isom_check_large_offset_overflow( moov, mtf_size + aligned_expansion - expansion ) )
+        {
+            if( (err = isom_shift_data( file, remux, file->mdat->pos, aligned_expansion, 1 )) < 0 )
+                return err;
+            if( err == 1 )
+                expansion = aligned_expansion;
+        }
+    }
+    /* Otherwise, move the Media Data Box by the exact enlargement outside the bytestream if available. */
+    if( err == 0
+     && (err = isom_shift_data( file, remux, file->mdat->pos, expansion, 0 )) < 0 )
+        return err;
+    if( err == 1 )
+    {
+        isom_add_preceding_box_size( moov, expansion );
+        file->mdat->pos += expansion;
+        file->size      += expansion;
+        return isom_write_movie_into_room( file, room_pos, reserved_size + expansion, reserved_size, 1 );
+    }
+    assert( unit == 0 );
     /* buffer size must be at least mtf_size * 2 */
     remux->buffer_size = LSMASH_MAX( remux->buffer_size, mtf_size * 2 );
     /* Split to 2 buffers. */
@@ -2566,10 +2639,10 @@ int lsmash_finish_movie
     size_t size = remux->buffer_size / 2;
     buf[1] = buf[0] + size;
     /* Now, the amount of the offset is fixed. apply it to stco/co64 */
-    isom_add_preceding_box_size( moov, mtf_size );
+    isom_add_preceding_box_size( moov, expansion );
     /* Backup starting area of mdat and write moov + meta there instead. */
     isom_mdat_t *mdat            = file->mdat;
-    uint64_t     total           = file->size + mtf_size;
+    uint64_t     total           = file->size + expansion;
     uint64_t     placeholder_pos = mdat->pos;
     if( (err = lsmash_bs_write_seek( bs, placeholder_pos, SEEK_SET )) < 0 )
         goto fail;
@@ -2577,17 +2650,15 @@ int lsmash_finish_movie
     lsmash_bs_read_data( bs, buf[0], &read_num );
     uint64_t read_pos = bs->offset;
     /* Write moov + meta there instead. */
-    if( (err = lsmash_bs_write_seek( bs, placeholder_pos, SEEK_SET )) < 0
-     || (err = isom_write_box( bs, (isom_box_t *)file->moov ))        < 0
-     || (err = isom_write_box( bs, (isom_box_t *)file->meta ))        < 0 )
+    if( (err = isom_write_movie_into_room( file, room_pos, reserved_size + expansion, reserved_size, 0 )) < 0 )
         goto fail;
     uint64_t write_pos = bs->offset;
     /* Update the positions */
-    mdat->pos += mtf_size;
+    mdat->pos += expansion;
     /* Move Media Data Box. */
     if( (err = isom_rearrange_data( file, remux, buf, read_num, size, read_pos, write_pos, total )) < 0 )
         goto fail;
-    file->size += mtf_size;
+    file->size += expansion;
     lsmash_free( buf[0] );
     return 0;
 fail:
@@ -2618,13 +2689,13 @@ int lsmash_set_last_sample_delta( lsmash_root_t *root, uint32_t track_ID, uint32
      || (LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->stbl->stsz )
       && LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->stbl->stz2 ))
      || !trak->cache
-     || !trak->mdia->minf->stbl->stts->list )
+     || LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->stbl->stts ) )
         return LSMASH_ERR_NAMELESS;
     isom_stbl_t *stbl = trak->mdia->minf->stbl;
     isom_stts_t *stts = stbl->stts;
     uint32_t sample_count = isom_get_sample_count( trak );
     int err;
-    if( !stts->list->tail )
+    if( stts->table.entry_count == 0 )
     {
         if( sample_count == 0 )
             return 0;       /* no samples */
@@ -2636,18 +2707,17 @@ int lsmash_set_last_sample_delta( lsmash_root_t *root, uint32_t track_ID, uint32
             return err;
         return lsmash_update_track_duration( root, track_ID, 0 );
     }
+    isom_stts_entry_t *stts_entries = (isom_stts_entry_t *)stts->table.data;
     uint32_t i = 0;
-    for( lsmash_entry_t *entry = stts->list->head; entry; entry = entry->next )
-        i += ((isom_stts_entry_t *)entry->data)->sample_count;
+    for( uint32_t n = 0; n < stts->table.entry_count; n++ )
+        i += stts_entries[n].sample_count;
     if( sample_count < i )
         return LSMASH_ERR_INVALID_DATA;
     int no_last = (sample_count > i);
-    isom_stts_entry_t *last_stts_data = (isom_stts_entry_t *)stts->list->tail->data;
-    if( !last_stts_data )
-        return LSMASH_ERR_INVALID_DATA;
+    isom_stts_entry_t *last_stts_data = isom_table_get_tail( &stts->table );
     /* Consider QuikcTime fixed compression audio. */
-    isom_audio_entry_t *audio = (isom_audio_entry_t *)lsmash_list_get_entry_data( &trak->mdia->minf->stbl->stsd->list,
-                                                                                  trak->cache->chunk.sample_description_index );
+    isom_audio_entry_t *audio = (isom_audio_entry_t *)lsmash_vector_get_entry_data( &trak->mdia->minf->stbl->stsd->list,
+                                                                                    trak->cache->chunk.sample_description_index );
     if( LSMASH_IS_NON_EXISTING_BOX( audio ) )
         return LSMASH_ERR_INVALID_DATA;
     if( (audio->manager & LSMASH_AUDIO_DESCRIPTION)
@@ -2659,11 +2729,9 @@ int lsmash_set_last_sample_delta( lsmash_root_t *root, uint32_t track_ID, uint32
             return LSMASH_ERR_INVALID_DATA;
         int exclude_last_sample = no_last ? 0 : 1;
         uint32_t j = audio->samplesPerPacket;
-        for( lsmash_entry_t *entry = stts->list->tail; entry && j > 1; entry = entry->prev )
+        for( uint32_t n = stts->table.entry_count; n && j > 1; n-- )
         {
-            isom_stts_entry_t *stts_data = (isom_stts_entry_t *)entry->data;
-            if( !stts_data )
-                return LSMASH_ERR_INVALID_DATA;
+            isom_stts_entry_t *stts_data = &stts_entries[n - 1];
             for( uint32_t k = exclude_last_sample; k < stts_data->sample_count && j > 1; k++ )
             {
                 sample_delta -= stts_data->sample_delta;
@@ -2839,38 +2907,93 @@ int lsmash_update_movie_modification_time( lsmash_root_t *root )
 }
 
 /*---- sample manipulators ----*/
-lsmash_sample_t *lsmash_create_sample( uint32_t size )
+/* Every sample allocated by the library is preceded by this header.
+ * 'pooled_data' is the address of the data allocated from 'pool', and the data is released to the pool only when the sample
+ * still has it since users may replace the data with their own one.
+ * The header cannot be detected reliably, so the public API accepts only the samples allocated here. */
+typedef struct
 {
-    lsmash_sample_t *sample = lsmash_malloc_zero( sizeof(lsmash_sample_t) );
-    if( !sample )
+    lsmash_sample_pool_t *pool;         /* the pool which the sample is allocated from if any */
+    uint8_t              *pooled_data;
+    lsmash_sample_t       sample;
+} isom_sample_holder_t;
+
+static inline isom_sample_holder_t *isom_get_sample_holder( lsmash_sample_t *sample )
+{
+    return (isom_sample_holder_t *)((uint8_t *)sample - offsetof( isom_sample_holder_t, sample ));
+}
+
+static void isom_free_sample_data( isom_sample_holder_t *holder )
+{
+    if( holder->sample.data && holder->sample.data == holder->pooled_data )
+        lsmash_recycler_free( holder->sample.data );
+    else
+        lsmash_free( holder->sample.data );
+    holder->sample.data = NULL;
+    holder->pooled_data = NULL;
+}
+
+lsmash_sample_t *isom_create_sample( lsmash_sample_pool_t *pool, uint32_t size )
+{
+    isom_sample_holder_t *holder = pool
+                                 ? lsmash_recycler_alloc( pool, sizeof(isom_sample_holder_t) )
+                                 : lsmash_malloc( sizeof(isom_sample_holder_t) );
+    if( !holder )
         return NULL;
+    memset( holder, 0, sizeof(isom_sample_holder_t) );
+    holder->pool = pool;
+    lsmash_sample_t *sample = &holder->sample;
     if( size == 0 )
         return sample;
-    sample->data = lsmash_malloc( size );
+    sample->data = pool ? lsmash_recycler_alloc( pool, size ) : lsmash_malloc( size );
     if( !sample->data )
     {
-        lsmash_free( sample );
+        lsmash_delete_sample( sample );
         return NULL;
     }
-    sample->length = size;
+    holder->pooled_data = pool ? sample->data : NULL;
+    sample->length      = size;
     return sample;
 }
 
+lsmash_sample_t *lsmash_create_sample( uint32_t size )
+{
+    return isom_create_sample( NULL, size );
+}
+
 int lsmash_sample_alloc( lsmash_sample_t *sample, uint32_t size )
 {
     if( !sample )
         return LSMASH_ERR_FUNCTION_PARAM;
+    isom_sample_holder_t *holder = isom_get_sample_holder( sample );
     if( size == 0 )
     {
-        lsmash_free( sample->data );
-        sample->data   = NULL;
+        isom_free_sample_data( holder );
         sample->length = 0;
         return 0;
     }
     if( size == sample->length )
         return 0;
     uint8_t *data;
-    if( !sample->data )
+    if( holder->pool )
+    {
+        int pooled = sample->data && sample->data == holder->pooled_data;
+        if( pooled && size <= lsmash_recycler_get_capacity( sample->data ) )
+        {
+            sample->length = size;
+            return 0;
+        }
+        data = lsmash_recycler_alloc( holder->pool, size );
+        if( !data )
+            return LSMASH_ERR_MEMORY_ALLOC;
+        if( sample->data )
+        {
+            memcpy( data, sample->data, LSMASH_MIN( sample->length, size ) );
+            isom_free_sample_data( holder );
+        }
+        holder->pooled_data = data;
+    }
+    else if( !sample->data )
         data = lsmash_malloc( size );
     else
         data = lsmash_realloc( sample->data, size );
@@ -2885,31 +3008,80 @@ void lsmash_delete_sample( lsmash_sample_t *sample )
 {
     if( !sample )
         return;
-    lsmash_free( sample->data );
-    lsmash_free( sample );
+    isom_sample_holder_t *holder = isom_get_sample_holder( sample );
+    isom_free_sample_data( holder );
+    if( holder->pool )
+        lsmash_recycler_free( holder );
+    else
+        lsmash_free( holder );
+}
+
+lsmash_sample_pool_t *lsmash_create_sample_pool( uint64_t max_cached_size )
+{
+    return lsmash_recycler_create( max_cached_size );
 }
 
-isom_sample_pool_t *isom_create_sample_pool( uint64_t size )
+void lsmash_destroy_sample_pool( lsmash_sample_pool_t *pool )
+{
+    lsmash_recycler_destroy( pool );
+}
+
+lsmash_sample_t *lsmash_create_sample_from_pool( lsmash_sample_pool_t *pool, uint32_t size )
+{
+    return isom_create_sample( pool, size );
+}
+
+int lsmash_get_sample_pool_stats( lsmash_sample_pool_t *pool, lsmash_sample_pool_stats_t *stats )
+{
+    if( !pool || !stats )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    lsmash_recycler_get_stats( pool, stats );
+    return 0;
+}
+
+int lsmash_set_sample_pool( lsmash_root_t *root, lsmash_sample_pool_t *pool )
+{
+    if( LSMASH_IS_NON_EXISTING_BOX( root ) )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    lsmash_recycler_destroy( root->sample_pool );
+    root->sample_pool = lsmash_recycler_ref( pool );
+    return 0;
+}
+
+isom_sample_pool_t *isom_create_sample_pool( uint32_t alloc )
 {
     isom_sample_pool_t *pool = lsmash_malloc_zero( sizeof(isom_sample_pool_t) );
     if( !pool )
         return NULL;
-    if( size == 0 )
+    if( alloc == 0 )
         return pool;
-    pool->data = lsmash_malloc( size );
+    pool->data = lsmash_malloc( alloc * sizeof(lsmash_bs_iovec_t) );
     if( !pool->data )
     {
         lsmash_free( pool );
         return NULL;
     }
-    pool->alloc = size;
+    pool->alloc = alloc;
     return pool;
 }
 
+static void isom_empty_sample_pool( isom_sample_pool_t *pool )
+{
+    for( uint32_t i = 0; i < pool->entry_count; i++ )
+        if( pool->data[i].release )
+            pool->data[i].release( pool->data[i].data );
+        else
+            lsmash_free( pool->data[i].data );
+    pool->entry_count  = 0;
+    pool->sample_count = 0;
+    pool->size         = 0;
+}
+
 void isom_remove_sample_pool( isom_sample_pool_t *pool )
 {
     if( !pool )
         return;
+    isom_empty_sample_pool( pool );
     lsmash_free( pool->data );
     lsmash_free( pool );
 }
@@ -2924,12 +3096,12 @@ static uint32_t isom_add_size( isom_stbl_t *stbl, uint32_t sample_size )
 static uint32_t isom_add_dts( isom_stbl_t *stbl, uint64_t dts, uint64_t prev_dts )
 {
     isom_stts_t *stts = stbl->stts;
-    if( stts->list->entry_count == 0 )
+    if( stts->table.entry_count == 0 )
         return isom_add_stts_entry( stbl, dts ) < 0 ? 0 : dts;
     if( dts <= prev_dts )
         return 0;
     uint32_t sample_delta = dts - prev_dts;
-    isom_stts_entry_t *data = (isom_stts_entry_t *)stts->list->tail->data;
+    isom_stts_entry_t *data = isom_table_get_tail( &stts->table );
     if( data->sample_delta == sample_delta )
         ++ data->sample_count;
     else if( isom_add_stts_entry( stbl, sample_delta ) < 0 )
@@ -2957,9 +3129,9 @@ static int isom_add_initial_sample_offset( isom_stbl_t *stbl, uint32_t sample_of
 
 static int isom_add_sample_offset( isom_stbl_t *stbl, uint32_t sample_offset )
 {
-    if( !stbl->ctts->list )
+    isom_ctts_entry_t *data = isom_table_get_tail( &stbl->ctts->table );
+    if( !data )
         return LSMASH_ERR_INVALID_DATA;
-    isom_ctts_entry_t *data = (isom_ctts_entry_t *)stbl->ctts->list->tail->data;
     if( data->sample_offset == sample_offset )
         ++ data->sample_count;
     else
@@ -3028,7 +3200,7 @@ void isom_update_cache_timestamp
 
 static int isom_add_timestamp( isom_stbl_t *stbl, isom_cache_t *cache, lsmash_file_t *file, uint64_t dts, uint64_t cts )
 {
-    if( !cache || !stbl->stts->list )
+    if( !cache || LSMASH_IS_NON_EXISTING_BOX( stbl->stts ) )
         return LSMASH_ERR_INVALID_DATA;
     int non_output_sample = (cts == LSMASH_TIMESTAMP_UNDEFINED);
     int err = isom_check_sample_offset_compatibility( file, dts, cts, non_output_sample );
@@ -3617,7 +3789,7 @@ static int isom_update_chunk_tables
     isom_chunk_t  *current
 )
 {
-    isom_stsc_entry_t *last_stsc_data = stbl->stsc->list->tail ? (isom_stsc_entry_t *)stbl->stsc->list->tail->data : NULL;
+    isom_stsc_entry_t *last_stsc_data = isom_table_get_tail( &stbl->stsc->table );
     /* Create a new chunk sequence in this track if needed. */
     int err;
     if( (!last_stsc_data
@@ -3650,7 +3822,7 @@ static int isom_add_sample_to_chunk
      || LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->stbl->stsd )
      || !trak->cache
      ||  trak->mdia->mdhd->timescale == 0
-     || !trak->mdia->minf->stbl->stsc->list )
+     || LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->stbl->stsc ) )
         return LSMASH_ERR_INVALID_DATA;
     isom_chunk_t *current = &trak->cache->chunk;
     if( !current->pool )
@@ -3697,15 +3869,16 @@ static int isom_write_pooled_samples( lsmash_file_t *file, isom_sample_pool_t *p
      || !(file->flags & LSMASH_FILE_MODE_MEDIA)
      || ((file->flags & LSMASH_FILE_MODE_BOX) && LSMASH_IS_NON_EXISTING_BOX( file->mdat )) )
         return LSMASH_ERR_INVALID_DATA;
-    lsmash_bs_put_bytes( file->bs, pool->size, pool->data );
-    int err = lsmash_bs_flush_buffer( file->bs );
+    /* The data of the samples is handed over, and may be written in background.
+     * Even so, the sizes are exact here since the bytestream counts the data as written. */
+    int err = lsmash_bs_write_vectors_and_free( file->bs, pool->data, pool->entry_count );
+    pool->entry_count = 0;
     if( err < 0 )
         return err;
     if( LSMASH_IS_EXISTING_BOX( file->mdat ) )
         file->mdat->media_size += pool->size;
     file->size += pool->size;
-    pool->sample_count = 0;
-    pool->size         = 0;
+    isom_empty_sample_pool( pool );
     return 0;
 }
 
@@ -3782,7 +3955,7 @@ static int isom_output_cached_chunk( isom_trak_t *trak )
 {
     isom_chunk_t      *chunk          = &trak->cache->chunk;
     isom_stbl_t       *stbl           = trak->mdia->minf->stbl;
-    isom_stsc_entry_t *last_stsc_data = stbl->stsc->list->tail ? (isom_stsc_entry_t *)stbl->stsc->list->tail->data : NULL;
+    isom_stsc_entry_t *last_stsc_data = isom_table_get_tail( &stbl->stsc->table );
     /* Create a new chunk sequence in this track if needed. */
     int err;
     if( (!last_stsc_data
@@ -3809,22 +3982,28 @@ static int isom_output_cached_chunk( isom_trak_t *trak )
 
 int isom_pool_sample( isom_sample_pool_t *pool, lsmash_sample_t *sample, uint32_t samples_per_packet )
 {
-    uint64_t pool_size = pool->size + sample->length;
-    if( pool->alloc < pool_size )
+    if( sample->length )
     {
-        uint8_t *data;
-        uint64_t alloc = pool_size + (1<<16);
-        if( !pool->data )
-            data = lsmash_malloc( alloc );
-        else
-            data = lsmash_realloc( pool->data, alloc );
-        if( !data )
-            return LSMASH_ERR_MEMORY_ALLOC;
-        pool->data  = data;
-        pool->alloc = alloc;
-    }
-    memcpy( pool->data + pool->size, sample->data, sample->length );
-    pool->size          = pool_size;
+        if( pool->alloc <= pool->entry_count )
+        {
+            uint32_t alloc = pool->alloc ? pool->alloc * 2 : 16;
+            lsmash_bs_iovec_t *data = lsmash_realloc( pool->data, alloc * sizeof(lsmash_bs_iovec_t) );
+            if( !data )
+                return LSMASH_ERR_MEMORY_ALLOC;
+            pool->data  = data;
+            pool->alloc = alloc;
+        }
+        /* Take over the data of the sample instead of copying it.
+         * The data is deallocated, or released to the sample pool, after written. */
+        isom_sample_holder_t *holder = isom_get_sample_holder( sample );
+        pool->data[ pool->entry_count ].data    = sample->data;
+        pool->data[ pool->entry_count ].size    = sample->length;
+        pool->data[ pool->entry_count ].release = sample->data == holder->pooled_data ? lsmash_recycler_free : NULL;
+        ++ pool->entry_count;
+        sample->data        = NULL;
+        holder->pooled_data = NULL;
+    }
+    pool->size         += sample->length;
     pool->sample_count += samples_per_packet;
     lsmash_delete_sample( sample );
     return 0;
@@ -3847,9 +4026,8 @@ static int isom_append_sample_internal
     {
         /* The sample_description_index in the cache is one of the next written chunk.
          * Therefore, it cannot be referenced here. */
-        lsmash_entry_list_t *stsc_list      = trak->mdia->minf->stbl->stsc->list;
-        isom_stsc_entry_t   *last_stsc_data = (isom_stsc_entry_t *)stsc_list->tail->data;
-        lsmash_file_t       *file           = isom_get_written_media_file( trak, last_stsc_data->sample_description_index );
+        isom_stsc_entry_t *last_stsc_data = isom_table_get_tail( &trak->mdia->minf->stbl->stsc->table );
+        lsmash_file_t     *file           = isom_get_written_media_file( trak, last_stsc_data->sample_description_index );
         if( (ret = isom_write_pooled_samples( file, current_pool )) < 0 )
             return ret;
     }
@@ -3869,7 +4047,7 @@ static int isom_append_sample_internal
          || LSMASH_IS_NON_EXISTING_BOX( other->mdia->mdhd )
          || !other->cache
          ||  other->mdia->mdhd->timescale == 0
-         || !other->mdia->minf->stbl->stsc->list )
+         || LSMASH_IS_NON_EXISTING_BOX( other->mdia->minf->stbl->stsc ) )
             return LSMASH_ERR_INVALID_DATA;
         isom_chunk_t *chunk = &other->cache->chunk;
         if( !chunk->pool || chunk->pool->sample_count == 0 )
@@ -3911,7 +4089,7 @@ int isom_append_sample_by_type
         uint64_t cts = sample->cts;
         for( uint32_t offset = 0; offset < sample->length; offset += frame_size )
         {
-            lsmash_sample_t *lpcm_sample = lsmash_create_sample( frame_size );
+            lsmash_sample_t *lpcm_sample = isom_create_sample( isom_get_sample_holder( sample )->pool, frame_size );
             if( !lpcm_sample )
                 return LSMASH_ERR_MEMORY_ALLOC;
             memcpy( lpcm_sample->data, sample->data + offset, frame_size );
@@ -3957,6 +4135,32 @@ int isom_append_sample_by_type
     return func_append_sample( track, sample, sample_entry );
 }
 
+/* Write the space reserved for the Movie Box as a Free Space Box filled with zeros. */
+static int isom_write_movie_reservation( lsmash_file_t *file )
+{
+    lsmash_bs_t *bs  = file->bs;
+    int          err = lsmash_bs_flush_buffer( bs );
+    if( err < 0 )
+        return err;
+    file->movie_reserved_pos = bs->offset;
+    lsmash_bs_put_be32( bs, file->movie_reserved_size );
+    lsmash_bs_put_be32( bs, ISOM_BOX_TYPE_FREE.fourcc );
+    if( (err = lsmash_bs_flush_buffer( bs )) < 0 )
+        return err;
+    uint64_t padding_size = file->movie_reserved_size - ISOM_BASEBOX_COMMON_SIZE;
+    static const uint8_t zero_bytes[64] = { 0 };
+    while( padding_size > sizeof(zero_bytes) )
+    {
+        if( (err = lsmash_bs_write_data( bs, zero_bytes, sizeof(zero_bytes) )) < 0 )
+            return err;
+        padding_size -= sizeof(zero_bytes);
+    }
+    if( (err = lsmash_bs_write_data( bs, zero_bytes, padding_size )) < 0 )
+        return err;
+    file->size += file->movie_reserved_size;
+    return 0;
+}
+
 /* This function is for non-fragmented movie. */
 static int isom_append_sample
 (
@@ -3973,6 +4177,8 @@ static int isom_append_sample
     {
         if( mdat_absent && LSMASH_IS_BOX_ADDITION_FAILURE( isom_add_mdat( file ) ) )
             return LSMASH_ERR_NAMELESS;
+        if( file->movie_reserved_size && (err = isom_write_movie_reservation( file )) < 0 )
+            return err;
         file->mdat->manager |= LSMASH_PLACEHOLDER;
         if( (err = isom_write_box( file->bs, (isom_box_t *)file->mdat )) < 0 )
             return err;
@@ -4047,7 +4253,7 @@ int lsmash_flush_pooled_samples( lsmash_root_t *root, uint32_t track_ID, uint32_
     isom_trak_t *trak = isom_get_trak( file, track_ID );
     if( LSMASH_IS_NON_EXISTING_BOX( trak )
      || !trak->cache
-     || !trak->mdia->minf->stbl->stsc->list )
+     || LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->stbl->stsc ) )
         return LSMASH_ERR_NAMELESS;
     int err = isom_output_cache( trak );
     if( err < 0 )
@@ -4088,9 +4294,9 @@ int lsmash_append_sample( lsmash_root_t *root, uint32_t track_ID, lsmash_sample_
      || LSMASH_IS_NON_EXISTING_BOX( trak->tkhd )
      ||  trak->mdia->mdhd->timescale == 0
      || !trak->cache
-     || !trak->mdia->minf->stbl->stsc->list )
+     || LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->stbl->stsc ) )
         return LSMASH_ERR_NAMELESS;
-    isom_sample_entry_t *sample_entry = (isom_sample_entry_t *)lsmash_list_get_entry_data( &trak->mdia->minf->stbl->stsd->list, sample->index );
+    isom_sample_entry_t *sample_entry = (isom_sample_entry_t *)lsmash_vector_get_entry_data( &trak->mdia->minf->stbl->stsd->list, sample->index );
     if( LSMASH_IS_NON_EXISTING_BOX( sample_entry ) )
         return LSMASH_ERR_NAMELESS;
     /* Append a sample. */
@@ -28,6 +28,7 @@
 #include <stdarg.h> /* for isom_iprintf */
 
 #include "box.h"
+#include "read.h"
 
 
 typedef int (*isom_print_box_t)( FILE *, lsmash_file_t *, isom_box_t *, int );
@@ -1605,17 +1606,14 @@ static int isom_print_sample_description_extesion( FILE *fp, lsmash_file_t *file
 
 static int isom_print_stts( FILE *fp, lsmash_file_t *file, isom_box_t *box, int level )
 {
-    if( !((isom_stts_t *)box)->list )
-        return LSMASH_ERR_INVALID_DATA;
     isom_stts_t *stts = (isom_stts_t *)box;
     int indent = level;
-    uint32_t i = 0;
     isom_print_box_common( fp, indent++, box, "Decoding Time to Sample Box" );
-    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", stts->list->entry_count );
-    for( lsmash_entry_t *entry = stts->list->head; entry; entry = entry->next )
+    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", stts->table.entry_count );
+    for( uint32_t i = 0; i < stts->table.entry_count; i++ )
     {
-        isom_stts_entry_t *data = (isom_stts_entry_t *)entry->data;
-        lsmash_ifprintf( fp, indent++, "entry[%"PRIu32"]\n", i++ );
+        isom_stts_entry_t *data = (isom_stts_entry_t *)stts->table.data + i;
+        lsmash_ifprintf( fp, indent++, "entry[%"PRIu32"]\n", i );
         lsmash_ifprintf( fp, indent, "sample_count = %"PRIu32"\n", data->sample_count );
         lsmash_ifprintf( fp, indent--, "sample_delta = %"PRIu32"\n", data->sample_delta );
     }
@@ -1624,18 +1622,15 @@ static int isom_print_stts( FILE *fp, lsmash_file_t *file, isom_box_t *box, int
 
 static int isom_print_ctts( FILE *fp, lsmash_file_t *file, isom_box_t *box, int level )
 {
-    if( !((isom_ctts_t *)box)->list )
-        return LSMASH_ERR_INVALID_DATA;
     isom_ctts_t *ctts = (isom_ctts_t *)box;
     int indent = level;
-    uint32_t i = 0;
     isom_print_box_common( fp, indent++, box, "Composition Time to Sample Box" );
-    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", ctts->list->entry_count );
+    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", ctts->table.entry_count );
     if( file->qt_compatible || ctts->version == 1 )
-        for( lsmash_entry_t *entry = ctts->list->head; entry; entry = entry->next )
+        for( uint32_t i = 0; i < ctts->table.entry_count; i++ )
         {
-            isom_ctts_entry_t *data = (isom_ctts_entry_t *)entry->data;
-            lsmash_ifprintf( fp, indent++, "entry[%"PRIu32"]\n", i++ );
+            isom_ctts_entry_t *data = (isom_ctts_entry_t *)ctts->table.data + i;
+            lsmash_ifprintf( fp, indent++, "entry[%"PRIu32"]\n", i );
             lsmash_ifprintf( fp, indent, "sample_count = %"PRIu32"\n", data->sample_count );
             if( data->sample_offset != ISOM_NON_OUTPUT_SAMPLE_OFFSET )
                 lsmash_ifprintf( fp, indent--, "sample_offset = %"PRId32"\n", (union {uint32_t ui; int32_t si;}){ data->sample_offset }.si );
@@ -1643,10 +1638,10 @@ static int isom_print_ctts( FILE *fp, lsmash_file_t *file, isom_box_t *box, int
                 lsmash_ifprintf( fp, indent--, "sample_offset = -2^31 (non-output sample)\n" );
         }
     else
-        for( lsmash_entry_t *entry = ctts->list->head; entry; entry = entry->next )
+        for( uint32_t i = 0; i < ctts->table.entry_count; i++ )
         {
-            isom_ctts_entry_t *data = (isom_ctts_entry_t *)entry->data;
-            lsmash_ifprintf( fp, indent++, "entry[%"PRIu32"]\n", i++ );
+            isom_ctts_entry_t *data = (isom_ctts_entry_t *)ctts->table.data + i;
+            lsmash_ifprintf( fp, indent++, "entry[%"PRIu32"]\n", i );
             lsmash_ifprintf( fp, indent, "sample_count = %"PRIu32"\n", data->sample_count );
             lsmash_ifprintf( fp, indent--, "sample_offset = %"PRIu32"\n", data->sample_offset );
         }
@@ -1680,44 +1675,35 @@ static int isom_print_cslg( FILE *fp, lsmash_file_t *file, isom_box_t *box, int
 
 static int isom_print_stss( FILE *fp, lsmash_file_t *file, isom_box_t *box, int level )
 {
-    if( !((isom_stss_t *)box)->list )
-        return LSMASH_ERR_INVALID_DATA;
     isom_stss_t *stss = (isom_stss_t *)box;
     int indent = level;
-    uint32_t i = 0;
     isom_print_box_common( fp, indent++, box, "Sync Sample Box" );
-    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", stss->list->entry_count );
-    for( lsmash_entry_t *entry = stss->list->head; entry; entry = entry->next )
-        lsmash_ifprintf( fp, indent, "sample_number[%"PRIu32"] = %"PRIu32"\n", i++, ((isom_stss_entry_t *)entry->data)->sample_number );
+    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", stss->table.entry_count );
+    for( uint32_t i = 0; i < stss->table.entry_count; i++ )
+        lsmash_ifprintf( fp, indent, "sample_number[%"PRIu32"] = %"PRIu32"\n", i, ((isom_stss_entry_t *)stss->table.data)[i].sample_number );
     return 0;
 }
 
 static int isom_print_stps( FILE *fp, lsmash_file_t *file, isom_box_t *box, int level )
 {
-    if( !((isom_stps_t *)box)->list )
-        return LSMASH_ERR_INVALID_DATA;
     isom_stps_t *stps = (isom_stps_t *)box;
     int indent = level;
-    uint32_t i = 0;
     isom_print_box_common( fp, indent++, box, "Partial Sync Sample Box" );
-    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", stps->list->entry_count );
-    for( lsmash_entry_t *entry = stps->list->head; entry; entry = entry->next )
-        lsmash_ifprintf( fp, indent, "sample_number[%"PRIu32"] = %"PRIu32"\n", i++, ((isom_stps_entry_t *)entry->data)->sample_number );
+    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", stps->table.entry_count );
+    for( uint32_t i = 0; i < stps->table.entry_count; i++ )
+        lsmash_ifprintf( fp, indent, "sample_number[%"PRIu32"] = %"PRIu32"\n", i, ((isom_stps_entry_t *)stps->table.data)[i].sample_number );
     return 0;
 }
 
 static int isom_print_sdtp( FILE *fp, lsmash_file_t *file, isom_box_t *box, int level )
 {
-    if( !((isom_sdtp_t *)box)->list )
-        return LSMASH_ERR_INVALID_DATA;
     isom_sdtp_t *sdtp = (isom_sdtp_t *)box;
     int indent = level;
-    uint32_t i = 0;
     isom_print_box_common( fp, indent++, box, "Independent and Disposable Samples Box" );
-    for( lsmash_entry_t *entry = sdtp->list->head; entry; entry = entry->next )
+    for( uint32_t i = 0; i < sdtp->table.entry_count; i++ )
     {
-        isom_sdtp_entry_t *data = (isom_sdtp_entry_t *)entry->data;
-        lsmash_ifprintf( fp, indent++, "entry[%"PRIu32"]\n", i++ );
+        isom_sdtp_entry_t *data = (isom_sdtp_entry_t *)sdtp->table.data + i;
+        lsmash_ifprintf( fp, indent++, "entry[%"PRIu32"]\n", i );
         if( data->is_leading || data->sample_depends_on || data->sample_is_depended_on || data->sample_has_redundancy )
         {
             if( file->avc_extensions )
@@ -1753,17 +1739,14 @@ static int isom_print_sdtp( FILE *fp, lsmash_file_t *file, isom_box_t *box, int
 
 static int isom_print_stsc( FILE *fp, lsmash_file_t *file, isom_box_t *box, int level )
 {
-    if( !((isom_stsc_t *)box)->list )
-        return LSMASH_ERR_INVALID_DATA;
     isom_stsc_t *stsc = (isom_stsc_t *)box;
     int indent = level;
-    uint32_t i = 0;
     isom_print_box_common( fp, indent++, box, "Sample To Chunk Box" );
-    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", stsc->list->entry_count );
-    for( lsmash_entry_t *entry = stsc->list->head; entry; entry = entry->next )
+    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", stsc->table.entry_count );
+    for( uint32_t i = 0; i < stsc->table.entry_count; i++ )
     {
-        isom_stsc_entry_t *data = (isom_stsc_entry_t *)entry->data;
-        lsmash_ifprintf( fp, indent++, "entry[%"PRIu32"]\n", i++ );
+        isom_stsc_entry_t *data = (isom_stsc_entry_t *)stsc->table.data + i;
+        lsmash_ifprintf( fp, indent++, "entry[%"PRIu32"]\n", i );
         lsmash_ifprintf( fp, indent, "first_chunk = %"PRIu32"\n", data->first_chunk );
         lsmash_ifprintf( fp, indent, "samples_per_chunk = %"PRIu32"\n", data->samples_per_chunk );
         lsmash_ifprintf( fp, indent--, "sample_description_index = %"PRIu32"\n", data->sample_description_index );
@@ -1775,18 +1758,17 @@ static int isom_print_stsz( FILE *fp, lsmash_file_t *file, isom_box_t *box, int
 {
     isom_stsz_t *stsz = (isom_stsz_t *)box;
     int indent = level;
-    uint32_t i = 0;
     isom_print_box_common( fp, indent++, box, "Sample Size Box" );
     if( !stsz->sample_size )
         lsmash_ifprintf( fp, indent, "sample_size = 0 (variable)\n" );
     else
         lsmash_ifprintf( fp, indent, "sample_size = %"PRIu32" (constant)\n", stsz->sample_size );
     lsmash_ifprintf( fp, indent, "sample_count = %"PRIu32"\n", stsz->sample_count );
-    if( !stsz->sample_size && stsz->list )
-        for( lsmash_entry_t *entry = stsz->list->head; entry; entry = entry->next )
+    if( !stsz->sample_size )
+        for( uint32_t i = 0; i < stsz->table.entry_count; i++ )
         {
-            isom_stsz_entry_t *data = (isom_stsz_entry_t *)entry->data;
-            lsmash_ifprintf( fp, indent, "entry_size[%"PRIu32"] = %"PRIu32"\n", i++, data->entry_size );
+            isom_stsz_entry_t *data = (isom_stsz_entry_t *)stsz->table.data + i;
+            lsmash_ifprintf( fp, indent, "entry_size[%"PRIu32"] = %"PRIu32"\n", i, data->entry_size );
         }
     return 0;
 }
@@ -1795,37 +1777,33 @@ static int isom_print_stz2( FILE *fp, lsmash_file_t *file, isom_box_t *box, int
 {
     isom_stz2_t *stz2 = (isom_stz2_t *)box;
     int indent = level;
-    uint32_t i = 0;
     isom_print_box_common( fp, indent++, box, "Compact Sample Size Box" );
     lsmash_ifprintf( fp, indent, "reserved = 0x%06"PRIx32"\n", stz2->reserved );
     lsmash_ifprintf( fp, indent, "field_size = %"PRIu8"\n", stz2->field_size );
     lsmash_ifprintf( fp, indent, "sample_count = %"PRIu32"\n", stz2->sample_count );
-    for( lsmash_entry_t *entry = stz2->list->head; entry; entry = entry->next )
+    for( uint32_t i = 0; i < stz2->table.entry_count; i++ )
     {
-        isom_stsz_entry_t *data = (isom_stsz_entry_t *)entry->data;
-        lsmash_ifprintf( fp, indent, "entry_size[%"PRIu32"] = %"PRIu32"\n", i++, data->entry_size );
+        isom_stsz_entry_t *data = (isom_stsz_entry_t *)stz2->table.data + i;
+        lsmash_ifprintf( fp, indent, "entry_size[%"PRIu32"] = %"PRIu32"\n", i, data->entry_size );
     }
     return 0;
 }
 
 static int isom_print_stco( FILE *fp, lsmash_file_t *file, isom_box_t *box, int level )
 {
-    if( !((isom_stco_t *)box)->list )
-        return LSMASH_ERR_INVALID_DATA;
     isom_stco_t *stco = (isom_stco_t *)box;
     int indent = level;
-    uint32_t i = 0;
     isom_print_box_common( fp, indent++, box, "Chunk Offset Box" );
-    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", stco->list->entry_count );
+    lsmash_ifprintf( fp, indent, "entry_count = %"PRIu32"\n", stco->table.entry_count );
     if( lsmash_check_box_type_identical( stco->type, ISOM_BOX_TYPE_STCO ) )
     {
-        for( lsmash_entry_t *entry = stco->list->head; entry; entry = entry->next )
-            lsmash_ifprintf( fp, indent, "chunk_offset[%"PRIu32"] = %"PRIu32"\n", i++, ((isom_stco_entry_t *)entry->data)->chunk_offset );
+        for( uint32_t i = 0; i < stco->table.entry_count; i++ )
+            lsmash_ifprintf( fp, indent, "chunk_offset[%"PRIu32"] = %"PRIu32"\n", i, ((isom_stco_entry_t *)stco->table.data)[i].chunk_offset );
     }
     else
     {
-        for( lsmash_entry_t *entry = stco->list->head; entry; entry = entry->next )
-            lsmash_ifprintf( fp, indent, "chunk_offset[%"PRIu32"] = %"PRIu64"\n", i++, ((isom_co64_entry_t *)entry->data)->chunk_offset );
+        for( uint32_t i = 0; i < stco->table.entry_count; i++ )
+            lsmash_ifprintf( fp, indent, "chunk_offset[%"PRIu32"] = %"PRIu64"\n", i, ((isom_co64_entry_t *)stco->table.data)[i].chunk_offset );
     }
     return 0;
 }
@@ -2645,7 +2623,9 @@ int lsmash_print_movie( lsmash_root_t *root, const char *filename )
             fclose( destination );
             return LSMASH_ERR_NAMELESS;
         }
-        int ret = data->func( destination, file, data->box, data->level );
+        int ret = isom_load_deferred_box( data->box );
+        if( ret == 0 )
+            ret = data->func( destination, file, data->box, data->level );
         if( ret < 0 )
         {
             fclose( destination );
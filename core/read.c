@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <limits.h>
 
 #include "box.h"
 #include "box_default.h"
@@ -176,6 +177,57 @@ static void isom_skip_box_rest( lsmash_bs_t *bs, isom_box_t *box )
         box->manager |= LSMASH_INCOMPLETE_BOX;
 }
 
+/* Read the stream until the next 'size' bytes are on the buffer, or up to the end of the stream known so far,
+ * so that no bytes beyond them are read. */
+static void isom_bs_read_exactly( lsmash_bs_t *bs, uint64_t size )
+{
+    uint64_t pos = lsmash_bs_get_stream_pos( bs );
+    if( bs->written >= pos )
+        size = LSMASH_MIN( size, bs->written - pos );
+    lsmash_bs_dispose_past_data( bs );
+    while( !bs->eof && !bs->error && lsmash_bs_get_remaining_buffer_size( bs ) < size )
+        if( lsmash_bs_read( bs, LSMASH_MIN( size - lsmash_bs_get_remaining_buffer_size( bs ), INT_MAX ) ) <= 0 )
+            break;
+}
+
+/* Read the top-level box at the current position by its exact size, or only its header if the rest is skipped,
+ * so that the box is read by at most a few reads and the reads never go beyond the box. */
+static void isom_read_top_level_box_minimally( lsmash_file_t *file )
+{
+    lsmash_bs_t *bs = file->bs;
+    if( lsmash_bs_get_remaining_buffer_size( bs ) == 0
+     && lsmash_bs_get_stream_pos( bs ) >= bs->written )
+    {
+        /* Reached the end of the stream known by the last seek to it, so no more read is needed. */
+        bs->eof = 1;
+        return;
+    }
+    uint64_t header_size = ISOM_BASEBOX_COMMON_SIZE;
+    isom_bs_read_exactly( bs, header_size );
+    if( lsmash_bs_get_remaining_buffer_size( bs ) < header_size )
+        return;
+    uint64_t size = lsmash_bs_show_be32( bs, 0 );
+    uint32_t type = lsmash_bs_show_be32( bs, 4 );
+    if( size == 1 )
+    {
+        /* large size */
+        header_size += 8;
+        isom_bs_read_exactly( bs, header_size );
+        if( lsmash_bs_get_remaining_buffer_size( bs ) < header_size )
+            return;
+        size = lsmash_bs_show_be64( bs, 8 );
+    }
+    if( type == ISOM_BOX_TYPE_UUID.fourcc )
+        header_size += 16;
+    /* The rest of the box extending to the end of the file is not read here since its size is unknown. */
+    int skipped = size < header_size
+               || type == ISOM_BOX_TYPE_MDAT.fourcc
+               || type == ISOM_BOX_TYPE_FREE.fourcc
+               || type == ISOM_BOX_TYPE_SKIP.fourcc
+               || (type == ISOM_BOX_TYPE_MOOF.fourcc && file->read_lazily);
+    isom_bs_read_exactly( bs, skipped ? header_size : size );
+}
+
 static void isom_validate_box_size( lsmash_bs_t *bs, isom_box_t *box )
 {
     uint64_t pos = lsmash_bs_count( bs );
@@ -1251,14 +1303,14 @@ static void *isom_add_description( lsmash_codec_type_t sample_type, isom_stsd_t
     void *sample_desc = isom_sample_description_alloc( sample_type, stsd );
     if( !sample_desc )
         return NULL;
-    if( lsmash_list_add_entry( &stsd->list, sample_desc ) < 0 )
+    if( lsmash_vector_add_entry( &stsd->list, sample_desc ) < 0 )
     {
         lsmash_free( sample_desc );
         return NULL;
     }
     if( lsmash_list_add_entry( &stsd->extensions, sample_desc ) < 0 )
     {
-        lsmash_list_remove_entry_tail( &stsd->list );
+        lsmash_vector_remove_entry( &stsd->list, stsd->list.entry_count );
         return NULL;
     }
     return sample_desc;
@@ -1838,52 +1890,125 @@ static int isom_read_other_description( lsmash_file_t *file, isom_box_t *box, is
     return isom_read_unknown_box( file, box, parent, level );
 }
 
-static int isom_read_stts( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
+/* Allocate the entries of a table at once as far as the rest of the box can hold them.
+ * 'entry_count' is not trusted since it may be broken. */
+static int isom_reserve_table_entries( isom_table_t *table, isom_box_t *box, lsmash_bs_t *bs, uint64_t entry_count, uint32_t bytes_per_entry )
 {
-    if( !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL )
-     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stts ) )
-        return isom_read_unknown_box( file, box, parent, level );
-    ADD_BOX( stts, isom_stbl_t );
-    lsmash_bs_t *bs = file->bs;
+    uint64_t pos = lsmash_bs_count( bs );
+    uint64_t max_entry_count = pos < box->size ? (box->size - pos + bytes_per_entry - 1) / bytes_per_entry : 0;
+    return isom_table_reserve( table, (uint32_t)LSMASH_MIN( entry_count, max_entry_count ) );
+}
+
+/* Read the entries of a table consisting only of big endian fields of 'field_size' bytes
+ * at once as far as the rest of the box wholly holds them and the table has room for them.
+ * The rest of the entries, if any, are left to the caller. */
+static void isom_read_table_entries_at_once( isom_table_t *table, isom_box_t *box, lsmash_bs_t *bs, uint32_t entry_count, int field_size )
+{
+    uint64_t pos   = lsmash_bs_count( bs );
+    uint32_t limit = LSMASH_MIN( entry_count, table->alloc_count );
+    if( pos >= box->size || table->entry_count >= limit )
+        return;
+    uint32_t count = (uint32_t)LSMASH_MIN( (box->size - pos) / table->entry_size, (uint64_t)(limit - table->entry_count) );
+    void    *data  = (uint8_t *)table->data + (size_t)table->entry_count * table->entry_size;
+    size_t   words = (size_t)count * (table->entry_size / field_size);
+    if( field_size == 8 )
+        lsmash_bs_get_be64_array( bs, (uint64_t *)data, words );
+    else
+        lsmash_bs_get_be32_array( bs, (uint32_t *)data, words );
+    table->entry_count += count;
+}
+
+/* The entries of a table box smaller than this are always read at once since deferring them saves little. */
+#define ISOM_DEFERRED_BOX_MIN_SIZE 256
+
+/* A reader of the fields of a table box following the box header.
+ * If 'read_entries' is set to 0, only the fields preceding the entries are read.
+ * 'box' is the box header just read, and 'instance' is the box in struct format. */
+typedef int (*isom_entries_reader_t)( lsmash_bs_t *bs, isom_box_t *box, void *instance, int read_entries );
+
+static int isom_read_table_box_rest( lsmash_file_t *file, isom_box_t *box, int level, void *instance, isom_entries_reader_t read_entries )
+{
+    lsmash_bs_t *bs = file->bs;
+    /* If requested, the entries of a large table box are not read here, and only its position is kept
+     * so that isom_load_deferred_box() can read them the first time they are needed.
+     * A table box not larger than a read from the stream is read at once since its bytes are read together with
+     * the neighbouring boxes anyway, and deferring it would read them twice. */
+    int defer = file->read_lazily
+             && !file->read_minimally   /* The whole of the parent box has been read already. */
+             && !file->fake_file_mode
+             && !bs->unseekable
+             && !(box->manager & LSMASH_LAST_BOX)
+             && box->size >= ISOM_DEFERRED_BOX_MIN_SIZE
+             && box->size >  bs->buffer.max_size;
+    int err = read_entries( bs, box, instance, !defer );
+    if( err < 0 )
+        return err;
+    if( !defer )
+        return isom_read_leaf_box_common_last_process( file, box, level, instance );
+    isom_skip_box_rest( bs, box );
+    isom_box_common_copy( instance, box );
+    ((isom_box_t *)instance)->manager |= LSMASH_DEFERRED_BOX;
+    return isom_add_print_func( file, instance, level );
+}
+
+static int isom_read_stts_entries( lsmash_bs_t *bs, isom_box_t *box, void *instance, int read_entries )
+{
+    isom_stts_t *stts = (isom_stts_t *)instance;
     uint32_t entry_count = lsmash_bs_get_be32( bs );
-    for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stts->list->entry_count < entry_count; pos = lsmash_bs_count( bs ) )
+    if( !read_entries )
+        return 0;
+    int err = isom_reserve_table_entries( &stts->table, box, bs, entry_count, 8 );
+    if( err < 0 )
+        return err;
+    isom_read_table_entries_at_once( &stts->table, box, bs, entry_count, 4 );
+    for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stts->table.entry_count < entry_count; pos = lsmash_bs_count( bs ) )
     {
-        isom_stts_entry_t *data = lsmash_malloc( sizeof(isom_stts_entry_t) );
+        isom_stts_entry_t *data = isom_table_add_entry( &stts->table );
         if( !data )
             return LSMASH_ERR_MEMORY_ALLOC;
-        if( lsmash_list_add_entry( stts->list, data ) < 0 )
-        {
-            lsmash_free( data );
-            return LSMASH_ERR_MEMORY_ALLOC;
-        }
         data->sample_count = lsmash_bs_get_be32( bs );
         data->sample_delta = lsmash_bs_get_be32( bs );
     }
-    return isom_read_leaf_box_common_last_process( file, box, level, stts );
+    return 0;
 }
 
-static int isom_read_ctts( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
+static int isom_read_stts( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
 {
     if( !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL )
-     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->ctts ) )
+     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stts ) )
         return isom_read_unknown_box( file, box, parent, level );
-    ADD_BOX( ctts, isom_stbl_t );
-    lsmash_bs_t *bs = file->bs;
+    ADD_BOX( stts, isom_stbl_t );
+    return isom_read_table_box_rest( file, box, level, stts, isom_read_stts_entries );
+}
+
+static int isom_read_ctts_entries( lsmash_bs_t *bs, isom_box_t *box, void *instance, int read_entries )
+{
+    isom_ctts_t *ctts = (isom_ctts_t *)instance;
     uint32_t entry_count = lsmash_bs_get_be32( bs );
-    for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && ctts->list->entry_count < entry_count; pos = lsmash_bs_count( bs ) )
+    if( !read_entries )
+        return 0;
+    int err = isom_reserve_table_entries( &ctts->table, box, bs, entry_count, 8 );
+    if( err < 0 )
+        return err;
+    isom_read_table_entries_at_once( &ctts->table, box, bs, entry_count, 4 );
+    for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && ctts->table.entry_count < entry_count; pos = lsmash_bs_count( bs ) )
     {
-        isom_ctts_entry_t *data = lsmash_malloc( sizeof(isom_ctts_entry_t) );
+        isom_ctts_entry_t *data = isom_table_add_entry( &ctts->table );
         if( !data )
             return LSMASH_ERR_MEMORY_ALLOC;
-        if( lsmash_list_add_entry( ctts->list, data ) < 0 )
-        {
-            lsmash_free( data );
-            return LSMASH_ERR_MEMORY_ALLOC;
-        }
         data->sample_count  = lsmash_bs_get_be32( bs );
         data->sample_offset = lsmash_bs_get_be32( bs );
     }
-    return isom_read_leaf_box_common_last_process( file, box, level, ctts );
+    return 0;
+}
+
+static int isom_read_ctts( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
+{
+    if( !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL )
+     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->ctts ) )
+        return isom_read_unknown_box( file, box, parent, level );
+    ADD_BOX( ctts, isom_stbl_t );
+    return isom_read_table_box_rest( file, box, level, ctts, isom_read_ctts_entries );
 }
 
 static int isom_read_cslg( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
@@ -1901,27 +2026,53 @@ static int isom_read_cslg( lsmash_file_t *file, isom_box_t *box, isom_box_t *par
     return isom_read_leaf_box_common_last_process( file, box, level, cslg );
 }
 
+static int isom_read_stss_entries( lsmash_bs_t *bs, isom_box_t *box, void *instance, int read_entries )
+{
+    isom_stss_t *stss = (isom_stss_t *)instance;
+    uint32_t entry_count = lsmash_bs_get_be32( bs );
+    if( !read_entries )
+        return 0;
+    int err = isom_reserve_table_entries( &stss->table, box, bs, entry_count, 4 );
+    if( err < 0 )
+        return err;
+    isom_read_table_entries_at_once( &stss->table, box, bs, entry_count, 4 );
+    for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stss->table.entry_count < entry_count; pos = lsmash_bs_count( bs ) )
+    {
+        isom_stss_entry_t *data = isom_table_add_entry( &stss->table );
+        if( !data )
+            return LSMASH_ERR_MEMORY_ALLOC;
+        data->sample_number = lsmash_bs_get_be32( bs );
+    }
+    return 0;
+}
+
 static int isom_read_stss( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
 {
     if( !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL )
      || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stss ) )
         return isom_read_unknown_box( file, box, parent, level );
     ADD_BOX( stss, isom_stbl_t );
-    lsmash_bs_t *bs = file->bs;
+    return isom_read_table_box_rest( file, box, level, stss, isom_read_stss_entries );
+}
+
+static int isom_read_stps_entries( lsmash_bs_t *bs, isom_box_t *box, void *instance, int read_entries )
+{
+    isom_stps_t *stps = (isom_stps_t *)instance;
     uint32_t entry_count = lsmash_bs_get_be32( bs );
-    for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stss->list->entry_count < entry_count; pos = lsmash_bs_count( bs ) )
+    if( !read_entries )
+        return 0;
+    int err = isom_reserve_table_entries( &stps->table, box, bs, entry_count, 4 );
+    if( err < 0 )
+        return err;
+    isom_read_table_entries_at_once( &stps->table, box, bs, entry_count, 4 );
+    for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stps->table.entry_count < entry_count; pos = lsmash_bs_count( bs ) )
     {
-        isom_stss_entry_t *data = lsmash_malloc( sizeof(isom_stss_entry_t) );
+        isom_stps_entry_t *data = isom_table_add_entry( &stps->table );
         if( !data )
             return LSMASH_ERR_MEMORY_ALLOC;
-        if( lsmash_list_add_entry( stss->list, data ) < 0 )
-        {
-            lsmash_free( data );
-            return LSMASH_ERR_MEMORY_ALLOC;
-        }
         data->sample_number = lsmash_bs_get_be32( bs );
     }
-    return isom_read_leaf_box_common_last_process( file, box, level, stss );
+    return 0;
 }
 
 static int isom_read_stps( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
@@ -1930,114 +2081,108 @@ static int isom_read_stps( lsmash_file_t *file, isom_box_t *box, isom_box_t *par
      || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stps ) )
         return isom_read_unknown_box( file, box, parent, level );
     ADD_BOX( stps, isom_stbl_t );
-    lsmash_bs_t *bs = file->bs;
-    uint32_t entry_count = lsmash_bs_get_be32( bs );
-    for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stps->list->entry_count < entry_count; pos = lsmash_bs_count( bs ) )
-    {
-        isom_stps_entry_t *data = lsmash_malloc( sizeof(isom_stps_entry_t) );
-        if( !data )
-            return LSMASH_ERR_MEMORY_ALLOC;
-        if( lsmash_list_add_entry( stps->list, data ) < 0 )
-        {
-            lsmash_free( data );
-            return LSMASH_ERR_MEMORY_ALLOC;
-        }
-        data->sample_number = lsmash_bs_get_be32( bs );
-    }
-    return isom_read_leaf_box_common_last_process( file, box, level, stps );
+    return isom_read_table_box_rest( file, box, level, stps, isom_read_stps_entries );
 }
 
-static int isom_read_sdtp( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
+static int isom_read_sdtp_entries( lsmash_bs_t *bs, isom_box_t *box, void *instance, int read_entries )
 {
-    if( (!lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL )
-      && !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_TRAF ))
-     || (lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL ) && LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->sdtp ))
-     || (lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_TRAF ) && LSMASH_IS_EXISTING_BOX( ((isom_traf_t *)parent)->sdtp )) )
-        return isom_read_unknown_box( file, box, parent, level );
-    ADD_BOX( sdtp, isom_box_t );
-    lsmash_bs_t *bs = file->bs;
+    isom_sdtp_t *sdtp = (isom_sdtp_t *)instance;
+    if( !read_entries )
+        return 0;
+    int err = isom_reserve_table_entries( &sdtp->table, box, bs, UINT32_MAX, 1 );
+    if( err < 0 )
+        return err;
     for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size; pos = lsmash_bs_count( bs ) )
     {
-        isom_sdtp_entry_t *data = lsmash_malloc( sizeof(isom_sdtp_entry_t) );
+        isom_sdtp_entry_t *data = isom_table_add_entry( &sdtp->table );
         if( !data )
             return LSMASH_ERR_MEMORY_ALLOC;
-        if( lsmash_list_add_entry( sdtp->list, data ) < 0 )
-        {
-            lsmash_free( data );
-            return LSMASH_ERR_MEMORY_ALLOC;
-        }
         uint8_t temp = lsmash_bs_get_byte( bs );
         data->is_leading            = (temp >> 6) & 0x3;
         data->sample_depends_on     = (temp >> 4) & 0x3;
         data->sample_is_depended_on = (temp >> 2) & 0x3;
         data->sample_has_redundancy =  temp       & 0x3;
     }
-    return isom_read_leaf_box_common_last_process( file, box, level, sdtp );
+    return 0;
 }
 
-static int isom_read_stsc( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
+static int isom_read_sdtp( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
 {
-    if( !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL )
-     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stsc ) )
+    if( (!lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL )
+      && !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_TRAF ))
+     || (lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL ) && LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->sdtp ))
+     || (lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_TRAF ) && LSMASH_IS_EXISTING_BOX( ((isom_traf_t *)parent)->sdtp )) )
         return isom_read_unknown_box( file, box, parent, level );
-    ADD_BOX( stsc, isom_stbl_t );
-    lsmash_bs_t *bs = file->bs;
+    ADD_BOX( sdtp, isom_box_t );
+    return isom_read_table_box_rest( file, box, level, sdtp, isom_read_sdtp_entries );
+}
+
+static int isom_read_stsc_entries( lsmash_bs_t *bs, isom_box_t *box, void *instance, int read_entries )
+{
+    isom_stsc_t *stsc = (isom_stsc_t *)instance;
     uint32_t entry_count = lsmash_bs_get_be32( bs );
-    for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stsc->list->entry_count < entry_count; pos = lsmash_bs_count( bs ) )
+    if( !read_entries )
+        return 0;
+    int err = isom_reserve_table_entries( &stsc->table, box, bs, entry_count, 12 );
+    if( err < 0 )
+        return err;
+    isom_read_table_entries_at_once( &stsc->table, box, bs, entry_count, 4 );
+    for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stsc->table.entry_count < entry_count; pos = lsmash_bs_count( bs ) )
     {
-        isom_stsc_entry_t *data = lsmash_malloc( sizeof(isom_stsc_entry_t) );
+        isom_stsc_entry_t *data = isom_table_add_entry( &stsc->table );
         if( !data )
             return LSMASH_ERR_MEMORY_ALLOC;
-        if( lsmash_list_add_entry( stsc->list, data ) < 0 )
-        {
-            lsmash_free( data );
-            return LSMASH_ERR_MEMORY_ALLOC;
-        }
         data->first_chunk              = lsmash_bs_get_be32( bs );
         data->samples_per_chunk        = lsmash_bs_get_be32( bs );
         data->sample_description_index = lsmash_bs_get_be32( bs );
     }
-    return isom_read_leaf_box_common_last_process( file, box, level, stsc );
+    return 0;
 }
 
-static int isom_read_stsz( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
+static int isom_read_stsc( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
 {
     if( !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL )
-     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stsz ) )
+     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stsc ) )
         return isom_read_unknown_box( file, box, parent, level );
-    ADD_BOX( stsz, isom_stbl_t );
-    lsmash_bs_t *bs = file->bs;
+    ADD_BOX( stsc, isom_stbl_t );
+    return isom_read_table_box_rest( file, box, level, stsc, isom_read_stsc_entries );
+}
+
+static int isom_read_stsz_entries( lsmash_bs_t *bs, isom_box_t *box, void *instance, int read_entries )
+{
+    isom_stsz_t *stsz = (isom_stsz_t *)instance;
     stsz->sample_size  = lsmash_bs_get_be32( bs );
     stsz->sample_count = lsmash_bs_get_be32( bs );
     uint64_t pos = lsmash_bs_count( bs );
-    if( pos < box->size )
+    if( read_entries && pos < box->size )
     {
-        stsz->list = lsmash_list_create_simple();
-        if( !stsz->list )
-            return LSMASH_ERR_MEMORY_ALLOC;
-        for( ; pos < box->size && stsz->list->entry_count < stsz->sample_count; pos = lsmash_bs_count( bs ) )
+        int err = isom_reserve_table_entries( &stsz->table, box, bs, stsz->sample_count, 4 );
+        if( err < 0 )
+            return err;
+        isom_read_table_entries_at_once( &stsz->table, box, bs, stsz->sample_count, 4 );
+        for( pos = lsmash_bs_count( bs ); pos < box->size && stsz->table.entry_count < stsz->sample_count; pos = lsmash_bs_count( bs ) )
         {
-            isom_stsz_entry_t *data = lsmash_malloc( sizeof(isom_stsz_entry_t) );
+            isom_stsz_entry_t *data = isom_table_add_entry( &stsz->table );
             if( !data )
                 return LSMASH_ERR_MEMORY_ALLOC;
-            if( lsmash_list_add_entry( stsz->list, data ) < 0 )
-            {
-                lsmash_free( data );
-                return LSMASH_ERR_MEMORY_ALLOC;
-            }
             data->entry_size = lsmash_bs_get_be32( bs );
         }
     }
-    return isom_read_leaf_box_common_last_process( file, box, level, stsz );
+    return 0;
 }
 
-static int isom_read_stz2( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
+static int isom_read_stsz( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
 {
     if( !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL )
-     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stz2 ) )
+     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stsz ) )
         return isom_read_unknown_box( file, box, parent, level );
-    ADD_BOX( stz2, isom_stbl_t );
-    lsmash_bs_t *bs = file->bs;
+    ADD_BOX( stsz, isom_stbl_t );
+    return isom_read_table_box_rest( file, box, level, stsz, isom_read_stsz_entries );
+}
+
+static int isom_read_stz2_entries( lsmash_bs_t *bs, isom_box_t *box, void *instance, int read_entries )
+{
+    isom_stz2_t *stz2 = (isom_stz2_t *)instance;
     uint32_t temp32    = lsmash_bs_get_be32( bs );
     stz2->reserved     = temp32 >> 24;
     stz2->field_size   = temp32 & 0xff;
@@ -2045,6 +2190,8 @@ static int isom_read_stz2( lsmash_file_t *file, isom_box_t *box, isom_box_t *par
     uint64_t pos = lsmash_bs_count( bs );
     if( pos < box->size )
     {
+        if( !read_entries )
+            return (stz2->field_size == 16 || stz2->field_size == 8 || stz2->field_size == 4) ? 0 : LSMASH_ERR_INVALID_DATA;
         if( stz2->field_size == 16 || stz2->field_size == 8 )
         {
             uint64_t (*bs_get_funcs[2])( lsmash_bs_t * ) =
@@ -2053,33 +2200,29 @@ static int isom_read_stz2( lsmash_file_t *file, isom_box_t *box, isom_box_t *par
                   lsmash_bs_get_be16_to_64
                 };
             uint64_t (*bs_get_entry_size)( lsmash_bs_t * ) = bs_get_funcs[ stz2->field_size == 16 ? 1 : 0 ];
-            for( ; pos < box->size && stz2->list->entry_count < stz2->sample_count; pos = lsmash_bs_count( bs ) )
+            int err = isom_reserve_table_entries( &stz2->table, box, bs, stz2->sample_count, stz2->field_size / 8 );
+            if( err < 0 )
+                return err;
+            for( ; pos < box->size && stz2->table.entry_count < stz2->sample_count; pos = lsmash_bs_count( bs ) )
             {
-                isom_stsz_entry_t *data = lsmash_malloc( sizeof(isom_stsz_entry_t) );
+                isom_stsz_entry_t *data = isom_table_add_entry( &stz2->table );
                 if( !data )
                     return LSMASH_ERR_MEMORY_ALLOC;
-                if( lsmash_list_add_entry( stz2->list, data ) < 0 )
-                {
-                    lsmash_free( data );
-                    return LSMASH_ERR_MEMORY_ALLOC;
-                }
                 data->entry_size = bs_get_entry_size( bs );
             }
         }
         else if( stz2->field_size == 4 )
         {
+            int err = isom_table_reserve( &stz2->table, (uint32_t)LSMASH_MIN( (uint64_t)stz2->sample_count, 2 * (box->size - pos) ) );
+            if( err < 0 )
+                return err;
             int parity = 1;
             uint8_t temp8;
-            while( pos < box->size && stz2->list->entry_count < stz2->sample_count )
+            while( pos < box->size && stz2->table.entry_count < stz2->sample_count )
             {
-                isom_stsz_entry_t *data = lsmash_malloc( sizeof(isom_stsz_entry_t) );
+                isom_stsz_entry_t *data = isom_table_add_entry( &stz2->table );
                 if( !data )
                     return LSMASH_ERR_MEMORY_ALLOC;
-                if( lsmash_list_add_entry( stz2->list, data ) < 0 )
-                {
-                    lsmash_free( data );
-                    return LSMASH_ERR_MEMORY_ALLOC;
-                }
                 /* Read a byte by two entries. */
                 if( parity )
                 {
@@ -2097,52 +2240,63 @@ static int isom_read_stz2( lsmash_file_t *file, isom_box_t *box, isom_box_t *par
         else
             return LSMASH_ERR_INVALID_DATA;
     }
-    return isom_read_leaf_box_common_last_process( file, box, level, stz2 );
+    return 0;
 }
 
-static int isom_read_stco( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
+static int isom_read_stz2( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
 {
     if( !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL )
-     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stco ) )
+     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stz2 ) )
         return isom_read_unknown_box( file, box, parent, level );
-    box->type = lsmash_form_iso_box_type( box->type.fourcc );
-    int is_stco = lsmash_check_box_type_identical( box->type, ISOM_BOX_TYPE_STCO );
-    isom_stco_t *stco = is_stco
-                      ? isom_add_stco( (isom_stbl_t *)parent )
-                      : isom_add_co64( (isom_stbl_t *)parent );
-    if( !stco )
-        return LSMASH_ERR_NAMELESS;
-    lsmash_bs_t *bs = file->bs;
+    ADD_BOX( stz2, isom_stbl_t );
+    return isom_read_table_box_rest( file, box, level, stz2, isom_read_stz2_entries );
+}
+
+static int isom_read_stco_entries( lsmash_bs_t *bs, isom_box_t *box, void *instance, int read_entries )
+{
+    isom_stco_t *stco = (isom_stco_t *)instance;
     uint32_t entry_count = lsmash_bs_get_be32( bs );
+    if( !read_entries )
+        return 0;
+    int is_stco = lsmash_check_box_type_identical( stco->type, ISOM_BOX_TYPE_STCO );
+    int err = isom_reserve_table_entries( &stco->table, box, bs, entry_count, is_stco ? 4 : 8 );
+    if( err < 0 )
+        return err;
+    isom_read_table_entries_at_once( &stco->table, box, bs, entry_count, is_stco ? 4 : 8 );
     if( is_stco )
-        for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stco->list->entry_count < entry_count; pos = lsmash_bs_count( bs ) )
+        for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stco->table.entry_count < entry_count; pos = lsmash_bs_count( bs ) )
         {
-            isom_stco_entry_t *data = lsmash_malloc( sizeof(isom_stco_entry_t) );
+            isom_stco_entry_t *data = isom_table_add_entry( &stco->table );
             if( !data )
                 return LSMASH_ERR_MEMORY_ALLOC;
-            if( lsmash_list_add_entry( stco->list, data ) < 0 )
-            {
-                lsmash_free( data );
-                return LSMASH_ERR_MEMORY_ALLOC;
-            }
             data->chunk_offset = lsmash_bs_get_be32( bs );
         }
     else
     {
-        for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stco->list->entry_count < entry_count; pos = lsmash_bs_count( bs ) )
+        for( uint64_t pos = lsmash_bs_count( bs ); pos < box->size && stco->table.entry_count < entry_count; pos = lsmash_bs_count( bs ) )
         {
-            isom_co64_entry_t *data = lsmash_malloc( sizeof(isom_co64_entry_t) );
+            isom_co64_entry_t *data = isom_table_add_entry( &stco->table );
             if( !data )
                 return LSMASH_ERR_MEMORY_ALLOC;
-            if( lsmash_list_add_entry( stco->list, data ) < 0 )
-            {
-                lsmash_free( data );
-                return LSMASH_ERR_MEMORY_ALLOC;
-            }
             data->chunk_offset = lsmash_bs_get_be64( bs );
         }
     }
-    return isom_read_leaf_box_common_last_process( file, box, level, stco );
+    return 0;
+}
+
+static int isom_read_stco( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
+{
+    if( !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_STBL )
+     || LSMASH_IS_EXISTING_BOX( ((isom_stbl_t *)parent)->stco ) )
+        return isom_read_unknown_box( file, box, parent, level );
+    box->type = lsmash_form_iso_box_type( box->type.fourcc );
+    int is_stco = lsmash_check_box_type_identical( box->type, ISOM_BOX_TYPE_STCO );
+    isom_stco_t *stco = is_stco
+                      ? isom_add_stco( (isom_stbl_t *)parent )
+                      : isom_add_co64( (isom_stbl_t *)parent );
+    if( !stco )
+        return LSMASH_ERR_NAMELESS;
+    return isom_read_table_box_rest( file, box, level, stco, isom_read_stco_entries );
 }
 
 static int isom_read_sgpd( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
@@ -2351,10 +2505,154 @@ static int isom_read_trex( lsmash_file_t *file, isom_box_t *box, isom_box_t *par
     return isom_read_leaf_box_common_last_process( file, box, level, trex );
 }
 
+/* Get the end of the subsegments indexed by the last Segment Index Box if the movie fragment at 'pos' is in them.
+ * The Segment Index Box referencing other Segment Index Boxes is not supported. */
+static int isom_get_fragments_indexed_by_sidx( lsmash_file_t *file, uint64_t pos, uint64_t file_size, uint64_t *end )
+{
+    isom_sidx_t *sidx = (isom_sidx_t *)lsmash_list_get_entry_data( &file->sidx_list, file->sidx_list.entry_count );
+    if( LSMASH_IS_NON_EXISTING_BOX( sidx )
+     || !sidx->list
+     ||  sidx->list->entry_count != sidx->reference_count )
+        return 0;
+    uint64_t start = sidx->pos + sidx->size + sidx->first_offset;
+    uint64_t subsegments_end = start;
+    for( lsmash_entry_t *entry = sidx->list->head; entry; entry = entry->next )
+    {
+        isom_sidx_referenced_item_t *data = (isom_sidx_referenced_item_t *)entry->data;
+        if( !data || data->reference_type )
+            return 0;
+        subsegments_end += data->reference_size;
+    }
+    if( pos < start || pos >= subsegments_end || subsegments_end > file_size )
+        return 0;
+    *end = subsegments_end;
+    return 1;
+}
+
+/* Get the start of the Movie Fragment Random Access Box from the Movie Fragment Random Access Offset Box,
+ * which is the last box of the file, if the movie fragment at 'pos' precedes it. */
+static int isom_get_fragments_indexed_by_mfra( lsmash_file_t *file, uint64_t pos, uint64_t file_size, uint64_t *end )
+{
+    lsmash_bs_t *bs = file->bs;
+    if( LSMASH_IS_EXISTING_BOX( file->mfra )
+     || file_size < pos + ISOM_FULLBOX_COMMON_SIZE + 4
+     || lsmash_bs_read_seek( bs, file_size - ISOM_FULLBOX_COMMON_SIZE - 4, SEEK_SET ) < 0 )
+        return 0;
+    if( file->read_minimally )
+        isom_bs_read_exactly( bs, ISOM_FULLBOX_COMMON_SIZE + 4 );
+    uint32_t mfro_size    = lsmash_bs_get_be32( bs );
+    uint32_t mfro_type    = lsmash_bs_get_be32( bs );
+    uint32_t mfro_version = lsmash_bs_get_be32( bs ) >> 24;
+    uint32_t mfra_size    = lsmash_bs_get_be32( bs );
+    if( bs->error
+     || mfro_size != ISOM_FULLBOX_COMMON_SIZE + 4
+     || mfro_type != ISOM_BOX_TYPE_MFRO.fourcc
+     || mfro_version != 0
+     || mfra_size >= file_size - pos
+     || mfra_size < ISOM_BASEBOX_COMMON_SIZE + mfro_size
+     || lsmash_bs_read_seek( bs, file_size - mfra_size, SEEK_SET ) < 0 )
+        return 0;
+    if( file->read_minimally )
+        /* The whole box is read here since it is read as the next top-level box anyway. */
+        isom_bs_read_exactly( bs, mfra_size );
+    /* Check the header of the Movie Fragment Random Access Box. */
+    if( lsmash_bs_get_be32( bs ) != mfra_size
+     || lsmash_bs_get_be32( bs ) != ISOM_BOX_TYPE_MFRA.fourcc
+     || bs->error )
+        return 0;
+    *end = file_size - mfra_size;
+    return 1;
+}
+
+/* Index the movie fragments from the box at the current position instead of reading them,
+ * and skip them so that the time to read the file does not depend on the number of them.
+ * Once any movie fragment is indexed, the subsequent ones are always deferred to keep their order.
+ * Return 1 if indexed. */
+static int isom_index_fragments( lsmash_file_t *file, isom_box_t *box )
+{
+    lsmash_bs_t *bs = file->bs;
+    /* If the rest of the file is not larger than a read from the stream, the movie fragments are read as usual
+     * since deferring them would read their bytes twice. The size of the file is gotten without seeking to its end,
+     * which would discard the buffer. */
+    uint64_t whole_size;
+    int64_t  mtime;
+    if( !file->fragment_extents
+     && !file->read_minimally   /* The movie fragments are skipped after reading only their header. */
+     && isom_get_file_status( file, &whole_size, &mtime ) == 0
+     && whole_size <= box->pos + bs->buffer.max_size )
+        return 0;
+    uint64_t current_pos = lsmash_bs_get_stream_pos( bs );
+    uint64_t count       = lsmash_bs_count( bs );
+    int64_t  file_size   = lsmash_bs_read_seek( bs, 0, SEEK_END );
+    uint64_t end;
+    int indexed = 0;
+    if( file_size > 0 && !(box->manager & LSMASH_LAST_BOX) )
+    {
+        if( isom_get_fragments_indexed_by_sidx( file, box->pos, file_size, &end )
+         || isom_get_fragments_indexed_by_mfra( file, box->pos, file_size, &end ) )
+        {
+            /* The indexed movie fragments are accompanied by their media data. */
+            file->flags |= LSMASH_FILE_MODE_MEDIA;
+            indexed = 1;
+        }
+        else if( file->fragment_extents && box->pos + box->size <= (uint64_t)file_size )
+        {
+            end = box->pos + box->size;
+            indexed = 1;
+        }
+    }
+    bs->error = 0;  /* Clear error flag. */
+    if( !indexed )
+    {
+        /* Get back to read the box as usual. */
+        lsmash_bs_read_seek( bs, current_pos, SEEK_SET );
+        bs->buffer.count = count;
+        if( file->read_minimally && !(box->manager & LSMASH_LAST_BOX) )
+            isom_bs_read_exactly( bs, box->size - count );
+        return 0;
+    }
+    if( !file->fragment_extents )
+    {
+        file->fragment_extents = lsmash_list_create_simple();
+        if( !file->fragment_extents )
+            return LSMASH_ERR_MEMORY_ALLOC;
+    }
+    isom_fragment_extent_t *extent = (isom_fragment_extent_t *)lsmash_list_get_entry_data( file->fragment_extents, file->fragment_extents->entry_count );
+    if( extent && extent->pos + extent->size == box->pos )
+        /* Merge the physically consecutive extents. */
+        extent->size += end - box->pos;
+    else
+    {
+        extent = lsmash_malloc( sizeof(isom_fragment_extent_t) );
+        if( !extent )
+            return LSMASH_ERR_MEMORY_ALLOC;
+        if( lsmash_list_add_entry( file->fragment_extents, extent ) < 0 )
+        {
+            lsmash_free( extent );
+            return LSMASH_ERR_MEMORY_ALLOC;
+        }
+        extent->pos  = box->pos;
+        extent->size = end - box->pos;
+    }
+    if( lsmash_bs_read_seek( bs, end, SEEK_SET ) < 0 )
+        return LSMASH_ERR_IO;
+    /* This is not the size of a box but makes sense in isom_read_children(). */
+    box->size = end - box->pos;
+    return 1;
+}
+
 static int isom_read_moof( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
 {
     if( !lsmash_check_box_type_identical( parent->type, LSMASH_BOX_TYPE_UNSPECIFIED ) )
         return isom_read_unknown_box( file, box, parent, level );
+    if( file->read_lazily
+     && !file->fake_file_mode
+     && !(file->flags & LSMASH_FILE_MODE_DUMP) )
+    {
+        int ret = isom_index_fragments( file, box );
+        if( ret != 0 )
+            return LSMASH_MIN( ret, 0 );
+    }
     ADD_BOX( moof, lsmash_file_t );
     box->parent = parent;
     isom_box_common_copy( moof, box );
@@ -2418,13 +2716,9 @@ static int isom_read_tfdt( lsmash_file_t *file, isom_box_t *box, isom_box_t *par
     return isom_read_leaf_box_common_last_process( file, box, level, tfdt );
 }
 
-static int isom_read_trun( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
+static int isom_read_trun_entries( lsmash_bs_t *bs, isom_box_t *box, void *instance, int read_entries )
 {
-    if( !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_TRAF ) )
-        return isom_read_unknown_box( file, box, parent, level );
-    ADD_BOX( trun, isom_traf_t );
-    box->parent = parent;
-    lsmash_bs_t *bs = file->bs;
+    isom_trun_t *trun = (isom_trun_t *)instance;
     int has_optional_rows = ISOM_TR_FLAGS_SAMPLE_DURATION_PRESENT
                           | ISOM_TR_FLAGS_SAMPLE_SIZE_PRESENT
                           | ISOM_TR_FLAGS_SAMPLE_FLAGS_PRESENT
@@ -2433,7 +2727,7 @@ static int isom_read_trun( lsmash_file_t *file, isom_box_t *box, isom_box_t *par
     trun->sample_count = lsmash_bs_get_be32( bs );
     if( box->flags & ISOM_TR_FLAGS_DATA_OFFSET_PRESENT        ) trun->data_offset        = lsmash_bs_get_be32( bs );
     if( box->flags & ISOM_TR_FLAGS_FIRST_SAMPLE_FLAGS_PRESENT ) trun->first_sample_flags = isom_bs_get_sample_flags( bs );
-    if( trun->sample_count && has_optional_rows )
+    if( read_entries && trun->sample_count && has_optional_rows )
     {
         trun->optional = lsmash_list_create_simple();
         if( !trun->optional )
@@ -2454,7 +2748,16 @@ static int isom_read_trun( lsmash_file_t *file, isom_box_t *box, isom_box_t *par
             if( box->flags & ISOM_TR_FLAGS_SAMPLE_COMPOSITION_TIME_OFFSET_PRESENT ) data->sample_composition_time_offset = lsmash_bs_get_be32( bs );
         }
     }
-    return isom_read_leaf_box_common_last_process( file, box, level, trun );
+    return 0;
+}
+
+static int isom_read_trun( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
+{
+    if( !lsmash_check_box_type_identical( parent->type, ISOM_BOX_TYPE_TRAF ) )
+        return isom_read_unknown_box( file, box, parent, level );
+    ADD_BOX( trun, isom_traf_t );
+    box->parent = parent;
+    return isom_read_table_box_rest( file, box, level, trun, isom_read_trun_entries );
 }
 
 static int isom_read_free( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, int level )
@@ -2924,9 +3227,54 @@ static int isom_read_emsg( lsmash_file_t *file, isom_box_t *box, isom_box_t *par
     return isom_read_leaf_box_common_last_process( file, box, level, emsg );
 }
 
+/* The readers of boxes are looked up by four character code in open addressing hash tables built on the first use,
+ * so the cost of the dispatch of a box does not depend on the number of the known box types. */
+typedef struct
+{
+    lsmash_compact_box_type_t fourcc;
+    lsmash_box_type_t (*form_box_type_func)( lsmash_compact_box_type_t );
+    int (*reader_func)( lsmash_file_t *, isom_box_t *, isom_box_t *, int );
+} isom_box_reader_t;
+
+/* Each table has (1 << bits) slots, which shall be more than twice the number of the readers in it. */
+#define ISOM_DESCRIPTION_READER_HASH_BITS 9
+#define ISOM_BOX_READER_HASH_BITS         8
+#define ISOM_EXTENSION_READER_HASH_BITS   7
+
+static inline uint32_t isom_hash_box_reader( lsmash_compact_box_type_t fourcc, int bits )
+{
+    return (uint32_t)(fourcc * UINT32_C(0x9E3779B1)) >> (32 - bits);
+}
+
+static void isom_add_box_reader( isom_box_reader_t *table, int bits, isom_box_reader_t reader )
+{
+    uint32_t mask = (UINT32_C(1) << bits) - 1;
+    for( uint32_t i = isom_hash_box_reader( reader.fourcc, bits ), probe = 0; probe <= mask; i = (i + 1) & mask, probe++ )
+        if( !table[i].form_box_type_func && !table[i].reader_func )
+        {
+            table[i] = reader;
+            return;
+        }
+        else if( table[i].fourcc == reader.fourcc )
+            return;     /* The reader added earlier wins. */
+    assert( 0 );    /* The table is too small. */
+}
+
+static const isom_box_reader_t *isom_find_box_reader( const isom_box_reader_t *table, int bits, lsmash_compact_box_type_t fourcc )
+{
+    uint32_t mask = (UINT32_C(1) << bits) - 1;
+    for( uint32_t i = isom_hash_box_reader( fourcc, bits ); ; i = (i + 1) & mask )
+        if( !table[i].form_box_type_func && !table[i].reader_func )
+            return NULL;
+        else if( table[i].fourcc == fourcc )
+            return &table[i];
+}
+
 int isom_read_box( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, uint64_t parent_pos, int level )
 {
     assert( parent && parent->root && parent->file );
+    if( parent == (isom_box_t *)file && file->read_minimally && !file->fake_file_mode )
+        isom_read_top_level_box_minimally( file );
     if( isom_read_skip_box_extra_bytes( file, box, parent, parent_pos ) != 0 )
         return 0;
     memset( box, 0, sizeof(isom_box_t) );
@@ -2958,17 +3306,13 @@ int isom_read_box( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, uin
         else
             reader_func = isom_read_other_description;
         /* Determine either of file formats the sample type is defined in; ISOBMFF or QTFF. */
-        static struct description_reader_table_tag
-        {
-            lsmash_compact_box_type_t fourcc;
-            lsmash_box_type_t (*form_box_type_func)( lsmash_compact_box_type_t );
-        } description_reader_table[160] = { { 0, NULL } };
-        if( !description_reader_table[0].form_box_type_func )
+        static isom_box_reader_t description_reader_table[1 << ISOM_DESCRIPTION_READER_HASH_BITS];
+        static int description_reader_table_initialized = 0;
+        if( !description_reader_table_initialized )
         {
             /* Initialize the table. */
-            int i = 0;
 #define ADD_DESCRIPTION_READER_TABLE_ELEMENT( type, form_box_type_func ) \
-    description_reader_table[i++] = (struct description_reader_table_tag){ type.fourcc, form_box_type_func }
+    isom_add_box_reader( description_reader_table, ISOM_DESCRIPTION_READER_HASH_BITS, (isom_box_reader_t){ type.fourcc, form_box_type_func, NULL } )
             ADD_DESCRIPTION_READER_TABLE_ELEMENT( ISOM_CODEC_TYPE_AV01_VIDEO, lsmash_form_iso_box_type );
             ADD_DESCRIPTION_READER_TABLE_ELEMENT( ISOM_CODEC_TYPE_AVC1_VIDEO, lsmash_form_iso_box_type );
             ADD_DESCRIPTION_READER_TABLE_ELEMENT( ISOM_CODEC_TYPE_AVC2_VIDEO, lsmash_form_iso_box_type );
@@ -3107,16 +3451,12 @@ int isom_read_box( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, uin
             ADD_DESCRIPTION_READER_TABLE_ELEMENT( ISOM_CODEC_TYPE_TX3G_TEXT, lsmash_form_iso_box_type );
             ADD_DESCRIPTION_READER_TABLE_ELEMENT( ISOM_CODEC_TYPE_MP4S_SYSTEM, lsmash_form_iso_box_type );
             ADD_DESCRIPTION_READER_TABLE_ELEMENT( LSMASH_CODEC_TYPE_RAW, lsmash_form_qtff_box_type );
-            ADD_DESCRIPTION_READER_TABLE_ELEMENT( LSMASH_CODEC_TYPE_UNSPECIFIED, NULL );
-            assert( sizeof(description_reader_table) >= (size_t)i * sizeof(description_reader_table[0]) );
 #undef ADD_DESCRIPTION_READER_TABLE_ELEMENT
+            description_reader_table_initialized = 1;
         }
-        for( int i = 0; description_reader_table[i].form_box_type_func; i++ )
-            if( box->type.fourcc == description_reader_table[i].fourcc )
-            {
-                form_box_type_func = description_reader_table[i].form_box_type_func;
-                goto read_box;
-            }
+        const isom_box_reader_t *description_reader = isom_find_box_reader( description_reader_table, ISOM_DESCRIPTION_READER_HASH_BITS, box->type.fourcc );
+        if( description_reader )
+            form_box_type_func = description_reader->form_box_type_func;
         goto read_box;
     }
     if( lsmash_check_box_type_identical( parent->type, QT_BOX_TYPE_WAVE ) )
@@ -3147,18 +3487,13 @@ int isom_read_box( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, uin
         reader_func = isom_read_dref_entry;
         goto read_box;
     }
-    static struct box_reader_table_tag
-    {
-        lsmash_compact_box_type_t fourcc;
-        lsmash_box_type_t (*form_box_type_func)( lsmash_compact_box_type_t );
-        int (*reader_func)( lsmash_file_t *, isom_box_t *, isom_box_t *, int );
-    } box_reader_table[132] = { { 0, NULL, NULL } };
-    if( !box_reader_table[0].reader_func )
+    static isom_box_reader_t box_reader_table[1 << ISOM_BOX_READER_HASH_BITS];
+    static int box_reader_table_initialized = 0;
+    if( !box_reader_table_initialized )
     {
         /* Initialize the table. */
-        int i = 0;
 #define ADD_BOX_READER_TABLE_ELEMENT( type, form_box_type_func, reader_func ) \
-    box_reader_table[i++] = (struct box_reader_table_tag){ type.fourcc, form_box_type_func, reader_func }
+    isom_add_box_reader( box_reader_table, ISOM_BOX_READER_HASH_BITS, (isom_box_reader_t){ type.fourcc, form_box_type_func, reader_func } )
         ADD_BOX_READER_TABLE_ELEMENT( ISOM_BOX_TYPE_FTYP, lsmash_form_iso_box_type,  isom_read_ftyp );
         ADD_BOX_READER_TABLE_ELEMENT( ISOM_BOX_TYPE_STYP, lsmash_form_iso_box_type,  isom_read_styp );
         ADD_BOX_READER_TABLE_ELEMENT( ISOM_BOX_TYPE_SIDX, lsmash_form_iso_box_type,  isom_read_sidx );
@@ -3240,17 +3575,16 @@ int isom_read_box( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, uin
         ADD_BOX_READER_TABLE_ELEMENT( ISOM_BOX_TYPE_TFRA, lsmash_form_iso_box_type,  isom_read_tfra );
         ADD_BOX_READER_TABLE_ELEMENT( ISOM_BOX_TYPE_MFRO, lsmash_form_iso_box_type,  isom_read_mfro );
         ADD_BOX_READER_TABLE_ELEMENT( ISOM_BOX_TYPE_EMSG, lsmash_form_iso_box_type,  isom_read_emsg );
-        ADD_BOX_READER_TABLE_ELEMENT( LSMASH_BOX_TYPE_UNSPECIFIED, NULL,  NULL );
-        assert( sizeof(box_reader_table) >= (size_t)i * sizeof(box_reader_table[0]) );
 #undef ADD_BOX_READER_TABLE_ELEMENT
+        box_reader_table_initialized = 1;
+    }
+    const isom_box_reader_t *box_reader = isom_find_box_reader( box_reader_table, ISOM_BOX_READER_HASH_BITS, box->type.fourcc );
+    if( box_reader )
+    {
+        form_box_type_func = box_reader->form_box_type_func;
+        reader_func        = box_reader->reader_func;
+        goto read_box;
     }
-    for( int i = 0; box_reader_table[i].reader_func; i++ )
-        if( box->type.fourcc == box_reader_table[i].fourcc )
-        {
-            form_box_type_func = box_reader_table[i].form_box_type_func;
-            reader_func        = box_reader_table[i].reader_func;
-            goto read_box;
-        }
     if( box->type.fourcc == ISOM_BOX_TYPE_META.fourcc )
     {
        if( lsmash_bs_is_end   ( bs, 3 ) == 0
@@ -3305,18 +3639,13 @@ int isom_read_box( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, uin
     }
     if( parent->parent && lsmash_check_box_type_identical( parent->parent->type, ISOM_BOX_TYPE_STSD ) )
     {
-        static struct sample_description_extension_reader_table_tag
-        {
-            lsmash_compact_box_type_t fourcc;
-            lsmash_box_type_t (*form_box_type_func)( lsmash_compact_box_type_t );
-            int (*reader_func)( lsmash_file_t *, isom_box_t *, isom_box_t *, int );
-        } extension_reader_table[67] = { { 0, NULL, NULL } };
-        if( !extension_reader_table[0].reader_func )
+        static isom_box_reader_t extension_reader_table[1 << ISOM_EXTENSION_READER_HASH_BITS];
+        static int extension_reader_table_initialized = 0;
+        if( !extension_reader_table_initialized )
         {
             /* Initialize the table. */
-            int i = 0;
 #define ADD_EXTENSION_READER_TABLE_ELEMENT( type, form_box_type_func, reader_func ) \
-    extension_reader_table[i++] = (struct sample_description_extension_reader_table_tag){ type.fourcc, form_box_type_func, reader_func }
+    isom_add_box_reader( extension_reader_table, ISOM_EXTENSION_READER_HASH_BITS, (isom_box_reader_t){ type.fourcc, form_box_type_func, reader_func } )
             /* Audio */
             ADD_EXTENSION_READER_TABLE_ELEMENT( ISOM_BOX_TYPE_ALAC, lsmash_form_iso_box_type,  isom_read_codec_specific );
             ADD_EXTENSION_READER_TABLE_ELEMENT( ISOM_BOX_TYPE_DAC3, lsmash_form_iso_box_type,  isom_read_codec_specific );
@@ -3359,17 +3688,16 @@ int isom_read_box( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, uin
             /* Others */
             ADD_EXTENSION_READER_TABLE_ELEMENT( ISOM_BOX_TYPE_ESDS, lsmash_form_iso_box_type,  isom_read_esds );
             ADD_EXTENSION_READER_TABLE_ELEMENT( ISOM_BOX_TYPE_FTAB, lsmash_form_iso_box_type,  isom_read_ftab );
-            ADD_EXTENSION_READER_TABLE_ELEMENT( LSMASH_BOX_TYPE_UNSPECIFIED, NULL,  NULL );
-            assert( sizeof(extension_reader_table) >= (size_t)i * sizeof(extension_reader_table[0]) );
 #undef ADD_EXTENSION_READER_TABLE_ELEMENT
+            extension_reader_table_initialized = 1;
+        }
+        const isom_box_reader_t *extension_reader = isom_find_box_reader( extension_reader_table, ISOM_EXTENSION_READER_HASH_BITS, box->type.fourcc );
+        if( extension_reader )
+        {
+            form_box_type_func = extension_reader->form_box_type_func;
+            reader_func        = extension_reader->reader_func;
+            goto read_box;
         }
-        for( int i = 0; extension_reader_table[i].reader_func; i++ )
-            if( box->type.fourcc == extension_reader_table[i].fourcc )
-            {
-                form_box_type_func = extension_reader_table[i].form_box_type_func;
-                reader_func        = extension_reader_table[i].reader_func;
-                goto read_box;
-            }
         reader_func = isom_read_codec_specific;
     }
 read_box:
@@ -3405,3 +3733,192 @@ int isom_read_file( lsmash_file_t *file )
         return ret;
     return isom_check_compatibility( file );
 }
+
+int isom_load_indexed_fragments( lsmash_file_t *file )
+{
+    lsmash_entry_list_t *extents = file->fragment_extents;
+    if( !extents )
+        return 0;
+    file->fragment_extents = NULL;
+    lsmash_bs_t *bs = file->bs;
+    uint64_t current_pos = lsmash_bs_get_stream_pos( bs );
+    /* Read the movie fragments in the same way as the other top-level boxes except for no more deferral.
+     * The track runs are read at once here since the construction of a timeline needs all of them. */
+    uint8_t read_lazily = file->read_lazily;
+    file->read_lazily = 0;
+    int err = 0;
+    for( lsmash_entry_t *entry = extents->head; entry && err == 0; entry = entry->next )
+    {
+        isom_fragment_extent_t *extent = (isom_fragment_extent_t *)entry->data;
+        if( !extent )
+            continue;
+        if( lsmash_bs_read_seek( bs, extent->pos, SEEK_SET ) < 0 )
+        {
+            err = LSMASH_ERR_IO;
+            break;
+        }
+        isom_box_t box;
+        for( uint64_t pos = extent->pos; pos < extent->pos + extent->size; pos += box.size )
+        {
+            int ret = isom_read_box( file, &box, (isom_box_t *)file, pos, 0 );
+            if( ret != 0 )
+            {
+                err = LSMASH_MIN( ret, 0 );
+                break;
+            }
+            if( bs->eob || bs->error )
+                break;
+        }
+    }
+    file->read_lazily = read_lazily;
+    lsmash_list_destroy( extents );
+    bs->error = 0;  /* Clear error flag. */
+    if( lsmash_bs_read_seek( bs, current_pos, SEEK_SET ) < 0 && err == 0 )
+        err = LSMASH_ERR_IO;
+    return err;
+}
+
+/* Get the size of the box at 'pos' if the whole of it is in the stream of 'stream_size' bytes.
+ * Return 0 if not, including the box extending to the end of the stream. */
+static uint64_t isom_get_complete_box_size( lsmash_bs_t *bs, uint64_t pos, uint64_t stream_size, lsmash_compact_box_type_t *type )
+{
+    if( stream_size < pos + ISOM_BASEBOX_COMMON_SIZE
+     || lsmash_bs_read_seek( bs, pos, SEEK_SET ) < 0 )
+        return 0;
+    uint64_t size = lsmash_bs_get_be32( bs );
+    *type = lsmash_bs_get_be32( bs );
+    if( size == 1 )
+        size = stream_size >= pos + 16 ? lsmash_bs_get_be64( bs ) : 0;
+    if( bs->error
+     || size < ISOM_BASEBOX_COMMON_SIZE
+     || size > stream_size - pos )
+        return 0;
+    return size;
+}
+
+int isom_read_appended_boxes( lsmash_file_t *file )
+{
+    lsmash_bs_t *bs = file->bs;
+    if( !bs || bs->unseekable )
+        return LSMASH_ERR_PATCH_WELCOME;
+    /* Read the indexed movie fragments first to keep the order of them. */
+    int err = isom_load_indexed_fragments( file );
+    if( err < 0 )
+        return err;
+    /* The stream may have grown since the last read, so discard the buffered data and get the current size.
+     * A mapped file is mapped again to reach the appended data. */
+    if( (err = isom_remap_file( file )) < 0 )
+        return err;
+    lsmash_bs_empty( bs );
+    int64_t stream_size = lsmash_bs_read_seek( bs, 0, SEEK_END );
+    if( stream_size < 0 )
+        return LSMASH_ERR_IO;
+    /* Find the end of the boxes written completely.
+     * A movie fragment is regarded as complete when the next box, usually the media data of it, is also complete. */
+    uint64_t end = file->size;
+    for( uint64_t pos = file->size; ; )
+    {
+        lsmash_compact_box_type_t type;
+        uint64_t size = isom_get_complete_box_size( bs, pos, stream_size, &type );
+        if( size == 0 )
+            break;
+        pos += size;
+        if( type != ISOM_BOX_TYPE_MOOF.fourcc )
+            end = pos;
+    }
+    bs->error = 0;  /* Clear error flag. */
+    if( end > file->size )
+    {
+        if( lsmash_bs_read_seek( bs, file->size, SEEK_SET ) < 0 )
+            return LSMASH_ERR_IO;
+        /* Read the appended boxes in the same way as the other top-level boxes except for no deferral. */
+        uint64_t pos         = file->size;
+        uint8_t  read_lazily = file->read_lazily;
+        file->read_lazily = 0;
+        file->size        = UINT64_MAX;
+        isom_box_t box;
+        while( pos < end )
+        {
+            int ret = isom_read_box( file, &box, (isom_box_t *)file, pos, 0 );
+            if( ret != 0 )
+            {
+                err = LSMASH_MIN( ret, 0 );
+                break;
+            }
+            pos += box.size;
+            if( bs->eob || bs->error )
+                break;
+        }
+        file->read_lazily = read_lazily;
+        file->size        = pos;
+    }
+    lsmash_bs_empty( bs );
+    bs->error = 0;  /* Clear error flag. */
+    return err;
+}
+
+static isom_entries_reader_t isom_get_entries_reader( lsmash_box_type_t type )
+{
+    if( type.fourcc == ISOM_BOX_TYPE_STTS.fourcc ) return isom_read_stts_entries;
+    if( type.fourcc == ISOM_BOX_TYPE_CTTS.fourcc ) return isom_read_ctts_entries;
+    if( type.fourcc == ISOM_BOX_TYPE_STSS.fourcc ) return isom_read_stss_entries;
+    if( type.fourcc ==   QT_BOX_TYPE_STPS.fourcc ) return isom_read_stps_entries;
+    if( type.fourcc == ISOM_BOX_TYPE_SDTP.fourcc ) return isom_read_sdtp_entries;
+    if( type.fourcc == ISOM_BOX_TYPE_STSC.fourcc ) return isom_read_stsc_entries;
+    if( type.fourcc == ISOM_BOX_TYPE_STSZ.fourcc ) return isom_read_stsz_entries;
+    if( type.fourcc == ISOM_BOX_TYPE_STZ2.fourcc ) return isom_read_stz2_entries;
+    if( type.fourcc == ISOM_BOX_TYPE_STCO.fourcc
+     || type.fourcc == ISOM_BOX_TYPE_CO64.fourcc ) return isom_read_stco_entries;
+    if( type.fourcc == ISOM_BOX_TYPE_TRUN.fourcc ) return isom_read_trun_entries;
+    return NULL;
+}
+
+int isom_load_deferred_box( void *box_ptr )
+{
+    isom_box_t *box = (isom_box_t *)box_ptr;
+    if( LSMASH_IS_NON_EXISTING_BOX( box )
+     || !(box->manager & LSMASH_DEFERRED_BOX) )
+        return 0;
+    isom_entries_reader_t read_entries = isom_get_entries_reader( box->type );
+    lsmash_bs_t          *bs           = box->file->bs;
+    if( !read_entries || !bs )
+        return LSMASH_ERR_NAMELESS;
+    box->manager &= ~LSMASH_DEFERRED_BOX;
+    /* Read the box again from its start, and then get back to the current position of the stream. */
+    uint64_t current_pos = lsmash_bs_get_stream_pos( bs );
+    if( lsmash_bs_read_seek( bs, box->pos, SEEK_SET ) < 0 )
+        return LSMASH_ERR_IO;
+    isom_box_t header = { 0 };
+    header.root   = box->root;
+    header.file   = box->file;
+    header.parent = box->parent;
+    int err = isom_bs_read_box_common( bs, &header ) != 0 ? LSMASH_ERR_IO : 0;
+    if( err == 0 && (header.type.fourcc != box->type.fourcc || header.size != box->size) )
+        err = LSMASH_ERR_INVALID_DATA;
+    if( err == 0 )
+    {
+        header.type = box->type;
+        isom_read_fullbox_common_extension( bs, &header );
+        err = read_entries( bs, &header, box, 1 );
+    }
+    if( err == 0 && bs->error )
+        err = LSMASH_ERR_IO;
+    bs->error = 0;  /* Clear error flag. */
+    if( lsmash_bs_read_seek( bs, current_pos, SEEK_SET ) < 0 && err == 0 )
+        err = LSMASH_ERR_IO;
+    return err;
+}
+
+int isom_load_deferred_boxes( void *parent_box )
+{
+    isom_box_t *parent = (isom_box_t *)parent_box;
+    if( LSMASH_IS_NON_EXISTING_BOX( parent ) )
+        return 0;
+    int err = isom_load_deferred_box( parent );
+    if( err < 0 )
+        return err;
+    for( lsmash_entry_t *entry = parent->extensions.head; entry; entry = entry->next )
+        if( (err = isom_load_deferred_boxes( entry->data )) < 0 )
+            return err;
+    return 0;
+}
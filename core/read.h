@@ -26,4 +26,14 @@
 int isom_read_file( lsmash_file_t *file );
 int isom_read_box( lsmash_file_t *file, isom_box_t *box, isom_box_t *parent, uint64_t parent_pos, int level );
 
+/* Read the entries of a table box whose reading was deferred, if not read yet. */
+int isom_load_deferred_box( void *box );
+/* Read the entries of all of the deferred table boxes contained in the given box. */
+int isom_load_deferred_boxes( void *parent_box );
+/* Read all of the movie fragments indexed but not read yet at once.
+ * They are not read one by one on demand since a timeline needs the samples of all the preceding movie fragments. */
+int isom_load_indexed_fragments( lsmash_file_t *file );
+/* Read the top-level boxes appended to the file since the last read, as far as they are written completely. */
+int isom_read_appended_boxes( lsmash_file_t *file );
+
 #endif /* LSMASH_READ_H */
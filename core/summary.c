@@ -176,26 +176,15 @@ lsmash_summary_t *lsmash_get_summary( lsmash_root_t *root, uint32_t track_ID, ui
      || LSMASH_IS_NON_EXISTING_BOX( trak->mdia->hdlr ) )
         return NULL;
     isom_minf_t *minf = trak->mdia->minf;
-    isom_stsd_t *stsd = minf->stbl->stsd;
-    uint32_t i = 1;
-    for( lsmash_entry_t *entry = stsd->list.head; entry; entry = entry->next )
-    {
-        if( i != description_number )
-        {
-            ++i;
-            continue;
-        }
-        isom_sample_entry_t *sample_entry = entry->data;
-        if( LSMASH_IS_NON_EXISTING_BOX( sample_entry ) )
-            return NULL;
-        if( LSMASH_IS_EXISTING_BOX( minf->vmhd ) )
-            return isom_create_video_summary_from_description( sample_entry );
-        else if( LSMASH_IS_EXISTING_BOX( minf->smhd ) )
-            return isom_create_audio_summary_from_description( sample_entry );
-        else
-            return NULL;
-    }
-    return NULL;
+    isom_sample_entry_t *sample_entry = (isom_sample_entry_t *)lsmash_vector_get_entry_data( &minf->stbl->stsd->list, description_number );
+    if( LSMASH_IS_NON_EXISTING_BOX( sample_entry ) )
+        return NULL;
+    if( LSMASH_IS_EXISTING_BOX( minf->vmhd ) )
+        return isom_create_video_summary_from_description( sample_entry );
+    else if( LSMASH_IS_EXISTING_BOX( minf->smhd ) )
+        return isom_create_audio_summary_from_description( sample_entry );
+    else
+        return NULL;
 }
 
 int lsmash_compare_summary( lsmash_summary_t *a, lsmash_summary_t *b )
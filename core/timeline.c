@@ -27,6 +27,8 @@
 #include <inttypes.h>
 
 #include "box.h"
+#include "file.h"
+#include "read.h"
 #include "timeline.h"
 
 #include "codecs/mp4a.h"
@@ -48,6 +50,103 @@ typedef struct
     lsmash_sample_property_t prop;
 } isom_sample_info_t;
 
+/* The sample property stored in the timeline
+ * This is the same information as lsmash_sample_property_t but packed into fewer bytes. */
+typedef struct
+{
+    uint32_t post_roll_identifier;
+    uint32_t post_roll_complete;
+    uint32_t pre_roll_distance;
+    uint8_t  ra_flags;
+    uint8_t  allow_earlier;
+    uint8_t  leading;
+    uint8_t  independent;
+    uint8_t  disposable;
+    uint8_t  redundant;
+} isom_packed_sample_property_t;
+
+/* The sample info of the timeline
+ * Each member of isom_sample_info_t is stored in its own array indexed by (sample_number - 1),
+ * and the durations are stored as their prefix sums, i.e. DTSs, so that any sample can be accessed in constant time.
+ * 'dts' has an extra element at the end, which is the sum of the durations of all samples. */
+typedef struct
+{
+    uint32_t                        sample_count;
+    uint32_t                        alloc_count;
+    uint64_t                       *pos;
+    uint64_t                       *dts;
+    uint32_t                       *offset;
+    uint32_t                       *length;
+    uint32_t                       *index;
+    isom_portable_chunk_t         **chunk;
+    isom_packed_sample_property_t  *prop;
+} isom_sample_info_array_t;
+
+/* The runs of samples in a run-length coded table
+ * The first sample number of each run is kept so that the run containing any sample can be found by binary search.
+ * An entry with sample_count equal to 0 never ends, so it becomes the tail run covering all the remaining samples. */
+typedef struct
+{
+    uint32_t  run_count;
+    uint32_t  sample_count;         /* the number of samples covered by the runs except for the tail */
+    uint32_t *first_sample_number;
+} isom_sample_run_index_t;
+
+/* The index of the sample tables for the lazy timeline
+ * The lazy timeline never expands the information of each sample, and resolves a sample from the sample tables on demand.
+ * The sample tables referenced here are owned by the file and must not be changed while the timeline is alive. */
+typedef struct
+{
+    isom_stbl_t                    *stbl;
+    isom_table_t                   *stsz_table;
+    isom_sgpd_t                    *sgpd_rap;
+    isom_sgpd_t                    *sgpd_roll;
+    lsmash_entry_list_t            *dref_list;
+    uint32_t                        constant_sample_size;
+    int                             all_sync;
+    int                             iso_sdtp;
+    int                             large_presentation;
+    isom_sample_run_index_t         stts;
+    uint64_t                       *stts_first_dts;         /* DTS of the first sample of each run, plus the end of the runs */
+    uint32_t                        stts_tail_delta;
+    isom_sample_run_index_t         ctts;
+    uint32_t                        ctts_tail_offset;
+    isom_sample_run_index_t         stsc;
+    uint32_t                       *stsc_entry_number;      /* broken entries are excluded */
+    uint32_t                       *stsc_first_chunk;
+    isom_sample_run_index_t         sbgp_roll;
+    isom_group_assignment_entry_t **sbgp_roll_assignment;   /* the last element is for the tail */
+    isom_sample_run_index_t         sbgp_rap;
+    isom_group_assignment_entry_t **sbgp_rap_assignment;    /* the last element is for the tail */
+    /* the last resolved sample, which makes sequential access cheap */
+    uint32_t                        last_sample_number;
+    uint32_t                        last_chunk_number;
+    uint32_t                        last_sample_length;
+    uint64_t                        last_sample_pos;
+    isom_portable_chunk_t           chunk;
+} isom_sample_table_index_t;
+
+/* The state of the expansion of movie fragments to be resumed for the fragments appended later */
+typedef struct
+{
+    uint32_t              moof_count;   /* the number of movie fragments expanded */
+    lsmash_entry_t       *tfra_entry;   /* the next random access point to be found */
+    isom_portable_chunk_t chunk;        /* the last track run considered as a chunk */
+    uint64_t              dts;
+    uint32_t              chunk_number;
+    uint32_t              distance;     /* distance from the previous random access point */
+    uint32_t              sample_number_in_sbgp_roll_entry;
+    uint32_t              sample_number_in_sbgp_rap_entry;
+} isom_fragment_expansion_t;
+
+/* An entry of the composition order index
+ * 'cts' is the CTS plus the composition to decode timeline shift so that the entries can be ordered without sign. */
+typedef struct
+{
+    uint64_t cts;
+    uint32_t sample_number;
+} isom_cts_index_entry_t;
+
 static const lsmash_class_t lsmash_timeline_class =
 {
     "timeline"
@@ -64,8 +163,6 @@ struct isom_timeline_tag
     uint32_t ctd_shift;     /* shift from composition to decode timeline */
     uint64_t media_duration;
     uint64_t track_duration;
-    uint32_t last_accessed_sample_number;
-    uint64_t last_accessed_sample_dts;
     uint32_t last_accessed_lpcm_bunch_number;
     uint32_t last_accessed_lpcm_bunch_duration;
     uint32_t last_accessed_lpcm_bunch_sample_count;
@@ -73,13 +170,18 @@ struct isom_timeline_tag
     uint64_t last_accessed_lpcm_bunch_dts;
     lsmash_entry_list_t edit_list [1];  /* list of edits */
     lsmash_entry_list_t chunk_list[1];  /* list of chunks */
-    lsmash_entry_list_t info_list [1];  /* list of sample info */
+    isom_sample_info_array_t info;      /* array of sample info */
+    isom_sample_table_index_t *stbl_index;  /* index of the sample tables if the timeline is lazy */
+    isom_cts_index_entry_t    *cts_index;   /* output samples in composition order, built on the first lookup by CTS */
+    uint32_t                   cts_index_count;
+    isom_fragment_expansion_t *fragment_expansion;  /* present only if the movie can be fragmented */
     lsmash_entry_list_t bunch_list[1];  /* list of LPCM bunch */
     int (*get_dts)( isom_timeline_t *timeline, uint32_t sample_number, uint64_t *dts );
     int (*get_cts)( isom_timeline_t *timeline, uint32_t sample_number, uint64_t *cts );
     int (*get_sample_duration)( isom_timeline_t *timeline, uint32_t sample_number, uint32_t *sample_duration );
     lsmash_sample_t *(*get_sample)( isom_timeline_t *timeline, uint32_t sample_number );
     int (*get_sample_info)( isom_timeline_t *timeline, uint32_t sample_number, lsmash_sample_t *sample );
+    int (*locate_sample)( isom_timeline_t *timeline, uint32_t sample_number, lsmash_sample_t *sample, isom_portable_chunk_t **chunk );
     int (*get_sample_property)( isom_timeline_t *timeline, uint32_t sample_number, lsmash_sample_property_t *prop );
     int (*check_sample_existence)( isom_timeline_t *timeline, uint32_t sample_number );
 };
@@ -90,15 +192,24 @@ isom_timeline_t *isom_get_timeline( lsmash_root_t *root, uint32_t track_ID )
      || track_ID == 0
      || !root->file->timeline )
         return NULL;
-    for( lsmash_entry_t *entry = root->file->timeline->head; entry; entry = entry->next )
-    {
-        isom_timeline_t *timeline = (isom_timeline_t *)entry->data;
-        if( !timeline )
-            return NULL;
-        if( timeline->track_ID == track_ID )
-            return timeline;
-    }
-    return NULL;
+    return (isom_timeline_t *)lsmash_id_index_get( &root->file->timeline_index, track_ID );
+}
+
+static void isom_remove_sample_table_index( isom_sample_table_index_t *index )
+{
+    if( !index )
+        return;
+    lsmash_free( index->stts.first_sample_number );
+    lsmash_free( index->stts_first_dts );
+    lsmash_free( index->ctts.first_sample_number );
+    lsmash_free( index->stsc.first_sample_number );
+    lsmash_free( index->stsc_entry_number );
+    lsmash_free( index->stsc_first_chunk );
+    lsmash_free( index->sbgp_roll.first_sample_number );
+    lsmash_free( index->sbgp_roll_assignment );
+    lsmash_free( index->sbgp_rap.first_sample_number );
+    lsmash_free( index->sbgp_rap_assignment );
+    lsmash_free( index );
 }
 
 isom_timeline_t *isom_timeline_create( void )
@@ -109,7 +220,6 @@ isom_timeline_t *isom_timeline_create( void )
     timeline->class = &lsmash_timeline_class;
     lsmash_list_init_simple( timeline->edit_list );
     lsmash_list_init_simple( timeline->chunk_list );
-    lsmash_list_init_simple( timeline->info_list );
     lsmash_list_init_simple( timeline->bunch_list );
     return timeline;
 }
@@ -120,37 +230,86 @@ void isom_timeline_destroy( isom_timeline_t *timeline )
         return;
     lsmash_list_remove_entries( timeline->edit_list );
     lsmash_list_remove_entries( timeline->chunk_list ); /* chunk data must be already freed. */
-    lsmash_list_remove_entries( timeline->info_list );
+    lsmash_free( timeline->info.pos );
+    lsmash_free( timeline->info.dts );
+    lsmash_free( timeline->info.offset );
+    lsmash_free( timeline->info.length );
+    lsmash_free( timeline->info.index );
+    lsmash_free( timeline->info.chunk );
+    lsmash_free( timeline->info.prop );
     lsmash_list_remove_entries( timeline->bunch_list );
+    isom_remove_sample_table_index( timeline->stbl_index );
+    lsmash_free( timeline->cts_index );
+    lsmash_free( timeline->fragment_expansion );
     lsmash_free( timeline );
 }
 
+int isom_add_timeline( lsmash_file_t *file, isom_timeline_t *timeline )
+{
+    if( LSMASH_IS_NON_EXISTING_BOX( file ) || !timeline || timeline->track_ID == 0 )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    if( !file->timeline )
+    {
+        file->timeline = lsmash_vector_create( isom_timeline_destroy );
+        if( !file->timeline )
+            return LSMASH_ERR_MEMORY_ALLOC;
+    }
+    /* The timeline added earlier wins if two or more timelines for the same track are present. */
+    int err;
+    if( !lsmash_id_index_get( &file->timeline_index, timeline->track_ID )
+     && (err = lsmash_id_index_set( &file->timeline_index, timeline->track_ID, timeline )) < 0 )
+        return err;
+    if( (err = lsmash_vector_add_entry( file->timeline, timeline )) < 0 )
+    {
+        if( lsmash_id_index_get( &file->timeline_index, timeline->track_ID ) == timeline )
+            lsmash_id_index_remove( &file->timeline_index, timeline->track_ID );
+        return err;
+    }
+    return 0;
+}
+
 void isom_remove_timelines( lsmash_file_t *file )
 {
     if( LSMASH_IS_NON_EXISTING_BOX( file ) || !file->timeline )
         return;
-    lsmash_list_destroy( file->timeline );
+    lsmash_vector_destroy( file->timeline );
+    file->timeline = NULL;
+    lsmash_id_index_cleanup( &file->timeline_index );
 }
 
-void lsmash_destruct_timeline( lsmash_root_t *root, uint32_t track_ID )
+/* Remove a timeline from a file, and make the next timeline for the same track visible if the removed one was. */
+static void isom_remove_timeline( lsmash_file_t *file, isom_timeline_t *timeline )
 {
-    if( LSMASH_IS_NON_EXISTING_BOX( root )
-     || track_ID == 0
-     || !root->file->timeline )
+    uint32_t track_ID = timeline->track_ID;
+    int      visible  = lsmash_id_index_get( &file->timeline_index, track_ID ) == timeline;
+    if( visible )
+        lsmash_id_index_remove( &file->timeline_index, track_ID );
+    lsmash_vector_remove_entry( file->timeline, lsmash_vector_find_entry( file->timeline, timeline ) );
+    if( !visible )
         return;
-    for( lsmash_entry_t *entry = root->file->timeline->head; entry; entry = entry->next )
+    for( uint32_t i = 1; i <= file->timeline->entry_count; i++ )
     {
-        isom_timeline_t *timeline = (isom_timeline_t *)entry->data;
-        if( !timeline )
-            continue;
-        if( timeline->track_ID == track_ID )
+        timeline = (isom_timeline_t *)lsmash_vector_get_entry_data( file->timeline, i );
+        if( timeline && timeline->track_ID == track_ID )
         {
-            lsmash_list_remove_entry_direct( root->file->timeline, entry );
+            lsmash_id_index_set( &file->timeline_index, track_ID, timeline );
             break;
         }
     }
 }
 
+void lsmash_destruct_timeline( lsmash_root_t *root, uint32_t track_ID )
+{
+    if( LSMASH_IS_NON_EXISTING_BOX( root )
+     || track_ID == 0
+     || !root->file->timeline )
+        return;
+    isom_timeline_t *timeline = (isom_timeline_t *)lsmash_id_index_get( &root->file->timeline_index, track_ID );
+    if( !timeline )
+        return;
+    isom_remove_timeline( root->file, timeline );
+}
+
 int isom_timeline_set_track_ID
 (
     isom_timeline_t *timeline,
@@ -279,17 +438,397 @@ static int isom_is_qt_fixed_compressed_audio
     return (((isom_audio_entry_t *)description)->compression_ID != QT_AUDIO_COMPRESSION_ID_VARIABLE_COMPRESSION);
 }
 
+static inline void isom_pack_sample_property( isom_packed_sample_property_t *dst, lsmash_sample_property_t *src )
+{
+    dst->post_roll_identifier = src->post_roll.identifier;
+    dst->post_roll_complete   = src->post_roll.complete;
+    dst->pre_roll_distance    = src->pre_roll.distance;
+    dst->ra_flags             = src->ra_flags;
+    dst->allow_earlier        = src->allow_earlier;
+    dst->leading              = src->leading;
+    dst->independent          = src->independent;
+    dst->disposable           = src->disposable;
+    dst->redundant            = src->redundant;
+}
+
+static inline void isom_unpack_sample_property( lsmash_sample_property_t *dst, isom_packed_sample_property_t *src )
+{
+    memset( dst, 0, sizeof(lsmash_sample_property_t) );
+    dst->post_roll.identifier = src->post_roll_identifier;
+    dst->post_roll.complete   = src->post_roll_complete;
+    dst->pre_roll.distance    = src->pre_roll_distance;
+    dst->ra_flags             = src->ra_flags;
+    dst->allow_earlier        = src->allow_earlier;
+    dst->leading              = src->leading;
+    dst->independent          = src->independent;
+    dst->disposable           = src->disposable;
+    dst->redundant            = src->redundant;
+}
+
+static int isom_realloc_array( void *array, uint64_t count, size_t size )
+{
+    if( count > SIZE_MAX / size )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    void *temp = lsmash_realloc( *(void **)array, count * size );
+    if( !temp )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    *(void **)array = temp;
+    return 0;
+}
+
+static int isom_resize_sample_info_array( isom_sample_info_array_t *info, uint32_t alloc_count )
+{
+    assert( alloc_count >= info->sample_count );
+    int err;
+    if( (err = isom_realloc_array( &info->pos,    alloc_count,                 sizeof(uint64_t) ))                      < 0
+     || (err = isom_realloc_array( &info->dts,    (uint64_t)alloc_count + 1,   sizeof(uint64_t) ))                      < 0
+     || (err = isom_realloc_array( &info->offset, alloc_count,                 sizeof(uint32_t) ))                      < 0
+     || (err = isom_realloc_array( &info->length, alloc_count,                 sizeof(uint32_t) ))                      < 0
+     || (err = isom_realloc_array( &info->index,  alloc_count,                 sizeof(uint32_t) ))                      < 0
+     || (err = isom_realloc_array( &info->chunk,  alloc_count,                 sizeof(isom_portable_chunk_t *) ))       < 0
+     || (err = isom_realloc_array( &info->prop,   alloc_count,                 sizeof(isom_packed_sample_property_t) )) < 0 )
+        return err;
+    info->alloc_count = alloc_count;
+    return 0;
+}
+
 static int isom_add_sample_info_entry( isom_timeline_t *timeline, isom_sample_info_t *src_info )
 {
-    isom_sample_info_t *dst_info = lsmash_malloc( sizeof(isom_sample_info_t) );
-    if( !dst_info )
+    isom_sample_info_array_t *info = &timeline->info;
+    if( info->sample_count == UINT32_MAX )
         return LSMASH_ERR_MEMORY_ALLOC;
-    if( lsmash_list_add_entry( timeline->info_list, dst_info ) < 0 )
+    if( info->sample_count == info->alloc_count )
     {
-        lsmash_free( dst_info );
-        return LSMASH_ERR_MEMORY_ALLOC;
+        uint32_t alloc_count = info->alloc_count ? LSMASH_MIN( (uint64_t)info->alloc_count * 2, UINT32_MAX ) : 256;
+        int err = isom_resize_sample_info_array( info, alloc_count );
+        if( err < 0 )
+            return err;
+        if( info->sample_count == 0 )
+            info->dts[0] = 0;
+    }
+    uint32_t i = info->sample_count++;
+    info->pos   [i]     = src_info->pos;
+    info->dts   [i + 1] = info->dts[i] + src_info->duration;
+    info->offset[i]     = src_info->offset;
+    info->length[i]     = src_info->length;
+    info->index [i]     = src_info->index;
+    info->chunk [i]     = src_info->chunk;
+    isom_pack_sample_property( &info->prop[i], &src_info->prop );
+    return 0;
+}
+
+static inline isom_sgpd_t *isom_select_appropriate_sgpd
+(
+    isom_sgpd_t *sgpd,
+    isom_sgpd_t *sgpd_frag,
+    uint32_t    *group_description_index
+)
+{
+    if( LSMASH_IS_EXISTING_BOX( sgpd_frag ) && *group_description_index >= 0x10000 )
+    {
+        /* The specification doesn't define 0x10000 explicitly, however says that there must be fewer than
+         * 65536 group definitions for this track and grouping type in the sample table in the Movie Box.
+         * So, we assume 0x10000 is equivalent to 0. */
+        *group_description_index -= 0x10000;
+        return sgpd_frag;
+    }
+    else
+        return sgpd;
+}
+
+/* Find the run containing a given sample.
+ * Return run_count if the sample is not covered by the runs, that is, if it is in the tail. */
+static uint32_t isom_find_sample_run( isom_sample_run_index_t *index, uint32_t sample_number )
+{
+    if( sample_number > index->sample_count )
+        return index->run_count;
+    uint32_t *first_sample_number = index->first_sample_number;
+    uint32_t  low  = 0;
+    uint32_t  high = index->run_count - 1;
+    while( low < high )
+    {
+        uint32_t mid = low + (high - low + 1) / 2;
+        if( first_sample_number[mid] <= sample_number )
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    return low;
+}
+
+/* Get the greatest sample number not greater than a given one from the Sync Sample Box or the Partial Sync Sample Box.
+ * Return 0 if not found. */
+static uint32_t isom_find_preceding_sample_number( isom_table_t *table, uint32_t sample_number )
+{
+    /* Both isom_stss_entry_t and isom_stps_entry_t consist of sample_number only. */
+    isom_stss_entry_t *data = (isom_stss_entry_t *)table->data;
+    uint32_t low  = 0;
+    uint32_t high = table->entry_count;
+    while( low < high )
+    {
+        uint32_t mid = low + (high - low) / 2;
+        if( data[mid].sample_number <= sample_number )
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low ? data[low - 1].sample_number : 0;
+}
+
+static uint64_t isom_get_dts_from_sample_table_index( isom_sample_table_index_t *index, uint32_t sample_number )
+{
+    uint32_t run = isom_find_sample_run( &index->stts, sample_number );
+    if( run == index->stts.run_count )
+        return index->stts_first_dts[run] + (uint64_t)(sample_number - index->stts.sample_count - 1) * index->stts_tail_delta;
+    isom_stts_entry_t *stts_data = (isom_stts_entry_t *)index->stbl->stts->table.data;
+    return index->stts_first_dts[run] + (uint64_t)(sample_number - index->stts.first_sample_number[run]) * stts_data[run].sample_delta;
+}
+
+static uint32_t isom_get_sample_delta_from_sample_table_index( isom_sample_table_index_t *index, uint32_t sample_number )
+{
+    uint32_t run = isom_find_sample_run( &index->stts, sample_number );
+    if( run == index->stts.run_count )
+        return index->stts_tail_delta;
+    return ((isom_stts_entry_t *)index->stbl->stts->table.data)[run].sample_delta;
+}
+
+static uint32_t isom_get_sample_offset_from_sample_table_index( isom_sample_table_index_t *index, uint32_t sample_number )
+{
+    uint32_t run = isom_find_sample_run( &index->ctts, sample_number );
+    if( run == index->ctts.run_count )
+        return index->ctts_tail_offset;
+    return ((isom_ctts_entry_t *)index->stbl->ctts->table.data)[run].sample_offset;
+}
+
+static inline uint32_t isom_get_sample_size_from_sample_table_index( isom_sample_table_index_t *index, uint32_t sample_number )
+{
+    isom_stsz_entry_t *stsz_data = isom_table_get_entry( index->stsz_table, sample_number );
+    return stsz_data ? stsz_data->entry_size : index->constant_sample_size;
+}
+
+static void isom_get_roll_recovery_grouping_info_from_sample_table_index
+(
+    isom_sample_table_index_t *index,
+    uint32_t                   sample_number,
+    lsmash_sample_property_t  *prop
+)
+{
+    uint32_t run = isom_find_sample_run( &index->sbgp_roll, sample_number );
+    isom_group_assignment_entry_t *assignment = index->sbgp_roll_assignment[run];
+    if( !assignment || assignment->group_description_index == 0 )
+        return;
+    uint32_t group_description_index = assignment->group_description_index;
+    isom_sgpd_t *sgpd = isom_select_appropriate_sgpd( index->sgpd_roll, NULL, &group_description_index );
+    isom_roll_entry_t *roll_data = (isom_roll_entry_t *)lsmash_list_get_entry_data( sgpd->list, group_description_index );
+    if( !roll_data )
+        return;
+    if( roll_data->roll_distance > 0 )
+    {
+        /* post-roll */
+        prop->post_roll.complete = sample_number + roll_data->roll_distance;
+        if( prop->ra_flags == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
+            prop->ra_flags |= ISOM_SAMPLE_RANDOM_ACCESS_FLAG_POST_ROLL_START;
+    }
+    else if( roll_data->roll_distance < 0 )
+    {
+        /* pre-roll */
+        prop->pre_roll.distance = -roll_data->roll_distance;
+        if( prop->ra_flags == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
+            prop->ra_flags |= ISOM_SAMPLE_RANDOM_ACCESS_FLAG_PRE_ROLL_END;
+    }
+}
+
+static isom_rap_entry_t *isom_get_random_access_point_group_from_sample_table_index
+(
+    isom_sample_table_index_t *index,
+    uint32_t                   run
+)
+{
+    isom_group_assignment_entry_t *assignment = index->sbgp_rap_assignment[run];
+    if( !assignment || assignment->group_description_index == 0 )
+        return NULL;
+    uint32_t group_description_index = assignment->group_description_index;
+    isom_sgpd_t *sgpd = isom_select_appropriate_sgpd( index->sgpd_rap, NULL, &group_description_index );
+    return (isom_rap_entry_t *)lsmash_list_get_entry_data( sgpd->list, group_description_index );
+}
+
+/* Get the properties of a sample except for the distance from the previous random access point. */
+static void isom_get_sample_property_from_sample_table_index
+(
+    isom_sample_table_index_t *index,
+    uint32_t                   sample_number,
+    lsmash_sample_property_t  *prop
+)
+{
+    isom_stbl_t *stbl = index->stbl;
+    memset( prop, 0, sizeof(lsmash_sample_property_t) );
+    /* Check whether sync sample or not.
+     * Don't count distance from sync samples if all samples are sync, see the construction of the timeline. */
+    if( index->all_sync
+     || isom_find_preceding_sample_number( &stbl->stss->table, sample_number ) == sample_number )
+        prop->ra_flags |= ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
+    /* Check whether partial sync sample or not. */
+    if( isom_find_preceding_sample_number( &stbl->stps->table, sample_number ) == sample_number )
+        prop->ra_flags |= QT_SAMPLE_RANDOM_ACCESS_FLAG_PARTIAL_SYNC | QT_SAMPLE_RANDOM_ACCESS_FLAG_RAP;
+    /* Get sample dependency info. */
+    isom_sdtp_entry_t *sdtp_data = isom_table_get_entry( &stbl->sdtp->table, sample_number );
+    if( sdtp_data )
+    {
+        if( index->iso_sdtp )
+            prop->leading       = sdtp_data->is_leading;
+        else
+            prop->allow_earlier = sdtp_data->is_leading;
+        prop->independent = sdtp_data->sample_depends_on;
+        prop->disposable  = sdtp_data->sample_is_depended_on;
+        prop->redundant   = sdtp_data->sample_has_redundancy;
+    }
+    /* Get roll recovery grouping info. */
+    isom_get_roll_recovery_grouping_info_from_sample_table_index( index, sample_number, prop );
+    prop->post_roll.identifier = sample_number;
+    /* Get random access point grouping info. */
+    if( prop->ra_flags == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
+    {
+        uint32_t run = isom_find_sample_run( &index->sbgp_rap, sample_number );
+        isom_rap_entry_t *rap_data = isom_get_random_access_point_group_from_sample_table_index( index, run );
+        if( rap_data )
+            /* If this is not an open RAP, we treat it as an unknown RAP since non-IDR sample could make a closed GOP. */
+            prop->ra_flags |= (rap_data->num_leading_samples_known && !!rap_data->num_leading_samples)
+                            ? ISOM_SAMPLE_RANDOM_ACCESS_FLAG_OPEN_RAP
+                            : ISOM_SAMPLE_RANDOM_ACCESS_FLAG_RAP;
+    }
+}
+
+/* Get the distance from the closest random access point in the past.
+ * This is the same value as the distance counted up through the construction of the timeline. */
+static uint32_t isom_get_distance_from_random_access_point_from_sample_table_index
+(
+    isom_sample_table_index_t *index,
+    uint32_t                   sample_number
+)
+{
+    isom_stbl_t *stbl = index->stbl;
+    uint32_t rap_number = index->all_sync ? 0 : isom_find_preceding_sample_number( &stbl->stss->table, sample_number );
+    rap_number = LSMASH_MAX( rap_number, isom_find_preceding_sample_number( &stbl->stps->table, sample_number ) );
+    if( !index->all_sync )
+    {
+        /* Any sample belonging to a random access point group is a random access point
+         * unless it is already marked as a sync sample, a partial sync sample or a start point of roll recovery. */
+        uint32_t current_sample_number = sample_number;
+        while( current_sample_number > rap_number )
+        {
+            uint32_t run = isom_find_sample_run( &index->sbgp_rap, current_sample_number );
+            uint32_t first_sample_number = run < index->sbgp_rap.run_count
+                                         ? index->sbgp_rap.first_sample_number[run]
+                                         : index->sbgp_rap.sample_count + 1;
+            if( isom_get_random_access_point_group_from_sample_table_index( index, run ) )
+            {
+                uint32_t lowest_sample_number = LSMASH_MAX( first_sample_number, rap_number + 1 );
+                for( ; current_sample_number >= lowest_sample_number; current_sample_number-- )
+                {
+                    lsmash_sample_property_t prop = { 0 };
+                    isom_get_roll_recovery_grouping_info_from_sample_table_index( index, current_sample_number, &prop );
+                    if( prop.ra_flags == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
+                    {
+                        rap_number = current_sample_number;
+                        break;
+                    }
+                }
+            }
+            else
+                current_sample_number = first_sample_number - 1;
+        }
     }
-    *dst_info = *src_info;
+    return rap_number ? sample_number - rap_number : NO_RANDOM_ACCESS_POINT;
+}
+
+static void isom_get_sample_property_and_distance_from_sample_table_index
+(
+    isom_sample_table_index_t *index,
+    uint32_t                   sample_number,
+    lsmash_sample_property_t  *prop
+)
+{
+    isom_get_sample_property_from_sample_table_index( index, sample_number, prop );
+    /* Set up distance from the previous random access point. */
+    uint32_t distance = isom_get_distance_from_random_access_point_from_sample_table_index( index, sample_number );
+    if( distance != NO_RANDOM_ACCESS_POINT && prop->pre_roll.distance == 0 )
+        prop->pre_roll.distance = distance;
+}
+
+static void isom_get_sample_location_from_sample_table_index
+(
+    isom_sample_table_index_t *index,
+    uint32_t                   sample_number,
+    isom_sample_info_t        *info
+)
+{
+    isom_stbl_t *stbl = index->stbl;
+    uint32_t run = isom_find_sample_run( &index->stsc, sample_number );
+    isom_stsc_entry_t *stsc_data = isom_table_get_entry( &stbl->stsc->table, index->stsc_entry_number[run] );
+    uint32_t sample_number_in_run   = sample_number - index->stsc.first_sample_number[run];
+    uint32_t chunk_number           = index->stsc_first_chunk[run] + sample_number_in_run / stsc_data->samples_per_chunk;
+    uint32_t sample_number_in_chunk = sample_number_in_run % stsc_data->samples_per_chunk;     /* 0-origin */
+    if( index->chunk.number != chunk_number )
+    {
+        index->chunk.data_offset = index->large_presentation
+                                 ? ((isom_co64_entry_t *)stbl->stco->table.data)[chunk_number - 1].chunk_offset
+                                 : ((isom_stco_entry_t *)stbl->stco->table.data)[chunk_number - 1].chunk_offset;
+        index->chunk.length      = 0;
+        index->chunk.number      = chunk_number;
+        isom_sample_entry_t *description = (isom_sample_entry_t *)lsmash_vector_get_entry_data( &stbl->stsd->list, stsc_data->sample_description_index );
+        isom_dref_entry_t   *dref_entry  = (isom_dref_entry_t *)lsmash_list_get_entry_data( index->dref_list, LSMASH_IS_EXISTING_BOX( description ) ? description->data_reference_index : 0 );
+        index->chunk.file = (!dref_entry || LSMASH_IS_NON_EXISTING_BOX( dref_entry->ref_file )) ? NULL : dref_entry->ref_file;
+    }
+    info->length = isom_get_sample_size_from_sample_table_index( index, sample_number );
+    if( sample_number_in_chunk
+     && index->last_sample_number + 1 == sample_number
+     && index->last_chunk_number      == chunk_number )
+        info->pos = index->last_sample_pos + index->last_sample_length;
+    else
+    {
+        info->pos = index->chunk.data_offset;
+        if( index->stsz_table->entry_count == 0 )
+            info->pos += (uint64_t)sample_number_in_chunk * index->constant_sample_size;
+        else
+            for( uint32_t i = sample_number - sample_number_in_chunk; i < sample_number; i++ )
+                info->pos += isom_get_sample_size_from_sample_table_index( index, i );
+    }
+    index->last_sample_number = sample_number;
+    index->last_chunk_number  = chunk_number;
+    index->last_sample_length = info->length;
+    index->last_sample_pos    = info->pos;
+    info->index = stsc_data->sample_description_index;
+    info->chunk = &index->chunk;
+}
+
+static int isom_get_sample_info_from_sample_table_index( isom_timeline_t *timeline, uint32_t sample_number, isom_sample_info_t *info )
+{
+    isom_sample_table_index_t *index = timeline->stbl_index;
+    if( sample_number == 0 || sample_number > timeline->sample_count )
+        return LSMASH_ERR_NAMELESS;
+    isom_get_sample_location_from_sample_table_index( index, sample_number, info );
+    info->duration = isom_get_sample_delta_from_sample_table_index( index, sample_number );
+    info->offset   = isom_get_sample_offset_from_sample_table_index( index, sample_number );
+    isom_get_sample_property_and_distance_from_sample_table_index( index, sample_number, &info->prop );
+    return 0;
+}
+
+/* Get the info of a sample in the timeline. */
+static int isom_get_sample_info( isom_timeline_t *timeline, uint32_t sample_number, isom_sample_info_t *dst_info )
+{
+    if( timeline->stbl_index )
+        return isom_get_sample_info_from_sample_table_index( timeline, sample_number, dst_info );
+    isom_sample_info_array_t *info = &timeline->info;
+    if( sample_number == 0 || sample_number > info->sample_count )
+        return LSMASH_ERR_NAMELESS;
+    uint32_t i = sample_number - 1;
+    dst_info->pos      = info->pos   [i];
+    dst_info->duration = info->dts   [i + 1] - info->dts[i];
+    dst_info->offset   = info->offset[i];
+    dst_info->length   = info->length[i];
+    dst_info->index    = info->index [i];
+    dst_info->chunk    = info->chunk [i];
+    isom_unpack_sample_property( &dst_info->prop, &info->prop[i] );
     return 0;
 }
 
@@ -387,44 +926,9 @@ static isom_lpcm_bunch_t *isom_get_bunch( isom_timeline_t *timeline, uint32_t sa
 
 static int isom_get_dts_from_info_list( isom_timeline_t *timeline, uint32_t sample_number, uint64_t *dts )
 {
-    if( sample_number == timeline->last_accessed_sample_number )
-        *dts = timeline->last_accessed_sample_dts;
-    else if( sample_number == 1 )
-        *dts = 0;
-    else if( sample_number == timeline->last_accessed_sample_number + 1 )
-    {
-        isom_sample_info_t *info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, timeline->last_accessed_sample_number );
-        if( !info )
-            return LSMASH_ERR_NAMELESS;
-        *dts = timeline->last_accessed_sample_dts + info->duration;
-    }
-    else if( sample_number == timeline->last_accessed_sample_number - 1 )
-    {
-        isom_sample_info_t *info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, timeline->last_accessed_sample_number - 1 );
-        if( !info )
-            return LSMASH_ERR_NAMELESS;
-        *dts = timeline->last_accessed_sample_dts - info->duration;
-    }
-    else
-    {
-        *dts = 0;
-        uint32_t distance = sample_number - 1;
-        lsmash_entry_t *entry;
-        for( entry = timeline->info_list->head; entry; entry = entry->next )
-        {
-            isom_sample_info_t *info = (isom_sample_info_t *)entry->data;
-            if( !info )
-                return LSMASH_ERR_NAMELESS;
-            if( distance-- == 0 )
-                break;
-            *dts += info->duration;
-        }
-        if( !entry )
-            return LSMASH_ERR_NAMELESS;
-    }
-    /* Note: last_accessed_sample_number is always updated together with last_accessed_sample_dts, and vice versa. */
-    timeline->last_accessed_sample_dts    = *dts;
-    timeline->last_accessed_sample_number = sample_number;
+    if( sample_number == 0 || sample_number > timeline->info.sample_count )
+        return LSMASH_ERR_NAMELESS;
+    *dts = timeline->info.dts[sample_number - 1];
     return 0;
 }
 
@@ -433,10 +937,7 @@ static int isom_get_cts_from_info_list( isom_timeline_t *timeline, uint32_t samp
     int ret = isom_get_dts_from_info_list( timeline, sample_number, cts );
     if( ret < 0 )
         return ret;
-    isom_sample_info_t *info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, sample_number );
-    if( !info )
-        return LSMASH_ERR_NAMELESS;
-    *cts = isom_make_cts( *cts, info->offset, timeline->ctd_shift );
+    *cts = isom_make_cts( *cts, timeline->info.offset[sample_number - 1], timeline->ctd_shift );
     return 0;
 }
 
@@ -460,10 +961,9 @@ static int isom_get_cts_from_bunch_list( isom_timeline_t *timeline, uint32_t sam
 
 static int isom_get_sample_duration_from_info_list( isom_timeline_t *timeline, uint32_t sample_number, uint32_t *sample_duration )
 {
-    isom_sample_info_t *info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, sample_number );
-    if( !info )
+    if( sample_number == 0 || sample_number > timeline->info.sample_count )
         return LSMASH_ERR_NAMELESS;
-    *sample_duration = info->duration;
+    *sample_duration = timeline->info.dts[sample_number] - timeline->info.dts[sample_number - 1];
     return 0;
 }
 
@@ -478,10 +978,10 @@ static int isom_get_sample_duration_from_bunch_list( isom_timeline_t *timeline,
 
 static int isom_check_sample_existence_in_info_list( isom_timeline_t *timeline, uint32_t sample_number )
 {
-    isom_sample_info_t *info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, sample_number );
-    if( !info || !info->chunk )
+    if( sample_number == 0 || sample_number > timeline->info.sample_count )
         return 0;
-    return !!info->chunk->file;
+    isom_portable_chunk_t *chunk = timeline->info.chunk[sample_number - 1];
+    return chunk && chunk->file;
 }
 
 static int isom_check_sample_existence_in_bunch_list( isom_timeline_t *timeline, uint32_t sample_number )
@@ -502,13 +1002,13 @@ static lsmash_sample_t *isom_read_sample_data_from_stream
 {
     if( !file )
         return NULL;
-    lsmash_sample_t *sample = lsmash_create_sample( 0 );
+    lsmash_sample_t *sample = isom_create_sample( file->root->sample_pool, sample_length );
     if( !sample )
         return NULL;
     lsmash_bs_t *bs = file->bs;
     lsmash_bs_read_seek( bs, sample_pos, SEEK_SET );
-    sample->data = lsmash_bs_get_bytes( bs, sample_length );
-    if( !sample->data )
+    if( !sample->data
+     || lsmash_bs_get_bytes_ex( bs, sample_length, sample->data ) < 0 )
     {
         lsmash_delete_sample( sample );
         return NULL;
@@ -540,24 +1040,23 @@ static lsmash_sample_t *isom_get_lpcm_sample_from_media_timeline( isom_timeline_
 
 static lsmash_sample_t *isom_get_sample_from_media_timeline( isom_timeline_t *timeline, uint32_t sample_number )
 {
+    isom_sample_info_t info;
     uint64_t dts;
-    if( isom_get_dts_from_info_list( timeline, sample_number, &dts ) < 0 )
-        return NULL;
-    isom_sample_info_t *info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, sample_number );
-    if( !info
-     || !info->chunk )
+    if( isom_get_sample_info( timeline, sample_number, &info ) < 0
+     || timeline->get_dts( timeline, sample_number, &dts ) < 0
+     || !info.chunk )
         return NULL;
     /* Get data of a sample from the stream. */
-    lsmash_sample_t *sample = isom_read_sample_data_from_stream( info->chunk->file, timeline, info->length, info->pos );
+    lsmash_sample_t *sample = isom_read_sample_data_from_stream( info.chunk->file, timeline, info.length, info.pos );
     if( !sample )
         return NULL;
     /* Get sample info. */
     sample->dts    = dts;
-    sample->cts    = isom_make_cts( dts, info->offset, timeline->ctd_shift );
-    sample->pos    = info->pos;
-    sample->length = info->length;
-    sample->index  = info->index;
-    sample->prop   = info->prop;
+    sample->cts    = isom_make_cts( sample->dts, info.offset, timeline->ctd_shift );
+    sample->pos    = info.pos;
+    sample->length = info.length;
+    sample->index  = info.index;
+    sample->prop   = info.prop;
     return sample;
 }
 
@@ -578,70 +1077,257 @@ static int isom_get_lpcm_sample_info_from_media_timeline( isom_timeline_t *timel
 
 static int isom_get_sample_info_from_media_timeline( isom_timeline_t *timeline, uint32_t sample_number, lsmash_sample_t *sample )
 {
+    isom_sample_info_t info;
     uint64_t dts;
-    int ret = isom_get_dts_from_info_list( timeline, sample_number, &dts );
-    if( ret < 0 )
+    int ret;
+    if( (ret = isom_get_sample_info( timeline, sample_number, &info )) < 0
+     || (ret = timeline->get_dts( timeline, sample_number, &dts )) < 0 )
         return ret;
-    isom_sample_info_t *info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, sample_number );
-    if( !info )
-        return LSMASH_ERR_NAMELESS;
     sample->dts    = dts;
-    sample->cts    = isom_make_cts( dts, info->offset, timeline->ctd_shift );
-    sample->pos    = info->pos;
-    sample->length = info->length;
-    sample->index  = info->index;
-    sample->prop   = info->prop;
+    sample->cts    = isom_make_cts( sample->dts, info.offset, timeline->ctd_shift );
+    sample->pos    = info.pos;
+    sample->length = info.length;
+    sample->index  = info.index;
+    sample->prop   = info.prop;
     return 0;
 }
 
-static int isom_get_lpcm_sample_property_from_media_timeline( isom_timeline_t *timeline, uint32_t sample_number, lsmash_sample_property_t *prop )
+static int isom_borrow_sample_data_from_stream
+(
+    lsmash_file_t   *file,
+    lsmash_sample_t *sample
+)
 {
-    memset( prop, 0, sizeof(lsmash_sample_property_t) );
-    prop->ra_flags = ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
-    return 0;
+    if( !file )
+        return LSMASH_ERR_NAMELESS;
+    lsmash_bs_t *bs = file->bs;
+    if( lsmash_bs_read_seek( bs, sample->pos, SEEK_SET ) < 0 )
+        return LSMASH_ERR_NAMELESS;
+    sample->data = lsmash_bs_borrow_bytes( bs, sample->length );
+    return sample->data ? 0 : LSMASH_ERR_NAMELESS;
 }
 
-static int isom_get_sample_property_from_media_timeline( isom_timeline_t *timeline, uint32_t sample_number, lsmash_sample_property_t *prop )
+/* Get the info of a sample and the chunk containing it. */
+static int isom_locate_lpcm_sample_in_media_timeline
+(
+    isom_timeline_t        *timeline,
+    uint32_t                sample_number,
+    lsmash_sample_t        *sample,
+    isom_portable_chunk_t **chunk
+)
 {
-    isom_sample_info_t *info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, sample_number );
-    if( !info )
+    int ret = isom_get_lpcm_sample_info_from_media_timeline( timeline, sample_number, sample );
+    if( ret < 0 )
+        return ret;
+    /* The bunch has been cached by the above. */
+    isom_lpcm_bunch_t *bunch = isom_get_bunch( timeline, sample_number );
+    if( !bunch
+     || !bunch->chunk )
         return LSMASH_ERR_NAMELESS;
-    *prop = info->prop;
+    *chunk = bunch->chunk;
     return 0;
 }
 
-static void isom_timeline_set_sample_getter_funcs
+static int isom_locate_sample_in_media_timeline
 (
-    isom_timeline_t *timeline
+    isom_timeline_t        *timeline,
+    uint32_t                sample_number,
+    lsmash_sample_t        *sample,
+    isom_portable_chunk_t **chunk
 )
 {
-    timeline->get_dts                = isom_get_dts_from_info_list;
-    timeline->get_cts                = isom_get_cts_from_info_list;
-    timeline->get_sample_duration    = isom_get_sample_duration_from_info_list;
-    timeline->check_sample_existence = isom_check_sample_existence_in_info_list;
-    timeline->get_sample             = isom_get_sample_from_media_timeline;
-    timeline->get_sample_info        = isom_get_sample_info_from_media_timeline;
-    timeline->get_sample_property    = isom_get_sample_property_from_media_timeline;
+    isom_sample_info_t info;
+    uint64_t dts;
+    int ret;
+    if( (ret = isom_get_sample_info( timeline, sample_number, &info )) < 0
+     || (ret = timeline->get_dts( timeline, sample_number, &dts )) < 0 )
+        return ret;
+    if( !info.chunk )
+        return LSMASH_ERR_NAMELESS;
+    sample->dts    = dts;
+    sample->cts    = isom_make_cts( sample->dts, info.offset, timeline->ctd_shift );
+    sample->pos    = info.pos;
+    sample->length = info.length;
+    sample->index  = info.index;
+    sample->prop   = info.prop;
+    *chunk = info.chunk;
+    return 0;
 }
 
-void isom_timeline_set_lpcm_sample_getter_funcs
-(
-    isom_timeline_t *timeline
-)
+static int isom_get_sample_view_from_media_timeline( isom_timeline_t *timeline, uint32_t sample_number, lsmash_sample_t *sample )
 {
-    timeline->get_dts                = isom_get_dts_from_bunch_list;
-    timeline->get_cts                = isom_get_cts_from_bunch_list;
-    timeline->get_sample_duration    = isom_get_sample_duration_from_bunch_list;
-    timeline->check_sample_existence = isom_check_sample_existence_in_bunch_list;
-    timeline->get_sample             = isom_get_lpcm_sample_from_media_timeline;
-    timeline->get_sample_info        = isom_get_lpcm_sample_info_from_media_timeline;
-    timeline->get_sample_property    = isom_get_lpcm_sample_property_from_media_timeline;
+    isom_portable_chunk_t *chunk;
+    int ret = timeline->locate_sample( timeline, sample_number, sample, &chunk );
+    if( ret < 0 )
+        return ret;
+    return isom_borrow_sample_data_from_stream( chunk->file, sample );
 }
 
-static inline void isom_increment_sample_number_in_entry
+/* Get the views of the samples from 'sample_number' within the chunk containing it.
+ * The data of the samples are borrowed by a single read since they are contiguous in the chunk. */
+static int isom_get_sample_views_from_media_timeline
 (
-    uint32_t        *sample_number_in_entry,
-    lsmash_entry_t **entry,
+    isom_timeline_t *timeline,
+    uint32_t         sample_number,
+    lsmash_sample_t *samples,
+    uint32_t        *sample_count
+)
+{
+    isom_portable_chunk_t *first_chunk = NULL;
+    lsmash_file_t *file = NULL;
+    uint32_t first_chunk_number = 0;
+    uint64_t start_pos = 0;
+    uint64_t end_pos   = 0;
+    uint32_t count     = 0;
+    while( count < *sample_count && count < timeline->sample_count - sample_number + 1 )
+    {
+        isom_portable_chunk_t *chunk;
+        int ret = timeline->locate_sample( timeline, sample_number + count, &samples[count], &chunk );
+        if( ret < 0 )
+        {
+            if( count == 0 )
+                return ret;
+            break;
+        }
+        if( count == 0 )
+        {
+            /* The chunk of the lazy timeline is reused and updated, so compare the numbers of chunks too. */
+            first_chunk        = chunk;
+            first_chunk_number = chunk->number;
+            file               = chunk->file;
+            start_pos          = samples[0].pos;
+        }
+        else if( chunk != first_chunk
+              || chunk->number != first_chunk_number
+              || samples[count].pos != end_pos
+              || end_pos + samples[count].length - start_pos > UINT32_MAX )
+            break;
+        end_pos = samples[count].pos + samples[count].length;
+        ++count;
+    }
+    if( count == 0 )
+        return LSMASH_ERR_NAMELESS;
+    lsmash_bs_t *bs = file ? file->bs : NULL;
+    if( !bs
+     || lsmash_bs_read_seek( bs, start_pos, SEEK_SET ) < 0 )
+        return LSMASH_ERR_NAMELESS;
+    uint8_t *data = NULL;
+    if( end_pos > start_pos
+     && (data = lsmash_bs_borrow_bytes( bs, end_pos - start_pos )) == NULL )
+        return LSMASH_ERR_NAMELESS;
+    for( uint32_t i = 0; i < count; i++ )
+        samples[i].data = data ? data + (samples[i].pos - start_pos) : NULL;
+    *sample_count = count;
+    return 0;
+}
+
+static int isom_get_lpcm_sample_property_from_media_timeline( isom_timeline_t *timeline, uint32_t sample_number, lsmash_sample_property_t *prop )
+{
+    memset( prop, 0, sizeof(lsmash_sample_property_t) );
+    prop->ra_flags = ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
+    return 0;
+}
+
+static int isom_get_sample_property_from_media_timeline( isom_timeline_t *timeline, uint32_t sample_number, lsmash_sample_property_t *prop )
+{
+    if( sample_number == 0 || sample_number > timeline->info.sample_count )
+        return LSMASH_ERR_NAMELESS;
+    isom_unpack_sample_property( prop, &timeline->info.prop[sample_number - 1] );
+    return 0;
+}
+
+static int isom_get_dts_from_sample_tables( isom_timeline_t *timeline, uint32_t sample_number, uint64_t *dts )
+{
+    if( sample_number == 0 || sample_number > timeline->sample_count )
+        return LSMASH_ERR_NAMELESS;
+    *dts = isom_get_dts_from_sample_table_index( timeline->stbl_index, sample_number );
+    return 0;
+}
+
+static int isom_get_cts_from_sample_tables( isom_timeline_t *timeline, uint32_t sample_number, uint64_t *cts )
+{
+    int ret = isom_get_dts_from_sample_tables( timeline, sample_number, cts );
+    if( ret < 0 )
+        return ret;
+    uint32_t sample_offset = isom_get_sample_offset_from_sample_table_index( timeline->stbl_index, sample_number );
+    *cts = isom_make_cts( *cts, sample_offset, timeline->ctd_shift );
+    return 0;
+}
+
+static int isom_get_sample_duration_from_sample_tables( isom_timeline_t *timeline, uint32_t sample_number, uint32_t *sample_duration )
+{
+    if( sample_number == 0 || sample_number > timeline->sample_count )
+        return LSMASH_ERR_NAMELESS;
+    *sample_duration = isom_get_sample_delta_from_sample_table_index( timeline->stbl_index, sample_number );
+    return 0;
+}
+
+static int isom_check_sample_existence_in_sample_tables( isom_timeline_t *timeline, uint32_t sample_number )
+{
+    if( sample_number == 0 || sample_number > timeline->sample_count )
+        return 0;
+    isom_sample_info_t info;
+    isom_get_sample_location_from_sample_table_index( timeline->stbl_index, sample_number, &info );
+    return !!info.chunk->file;
+}
+
+static int isom_get_sample_property_from_sample_tables( isom_timeline_t *timeline, uint32_t sample_number, lsmash_sample_property_t *prop )
+{
+    if( sample_number == 0 || sample_number > timeline->sample_count )
+        return LSMASH_ERR_NAMELESS;
+    isom_get_sample_property_and_distance_from_sample_table_index( timeline->stbl_index, sample_number, prop );
+    return 0;
+}
+
+static void isom_timeline_set_sample_getter_funcs
+(
+    isom_timeline_t *timeline
+)
+{
+    timeline->get_dts                = isom_get_dts_from_info_list;
+    timeline->get_cts                = isom_get_cts_from_info_list;
+    timeline->get_sample_duration    = isom_get_sample_duration_from_info_list;
+    timeline->check_sample_existence = isom_check_sample_existence_in_info_list;
+    timeline->get_sample             = isom_get_sample_from_media_timeline;
+    timeline->get_sample_info        = isom_get_sample_info_from_media_timeline;
+    timeline->locate_sample          = isom_locate_sample_in_media_timeline;
+    timeline->get_sample_property    = isom_get_sample_property_from_media_timeline;
+}
+
+static void isom_timeline_set_lazy_sample_getter_funcs
+(
+    isom_timeline_t *timeline
+)
+{
+    timeline->get_dts                = isom_get_dts_from_sample_tables;
+    timeline->get_cts                = isom_get_cts_from_sample_tables;
+    timeline->get_sample_duration    = isom_get_sample_duration_from_sample_tables;
+    timeline->check_sample_existence = isom_check_sample_existence_in_sample_tables;
+    timeline->get_sample             = isom_get_sample_from_media_timeline;
+    timeline->get_sample_info        = isom_get_sample_info_from_media_timeline;
+    timeline->locate_sample          = isom_locate_sample_in_media_timeline;
+    timeline->get_sample_property    = isom_get_sample_property_from_sample_tables;
+}
+
+void isom_timeline_set_lpcm_sample_getter_funcs
+(
+    isom_timeline_t *timeline
+)
+{
+    timeline->get_dts                = isom_get_dts_from_bunch_list;
+    timeline->get_cts                = isom_get_cts_from_bunch_list;
+    timeline->get_sample_duration    = isom_get_sample_duration_from_bunch_list;
+    timeline->check_sample_existence = isom_check_sample_existence_in_bunch_list;
+    timeline->get_sample             = isom_get_lpcm_sample_from_media_timeline;
+    timeline->get_sample_info        = isom_get_lpcm_sample_info_from_media_timeline;
+    timeline->locate_sample          = isom_locate_lpcm_sample_in_media_timeline;
+    timeline->get_sample_property    = isom_get_lpcm_sample_property_from_media_timeline;
+}
+
+static inline void isom_increment_sample_number_in_entry
+(
+    uint32_t        *sample_number_in_entry,
+    lsmash_entry_t **entry,
     uint32_t         sample_count
 )
 {
@@ -654,23 +1340,20 @@ static inline void isom_increment_sample_number_in_entry
         *sample_number_in_entry += 1;
 }
 
-static inline isom_sgpd_t *isom_select_appropriate_sgpd
+static inline void isom_increment_sample_number_in_table_entry
 (
-    isom_sgpd_t *sgpd,
-    isom_sgpd_t *sgpd_frag,
-    uint32_t    *group_description_index
+    uint32_t *sample_number_in_entry,
+    uint32_t *entry_number,
+    uint32_t  sample_count
 )
 {
-    if( LSMASH_IS_EXISTING_BOX( sgpd_frag ) && *group_description_index >= 0x10000 )
+    if( *sample_number_in_entry == sample_count )
     {
-        /* The specification doesn't define 0x10000 explicitly, however says that there must be fewer than
-         * 65536 group definitions for this track and grouping type in the sample table in the Movie Box.
-         * So, we assume 0x10000 is equivalent to 0. */
-        *group_description_index -= 0x10000;
-        return sgpd_frag;
+        *sample_number_in_entry = 1;
+        *entry_number += 1;
     }
     else
-        return sgpd;
+        *sample_number_in_entry += 1;
 }
 
 static int isom_get_roll_recovery_grouping_info
@@ -750,11 +1433,336 @@ static int isom_get_random_access_point_grouping_info
     return 0;
 }
 
-int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
+static int isom_timeline_copy_edits( isom_timeline_t *timeline, isom_elst_t *elst )
+{
+    for( lsmash_entry_t *entry = elst->list ? elst->list->head : NULL; entry; entry = entry->next )
+    {
+        isom_elst_entry_t *edit = (isom_elst_entry_t *)lsmash_memdup( entry->data, sizeof(isom_elst_entry_t) );
+        if( !edit )
+            return LSMASH_ERR_MEMORY_ALLOC;
+        if( lsmash_list_add_entry( timeline->edit_list, edit ) < 0 )
+        {
+            lsmash_free( edit );
+            return LSMASH_ERR_MEMORY_ALLOC;
+        }
+    }
+    return 0;
+}
+
+/* Check what the first 2-bits of sample dependency means.
+ * This check is for chimera of ISO Base Media and QTFF. */
+static int isom_check_iso_sdtp( lsmash_file_t *file, isom_sdtp_t *sdtp )
+{
+    if( file->max_isom_version < 2 && !file->avc_extensions )
+        return 0;
+    isom_sdtp_entry_t *sdtp_data = (isom_sdtp_entry_t *)sdtp->table.data;
+    for( uint32_t i = 0; i < sdtp->table.entry_count; i++ )
+    {
+        if( sdtp_data[i].is_leading > 1 )
+            break;      /* Apparently, it's defined under ISO Base Media. */
+        if( (sdtp_data[i].is_leading == 1) && (sdtp_data[i].sample_depends_on == ISOM_SAMPLE_IS_INDEPENDENT) )
+            return 0;   /* Obviously, it's not defined under ISO Base Media. */
+    }
+    return 1;
+}
+
+/* Expand the information of every sample in the movie fragments following the ones expanded already.
+ * The state of the expansion is kept in the timeline so that the fragments appended later can be expanded. */
+static int isom_timeline_expand_fragments( isom_timeline_t *timeline, lsmash_file_t *file, isom_trak_t *trak, isom_lpcm_bunch_t *bunch )
+{
+    isom_fragment_expansion_t *state = timeline->fragment_expansion;
+    uint32_t     track_ID  = timeline->track_ID;
+    isom_dref_t *dref      = trak->mdia->minf->dinf->dref;
+    isom_stbl_t *stbl      = trak->mdia->minf->stbl;
+    isom_stsd_t *stsd      = stbl->stsd;
+    isom_sgpd_t *sgpd_rap  = isom_get_sample_group_description( stbl, ISOM_GROUP_TYPE_RAP );
+    isom_sgpd_t *sgpd_roll = isom_get_roll_recovery_sample_group_description( &stbl->sgpd_list );
+    isom_tfra_t *tfra      = isom_get_tfra( file->mfra, track_ID );
+    lsmash_entry_list_t             *dref_list  = LSMASH_IS_EXISTING_BOX( dref ) ? &dref->list : NULL;
+    lsmash_entry_t                  *tfra_entry = state->tfra_entry;
+    isom_tfra_location_time_entry_t *rap        = tfra_entry ? (isom_tfra_location_time_entry_t *)tfra_entry->data : NULL;
+    isom_portable_chunk_t chunk = state->chunk;
+    uint64_t dts          = state->dts;
+    uint32_t chunk_number = state->chunk_number;
+    uint32_t distance     = state->distance;
+    uint32_t sample_count = timeline->sample_count;
+    uint32_t sample_number_in_sbgp_roll_entry = state->sample_number_in_sbgp_roll_entry;
+    uint32_t sample_number_in_sbgp_rap_entry  = state->sample_number_in_sbgp_rap_entry;
+    int err;
+    for( uint32_t moof_number = state->moof_count + 1; moof_number <= file->moof_list.entry_count; moof_number++ )
+    {
+        isom_moof_t *moof = (isom_moof_t *)lsmash_vector_get_entry_data( &file->moof_list, moof_number );
+        if( LSMASH_IS_NON_EXISTING_BOX( moof ) )
+            return LSMASH_ERR_INVALID_DATA;
+        uint64_t last_sample_end_pos = 0;
+        /* Track fragments */
+        uint32_t traf_number = 1;
+        for( uint32_t i = 1; i <= moof->traf_list.entry_count; i++ )
+        {
+            isom_traf_t *traf = (isom_traf_t *)lsmash_vector_get_entry_data( &moof->traf_list, i );
+            isom_tfhd_t *tfhd = traf->tfhd;
+            isom_trex_t *trex = isom_get_trex( file->moov->mvex, tfhd->track_ID );
+            if( LSMASH_IS_NON_EXISTING_BOX( trex ) )
+                return LSMASH_ERR_INVALID_DATA;
+            if( (err = isom_load_deferred_boxes( traf )) < 0 )
+                return err;
+            /* Ignore ISOM_TF_FLAGS_DURATION_IS_EMPTY flag even if set. */
+            if( !traf->trun_list.head )
+            {
+                ++traf_number;
+                continue;
+            }
+            /* Get base_data_offset. */
+            uint64_t base_data_offset;
+            if( tfhd->flags & ISOM_TF_FLAGS_BASE_DATA_OFFSET_PRESENT )
+                base_data_offset = tfhd->base_data_offset;
+            else if( (tfhd->flags & ISOM_TF_FLAGS_DEFAULT_BASE_IS_MOOF) || traf_number == 1 )
+                base_data_offset = moof->pos;
+            else
+                base_data_offset = last_sample_end_pos;
+            /* sample grouping */
+            isom_sgpd_t    *sgpd_frag_rap   = isom_get_fragment_sample_group_description( traf, ISOM_GROUP_TYPE_RAP );
+            isom_sbgp_t    *sbgp_rap        = isom_get_fragment_sample_to_group         ( traf, ISOM_GROUP_TYPE_RAP );
+            lsmash_entry_t *sbgp_rap_entry  = sbgp_rap->list ? sbgp_rap->list->head : NULL;
+            isom_sgpd_t    *sgpd_frag_roll  = isom_get_roll_recovery_sample_group_description( &traf->sgpd_list );
+            isom_sbgp_t    *sbgp_roll       = isom_get_roll_recovery_sample_to_group         ( &traf->sbgp_list );
+            lsmash_entry_t *sbgp_roll_entry = sbgp_roll->list ? sbgp_roll->list->head : NULL;
+            int need_data_offset_only = (tfhd->track_ID != track_ID);
+            /* Track runs */
+            uint32_t trun_number = 1;
+            for( lsmash_entry_t *trun_entry = traf->trun_list.head; trun_entry; trun_entry = trun_entry->next )
+            {
+                isom_trun_t *trun = (isom_trun_t *)trun_entry->data;
+                if( LSMASH_IS_NON_EXISTING_BOX( trun ) )
+                    return LSMASH_ERR_INVALID_DATA;
+                if( trun->sample_count == 0 )
+                {
+                    ++trun_number;
+                    continue;
+                }
+                /* Get data_offset. */
+                uint64_t data_offset;
+                if( trun->flags & ISOM_TR_FLAGS_DATA_OFFSET_PRESENT )
+                    data_offset = trun->data_offset + base_data_offset;
+                else if( trun_entry == traf->trun_list.head )
+                    data_offset = base_data_offset;
+                else
+                    data_offset = last_sample_end_pos;
+                /* */
+                uint32_t sample_description_index = 0;
+                uint32_t sdtp_entry_number        = 0;
+                int      is_lpcm_audio            = 0;
+                isom_sdtp_entry_t *sdtp_data = NULL;
+                if( !need_data_offset_only )
+                {
+                    /* Get sample_description_index of this track fragment. */
+                    if( tfhd->flags & ISOM_TF_FLAGS_SAMPLE_DESCRIPTION_INDEX_PRESENT )
+                        sample_description_index = tfhd->sample_description_index;
+                    else
+                        sample_description_index = trex->default_sample_description_index;
+                    isom_sample_entry_t *description = (isom_sample_entry_t *)lsmash_vector_get_entry_data( &stsd->list, sample_description_index );
+                    is_lpcm_audio = LSMASH_IS_EXISTING_BOX( description ) ? isom_is_lpcm_audio( description ) : 0;
+                    /* Reference media data. */
+                    isom_dref_entry_t *dref_entry = (isom_dref_entry_t *)lsmash_list_get_entry_data( dref_list, LSMASH_IS_EXISTING_BOX( description ) ? description->data_reference_index : 0 );
+                    lsmash_file_t *ref_file = (!dref_entry || LSMASH_IS_NON_EXISTING_BOX( dref_entry->ref_file )) ? NULL : dref_entry->ref_file;
+                    /* Each track run can be considered as a chunk.
+                     * Here, we consider physically consecutive track runs as one chunk. */
+                    if( chunk.data_offset + chunk.length != data_offset || chunk.file != ref_file )
+                    {
+                        chunk.data_offset = data_offset;
+                        chunk.length      = 0;
+                        chunk.number      = ++chunk_number;
+                        chunk.file        = ref_file;
+                        if( (err = isom_add_portable_chunk_entry( timeline, &chunk )) < 0 )
+                            return err;
+                    }
+                    /* Get dependency info for this track fragment. */
+                    sdtp_entry_number = 1;
+                    sdtp_data         = isom_table_get_entry( &traf->sdtp->table, sdtp_entry_number );
+                }
+                /* Get info of each sample. */
+                lsmash_entry_t *row_entry = trun->optional && trun->optional->head ? trun->optional->head : NULL;
+                uint32_t sample_number = 1;
+                while( sample_number <= trun->sample_count )
+                {
+                    isom_sample_info_t info = { 0 };
+                    isom_trun_optional_row_t *row = row_entry && row_entry->data ? (isom_trun_optional_row_t *)row_entry->data : NULL;
+                    /* Get sample_size */
+                    if( row && (trun->flags & ISOM_TR_FLAGS_SAMPLE_SIZE_PRESENT) )
+                        info.length = row->sample_size;
+                    else if( tfhd->flags & ISOM_TF_FLAGS_DEFAULT_SAMPLE_SIZE_PRESENT )
+                        info.length = tfhd->default_sample_size;
+                    else
+                        info.length = trex->default_sample_size;
+                    if( !need_data_offset_only )
+                    {
+                        info.pos   = data_offset;
+                        info.index = sample_description_index;
+                        info.chunk = (isom_portable_chunk_t *)timeline->chunk_list->tail->data;
+                        info.chunk->length += info.length;
+                        /* Get sample_duration. */
+                        if( row && (trun->flags & ISOM_TR_FLAGS_SAMPLE_DURATION_PRESENT) )
+                            info.duration = row->sample_duration;
+                        else if( tfhd->flags & ISOM_TF_FLAGS_DEFAULT_SAMPLE_DURATION_PRESENT )
+                            info.duration = tfhd->default_sample_duration;
+                        else
+                            info.duration = trex->default_sample_duration;
+                        /* Get composition time offset. */
+                        if( row && (trun->flags & ISOM_TR_FLAGS_SAMPLE_COMPOSITION_TIME_OFFSET_PRESENT) )
+                        {
+                            info.offset = row->sample_composition_time_offset;
+                            /* Check composition to decode timeline shift. */
+                            if( file->max_isom_version >= 6 && trun->version != 0 && info.offset != ISOM_NON_OUTPUT_SAMPLE_OFFSET )
+                            {
+                                uint64_t cts = dts + (int32_t)info.offset;
+                                if( (cts + timeline->ctd_shift) < dts )
+                                    timeline->ctd_shift = dts - cts;
+                            }
+                        }
+                        else
+                            info.offset = 0;
+                        dts += info.duration;
+                        /* Update media duration and maximun sample size. */
+                        timeline->media_duration += info.duration;
+                        timeline->max_sample_size = LSMASH_MAX( timeline->max_sample_size, info.length );
+                        if( !is_lpcm_audio )
+                        {
+                            /* Get sample_flags. */
+                            isom_sample_flags_t sample_flags;
+                            if( sample_number == 1 && (trun->flags & ISOM_TR_FLAGS_FIRST_SAMPLE_FLAGS_PRESENT) )
+                                sample_flags = trun->first_sample_flags;
+                            else if( row && (trun->flags & ISOM_TR_FLAGS_SAMPLE_FLAGS_PRESENT) )
+                                sample_flags = row->sample_flags;
+                            else if( tfhd->flags & ISOM_TF_FLAGS_DEFAULT_SAMPLE_FLAGS_PRESENT )
+                                sample_flags = tfhd->default_sample_flags;
+                            else
+                                sample_flags = trex->default_sample_flags;
+                            if( sdtp_data )
+                            {
+                                /* Independent and Disposable Samples Box overrides the information from sample_flags.
+                                 * There is no description in the specification about this, but the intention should be such a thing.
+                                 * The ground is that sample_flags is placed in media layer
+                                 * while Independent and Disposable Samples Box is placed in track or presentation layer. */
+                                info.prop.leading     = sdtp_data->is_leading;
+                                info.prop.independent = sdtp_data->sample_depends_on;
+                                info.prop.disposable  = sdtp_data->sample_is_depended_on;
+                                info.prop.redundant   = sdtp_data->sample_has_redundancy;
+                                sdtp_data = isom_table_get_entry( &traf->sdtp->table, ++sdtp_entry_number );
+                            }
+                            else
+                            {
+                                info.prop.leading     = sample_flags.is_leading;
+                                info.prop.independent = sample_flags.sample_depends_on;
+                                info.prop.disposable  = sample_flags.sample_is_depended_on;
+                                info.prop.redundant   = sample_flags.sample_has_redundancy;
+                            }
+                            /* Check this sample is a sync sample or not.
+                             * Note: all sync sample shall be independent. */
+                            if( !sample_flags.sample_is_non_sync_sample
+                             && info.prop.independent != ISOM_SAMPLE_IS_NOT_INDEPENDENT )
+                            {
+                                info.prop.ra_flags |= ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
+                                distance = 0;
+                            }
+                            /* Get roll recovery grouping info. */
+                            uint32_t roll_id = sample_count + sample_number;
+                            if( sbgp_roll_entry
+                             && isom_get_roll_recovery_grouping_info( timeline,
+                                                                      &sbgp_roll_entry, sgpd_roll, sgpd_frag_roll,
+                                                                      &sample_number_in_sbgp_roll_entry,
+                                                                      &info, roll_id ) < 0 )
+                                return LSMASH_ERR_INVALID_DATA;
+                            info.prop.post_roll.identifier = roll_id;
+                            /* Get random access point grouping info. */
+                            if( sbgp_rap_entry
+                             && isom_get_random_access_point_grouping_info( timeline,
+                                                                            &sbgp_rap_entry, sgpd_rap, sgpd_frag_rap,
+                                                                            &sample_number_in_sbgp_rap_entry,
+                                                                            &info, &distance ) < 0 )
+                                return LSMASH_ERR_INVALID_DATA;
+                            /* Get the location of the sync sample from 'tfra' if it is not set up yet.
+                             * Note: there is no guarantee that its entries are placed in a specific order. */
+                            if( LSMASH_IS_EXISTING_BOX( tfra ) )
+                            {
+                                if( tfra->number_of_entry == 0
+                                 && info.prop.ra_flags == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
+                                    info.prop.ra_flags |= ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
+                                if( rap
+                                 && rap->moof_offset   == moof->pos
+                                 && rap->traf_number   == traf_number
+                                 && rap->trun_number   == trun_number
+                                 && rap->sample_number == sample_number )
+                                {
+                                    if( info.prop.ra_flags == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
+                                        info.prop.ra_flags |= ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
+                                    if( tfra_entry )
+                                        tfra_entry = tfra_entry->next;
+                                    rap = tfra_entry ? (isom_tfra_location_time_entry_t *)tfra_entry->data : NULL;
+                                }
+                            }
+                            /* Set up distance from the previous random access point. */
+                            if( distance != NO_RANDOM_ACCESS_POINT )
+                            {
+                                if( info.prop.pre_roll.distance == 0 )
+                                    info.prop.pre_roll.distance = distance;
+                                ++distance;
+                            }
+                            /* OK. Let's add its info. */
+                            if( (err = isom_add_sample_info_entry( timeline, &info )) < 0 )
+                                return err;
+                        }
+                        else
+                        {
+                            /* All LPCMFrame is a sync sample. */
+                            info.prop.ra_flags = ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
+                            /* OK. Let's add its info. */
+                            if( sample_count == 0 && sample_number == 1 )
+                                isom_update_bunch( bunch, &info );
+                            else if( isom_compare_lpcm_sample_info( bunch, &info ) )
+                            {
+                                if( (err = isom_add_lpcm_bunch_entry( timeline, bunch )) < 0 )
+                                    return err;
+                                isom_update_bunch( bunch, &info );
+                            }
+                            else
+                                ++ bunch->sample_count;
+                        }
+                        if( timeline->info.sample_count
+                         && timeline->bunch_list->entry_count )
+                        {
+                            lsmash_log( timeline, LSMASH_LOG_ERROR, "LPCM + non-LPCM track is not supported.\n" );
+                            return LSMASH_ERR_PATCH_WELCOME;
+                        }
+                    }
+                    data_offset += info.length;
+                    last_sample_end_pos = data_offset;
+                    if( row_entry )
+                        row_entry = row_entry->next;
+                    ++sample_number;
+                }
+                if( !need_data_offset_only )
+                    sample_count += sample_number - 1;
+                ++trun_number;
+            }   /* Track runs */
+            ++traf_number;
+        }   /* Track fragments */
+    }   /* Movie fragments */
+    state->moof_count   = file->moof_list.entry_count;
+    state->tfra_entry   = tfra_entry;
+    state->chunk        = chunk;
+    state->dts          = dts;
+    state->chunk_number = chunk_number;
+    state->distance     = distance;
+    state->sample_number_in_sbgp_roll_entry = sample_number_in_sbgp_roll_entry;
+    state->sample_number_in_sbgp_rap_entry  = sample_number_in_sbgp_rap_entry;
+    timeline->sample_count = sample_count;
+    return 0;
+}
+
+/* Check a track and read the boxes deferred for it.
+ * This is the only part of the construction of a timeline which touches the stream. */
+static int isom_timeline_prepare( lsmash_file_t *file, uint32_t track_ID, isom_trak_t **p_trak )
 {
-    if( isom_check_initializer_present( root ) < 0 )
-        return LSMASH_ERR_FUNCTION_PARAM;
-    lsmash_file_t *file = root->file;
     if( LSMASH_IS_NON_EXISTING_BOX( file->moov->mvhd )
      ||  file->moov->mvhd->timescale == 0 )
         return LSMASH_ERR_INVALID_DATA;
@@ -767,13 +1775,22 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
      || (LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->stbl->stsz ) && LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->stbl->stz2 ))
      ||  trak->mdia->mdhd->timescale == 0 )
         return LSMASH_ERR_INVALID_DATA;
-    /* Create a timeline list if it doesn't exist. */
-    if( !file->timeline )
-    {
-        file->timeline = lsmash_list_create( isom_timeline_destroy );
-        if( !file->timeline )
-            return LSMASH_ERR_MEMORY_ALLOC;
-    }
+    int err;
+    if( (err = isom_load_deferred_boxes( trak )) < 0
+     || (err = isom_load_indexed_fragments( file )) < 0 )
+        return err;
+    /* Make the lookup of the random access points by track_ID read-only from here. */
+    (void)isom_get_tfra( file->mfra, track_ID );
+    *p_trak = trak;
+    return 0;
+}
+
+/* Build the timeline of a track prepared by isom_timeline_prepare().
+ * This neither touches the stream nor modifies anything shared between tracks,
+ * so the timelines of different tracks can be built concurrently. */
+static int isom_timeline_build( lsmash_file_t *file, isom_trak_t *trak, isom_timeline_t **p_timeline )
+{
+    uint32_t track_ID = trak->tkhd->track_ID;
     /* Create a timeline. */
     isom_timeline_t *timeline = isom_timeline_create();
     if( !timeline )
@@ -801,25 +1818,24 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
     isom_sbgp_t *sbgp_rap  = isom_get_sample_to_group         ( stbl, ISOM_GROUP_TYPE_RAP );
     isom_sgpd_t *sgpd_roll = isom_get_roll_recovery_sample_group_description( &stbl->sgpd_list );
     isom_sbgp_t *sbgp_roll = isom_get_roll_recovery_sample_to_group         ( &stbl->sbgp_list );
-    lsmash_entry_t *elst_entry = elst->list ? elst->list->head : NULL;
-    lsmash_entry_t *stts_entry = stts->list ? stts->list->head : NULL;
-    lsmash_entry_t *ctts_entry = ctts->list ? ctts->list->head : NULL;
-    lsmash_entry_t *stss_entry = stss->list ? stss->list->head : NULL;
-    lsmash_entry_t *stps_entry = stps->list ? stps->list->head : NULL;
-    lsmash_entry_t *sdtp_entry = sdtp->list ? sdtp->list->head : NULL;
-    lsmash_entry_t *stsz_entry = LSMASH_IS_EXISTING_BOX( stsz ) ? (stsz->list ? stsz->list->head : NULL)
-                                                                : (stz2->list ? stz2->list->head : NULL);
-    lsmash_entry_t *stsc_entry = stsc->list ? stsc->list->head : NULL;
-    lsmash_entry_t *stco_entry = stco->list ? stco->list->head : NULL;
+    isom_table_t   *stsz_table = LSMASH_IS_EXISTING_BOX( stsz ) ? &stsz->table : &stz2->table;
     lsmash_entry_t *sbgp_roll_entry = sbgp_roll->list ? sbgp_roll->list->head : NULL;
     lsmash_entry_t *sbgp_rap_entry  = sbgp_rap->list  ? sbgp_rap->list->head  : NULL;
-    lsmash_entry_t *next_stsc_entry = stsc_entry ? stsc_entry->next : NULL;
-    isom_stsc_entry_t *stsc_data = stsc_entry ? (isom_stsc_entry_t *)stsc_entry->data : NULL;
+    /* The entry numbers of the sample tables to be referenced next. */
+    uint32_t stts_entry_number = 1;
+    uint32_t ctts_entry_number = 1;
+    uint32_t stss_entry_number = 1;
+    uint32_t stps_entry_number = 1;
+    uint32_t sdtp_entry_number = 1;
+    uint32_t stsz_entry_number = 1;
+    uint32_t next_stsc_entry_number = 2;
+    isom_stsc_entry_t *stsc_data = isom_table_get_entry( &stsc->table, 1 );
     int err = LSMASH_ERR_INVALID_DATA;
-    int movie_fragments_present = (LSMASH_IS_EXISTING_BOX( file->moov->mvex ) && file->moof_list.head);
-    if( !movie_fragments_present && (!stts_entry || !stsc_entry || !stco_entry || !stco_entry->data || (next_stsc_entry && !next_stsc_entry->data)) )
+    /* The movie fragments may be appended later even if there is no one yet. */
+    int movie_fragments_allowed = LSMASH_IS_EXISTING_BOX( file->moov->mvex );
+    if( !movie_fragments_allowed && (stts->table.entry_count == 0 || !stsc_data || stco->table.entry_count == 0) )
         goto fail;
-    isom_sample_entry_t *description = (isom_sample_entry_t *)lsmash_list_get_entry_data( &stsd->list, stsc_data ? stsc_data->sample_description_index : 1 );
+    isom_sample_entry_t *description = (isom_sample_entry_t *)lsmash_vector_get_entry_data( &stsd->list, stsc_data ? stsc_data->sample_description_index : 1 );
     if( LSMASH_IS_NON_EXISTING_BOX( description ) )
         goto fail;
     lsmash_entry_list_t *dref_list = LSMASH_IS_EXISTING_BOX( dref ) ? &dref->list : NULL;
@@ -828,7 +1844,7 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
     int large_presentation = stco->large_presentation || lsmash_check_box_type_identical( stco->type, ISOM_BOX_TYPE_CO64 );
     int is_lpcm_audio          = isom_is_lpcm_audio( description );
     int is_qt_fixed_comp_audio = isom_is_qt_fixed_compressed_audio( description );
-    int iso_sdtp = file->max_isom_version >= 2 || file->avc_extensions;
+    int iso_sdtp = isom_check_iso_sdtp( file, sdtp );
     int allow_negative_sample_offset = ctts && ((file->max_isom_version >= 4 && ctts->version == 1) || file->qt_compatible);
     uint32_t sample_number_in_stts_entry      = 1;
     uint32_t sample_number_in_ctts_entry      = 1;
@@ -837,10 +1853,10 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
     uint64_t dts               = 0;
     uint32_t chunk_number      = 1;
     uint64_t offset_from_chunk = 0;
-    uint64_t data_offset = stco_entry && stco_entry->data
+    uint64_t data_offset = stco->table.entry_count
                          ? large_presentation
-                             ? ((isom_co64_entry_t *)stco_entry->data)->chunk_offset
-                             : ((isom_stco_entry_t *)stco_entry->data)->chunk_offset
+                             ? ((isom_co64_entry_t *)stco->table.data)[0].chunk_offset
+                             : ((isom_stco_entry_t *)stco->table.data)[0].chunk_offset
                          : 0;
     uint32_t initial_movie_sample_count = LSMASH_IS_EXISTING_BOX( stsz ) ? stsz->sample_count : stz2->sample_count;
     uint32_t samples_per_packet;
@@ -855,38 +1871,8 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
     uint32_t sample_number          = samples_per_packet;
     uint32_t sample_number_in_chunk = samples_per_packet;
     /* Copy edits. */
-    while( elst_entry )
-    {
-        isom_elst_entry_t *edit = (isom_elst_entry_t *)lsmash_memdup( elst_entry->data, sizeof(isom_elst_entry_t) );
-        if( !edit
-         || lsmash_list_add_entry( timeline->edit_list, edit ) < 0 )
-        {
-            err = LSMASH_ERR_MEMORY_ALLOC;
-            goto fail;
-        }
-        elst_entry = elst_entry->next;
-    }
-    /* Check what the first 2-bits of sample dependency means.
-     * This check is for chimera of ISO Base Media and QTFF. */
-    if( iso_sdtp && sdtp_entry )
-    {
-        while( sdtp_entry )
-        {
-            isom_sdtp_entry_t *sdtp_data = (isom_sdtp_entry_t *)sdtp_entry->data;
-            if( !sdtp_data )
-                goto fail;
-            if( sdtp_data->is_leading > 1 )
-                break;      /* Apparently, it's defined under ISO Base Media. */
-            if( (sdtp_data->is_leading == 1) && (sdtp_data->sample_depends_on == ISOM_SAMPLE_IS_INDEPENDENT) )
-            {
-                /* Obviously, it's not defined under ISO Base Media. */
-                iso_sdtp = 0;
-                break;
-            }
-            sdtp_entry = sdtp_entry->next;
-        }
-        sdtp_entry = sdtp->list->head;
-    }
+    if( (err = isom_timeline_copy_edits( timeline, elst )) < 0 )
+        goto fail;
     /**--- Construct media timeline. ---**/
     isom_portable_chunk_t chunk;
     chunk.data_offset = data_offset;
@@ -906,24 +1892,20 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
         for( uint32_t i = 0; i < samples_per_packet; i++ )
         {
             /* sample duration */
-            if( stts_entry )
+            isom_stts_entry_t *stts_data = isom_table_get_entry( &stts->table, stts_entry_number );
+            if( stts_data )
             {
-                isom_stts_entry_t *stts_data = (isom_stts_entry_t *)stts_entry->data;
-                if( !stts_data )
-                    goto fail;
-                isom_increment_sample_number_in_entry( &sample_number_in_stts_entry, &stts_entry, stts_data->sample_count );
+                isom_increment_sample_number_in_table_entry( &sample_number_in_stts_entry, &stts_entry_number, stts_data->sample_count );
                 last_duration = stts_data->sample_delta;
             }
             info.duration += last_duration;
             dts           += last_duration;
             /* sample offset */
             uint32_t sample_offset;
-            if( ctts_entry )
+            isom_ctts_entry_t *ctts_data = isom_table_get_entry( &ctts->table, ctts_entry_number );
+            if( ctts_data )
             {
-                isom_ctts_entry_t *ctts_data = (isom_ctts_entry_t *)ctts_entry->data;
-                if( !ctts_data )
-                    goto fail;
-                isom_increment_sample_number_in_entry( &sample_number_in_ctts_entry, &ctts_entry, ctts_data->sample_count );
+                isom_increment_sample_number_in_table_entry( &sample_number_in_ctts_entry, &ctts_entry_number, ctts_data->sample_count );
                 sample_offset = ctts_data->sample_offset;
                 if( allow_negative_sample_offset && sample_offset != ISOM_NON_OUTPUT_SAMPLE_OFFSET )
                 {
@@ -941,15 +1923,13 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
         if( !is_qt_fixed_comp_audio )
         {
             /* Check whether sync sample or not. */
-            if( stss_entry )
+            isom_stss_entry_t *stss_data = isom_table_get_entry( &stss->table, stss_entry_number );
+            if( stss_data )
             {
-                isom_stss_entry_t *stss_data = (isom_stss_entry_t *)stss_entry->data;
-                if( !stss_data )
-                    goto fail;
                 if( sample_number == stss_data->sample_number )
                 {
                     info.prop.ra_flags |= ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
-                    stss_entry = stss_entry->next;
+                    ++stss_entry_number;
                     distance = 0;
                 }
             }
@@ -958,24 +1938,20 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
                  * though all of them could be marked as a sync sample. */
                 info.prop.ra_flags |= ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
             /* Check whether partial sync sample or not. */
-            if( stps_entry )
+            isom_stps_entry_t *stps_data = isom_table_get_entry( &stps->table, stps_entry_number );
+            if( stps_data )
             {
-                isom_stps_entry_t *stps_data = (isom_stps_entry_t *)stps_entry->data;
-                if( !stps_data )
-                    goto fail;
                 if( sample_number == stps_data->sample_number )
                 {
                     info.prop.ra_flags |= QT_SAMPLE_RANDOM_ACCESS_FLAG_PARTIAL_SYNC | QT_SAMPLE_RANDOM_ACCESS_FLAG_RAP;
-                    stps_entry = stps_entry->next;
+                    ++stps_entry_number;
                     distance = 0;
                 }
             }
             /* Get sample dependency info. */
-            if( sdtp_entry )
+            isom_sdtp_entry_t *sdtp_data = isom_table_get_entry( &sdtp->table, sdtp_entry_number );
+            if( sdtp_data )
             {
-                isom_sdtp_entry_t *sdtp_data = (isom_sdtp_entry_t *)sdtp_entry->data;
-                if( !sdtp_data )
-                    goto fail;
                 if( iso_sdtp )
                     info.prop.leading       = sdtp_data->is_leading;
                 else
@@ -983,7 +1959,7 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
                 info.prop.independent = sdtp_data->sample_depends_on;
                 info.prop.disposable  = sdtp_data->sample_is_depended_on;
                 info.prop.redundant   = sdtp_data->sample_has_redundancy;
-                sdtp_entry = sdtp_entry->next;
+                ++sdtp_entry_number;
             }
             /* Get roll recovery grouping info. */
             if( sbgp_roll_entry
@@ -1012,14 +1988,13 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
             /* All uncompressed and non-variable compressed audio frame is a sync sample. */
             info.prop.ra_flags = ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
         /* Get size of sample in the stream. */
-        if( is_qt_fixed_comp_audio || !stsz_entry )
+        isom_stsz_entry_t *stsz_data = isom_table_get_entry( stsz_table, stsz_entry_number );
+        if( is_qt_fixed_comp_audio || !stsz_data )
             info.length = constant_sample_size;
         else
         {
-            if( !stsz_entry->data )
-                goto fail;
-            info.length = ((isom_stsz_entry_t *)stsz_entry->data)->entry_size;
-            stsz_entry = stsz_entry->next;
+            info.length = stsz_data->entry_size;
+            ++stsz_entry_number;
         }
         timeline->max_sample_size = LSMASH_MAX( timeline->max_sample_size, info.length );
         /* Get chunk info. */
@@ -1033,39 +2008,31 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
             if( info.chunk )
                 info.chunk->length = offset_from_chunk;
             /* Move the next chunk. */
-            if( stco_entry )
-                stco_entry = stco_entry->next;
-            if( stco_entry
-             && stco_entry->data )
+            ++chunk_number;
+            if( chunk_number <= stco->table.entry_count )
                 data_offset = large_presentation
-                            ? ((isom_co64_entry_t *)stco_entry->data)->chunk_offset
-                            : ((isom_stco_entry_t *)stco_entry->data)->chunk_offset;
+                            ? ((isom_co64_entry_t *)stco->table.data)[chunk_number - 1].chunk_offset
+                            : ((isom_stco_entry_t *)stco->table.data)[chunk_number - 1].chunk_offset;
             chunk.data_offset = data_offset;
             chunk.length      = 0;
-            chunk.number      = ++chunk_number;
+            chunk.number      = chunk_number;
             offset_from_chunk = 0;
             /* Check if the next entry is broken. */
-            while( next_stsc_entry && chunk_number > ((isom_stsc_entry_t *)next_stsc_entry->data)->first_chunk )
+            isom_stsc_entry_t *next_stsc_data = isom_table_get_entry( &stsc->table, next_stsc_entry_number );
+            while( next_stsc_data && chunk_number > next_stsc_data->first_chunk )
             {
                 /* Just skip broken next entry. */
                 lsmash_log( timeline, LSMASH_LOG_WARNING, "ignore broken entry in Sample To Chunk Box.\n" );
                 lsmash_log( timeline, LSMASH_LOG_WARNING, "timeline might be corrupted.\n" );
-                next_stsc_entry = next_stsc_entry->next;
-                if(  next_stsc_entry
-                 && !next_stsc_entry->data )
-                    goto fail;
+                next_stsc_data = isom_table_get_entry( &stsc->table, ++next_stsc_entry_number );
             }
             /* Check if the next chunk belongs to the next sequence of chunks. */
-            if( next_stsc_entry && chunk_number == ((isom_stsc_entry_t *)next_stsc_entry->data)->first_chunk )
+            if( next_stsc_data && chunk_number == next_stsc_data->first_chunk )
             {
-                stsc_entry      = next_stsc_entry;
-                next_stsc_entry = next_stsc_entry->next;
-                if(  next_stsc_entry
-                 && !next_stsc_entry->data )
-                    goto fail;
-                stsc_data = (isom_stsc_entry_t *)stsc_entry->data;
+                stsc_data = next_stsc_data;
+                ++next_stsc_entry_number;
                 /* Update sample description. */
-                description = (isom_sample_entry_t *)lsmash_list_get_entry_data( &stsd->list, stsc_data->sample_description_index );
+                description = (isom_sample_entry_t *)lsmash_vector_get_entry_data( &stsd->list, stsc_data->sample_description_index );
                 is_lpcm_audio          = LSMASH_IS_EXISTING_BOX( description ) ? isom_is_lpcm_audio( description )                : 0;
                 is_qt_fixed_comp_audio = LSMASH_IS_EXISTING_BOX( description ) ? isom_is_qt_fixed_compressed_audio( description ) : 0;
                 if( is_qt_fixed_comp_audio )
@@ -1104,7 +2071,7 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
         }
         else if( (err = isom_add_sample_info_entry( timeline, &info )) < 0 )
             goto fail;
-        if( timeline->info_list->entry_count && timeline->bunch_list->entry_count )
+        if( timeline->info.sample_count && timeline->bunch_list->entry_count )
         {
             lsmash_log( timeline, LSMASH_LOG_ERROR, "LPCM + non-LPCM track is not supported.\n" );
             err = LSMASH_ERR_PATCH_WELCOME;
@@ -1125,292 +2092,369 @@ int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
             --chunk_number;
         }
     }
-    uint32_t sample_count = packet_number - 1;
-    if( movie_fragments_present )
+    timeline->sample_count = packet_number - 1;
+    if( movie_fragments_allowed )
     {
-        isom_tfra_t                     *tfra       = isom_get_tfra( file->mfra, track_ID );
-        lsmash_entry_t                  *tfra_entry = tfra->list ? tfra->list->head : NULL;
-        isom_tfra_location_time_entry_t *rap        = tfra_entry ? (isom_tfra_location_time_entry_t *)tfra_entry->data : NULL;
-        chunk.data_offset = 0;
-        chunk.length      = 0;
         /* Movie fragments */
-        for( lsmash_entry_t *moof_entry = file->moof_list.head; moof_entry; moof_entry = moof_entry->next )
+        isom_tfra_t *tfra = isom_get_tfra( file->mfra, track_ID );
+        isom_fragment_expansion_t *state = lsmash_malloc_zero( sizeof(isom_fragment_expansion_t) );
+        if( !state )
         {
-            isom_moof_t *moof = (isom_moof_t *)moof_entry->data;
-            if( LSMASH_IS_NON_EXISTING_BOX( moof ) )
-                goto fail;
-            uint64_t last_sample_end_pos = 0;
-            /* Track fragments */
-            uint32_t traf_number = 1;
-            for( lsmash_entry_t *traf_entry = moof->traf_list.head; traf_entry; traf_entry = traf_entry->next )
-            {
-                isom_traf_t *traf = (isom_traf_t *)traf_entry->data;
-                isom_tfhd_t *tfhd = traf->tfhd;
-                isom_trex_t *trex = isom_get_trex( file->moov->mvex, tfhd->track_ID );
-                if( LSMASH_IS_NON_EXISTING_BOX( trex ) )
-                    goto fail;
-                /* Ignore ISOM_TF_FLAGS_DURATION_IS_EMPTY flag even if set. */
-                if( !traf->trun_list.head )
-                {
-                    ++traf_number;
-                    continue;
-                }
-                /* Get base_data_offset. */
-                uint64_t base_data_offset;
-                if( tfhd->flags & ISOM_TF_FLAGS_BASE_DATA_OFFSET_PRESENT )
-                    base_data_offset = tfhd->base_data_offset;
-                else if( (tfhd->flags & ISOM_TF_FLAGS_DEFAULT_BASE_IS_MOOF) || traf_entry == moof->traf_list.head )
-                    base_data_offset = moof->pos;
-                else
-                    base_data_offset = last_sample_end_pos;
-                /* sample grouping */
-                isom_sgpd_t *sgpd_frag_rap;
-                isom_sgpd_t *sgpd_frag_roll;
-                sgpd_frag_rap   = isom_get_fragment_sample_group_description( traf, ISOM_GROUP_TYPE_RAP );
-                sbgp_rap        = isom_get_fragment_sample_to_group         ( traf, ISOM_GROUP_TYPE_RAP );
-                sbgp_rap_entry  = sbgp_rap->list ? sbgp_rap->list->head : NULL;
-                sgpd_frag_roll  = isom_get_roll_recovery_sample_group_description( &traf->sgpd_list );
-                sbgp_roll       = isom_get_roll_recovery_sample_to_group         ( &traf->sbgp_list );
-                sbgp_roll_entry = sbgp_roll->list ? sbgp_roll->list->head : NULL;
-                int need_data_offset_only = (tfhd->track_ID != track_ID);
-                /* Track runs */
-                uint32_t trun_number = 1;
-                for( lsmash_entry_t *trun_entry = traf->trun_list.head; trun_entry; trun_entry = trun_entry->next )
-                {
-                    isom_trun_t *trun = (isom_trun_t *)trun_entry->data;
-                    if( LSMASH_IS_NON_EXISTING_BOX( trun ) )
-                        goto fail;
-                    if( trun->sample_count == 0 )
-                    {
-                        ++trun_number;
-                        continue;
-                    }
-                    /* Get data_offset. */
-                    if( trun->flags & ISOM_TR_FLAGS_DATA_OFFSET_PRESENT )
-                        data_offset = trun->data_offset + base_data_offset;
-                    else if( trun_entry == traf->trun_list.head )
-                        data_offset = base_data_offset;
-                    else
-                        data_offset = last_sample_end_pos;
-                    /* */
-                    uint32_t sample_description_index = 0;
-                    isom_sdtp_entry_t *sdtp_data = NULL;
-                    if( !need_data_offset_only )
-                    {
-                        /* Get sample_description_index of this track fragment. */
-                        if( tfhd->flags & ISOM_TF_FLAGS_SAMPLE_DESCRIPTION_INDEX_PRESENT )
-                            sample_description_index = tfhd->sample_description_index;
-                        else
-                            sample_description_index = trex->default_sample_description_index;
-                        description   = (isom_sample_entry_t *)lsmash_list_get_entry_data( &stsd->list, sample_description_index );
-                        is_lpcm_audio = LSMASH_IS_EXISTING_BOX( description ) ? isom_is_lpcm_audio( description ) : 0;
-                        /* Reference media data. */
-                        dref_entry = (isom_dref_entry_t *)lsmash_list_get_entry_data( dref_list, LSMASH_IS_EXISTING_BOX( description ) ? description->data_reference_index : 0 );
-                        lsmash_file_t *ref_file = (!dref_entry || LSMASH_IS_NON_EXISTING_BOX( dref_entry->ref_file )) ? NULL : dref_entry->ref_file;
-                        /* Each track run can be considered as a chunk.
-                         * Here, we consider physically consecutive track runs as one chunk. */
-                        if( chunk.data_offset + chunk.length != data_offset || chunk.file != ref_file )
-                        {
-                            chunk.data_offset = data_offset;
-                            chunk.length      = 0;
-                            chunk.number      = ++chunk_number;
-                            chunk.file        = ref_file;
-                            if( (err = isom_add_portable_chunk_entry( timeline, &chunk )) < 0 )
-                                goto fail;
-                        }
-                        /* Get dependency info for this track fragment. */
-                        sdtp_entry = traf->sdtp->list ? traf->sdtp->list->head : NULL;
-                        sdtp_data  = sdtp_entry && sdtp_entry->data ? (isom_sdtp_entry_t *)sdtp_entry->data : NULL;
-                    }
-                    /* Get info of each sample. */
-                    lsmash_entry_t *row_entry = trun->optional && trun->optional->head ? trun->optional->head : NULL;
-                    sample_number = 1;
-                    while( sample_number <= trun->sample_count )
-                    {
-                        isom_sample_info_t info = { 0 };
-                        isom_trun_optional_row_t *row = row_entry && row_entry->data ? (isom_trun_optional_row_t *)row_entry->data : NULL;
-                        /* Get sample_size */
-                        if( row && (trun->flags & ISOM_TR_FLAGS_SAMPLE_SIZE_PRESENT) )
-                            info.length = row->sample_size;
-                        else if( tfhd->flags & ISOM_TF_FLAGS_DEFAULT_SAMPLE_SIZE_PRESENT )
-                            info.length = tfhd->default_sample_size;
-                        else
-                            info.length = trex->default_sample_size;
-                        if( !need_data_offset_only )
-                        {
-                            info.pos   = data_offset;
-                            info.index = sample_description_index;
-                            info.chunk = (isom_portable_chunk_t *)timeline->chunk_list->tail->data;
-                            info.chunk->length += info.length;
-                            /* Get sample_duration. */
-                            if( row && (trun->flags & ISOM_TR_FLAGS_SAMPLE_DURATION_PRESENT) )
-                                info.duration = row->sample_duration;
-                            else if( tfhd->flags & ISOM_TF_FLAGS_DEFAULT_SAMPLE_DURATION_PRESENT )
-                                info.duration = tfhd->default_sample_duration;
-                            else
-                                info.duration = trex->default_sample_duration;
-                            /* Get composition time offset. */
-                            if( row && (trun->flags & ISOM_TR_FLAGS_SAMPLE_COMPOSITION_TIME_OFFSET_PRESENT) )
-                            {
-                                info.offset = row->sample_composition_time_offset;
-                                /* Check composition to decode timeline shift. */
-                                if( file->max_isom_version >= 6 && trun->version != 0 && info.offset != ISOM_NON_OUTPUT_SAMPLE_OFFSET )
-                                {
-                                    uint64_t cts = dts + (int32_t)info.offset;
-                                    if( (cts + timeline->ctd_shift) < dts )
-                                        timeline->ctd_shift = dts - cts;
-                                }
-                            }
-                            else
-                                info.offset = 0;
-                            dts += info.duration;
-                            /* Update media duration and maximun sample size. */
-                            timeline->media_duration += info.duration;
-                            timeline->max_sample_size = LSMASH_MAX( timeline->max_sample_size, info.length );
-                            if( !is_lpcm_audio )
-                            {
-                                /* Get sample_flags. */
-                                isom_sample_flags_t sample_flags;
-                                if( sample_number == 1 && (trun->flags & ISOM_TR_FLAGS_FIRST_SAMPLE_FLAGS_PRESENT) )
-                                    sample_flags = trun->first_sample_flags;
-                                else if( row && (trun->flags & ISOM_TR_FLAGS_SAMPLE_FLAGS_PRESENT) )
-                                    sample_flags = row->sample_flags;
-                                else if( tfhd->flags & ISOM_TF_FLAGS_DEFAULT_SAMPLE_FLAGS_PRESENT )
-                                    sample_flags = tfhd->default_sample_flags;
-                                else
-                                    sample_flags = trex->default_sample_flags;
-                                if( sdtp_data )
-                                {
-                                    /* Independent and Disposable Samples Box overrides the information from sample_flags.
-                                     * There is no description in the specification about this, but the intention should be such a thing.
-                                     * The ground is that sample_flags is placed in media layer
-                                     * while Independent and Disposable Samples Box is placed in track or presentation layer. */
-                                    info.prop.leading     = sdtp_data->is_leading;
-                                    info.prop.independent = sdtp_data->sample_depends_on;
-                                    info.prop.disposable  = sdtp_data->sample_is_depended_on;
-                                    info.prop.redundant   = sdtp_data->sample_has_redundancy;
-                                    if( sdtp_entry )
-                                        sdtp_entry = sdtp_entry->next;
-                                    sdtp_data = sdtp_entry ? (isom_sdtp_entry_t *)sdtp_entry->data : NULL;
-                                }
-                                else
-                                {
-                                    info.prop.leading     = sample_flags.is_leading;
-                                    info.prop.independent = sample_flags.sample_depends_on;
-                                    info.prop.disposable  = sample_flags.sample_is_depended_on;
-                                    info.prop.redundant   = sample_flags.sample_has_redundancy;
-                                }
-                                /* Check this sample is a sync sample or not.
-                                 * Note: all sync sample shall be independent. */
-                                if( !sample_flags.sample_is_non_sync_sample
-                                 && info.prop.independent != ISOM_SAMPLE_IS_NOT_INDEPENDENT )
-                                {
-                                    info.prop.ra_flags |= ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
-                                    distance = 0;
-                                }
-                                /* Get roll recovery grouping info. */
-                                uint32_t roll_id = sample_count + sample_number;
-                                if( sbgp_roll_entry
-                                 && isom_get_roll_recovery_grouping_info( timeline,
-                                                                          &sbgp_roll_entry, sgpd_roll, sgpd_frag_roll,
-                                                                          &sample_number_in_sbgp_roll_entry,
-                                                                          &info, roll_id ) < 0 )
-                                    goto fail;
-                                info.prop.post_roll.identifier = roll_id;
-                                /* Get random access point grouping info. */
-                                if( sbgp_rap_entry
-                                 && isom_get_random_access_point_grouping_info( timeline,
-                                                                                &sbgp_rap_entry, sgpd_rap, sgpd_frag_rap,
-                                                                                &sample_number_in_sbgp_rap_entry,
-                                                                                &info, &distance ) < 0 )
-                                    goto fail;
-                                /* Get the location of the sync sample from 'tfra' if it is not set up yet.
-                                 * Note: there is no guarantee that its entries are placed in a specific order. */
-                                if( LSMASH_IS_EXISTING_BOX( tfra ) )
-                                {
-                                    if( tfra->number_of_entry == 0
-                                     && info.prop.ra_flags == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
-                                        info.prop.ra_flags |= ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
-                                    if( rap
-                                     && rap->moof_offset   == moof->pos
-                                     && rap->traf_number   == traf_number
-                                     && rap->trun_number   == trun_number
-                                     && rap->sample_number == sample_number )
-                                    {
-                                        if( info.prop.ra_flags == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
-                                            info.prop.ra_flags |= ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
-                                        if( tfra_entry )
-                                            tfra_entry = tfra_entry->next;
-                                        rap = tfra_entry ? (isom_tfra_location_time_entry_t *)tfra_entry->data : NULL;
-                                    }
-                                }
-                                /* Set up distance from the previous random access point. */
-                                if( distance != NO_RANDOM_ACCESS_POINT )
-                                {
-                                    if( info.prop.pre_roll.distance == 0 )
-                                        info.prop.pre_roll.distance = distance;
-                                    ++distance;
-                                }
-                                /* OK. Let's add its info. */
-                                if( (err = isom_add_sample_info_entry( timeline, &info )) < 0 )
-                                    goto fail;
-                            }
-                            else
-                            {
-                                /* All LPCMFrame is a sync sample. */
-                                info.prop.ra_flags = ISOM_SAMPLE_RANDOM_ACCESS_FLAG_SYNC;
-                                /* OK. Let's add its info. */
-                                if( sample_count == 0 && sample_number == 1 )
-                                    isom_update_bunch( &bunch, &info );
-                                else if( isom_compare_lpcm_sample_info( &bunch, &info ) )
-                                {
-                                    if( (err = isom_add_lpcm_bunch_entry( timeline, &bunch )) < 0 )
-                                        goto fail;
-                                    isom_update_bunch( &bunch, &info );
-                                }
-                                else
-                                    ++ bunch.sample_count;
-                            }
-                            if( timeline-> info_list->entry_count
-                             && timeline->bunch_list->entry_count )
-                            {
-                                lsmash_log( timeline, LSMASH_LOG_ERROR, "LPCM + non-LPCM track is not supported.\n" );
-                                err = LSMASH_ERR_PATCH_WELCOME;
-                                goto fail;
-                            }
-                        }
-                        data_offset += info.length;
-                        last_sample_end_pos = data_offset;
-                        if( row_entry )
-                            row_entry = row_entry->next;
-                        ++sample_number;
-                    }
-                    if( !need_data_offset_only )
-                        sample_count += sample_number - 1;
-                    ++trun_number;
-                }   /* Track runs */
-                ++traf_number;
-            }   /* Track fragments */
-        }   /* Movie fragments */
+            err = LSMASH_ERR_MEMORY_ALLOC;
+            goto fail;
+        }
+        timeline->fragment_expansion = state;
+        state->tfra_entry   = tfra->list ? tfra->list->head : NULL;
+        state->chunk        = chunk;
+        state->chunk.data_offset = 0;
+        state->chunk.length      = 0;
+        state->dts          = dts;
+        state->chunk_number = chunk_number;
+        state->distance     = distance;
+        state->sample_number_in_sbgp_roll_entry = sample_number_in_sbgp_roll_entry;
+        state->sample_number_in_sbgp_rap_entry  = sample_number_in_sbgp_rap_entry;
+        if( (err = isom_timeline_expand_fragments( timeline, file, trak, &bunch )) < 0 )
+            goto fail;
     }
     else if( timeline->chunk_list->entry_count == 0 )
         goto fail;  /* No samples in this track. */
     if( bunch.sample_count && (err = isom_add_lpcm_bunch_entry( timeline, &bunch )) < 0 )
         goto fail;
-    if( (err = lsmash_list_add_entry( file->timeline, timeline )) < 0 )
-        goto fail;
     /* Finish timeline construction. */
-    timeline->sample_count = sample_count;
-    if( timeline->info_list->entry_count )
+    if( timeline->info.sample_count )
+    {
+        /* Release the unused space reserved for the growth. */
+        if( (err = isom_resize_sample_info_array( &timeline->info, timeline->info.sample_count )) < 0 )
+            goto fail;
         isom_timeline_set_sample_getter_funcs( timeline );
+    }
     else
         isom_timeline_set_lpcm_sample_getter_funcs( timeline );
+    *p_timeline = timeline;
+    return 0;
+fail:
+    isom_timeline_destroy( timeline );
+    return err;
+}
+
+int isom_timeline_construct( lsmash_root_t *root, uint32_t track_ID )
+{
+    if( isom_check_initializer_present( root ) < 0 )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    lsmash_file_t   *file     = root->file;
+    isom_trak_t     *trak     = NULL;
+    isom_timeline_t *timeline = NULL;
+    int err;
+    if( (err = isom_timeline_prepare( file, track_ID, &trak )) < 0
+     || (err = isom_timeline_build( file, trak, &timeline )) < 0 )
+        return err;
+    if( (err = isom_add_timeline( file, timeline )) < 0 )
+        isom_timeline_destroy( timeline );
+    return err;
+}
+
+static int isom_alloc_sample_run_index( isom_sample_run_index_t *index, uint32_t entry_count )
+{
+    return isom_realloc_array( &index->first_sample_number, LSMASH_MAX( entry_count, 1 ), sizeof(uint32_t) );
+}
+
+/* Append a run of samples to the index.
+ * Return 1 if the run is the tail, which never ends. */
+static int isom_append_sample_run( isom_sample_run_index_t *index, uint32_t sample_count )
+{
+    sample_count = LSMASH_MIN( sample_count, UINT32_MAX - index->sample_count );
+    if( sample_count == 0 )
+        return 1;
+    index->first_sample_number[ index->run_count++ ] = index->sample_count + 1;
+    index->sample_count += sample_count;
+    return 0;
+}
+
+static int isom_create_group_assignment_index
+(
+    isom_sample_run_index_t         *index,
+    isom_group_assignment_entry_t ***assignments,
+    isom_sbgp_t                     *sbgp
+)
+{
+    uint32_t entry_count = sbgp->list ? sbgp->list->entry_count : 0;
+    int err;
+    if( (err = isom_alloc_sample_run_index( index, entry_count )) < 0
+     || (err = isom_realloc_array( assignments, (uint64_t)entry_count + 1, sizeof(isom_group_assignment_entry_t *) )) < 0 )
+        return err;
+    (*assignments)[0] = NULL;
+    for( lsmash_entry_t *entry = entry_count ? sbgp->list->head : NULL; entry; entry = entry->next )
+    {
+        isom_group_assignment_entry_t *assignment = (isom_group_assignment_entry_t *)entry->data;
+        if( !assignment )
+            return LSMASH_ERR_INVALID_DATA;
+        (*assignments)[ index->run_count ] = assignment;
+        if( isom_append_sample_run( index, assignment->sample_count ) )
+            return 0;
+        (*assignments)[ index->run_count ] = NULL;
+    }
+    return 0;
+}
+
+/* Check that a given table is arranged in strictly increasing order of sample number. */
+static int isom_check_sample_number_order( isom_table_t *table )
+{
+    /* Both isom_stss_entry_t and isom_stps_entry_t consist of sample_number only. */
+    isom_stss_entry_t *data = (isom_stss_entry_t *)table->data;
+    uint32_t prev_sample_number = 0;
+    for( uint32_t i = 0; i < table->entry_count; i++ )
+    {
+        if( data[i].sample_number <= prev_sample_number )
+            return 0;
+        prev_sample_number = data[i].sample_number;
+    }
+    return 1;
+}
+
+/* Create the index of the sample tables for the lazy timeline.
+ * Return LSMASH_ERR_PATCH_WELCOME if the sample tables are so irregular that the lazy timeline cannot reproduce
+ * the same timeline as the one expanding every sample. */
+static int isom_create_sample_table_index
+(
+    isom_timeline_t *timeline,
+    lsmash_file_t   *file,
+    isom_trak_t     *trak
+)
+{
+    isom_stbl_t *stbl = trak->mdia->minf->stbl;
+    isom_dref_t *dref = trak->mdia->minf->dinf->dref;
+    if( !isom_check_sample_number_order( &stbl->stss->table )
+     || !isom_check_sample_number_order( &stbl->stps->table ) )
+        return LSMASH_ERR_PATCH_WELCOME;
+    isom_sample_table_index_t *index = lsmash_malloc_zero( sizeof(isom_sample_table_index_t) );
+    if( !index )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    timeline->stbl_index = index;
+    index->stbl       = stbl;
+    index->stsz_table = LSMASH_IS_EXISTING_BOX( stbl->stsz ) ? &stbl->stsz->table : &stbl->stz2->table;
+    index->sgpd_rap   = isom_get_sample_group_description( stbl, ISOM_GROUP_TYPE_RAP );
+    index->sgpd_roll  = isom_get_roll_recovery_sample_group_description( &stbl->sgpd_list );
+    index->dref_list  = LSMASH_IS_EXISTING_BOX( dref ) ? &dref->list : NULL;
+    index->constant_sample_size = stbl->stsz->sample_size;
+    index->all_sync           = LSMASH_IS_NON_EXISTING_BOX( stbl->stss );
+    index->iso_sdtp           = isom_check_iso_sdtp( file, stbl->sdtp );
+    index->large_presentation = stbl->stco->large_presentation || lsmash_check_box_type_identical( stbl->stco->type, ISOM_BOX_TYPE_CO64 );
+    /* Decoding Time to Sample Box */
+    isom_stts_entry_t *stts_data = (isom_stts_entry_t *)stbl->stts->table.data;
+    uint32_t stts_entry_count = stbl->stts->table.entry_count;
+    int err;
+    if( (err = isom_alloc_sample_run_index( &index->stts, stts_entry_count )) < 0
+     || (err = isom_realloc_array( &index->stts_first_dts, (uint64_t)stts_entry_count + 1, sizeof(uint64_t) )) < 0 )
+        return err;
+    uint64_t dts = 0;
+    for( uint32_t i = 0; i < stts_entry_count; i++ )
+    {
+        index->stts_first_dts[ index->stts.run_count ] = dts;
+        index->stts_tail_delta = stts_data[i].sample_delta;
+        if( isom_append_sample_run( &index->stts, stts_data[i].sample_count ) )
+            break;
+        dts += (uint64_t)(index->stts.sample_count - index->stts.first_sample_number[ index->stts.run_count - 1 ] + 1) * stts_data[i].sample_delta;
+    }
+    index->stts_first_dts[ index->stts.run_count ] = dts;
+    /* Composition Time to Sample Box */
+    isom_ctts_entry_t *ctts_data = (isom_ctts_entry_t *)stbl->ctts->table.data;
+    uint32_t ctts_entry_count = stbl->ctts->table.entry_count;
+    if( (err = isom_alloc_sample_run_index( &index->ctts, ctts_entry_count )) < 0 )
+        return err;
+    for( uint32_t i = 0; i < ctts_entry_count; i++ )
+        if( isom_append_sample_run( &index->ctts, ctts_data[i].sample_count ) )
+        {
+            index->ctts_tail_offset = ctts_data[i].sample_offset;
+            break;
+        }
+    /* Sample To Chunk Box */
+    isom_stsc_entry_t *stsc_data = (isom_stsc_entry_t *)stbl->stsc->table.data;
+    uint32_t stsc_entry_count = stbl->stsc->table.entry_count;
+    uint32_t chunk_count      = stbl->stco->table.entry_count;
+    if( (err = isom_alloc_sample_run_index( &index->stsc, stsc_entry_count )) < 0
+     || (err = isom_realloc_array( &index->stsc_entry_number, LSMASH_MAX( stsc_entry_count, 1 ), sizeof(uint32_t) )) < 0
+     || (err = isom_realloc_array( &index->stsc_first_chunk,  LSMASH_MAX( stsc_entry_count, 1 ), sizeof(uint32_t) )) < 0 )
+        return err;
+    uint64_t sample_count = 0;
+    for( uint32_t i = 0; i < stsc_entry_count && sample_count < timeline->sample_count; i++ )
+    {
+        uint32_t run = index->stsc.run_count;
+        /* The first entry is always applied to the first chunk. */
+        uint32_t first_chunk = run ? stsc_data[i].first_chunk : 1;
+        if( run && first_chunk <= index->stsc_first_chunk[run - 1] )
+        {
+            /* Just skip broken entry. */
+            lsmash_log( timeline, LSMASH_LOG_WARNING, "ignore broken entry in Sample To Chunk Box.\n" );
+            lsmash_log( timeline, LSMASH_LOG_WARNING, "timeline might be corrupted.\n" );
+            continue;
+        }
+        if( first_chunk > chunk_count )
+            break;
+        if( stsc_data[i].samples_per_chunk == 0 )
+            return LSMASH_ERR_PATCH_WELCOME;
+        if( run )
+            sample_count += (uint64_t)(first_chunk - index->stsc_first_chunk[run - 1])
+                          * stsc_data[ index->stsc_entry_number[run - 1] - 1 ].samples_per_chunk;
+        if( sample_count >= timeline->sample_count )
+            break;
+        index->stsc.first_sample_number[run] = sample_count + 1;
+        index->stsc_entry_number       [run] = i + 1;
+        index->stsc_first_chunk        [run] = first_chunk;
+        ++ index->stsc.run_count;
+    }
+    if( index->stsc.run_count )
+    {
+        uint32_t last = index->stsc.run_count - 1;
+        sample_count = index->stsc.first_sample_number[last] - 1
+                     + (uint64_t)(chunk_count - index->stsc_first_chunk[last] + 1)
+                     * stsc_data[ index->stsc_entry_number[last] - 1 ].samples_per_chunk;
+    }
+    if( sample_count < timeline->sample_count )
+        /* Some samples are not present in any chunk. */
+        return LSMASH_ERR_PATCH_WELCOME;
+    index->stsc.sample_count = timeline->sample_count;
+    /* Sample to Group Boxes */
+    if( (err = isom_create_group_assignment_index( &index->sbgp_roll, &index->sbgp_roll_assignment, isom_get_roll_recovery_sample_to_group( &stbl->sbgp_list ) )) < 0
+     || (err = isom_create_group_assignment_index( &index->sbgp_rap,  &index->sbgp_rap_assignment,  isom_get_sample_to_group( stbl, ISOM_GROUP_TYPE_RAP ) )) < 0 )
+        return err == LSMASH_ERR_INVALID_DATA ? LSMASH_ERR_PATCH_WELCOME : err;
+    return 0;
+}
+
+/* Construct the timeline without expanding the information of every sample.
+ * Return LSMASH_ERR_PATCH_WELCOME if the track cannot be handled by the lazy timeline. */
+static int isom_timeline_construct_lazily( lsmash_root_t *root, uint32_t track_ID )
+{
+    if( isom_check_initializer_present( root ) < 0 )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    lsmash_file_t *file = root->file;
+    if( LSMASH_IS_NON_EXISTING_BOX( file->moov->mvhd )
+     ||  file->moov->mvhd->timescale == 0
+     || LSMASH_IS_EXISTING_BOX( file->moov->mvex ) )
+        return LSMASH_ERR_PATCH_WELCOME;
+    isom_trak_t *trak = isom_get_trak( file, track_ID );
+    isom_stbl_t *stbl = trak->mdia->minf->stbl;
+    int err = isom_load_deferred_boxes( stbl );
+    if( err < 0 )
+        return err;
+    if( LSMASH_IS_NON_EXISTING_BOX( trak->tkhd )
+     || LSMASH_IS_NON_EXISTING_BOX( trak->mdia->mdhd )
+     || LSMASH_IS_NON_EXISTING_BOX( stbl->stsd )
+     || (LSMASH_IS_NON_EXISTING_BOX( stbl->stsz ) && LSMASH_IS_NON_EXISTING_BOX( stbl->stz2 ))
+     ||  trak->mdia->mdhd->timescale == 0
+     ||  stbl->stts->table.entry_count == 0
+     ||  stbl->stsc->table.entry_count == 0
+     ||  stbl->stco->table.entry_count == 0 )
+        return LSMASH_ERR_PATCH_WELCOME;
+    uint32_t sample_count = LSMASH_IS_EXISTING_BOX( stbl->stsz ) ? stbl->stsz->sample_count : stbl->stz2->sample_count;
+    if( sample_count == 0 )
+        return LSMASH_ERR_PATCH_WELCOME;
+    /* LPCM and fixed compressed audio are handled by the bunches of samples. */
+    isom_stsc_entry_t *stsc_data = isom_table_get_entry( &stbl->stsc->table, 1 );
+    if( LSMASH_IS_NON_EXISTING_BOX( (isom_sample_entry_t *)lsmash_vector_get_entry_data( &stbl->stsd->list, stsc_data->sample_description_index ) ) )
+        return LSMASH_ERR_PATCH_WELCOME;
+    for( uint32_t i = 1; i <= stbl->stsd->list.entry_count; i++ )
+    {
+        isom_sample_entry_t *description = (isom_sample_entry_t *)lsmash_vector_get_entry_data( &stbl->stsd->list, i );
+        if( LSMASH_IS_NON_EXISTING_BOX( description )
+         || isom_is_lpcm_audio( description )
+         || isom_is_qt_fixed_compressed_audio( description ) )
+            return LSMASH_ERR_PATCH_WELCOME;
+    }
+    /* Create a timeline. */
+    isom_timeline_t *timeline = isom_timeline_create();
+    if( !timeline )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    timeline->track_ID        = track_ID;
+    timeline->movie_timescale = file->moov->mvhd->timescale;
+    timeline->media_timescale = trak->mdia->mdhd->timescale;
+    timeline->track_duration  = trak->tkhd->duration;
+    timeline->sample_count    = sample_count;
+    if( (err = isom_timeline_copy_edits( timeline, trak->edts->elst )) < 0
+     || (err = isom_create_sample_table_index( timeline, file, trak )) < 0 )
+        goto fail;
+    isom_sample_table_index_t *index = timeline->stbl_index;
+    /* Get the media duration and the maximum sample size. */
+    timeline->media_duration = isom_get_dts_from_sample_table_index( index, sample_count )
+                             + isom_get_sample_delta_from_sample_table_index( index, sample_count );
+    uint32_t stsz_entry_count = LSMASH_MIN( index->stsz_table->entry_count, sample_count );
+    isom_stsz_entry_t *stsz_data = (isom_stsz_entry_t *)index->stsz_table->data;
+    for( uint32_t i = 0; i < stsz_entry_count; i++ )
+        timeline->max_sample_size = LSMASH_MAX( timeline->max_sample_size, stsz_data[i].entry_size );
+    if( stsz_entry_count < sample_count )
+        timeline->max_sample_size = LSMASH_MAX( timeline->max_sample_size, index->constant_sample_size );
+    /* Get the shift of composition timeline to decode timeline.
+     * The shift is updated at the last sample of each run in the same way as the construction expanding every sample. */
+    isom_ctts_t *ctts = stbl->ctts;
+    if( (file->max_isom_version >= 4 && ctts->version == 1) || file->qt_compatible )
+        for( uint32_t run = 0; run <= index->ctts.run_count; run++ )
+        {
+            uint32_t first_sample_number = run < index->ctts.run_count ? index->ctts.first_sample_number[run] : index->ctts.sample_count + 1;
+            if( first_sample_number > sample_count )
+                break;
+            uint32_t last_sample_number = run + 1 < index->ctts.run_count ? index->ctts.first_sample_number[run + 1] - 1
+                                        : run     < index->ctts.run_count ? index->ctts.sample_count
+                                        :                                   sample_count;
+            last_sample_number = LSMASH_MIN( last_sample_number, sample_count );
+            uint32_t sample_offset = isom_get_sample_offset_from_sample_table_index( index, first_sample_number );
+            if( sample_offset == ISOM_NON_OUTPUT_SAMPLE_OFFSET || (int32_t)sample_offset >= 0 )
+                continue;
+            uint64_t dts = isom_get_dts_from_sample_table_index( index, last_sample_number )
+                         + isom_get_sample_delta_from_sample_table_index( index, last_sample_number );
+            uint64_t cts = dts + (int32_t)sample_offset;
+            if( (cts + timeline->ctd_shift) < dts )
+                timeline->ctd_shift = dts - cts;
+        }
+    if( (err = isom_add_timeline( file, timeline )) < 0 )
+        goto fail;
+    isom_timeline_set_lazy_sample_getter_funcs( timeline );
     return 0;
 fail:
     isom_timeline_destroy( timeline );
     return err;
 }
 
+/* Expand the information of every sample of the lazy timeline. */
+static int isom_timeline_expand( isom_timeline_t *timeline )
+{
+    isom_sample_table_index_t *index = timeline->stbl_index;
+    isom_portable_chunk_t     *chunk = NULL;
+    int err;
+    for( uint32_t sample_number = 1; sample_number <= timeline->sample_count; sample_number++ )
+    {
+        isom_sample_info_t info;
+        if( (err = isom_get_sample_info_from_sample_table_index( timeline, sample_number, &info )) < 0 )
+            goto fail;
+        if( !chunk || chunk->number != info.chunk->number )
+        {
+            if( (err = isom_add_portable_chunk_entry( timeline, info.chunk )) < 0 )
+                goto fail;
+            chunk = (isom_portable_chunk_t *)timeline->chunk_list->tail->data;
+        }
+        chunk->length += info.length;
+        info.chunk = chunk;
+        if( (err = isom_add_sample_info_entry( timeline, &info )) < 0 )
+            goto fail;
+    }
+    if( (err = isom_resize_sample_info_array( &timeline->info, timeline->info.sample_count )) < 0 )
+        goto fail;
+    isom_remove_sample_table_index( index );
+    timeline->stbl_index = NULL;
+    isom_timeline_set_sample_getter_funcs( timeline );
+    return 0;
+fail:
+    lsmash_list_remove_entries( timeline->chunk_list );
+    lsmash_freep( &timeline->info.pos );
+    lsmash_freep( &timeline->info.dts );
+    lsmash_freep( &timeline->info.offset );
+    lsmash_freep( &timeline->info.length );
+    lsmash_freep( &timeline->info.index );
+    lsmash_freep( &timeline->info.chunk );
+    lsmash_freep( &timeline->info.prop );
+    timeline->info.sample_count = 0;
+    timeline->info.alloc_count  = 0;
+    return err;
+}
+
 int lsmash_construct_timeline( lsmash_root_t *root, uint32_t track_ID )
 {
     if( LSMASH_IS_NON_EXISTING_BOX( root )
@@ -1445,6 +2489,196 @@ int lsmash_construct_timeline( lsmash_root_t *root, uint32_t track_ID )
     return lsmash_importer_construct_timeline( root->file->importer, track_number );
 }
 
+int lsmash_construct_lazy_timeline( lsmash_root_t *root, uint32_t track_ID )
+{
+    if( LSMASH_IS_NON_EXISTING_BOX( root )
+     || LSMASH_IS_NON_EXISTING_BOX( root->file )
+     || track_ID == 0 )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    int err = isom_timeline_construct_lazily( root, track_ID );
+    if( err == LSMASH_ERR_PATCH_WELCOME )
+        /* Fall back to the timeline expanding every sample. */
+        return lsmash_construct_timeline( root, track_ID );
+    return err;
+}
+
+void isom_expand_lazy_timelines( lsmash_file_t *file )
+{
+    if( LSMASH_IS_NON_EXISTING_BOX( file ) || !file->timeline )
+        return;
+    /* Go backward so that the removal of a timeline does not skip the next one. */
+    for( uint32_t i = file->timeline->entry_count; i; i-- )
+    {
+        isom_timeline_t *timeline = (isom_timeline_t *)lsmash_vector_get_entry_data( file->timeline, i );
+        if( !timeline
+         || !timeline->stbl_index
+         || isom_timeline_expand( timeline ) == 0 )
+            continue;
+        /* The timeline cannot resolve any sample without the sample tables anymore. */
+        isom_remove_timeline( file, timeline );
+    }
+}
+
+typedef struct
+{
+    lsmash_mutex_t   *mutex;
+    lsmash_file_t    *file;
+    isom_trak_t     **trak;
+    isom_timeline_t **timeline;
+    uint32_t          track_count;
+    uint32_t          next;     /* the index of the track to be built next */
+    int               err;      /* the first error which occurred */
+} isom_timeline_builder_t;
+
+static void *isom_timeline_builder_main( void *arg )
+{
+    isom_timeline_builder_t *builder = (isom_timeline_builder_t *)arg;
+    while( 1 )
+    {
+        lsmash_mutex_lock( builder->mutex );
+        uint32_t i = builder->err < 0 ? builder->track_count : builder->next++;
+        lsmash_mutex_unlock( builder->mutex );
+        if( i >= builder->track_count )
+            break;
+        int err = isom_timeline_build( builder->file, builder->trak[i], &builder->timeline[i] );
+        if( err < 0 )
+        {
+            lsmash_mutex_lock( builder->mutex );
+            if( builder->err == 0 )
+                builder->err = err;
+            lsmash_mutex_unlock( builder->mutex );
+        }
+    }
+    return NULL;
+}
+
+static int isom_build_timelines_concurrently( isom_timeline_builder_t *builder, uint32_t thread_count )
+{
+    builder->mutex = lsmash_mutex_create();
+    if( !builder->mutex )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    lsmash_thread_t **thread = lsmash_malloc_zero( thread_count * sizeof(lsmash_thread_t *) );
+    if( !thread )
+    {
+        lsmash_mutex_destroy( builder->mutex );
+        return LSMASH_ERR_MEMORY_ALLOC;
+    }
+    /* The calling thread also works as a builder, so a failure to create threads only slows down the construction. */
+    for( uint32_t i = 1; i < thread_count; i++ )
+        thread[i] = lsmash_thread_create( isom_timeline_builder_main, builder );
+    isom_timeline_builder_main( builder );
+    for( uint32_t i = 1; i < thread_count; i++ )
+        if( thread[i] )
+            lsmash_thread_join( thread[i] );
+    lsmash_free( thread );
+    lsmash_mutex_destroy( builder->mutex );
+    return builder->err;
+}
+
+int lsmash_construct_all_timelines( lsmash_root_t *root, uint32_t thread_count )
+{
+    if( isom_check_initializer_present( root ) < 0 )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    lsmash_file_t *file = root->file;
+    isom_timeline_builder_t builder = { 0 };
+    builder.file = file;
+    uint32_t track_count = file->moov->trak_list.entry_count;
+    if( track_count == 0 )
+        return 0;
+    builder.trak     = lsmash_malloc_zero( track_count * sizeof(isom_trak_t *) );
+    builder.timeline = lsmash_malloc_zero( track_count * sizeof(isom_timeline_t *) );
+    int err = LSMASH_ERR_MEMORY_ALLOC;
+    if( !builder.trak || !builder.timeline )
+        goto fail;
+    /* Read everything required from the stream in advance since the stream cannot be shared between threads. */
+    for( lsmash_entry_t *entry = file->moov->trak_list.head; entry; entry = entry->next )
+    {
+        isom_trak_t *trak = (isom_trak_t *)entry->data;
+        if( LSMASH_IS_NON_EXISTING_BOX( trak->tkhd )
+         || isom_get_timeline( root, trak->tkhd->track_ID ) )
+            continue;
+        if( (err = isom_timeline_prepare( file, trak->tkhd->track_ID, &builder.trak[ builder.track_count ] )) < 0 )
+            goto fail;
+        ++ builder.track_count;
+    }
+    if( thread_count == 0 || thread_count > builder.track_count )
+        thread_count = builder.track_count;
+    if( thread_count > 1 )
+        err = isom_build_timelines_concurrently( &builder, thread_count );
+    else
+    {
+        err = 0;
+        for( uint32_t i = 0; i < builder.track_count && err == 0; i++ )
+            err = isom_timeline_build( file, builder.trak[i], &builder.timeline[i] );
+    }
+    if( err < 0 )
+        goto fail;
+    /* Add the timelines in the order of the tracks. */
+    for( uint32_t i = 0; i < builder.track_count; i++ )
+    {
+        if( (err = isom_add_timeline( file, builder.timeline[i] )) < 0 )
+        {
+            for( uint32_t j = 0; j < i; j++ )
+                lsmash_destruct_timeline( root, builder.trak[j]->tkhd->track_ID );
+            goto fail;
+        }
+        builder.timeline[i] = NULL;
+    }
+    err = 0;
+fail:
+    if( builder.timeline )
+        for( uint32_t i = 0; i < builder.track_count; i++ )
+            isom_timeline_destroy( builder.timeline[i] );
+    lsmash_free( builder.timeline );
+    lsmash_free( builder.trak );
+    return err;
+}
+
+int lsmash_extend_timeline( lsmash_root_t *root, uint32_t track_ID, uint32_t *sample_count )
+{
+    if( !sample_count )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    isom_timeline_t *timeline = isom_get_timeline( root, track_ID );
+    if( !timeline )
+        return LSMASH_ERR_NAMELESS;
+    if( !timeline->fragment_expansion )
+        return LSMASH_ERR_PATCH_WELCOME;
+    lsmash_file_t *file = root->file;
+    isom_trak_t   *trak = isom_get_trak( file, track_ID );
+    if( LSMASH_IS_NON_EXISTING_BOX( trak->mdia->minf->stbl ) )
+        return LSMASH_ERR_NAMELESS;
+    int err = isom_read_appended_boxes( file );
+    if( err < 0 )
+        return err;
+    /* The last LPCM bunch may continue in the appended movie fragments. */
+    isom_lpcm_bunch_t bunch = { 0 };
+    isom_lpcm_bunch_t *last_bunch = lsmash_list_get_entry_data( timeline->bunch_list, timeline->bunch_list->entry_count );
+    if( last_bunch )
+    {
+        bunch = *last_bunch;
+        lsmash_list_remove_entry( timeline->bunch_list, timeline->bunch_list->entry_count );
+    }
+    if( (err = isom_timeline_expand_fragments( timeline, file, trak, &bunch )) < 0
+     || (bunch.sample_count && (err = isom_add_lpcm_bunch_entry( timeline, &bunch )) < 0) )
+        return err;
+    /* Drop the caches which may refer to the removed bunch or miss the appended samples. */
+    lsmash_free( timeline->cts_index );
+    timeline->cts_index       = NULL;
+    timeline->cts_index_count = 0;
+    timeline->last_accessed_lpcm_bunch_number              = 0;
+    timeline->last_accessed_lpcm_bunch_duration            = 0;
+    timeline->last_accessed_lpcm_bunch_sample_count        = 0;
+    timeline->last_accessed_lpcm_bunch_first_sample_number = 0;
+    timeline->last_accessed_lpcm_bunch_dts                 = 0;
+    /* The array of sample info is not shrunk here since it will grow again at the next extension. */
+    if( timeline->info.sample_count )
+        isom_timeline_set_sample_getter_funcs( timeline );
+    else
+        isom_timeline_set_lpcm_sample_getter_funcs( timeline );
+    *sample_count = timeline->sample_count;
+    return 0;
+}
+
 int lsmash_get_dts_from_media_timeline( lsmash_root_t *root, uint32_t track_ID, uint32_t sample_number, uint64_t *dts )
 {
     if( !sample_number || !dts )
@@ -1479,6 +2713,255 @@ int lsmash_get_sample_info_from_media_timeline( lsmash_root_t *root, uint32_t tr
     return timeline ? timeline->get_sample_info( timeline, sample_number, sample ) : -1;
 }
 
+int lsmash_get_sample_view_from_media_timeline( lsmash_root_t *root, uint32_t track_ID, uint32_t sample_number, lsmash_sample_t *sample )
+{
+    if( !sample )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    isom_timeline_t *timeline = isom_get_timeline( root, track_ID );
+    return timeline ? isom_get_sample_view_from_media_timeline( timeline, sample_number, sample ) : LSMASH_ERR_NAMELESS;
+}
+
+int lsmash_get_sample_views_from_media_timeline( lsmash_root_t *root, uint32_t track_ID, uint32_t sample_number, lsmash_sample_t *samples, uint32_t *sample_count )
+{
+    if( !samples || !sample_count || *sample_count == 0 )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    isom_timeline_t *timeline = isom_get_timeline( root, track_ID );
+    if( !timeline )
+        return LSMASH_ERR_NAMELESS;
+    if( sample_number == 0 || sample_number > timeline->sample_count )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    return isom_get_sample_views_from_media_timeline( timeline, sample_number, samples, sample_count );
+}
+
+/* The read planner reads ahead the samples of multiple tracks in a file by sweeps in the order of the file offset.
+ * A sweep reads the region starting from the next sample of the requested track by a single read, and queues every
+ * planned track's samples in the region in decoding order, so the interleaved tracks are demuxed sequentially. */
+#define ISOM_READ_PLANNER_DEFAULT_READ_SIZE (4 * 1024 * 1024)
+
+typedef struct
+{
+    uint32_t            track_ID;
+    uint32_t            next_sample_number; /* the number of the sample next to the last queued one */
+    uint64_t            queued_size;        /* the total size of the queued samples */
+    lsmash_entry_list_t queue[1];           /* the samples read ahead in decoding order */
+    lsmash_sample_t     next;               /* the location of the sample of 'next_sample_number' if 'next_file' is set */
+    lsmash_file_t      *next_file;
+} isom_planned_track_t;
+
+typedef struct
+{
+    isom_planned_track_t *track;
+    lsmash_sample_t       location;
+} isom_planned_read_t;
+
+struct lsmash_read_planner_tag
+{
+    lsmash_root_t        *root;
+    uint32_t              max_read_size;
+    uint32_t              track_count;
+    isom_planned_track_t *track;
+    isom_planned_read_t  *read;         /* the samples to be read by a sweep */
+    uint32_t              read_alloc;
+};
+
+static void isom_clear_planned_track( isom_planned_track_t *track, uint32_t sample_number )
+{
+    lsmash_list_remove_entries( track->queue );
+    track->queued_size        = 0;
+    track->next_sample_number = sample_number;
+    track->next_file          = NULL;
+}
+
+static int isom_locate_next_planned_sample( lsmash_read_planner_t *planner, isom_planned_track_t *track )
+{
+    if( track->next_file )
+        return 0;
+    isom_timeline_t *timeline = isom_get_timeline( planner->root, track->track_ID );
+    if( !timeline
+     || track->next_sample_number == 0
+     || track->next_sample_number > timeline->sample_count )
+        return LSMASH_ERR_NAMELESS;
+    isom_portable_chunk_t *chunk;
+    int ret = timeline->locate_sample( timeline, track->next_sample_number, &track->next, &chunk );
+    if( ret < 0 )
+        return ret;
+    track->next_file = chunk->file;
+    return track->next_file ? 0 : LSMASH_ERR_NAMELESS;
+}
+
+static int isom_add_planned_read( lsmash_read_planner_t *planner, uint32_t count, isom_planned_track_t *track )
+{
+    if( count >= planner->read_alloc )
+    {
+        uint32_t alloc = planner->read_alloc ? planner->read_alloc * 2 : 256;
+        isom_planned_read_t *read = lsmash_realloc( planner->read, alloc * sizeof(isom_planned_read_t) );
+        if( !read )
+            return LSMASH_ERR_MEMORY_ALLOC;
+        planner->read       = read;
+        planner->read_alloc = alloc;
+    }
+    planner->read[count].track    = track;
+    planner->read[count].location = track->next;
+    return 0;
+}
+
+/* Read the region starting from the next sample of 'base' and queue the samples in it. */
+static int isom_sweep_planned_tracks( lsmash_read_planner_t *planner, isom_planned_track_t *base )
+{
+    int ret = isom_locate_next_planned_sample( planner, base );
+    if( ret < 0 )
+        return ret;
+    lsmash_file_t *file      = base->next_file;
+    uint64_t       start_pos = base->next.pos;
+    uint64_t       limit_pos = start_pos + LSMASH_MAX( base->next.length, planner->max_read_size );
+    uint64_t       end_pos   = start_pos;
+    uint32_t       count     = 0;
+    for( uint32_t i = 0; i < planner->track_count; i++ )
+    {
+        isom_planned_track_t *track = &planner->track[i];
+        /* Tracks holding enough samples are skipped in order to bound the memory for the samples nobody requests. */
+        if( track != base && track->queued_size >= planner->max_read_size )
+            continue;
+        uint64_t last_pos = start_pos;
+        while( isom_locate_next_planned_sample( planner, track ) == 0
+            && track->next_file == file
+            && track->next.pos >= last_pos
+            && track->next.pos + track->next.length <= limit_pos )
+        {
+            if( (ret = isom_add_planned_read( planner, count, track )) < 0 )
+                return ret;
+            ++count;
+            last_pos = track->next.pos;
+            end_pos  = LSMASH_MAX( end_pos, track->next.pos + track->next.length );
+            track->next_sample_number += 1;
+            track->next_file           = NULL;
+        }
+    }
+    if( count == 0 )
+        return LSMASH_ERR_NAMELESS;
+    /* Read the region at a time. */
+    lsmash_bs_t *bs   = file->bs;
+    uint8_t     *data = NULL;
+    if( lsmash_bs_read_seek( bs, start_pos, SEEK_SET ) < 0
+     || (end_pos > start_pos && (data = lsmash_bs_borrow_bytes( bs, end_pos - start_pos )) == NULL) )
+        ret = LSMASH_ERR_NAMELESS;
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        isom_planned_read_t  *read  = &planner->read[i];
+        isom_planned_track_t *track = read->track;
+        if( !track )
+            continue;
+        lsmash_sample_t *sample = ret < 0 ? NULL : isom_create_sample( planner->root->sample_pool, read->location.length );
+        if( !sample || lsmash_list_add_entry( track->queue, sample ) < 0 )
+        {
+            lsmash_delete_sample( sample );
+            /* Get the track back to the first sample not queued, and cancel the rest of its reads. */
+            track->next_sample_number -= 1;
+            track->next_file           = NULL;
+            for( uint32_t j = i + 1; j < count; j++ )
+                if( planner->read[j].track == track )
+                {
+                    planner->read[j].track     = NULL;
+                    track->next_sample_number -= 1;
+                }
+            ret = ret < 0 ? ret : LSMASH_ERR_MEMORY_ALLOC;
+            continue;
+        }
+        uint8_t *sample_data = sample->data;
+        *sample = read->location;
+        sample->data = sample_data;
+        if( sample->length )
+            memcpy( sample->data, data + (sample->pos - start_pos), sample->length );
+        track->queued_size += sample->length;
+    }
+    return ret;
+}
+
+void lsmash_destroy_read_planner( lsmash_read_planner_t *planner )
+{
+    if( !planner )
+        return;
+    if( planner->track )
+        for( uint32_t i = 0; i < planner->track_count; i++ )
+            lsmash_list_remove_entries( planner->track[i].queue );
+    lsmash_free( planner->track );
+    lsmash_free( planner->read );
+    lsmash_free( planner );
+}
+
+lsmash_read_planner_t *lsmash_create_read_planner( lsmash_root_t *root, const uint32_t *track_IDs, uint32_t track_count, uint32_t max_read_size )
+{
+    if( isom_check_initializer_present( root ) < 0
+     || !track_IDs
+     || track_count == 0 )
+        return NULL;
+    for( uint32_t i = 0; i < track_count; i++ )
+        if( !isom_get_timeline( root, track_IDs[i] ) )
+            return NULL;
+    lsmash_read_planner_t *planner = lsmash_malloc_zero( sizeof(lsmash_read_planner_t) );
+    if( !planner )
+        return NULL;
+    planner->track = lsmash_malloc_zero( track_count * sizeof(isom_planned_track_t) );
+    if( !planner->track )
+    {
+        lsmash_free( planner );
+        return NULL;
+    }
+    planner->root          = root;
+    planner->max_read_size = max_read_size ? max_read_size : ISOM_READ_PLANNER_DEFAULT_READ_SIZE;
+    planner->track_count   = track_count;
+    for( uint32_t i = 0; i < track_count; i++ )
+    {
+        isom_planned_track_t *track = &planner->track[i];
+        track->track_ID           = track_IDs[i];
+        track->next_sample_number = 1;
+        lsmash_list_init( track->queue, lsmash_delete_sample );
+    }
+    return planner;
+}
+
+lsmash_sample_t *lsmash_get_sample_from_read_planner( lsmash_read_planner_t *planner, uint32_t track_ID, uint32_t sample_number )
+{
+    if( !planner )
+        return NULL;
+    isom_planned_track_t *track = NULL;
+    for( uint32_t i = 0; i < planner->track_count; i++ )
+        if( planner->track[i].track_ID == track_ID )
+        {
+            track = &planner->track[i];
+            break;
+        }
+    isom_timeline_t *timeline = isom_get_timeline( planner->root, track_ID );
+    if( !track || !timeline || sample_number == 0 || sample_number > timeline->sample_count )
+        return NULL;
+    for( int retry = 0; retry < 2; retry++ )
+    {
+        if( track->queue->head )
+        {
+            lsmash_entry_t  *entry  = track->queue->head;
+            lsmash_sample_t *sample = (lsmash_sample_t *)entry->data;
+            /* The queue holds the samples just before 'next_sample_number'. */
+            if( sample && sample_number == track->next_sample_number - track->queue->entry_count )
+            {
+                entry->data = NULL;
+                lsmash_list_remove_entry_direct( track->queue, entry );
+                track->queued_size -= sample->length;
+                return sample;
+            }
+        }
+        if( retry )
+            break;
+        /* Random access or no sample queued. */
+        if( track->queue->entry_count || track->next_sample_number != sample_number )
+            isom_clear_planned_track( track, sample_number );
+        if( isom_sweep_planned_tracks( planner, track ) < 0 && track->queue->entry_count == 0 )
+            break;
+    }
+    /* Fall back on the reader of the timeline. */
+    isom_clear_planned_track( track, sample_number + 1 );
+    return timeline->get_sample( timeline, sample_number );
+}
+
 int lsmash_get_sample_property_from_media_timeline( lsmash_root_t *root, uint32_t track_ID, uint32_t sample_number, lsmash_sample_property_t *prop )
 {
     if( !prop )
@@ -1498,43 +2981,42 @@ int lsmash_get_composition_to_decode_shift_from_media_timeline( lsmash_root_t *r
     return 0;
 }
 
+/* Check whether the timeline has the information of each sample, i.e. the timeline is not of LPCM. */
+static inline int isom_has_sample_info( isom_timeline_t *timeline )
+{
+    return timeline->info.sample_count || timeline->stbl_index;
+}
+
+static lsmash_random_access_flag isom_get_random_access_flags( isom_timeline_t *timeline, uint32_t sample_number )
+{
+    if( timeline->stbl_index )
+    {
+        lsmash_sample_property_t prop;
+        isom_get_sample_property_from_sample_table_index( timeline->stbl_index, sample_number, &prop );
+        return prop.ra_flags;
+    }
+    return timeline->info.prop[sample_number - 1].ra_flags;
+}
+
 static int isom_get_closest_past_random_accessible_point_from_media_timeline( isom_timeline_t *timeline, uint32_t sample_number, uint32_t *rap_number )
 {
-    lsmash_entry_t *entry = lsmash_list_get_entry( timeline->info_list, sample_number-- );
-    if( !entry
-     || !entry->data )
+    if( sample_number == 0 || sample_number > timeline->sample_count )
         return LSMASH_ERR_NAMELESS;
-    isom_sample_info_t *info = (isom_sample_info_t *)entry->data;
-    while( info->prop.ra_flags == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
-    {
-        entry = entry->prev;
-        if( !entry
-         || !entry->data )
+    while( isom_get_random_access_flags( timeline, sample_number ) == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
+        if( --sample_number == 0 )
             return LSMASH_ERR_NAMELESS;
-        info = (isom_sample_info_t *)entry->data;
-        --sample_number;
-    }
-    *rap_number = sample_number + 1;
+    *rap_number = sample_number;
     return 0;
 }
 
 static inline int isom_get_closest_future_random_accessible_point_from_media_timeline( isom_timeline_t *timeline, uint32_t sample_number, uint32_t *rap_number )
 {
-    lsmash_entry_t *entry = lsmash_list_get_entry( timeline->info_list, sample_number++ );
-    if( !entry
-     || !entry->data )
+    if( sample_number == 0 || sample_number > timeline->sample_count )
         return LSMASH_ERR_NAMELESS;
-    isom_sample_info_t *info = (isom_sample_info_t *)entry->data;
-    while( info->prop.ra_flags == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
-    {
-        entry = entry->next;
-        if( !entry
-         || !entry->data )
+    while( isom_get_random_access_flags( timeline, sample_number ) == ISOM_SAMPLE_RANDOM_ACCESS_FLAG_NONE )
+        if( ++sample_number > timeline->sample_count )
             return LSMASH_ERR_NAMELESS;
-        info = (isom_sample_info_t *)entry->data;
-        ++sample_number;
-    }
-    *rap_number = sample_number - 1;
+    *rap_number = sample_number;
     return 0;
 }
 
@@ -1556,7 +3038,7 @@ int lsmash_get_closest_random_accessible_point_from_media_timeline( lsmash_root_
     isom_timeline_t *timeline = isom_get_timeline( root, track_ID );
     if( !timeline )
         return LSMASH_ERR_NAMELESS;
-    if( timeline->info_list->entry_count == 0 )
+    if( !isom_has_sample_info( timeline ) )
     {
         *rap_number = sample_number;    /* All LPCM is sync sample. */
         return 0;
@@ -1572,7 +3054,7 @@ int lsmash_get_closest_random_accessible_point_detail_from_media_timeline( lsmas
     isom_timeline_t *timeline = isom_get_timeline( root, track_ID );
     if( !timeline )
         return LSMASH_ERR_NAMELESS;
-    if( timeline->info_list->entry_count == 0 )
+    if( !isom_has_sample_info( timeline ) )
     {
         /* All LPCM is sync sample. */
         *rap_number = sample_number;
@@ -1587,11 +3069,11 @@ int lsmash_get_closest_random_accessible_point_detail_from_media_timeline( lsmas
     int ret = isom_get_closest_random_accessible_point_from_media_timeline_internal( timeline, sample_number, rap_number );
     if( ret < 0 )
         return ret;
-    isom_sample_info_t *info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, *rap_number );
-    if( !info )
-        return LSMASH_ERR_NAMELESS;
+    isom_sample_info_t info;
+    if( (ret = isom_get_sample_info( timeline, *rap_number, &info )) < 0 )
+        return ret;
     if( ra_flags )
-        *ra_flags = info->prop.ra_flags;
+        *ra_flags = info.prop.ra_flags;
     if( leading )
         *leading  = 0;
     if( distance )
@@ -1599,25 +3081,24 @@ int lsmash_get_closest_random_accessible_point_detail_from_media_timeline( lsmas
     if( sample_number < *rap_number )
         /* Impossible to desire to decode the sample of given number correctly. */
         return 0;
-    else if( !(info->prop.ra_flags & ISOM_SAMPLE_RANDOM_ACCESS_FLAG_GDR) )
+    else if( !(info.prop.ra_flags & ISOM_SAMPLE_RANDOM_ACCESS_FLAG_GDR) )
     {
         if( leading )
         {
             /* Count leading samples. */
             uint32_t current_sample_number = *rap_number + 1;
             uint64_t dts;
-            if( (ret = isom_get_dts_from_info_list( timeline, *rap_number, &dts )) < 0 )
+            if( (ret = timeline->get_dts( timeline, *rap_number, &dts )) < 0 )
                 return ret;
-            uint64_t rap_cts = isom_make_cts_adjust( dts, info->offset, timeline->ctd_shift );
+            uint64_t rap_cts = isom_make_cts_adjust( dts, info.offset, timeline->ctd_shift );
             do
             {
-                dts += info->duration;
+                dts += info.duration;
                 if( rap_cts <= dts )
                     break;  /* leading samples of this random accessible point must not be present more. */
-                info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, current_sample_number++ );
-                if( !info )
+                if( isom_get_sample_info( timeline, current_sample_number++, &info ) < 0 )
                     break;
-                uint64_t cts = isom_make_cts_adjust( dts, info->offset, timeline->ctd_shift );
+                uint64_t cts = isom_make_cts_adjust( dts, info.offset, timeline->ctd_shift );
                 if( rap_cts != LSMASH_TIMESTAMP_UNDEFINED && rap_cts > cts )
                     ++ *leading;
             } while( 1 );
@@ -1631,10 +3112,9 @@ int lsmash_get_closest_random_accessible_point_detail_from_media_timeline( lsmas
             if( isom_get_closest_past_random_accessible_point_from_media_timeline( timeline, prev_rap_number - 1, &prev_rap_number ) < 0 )
                 /* The previous random accessible point is not present. */
                 return 0;
-            info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, prev_rap_number );
-            if( !info )
-                return LSMASH_ERR_NAMELESS;
-            if( !(info->prop.ra_flags & ISOM_SAMPLE_RANDOM_ACCESS_FLAG_GDR) )
+            if( (ret = isom_get_sample_info( timeline, prev_rap_number, &info )) < 0 )
+                return ret;
+            if( !(info.prop.ra_flags & ISOM_SAMPLE_RANDOM_ACCESS_FLAG_GDR) )
             {
                 /* Decode shall already complete at the first closest non-recovery random accessible point if starting to decode from the second. */
                 *distance = *rap_number - prev_rap_number;
@@ -1645,21 +3125,21 @@ int lsmash_get_closest_random_accessible_point_detail_from_media_timeline( lsmas
     if( !distance )
         return 0;
     /* Calculate roll-distance. */
-    if( info->prop.pre_roll.distance )
+    if( info.prop.pre_roll.distance )
     {
         /* Pre-roll recovery */
         uint32_t prev_rap_number = *rap_number;
         do
         {
             if( isom_get_closest_past_random_accessible_point_from_media_timeline( timeline, prev_rap_number - 1, &prev_rap_number ) < 0
-             && *rap_number < info->prop.pre_roll.distance )
+             && *rap_number < info.prop.pre_roll.distance )
             {
                 /* The previous random accessible point is not present.
                  * And sample of given number might be not able to decoded correctly. */
                 *distance = 0;
                 return 0;
             }
-            if( prev_rap_number + info->prop.pre_roll.distance <= *rap_number )
+            if( prev_rap_number + info.prop.pre_roll.distance <= *rap_number )
             {
                 /*
                  *                                          |<---- pre-roll distance ---->|
@@ -1669,10 +3149,10 @@ int lsmash_get_closest_random_accessible_point_detail_from_media_timeline( lsmas
                  *       random accessible point         starting point        random accessible point   given sample
                  *                                                                   (complete)
                  */
-                *distance = info->prop.pre_roll.distance;
+                *distance = info.prop.pre_roll.distance;
                 return 0;
             }
-            else if( !(info->prop.ra_flags & ISOM_SAMPLE_RANDOM_ACCESS_FLAG_GDR) )
+            else if( !(info.prop.ra_flags & ISOM_SAMPLE_RANDOM_ACCESS_FLAG_GDR) )
             {
                 /*
                  *            |<------------ pre-roll distance ------------------>|
@@ -1688,7 +3168,7 @@ int lsmash_get_closest_random_accessible_point_detail_from_media_timeline( lsmas
         } while( 1 );
     }
     /* Post-roll recovery */
-    if( sample_number >= info->prop.post_roll.complete )
+    if( sample_number >= info.prop.post_roll.complete )
         /*
          *                  |<----- post-roll distance ----->|
          *            (distance = 0)
@@ -1704,10 +3184,9 @@ int lsmash_get_closest_random_accessible_point_detail_from_media_timeline( lsmas
         if( isom_get_closest_past_random_accessible_point_from_media_timeline( timeline, prev_rap_number - 1, &prev_rap_number ) < 0 )
             /* The previous random accessible point is not present. */
             return 0;
-        info = (isom_sample_info_t *)lsmash_list_get_entry_data( timeline->info_list, prev_rap_number );
-        if( !info )
-            return LSMASH_ERR_NAMELESS;
-        if( !(info->prop.ra_flags & ISOM_SAMPLE_RANDOM_ACCESS_FLAG_GDR) || sample_number >= info->prop.post_roll.complete )
+        if( (ret = isom_get_sample_info( timeline, prev_rap_number, &info )) < 0 )
+            return ret;
+        if( !(info.prop.ra_flags & ISOM_SAMPLE_RANDOM_ACCESS_FLAG_GDR) || sample_number >= info.prop.post_roll.complete )
         {
             *distance = *rap_number - prev_rap_number;
             return 0;
@@ -1715,6 +3194,227 @@ int lsmash_get_closest_random_accessible_point_detail_from_media_timeline( lsmas
     } while( 1 );
 }
 
+/* Get the greatest sample number whose DTS is not greater than a given DTS.
+ * DTSs never decrease in decoding order, so the sample can be found by binary search.
+ * If the given DTS precedes the first sample, the first sample is returned. */
+static int isom_find_sample_number_by_dts( isom_timeline_t *timeline, uint64_t dts, uint32_t *sample_number )
+{
+    if( timeline->sample_count == 0 )
+        return LSMASH_ERR_NAMELESS;
+    uint32_t low  = 1;
+    uint32_t high = timeline->sample_count;
+    while( low < high )
+    {
+        uint32_t mid = low + (high - low + 1) / 2;
+        uint64_t mid_dts;
+        int ret = timeline->get_dts( timeline, mid, &mid_dts );
+        if( ret < 0 )
+            return ret;
+        if( mid_dts <= dts )
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    *sample_number = low;
+    return 0;
+}
+
+static int isom_compare_cts_index_entries( const void *a, const void *b )
+{
+    const isom_cts_index_entry_t *entry_a = (const isom_cts_index_entry_t *)a;
+    const isom_cts_index_entry_t *entry_b = (const isom_cts_index_entry_t *)b;
+    if( entry_a->cts != entry_b->cts )
+        return entry_a->cts < entry_b->cts ? -1 : 1;
+    if( entry_a->sample_number != entry_b->sample_number )
+        return entry_a->sample_number < entry_b->sample_number ? -1 : 1;
+    return 0;
+}
+
+static int isom_create_cts_index( isom_timeline_t *timeline )
+{
+    isom_cts_index_entry_t *cts_index = lsmash_malloc( timeline->sample_count * sizeof(isom_cts_index_entry_t) );
+    if( !cts_index )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    uint32_t count = 0;
+    for( uint32_t sample_number = 1; sample_number <= timeline->sample_count; sample_number++ )
+    {
+        uint64_t cts;
+        int ret = timeline->get_cts( timeline, sample_number, &cts );
+        if( ret < 0 )
+        {
+            lsmash_free( cts_index );
+            return ret;
+        }
+        if( cts == LSMASH_TIMESTAMP_UNDEFINED )
+            continue;   /* Non-output samples are never presented. */
+        cts_index[count].cts           = cts + timeline->ctd_shift;
+        cts_index[count].sample_number = sample_number;
+        ++count;
+    }
+    if( count == 0 )
+    {
+        lsmash_free( cts_index );
+        return LSMASH_ERR_NAMELESS;
+    }
+    qsort( cts_index, count, sizeof(isom_cts_index_entry_t), isom_compare_cts_index_entries );
+    timeline->cts_index       = cts_index;
+    timeline->cts_index_count = count;
+    return 0;
+}
+
+/* Get the number of the output sample presented at a given CTS, that is, the sample with the greatest CTS not greater than it.
+ * If two or more samples share the CTS, the first one in decoding order is returned.
+ * If the given CTS precedes all samples, the first sample in composition order is returned. */
+static int isom_find_sample_number_by_cts( isom_timeline_t *timeline, uint64_t cts, uint32_t *sample_number )
+{
+    if( timeline->sample_count == 0 )
+        return LSMASH_ERR_NAMELESS;
+    if( !isom_has_sample_info( timeline ) )
+    {
+        /* LPCM has no composition reordering. */
+        uint64_t first_cts;
+        uint64_t first_dts;
+        int ret;
+        if( (ret = timeline->get_cts( timeline, 1, &first_cts )) < 0
+         || (ret = timeline->get_dts( timeline, 1, &first_dts )) < 0 )
+            return ret;
+        return isom_find_sample_number_by_dts( timeline, cts > first_cts ? cts - (first_cts - first_dts) : first_dts, sample_number );
+    }
+    if( !timeline->cts_index )
+    {
+        int ret = isom_create_cts_index( timeline );
+        if( ret < 0 )
+            return ret;
+    }
+    isom_cts_index_entry_t *cts_index = timeline->cts_index;
+    cts += timeline->ctd_shift;
+    /* Find the first entry whose CTS is greater than the given one. */
+    uint32_t low  = 0;
+    uint32_t high = timeline->cts_index_count;
+    while( low < high )
+    {
+        uint32_t mid = low + (high - low) / 2;
+        if( cts_index[mid].cts <= cts )
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if( low == 0 )
+    {
+        *sample_number = cts_index[0].sample_number;
+        return 0;
+    }
+    /* Rewind to the first one in decoding order among the samples sharing the CTS. */
+    uint64_t found_cts = cts_index[--low].cts;
+    while( low && cts_index[low - 1].cts == found_cts )
+        --low;
+    *sample_number = cts_index[low].sample_number;
+    return 0;
+}
+
+/* Convert a time on the presentation timeline into the composition time within the media by the edit list. */
+static int isom_get_cts_from_presentation_time( isom_timeline_t *timeline, uint64_t presentation_time, uint64_t *cts )
+{
+    if( timeline->edit_list->entry_count == 0 )
+    {
+        /* The media is presented as it is. */
+        *cts = presentation_time;
+        return 0;
+    }
+    uint64_t edit_start_time = 0;
+    for( lsmash_entry_t *entry = timeline->edit_list->head; entry; entry = entry->next )
+    {
+        isom_elst_entry_t *edit = (isom_elst_entry_t *)entry->data;
+        if( !edit )
+            return LSMASH_ERR_NAMELESS;
+        uint64_t edit_duration;
+        if( edit->segment_duration == ISOM_EDIT_DURATION_IMPLICIT
+         || edit->segment_duration == ISOM_EDIT_DURATION_UNKNOWN32
+         || edit->segment_duration == ISOM_EDIT_DURATION_UNKNOWN64
+         || timeline->movie_timescale == 0 )
+            edit_duration = UINT64_MAX; /* The edit lasts until the end of the media. */
+        else
+            edit_duration = edit->segment_duration * ((double)timeline->media_timescale / timeline->movie_timescale) + 0.5;
+        if( presentation_time - edit_start_time < edit_duration )
+        {
+            if( edit->media_time == ISOM_EDIT_MODE_EMPTY )
+            {
+                /* Nothing is presented in an empty edit, so seek to the beginning of the next edit. */
+                if( edit_duration == UINT64_MAX )
+                    return LSMASH_ERR_NAMELESS;
+                presentation_time = edit_start_time + edit_duration;
+            }
+            else if( edit->media_rate < 0 )
+                return LSMASH_ERR_PATCH_WELCOME;
+            else
+            {
+                uint64_t elapsed_time = presentation_time - edit_start_time;
+                if( edit->media_rate == ISOM_EDIT_MODE_DWELL )
+                    elapsed_time = 0;
+                else if( edit->media_rate != ISOM_EDIT_MODE_NORMAL )
+                    elapsed_time = elapsed_time * ((double)edit->media_rate / ISOM_EDIT_MODE_NORMAL);
+                *cts = edit->media_time + elapsed_time;
+                return 0;
+            }
+        }
+        if( edit_duration == UINT64_MAX )
+            break;
+        edit_start_time += edit_duration;
+    }
+    /* Nothing is presented at the given time. */
+    return LSMASH_ERR_NAMELESS;
+}
+
+static int isom_get_sample_number_from_media_timeline
+(
+    lsmash_root_t *root,
+    uint32_t       track_ID,
+    uint64_t       timestamp,
+    int            (*find_sample_number)( isom_timeline_t *, uint64_t, uint32_t * ),
+    uint32_t      *sample_number,
+    uint32_t      *rap_number
+)
+{
+    if( !sample_number )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    isom_timeline_t *timeline = isom_get_timeline( root, track_ID );
+    if( !timeline )
+        return LSMASH_ERR_NAMELESS;
+    int ret = find_sample_number( timeline, timestamp, sample_number );
+    if( ret < 0 || !rap_number )
+        return ret;
+    if( !isom_has_sample_info( timeline ) )
+    {
+        *rap_number = *sample_number;   /* All LPCM is sync sample. */
+        return 0;
+    }
+    return isom_get_closest_random_accessible_point_from_media_timeline_internal( timeline, *sample_number, rap_number );
+}
+
+int lsmash_get_sample_number_from_dts( lsmash_root_t *root, uint32_t track_ID, uint64_t dts, uint32_t *sample_number, uint32_t *rap_number )
+{
+    return isom_get_sample_number_from_media_timeline( root, track_ID, dts, isom_find_sample_number_by_dts, sample_number, rap_number );
+}
+
+int lsmash_get_sample_number_from_cts( lsmash_root_t *root, uint32_t track_ID, uint64_t cts, uint32_t *sample_number, uint32_t *rap_number )
+{
+    return isom_get_sample_number_from_media_timeline( root, track_ID, cts, isom_find_sample_number_by_cts, sample_number, rap_number );
+}
+
+static int isom_find_sample_number_by_presentation_time( isom_timeline_t *timeline, uint64_t presentation_time, uint32_t *sample_number )
+{
+    uint64_t cts;
+    int ret = isom_get_cts_from_presentation_time( timeline, presentation_time, &cts );
+    if( ret < 0 )
+        return ret;
+    return isom_find_sample_number_by_cts( timeline, cts, sample_number );
+}
+
+int lsmash_get_sample_number_from_presentation_time( lsmash_root_t *root, uint32_t track_ID, uint64_t presentation_time, uint32_t *sample_number, uint32_t *rap_number )
+{
+    return isom_get_sample_number_from_media_timeline( root, track_ID, presentation_time, isom_find_sample_number_by_presentation_time, sample_number, rap_number );
+}
+
 int lsmash_check_sample_existence_in_media_timeline( lsmash_root_t *root, uint32_t track_ID, uint32_t sample_number )
 {
     isom_timeline_t *timeline = isom_get_timeline( root, track_ID );
@@ -1902,62 +3602,52 @@ int lsmash_set_media_timestamps( lsmash_root_t *root, uint32_t track_ID, lsmash_
     isom_timeline_t *timeline = isom_get_timeline( root, track_ID );
     if( !timeline )
         return LSMASH_ERR_NAMELESS;
-    if( timeline->info_list->entry_count == 0 )
+    int err;
+    if( timeline->stbl_index && (err = isom_timeline_expand( timeline )) < 0 )
+        return err;
+    isom_sample_info_array_t *info = &timeline->info;
+    if( info->sample_count == 0 )
     {
         lsmash_log( timeline, LSMASH_LOG_ERROR, "Changing timestamps of LPCM track is not supported.\n" );
         return LSMASH_ERR_PATCH_WELCOME;
     }
-    if( ts_list->sample_count != timeline->info_list->entry_count )
+    if( ts_list->sample_count != info->sample_count )
         return LSMASH_ERR_INVALID_DATA; /* Number of samples must be same. */
     lsmash_media_ts_t *ts = ts_list->timestamp;
     if( ts[0].dts )
         return LSMASH_ERR_INVALID_DATA; /* DTS must start from value zero. */
+    /* The composition order index is built again on demand. */
+    lsmash_free( timeline->cts_index );
+    timeline->cts_index       = NULL;
+    timeline->cts_index_count = 0;
     /* Update DTSs. */
-    uint32_t sample_count  = ts_list->sample_count;
-    uint32_t i;
-    if( timeline->info_list->entry_count > 1 )
-    {
-        i = 1;
-        lsmash_entry_t *entry = timeline->info_list->head;
-        isom_sample_info_t *info = NULL;
-        while( i < sample_count )
-        {
-            info = (isom_sample_info_t *)entry->data;
-            if( !info || (ts[i].dts < ts[i - 1].dts) )
-                return LSMASH_ERR_INVALID_DATA;
-            info->duration = ts[i].dts - ts[i - 1].dts;
-            entry = entry->next;
-            ++i;
-        }
-        if( i > 1 )
+    uint32_t sample_count = ts_list->sample_count;
+    if( sample_count > 1 )
+    {
+        for( uint32_t i = 1; i < sample_count; i++ )
         {
-            if( !entry
-             || !entry->data )
+            if( ts[i].dts < ts[i - 1].dts )
                 return LSMASH_ERR_INVALID_DATA;
-            /* Copy the previous duration. */
-            ((isom_sample_info_t *)entry->data)->duration = info->duration;
+            info->dts[i] = ts[i].dts;
         }
-        else
-            return LSMASH_ERR_INVALID_DATA; /* Irregular case: sample_count this timeline has is incorrect. */
+        /* Copy the previous duration. */
+        info->dts[sample_count] = 2 * info->dts[sample_count - 1] - info->dts[sample_count - 2];
     }
     else    /* still image */
-        ((isom_sample_info_t *)timeline->info_list->head->data)->duration = UINT32_MAX;
+        info->dts[1] = UINT32_MAX;
     /* Update CTSs.
      * ToDo: hint track must not have any sample_offset. */
-    i = 0;
     timeline->ctd_shift = 0;
-    for( lsmash_entry_t *entry = timeline->info_list->head; entry; entry = entry->next )
+    for( uint32_t i = 0; i < sample_count; i++ )
     {
-        isom_sample_info_t *info = (isom_sample_info_t *)entry->data;
         if( ts[i].cts != LSMASH_TIMESTAMP_UNDEFINED )
         {
             if( (ts[i].cts + timeline->ctd_shift) < ts[i].dts )
                 timeline->ctd_shift = ts[i].dts - ts[i].cts;
-            info->offset = ts[i].cts - ts[i].dts;
+            info->offset[i] = ts[i].cts - ts[i].dts;
         }
         else
-            info->offset = ISOM_NON_OUTPUT_SAMPLE_OFFSET;
-        ++i;
+            info->offset[i] = ISOM_NON_OUTPUT_SAMPLE_OFFSET;
     }
     if( timeline->ctd_shift && (!root->file->qt_compatible || root->file->max_isom_version < 4) )
         return LSMASH_ERR_INVALID_DATA; /* Don't allow composition to decode timeline shift. */
@@ -1971,7 +3661,7 @@ int lsmash_get_media_timestamps( lsmash_root_t *root, uint32_t track_ID, lsmash_
     isom_timeline_t *timeline = isom_get_timeline( root, track_ID );
     if( !timeline )
         return LSMASH_ERR_NAMELESS;
-    uint32_t sample_count = timeline->info_list->entry_count;
+    uint32_t sample_count = timeline->stbl_index ? timeline->sample_count : timeline->info.sample_count;
     if( sample_count == 0 )
     {
         ts_list->sample_count = 0;
@@ -1983,19 +3673,18 @@ int lsmash_get_media_timestamps( lsmash_root_t *root, uint32_t track_ID, lsmash_
         return LSMASH_ERR_MEMORY_ALLOC;
     uint64_t dts = 0;
     uint32_t i = 0;
-    if( timeline->info_list->entry_count )
-        for( lsmash_entry_t *entry = timeline->info_list->head; entry; entry = entry->next )
+    if( timeline->info.sample_count )
+        for( i = 0; i < sample_count; i++ )
         {
-            isom_sample_info_t *info = (isom_sample_info_t *)entry->data;
-            if( !info )
-            {
-                lsmash_free( ts );
-                return LSMASH_ERR_NAMELESS;
-            }
-            ts[i].dts = dts;
-            ts[i].cts = isom_make_cts( dts, info->offset, timeline->ctd_shift );
-            dts += info->duration;
-            ++i;
+            ts[i].dts = timeline->info.dts[i];
+            ts[i].cts = isom_make_cts( ts[i].dts, timeline->info.offset[i], timeline->ctd_shift );
+        }
+    else if( timeline->stbl_index )
+        for( i = 0; i < sample_count; i++ )
+        {
+            uint32_t sample_offset = isom_get_sample_offset_from_sample_table_index( timeline->stbl_index, i + 1 );
+            ts[i].dts = isom_get_dts_from_sample_table_index( timeline->stbl_index, i + 1 );
+            ts[i].cts = isom_make_cts( ts[i].dts, sample_offset, timeline->ctd_shift );
         }
     else
         for( lsmash_entry_t *entry = timeline->bunch_list->head; entry; entry = entry->next )
@@ -2079,3 +3768,495 @@ int lsmash_get_max_sample_delay( lsmash_media_ts_list_t *ts_list, uint32_t *max_
     ts_list->timestamp = orig_ts;
     return 0;
 }
+
+/*---- timeline index ----*/
+/* The timeline index is a file caching the timelines constructed for a file,
+ * so that the timelines are loaded by a single read of the index instead of being constructed again when the file is reopened.
+ * The index is valid only for the file which has the same size, modification time and layout of the boxes in the Movie Box.
+ * All of the fields are stored in big endian.
+ *   header   : magic 'lsix', version, index size (64), source size (64), source modification time (64),
+ *              source layout hash (64), checksum (64), timeline count
+ *   timeline : track_ID, movie_timescale, media_timescale, sample_count, max_sample_size, ctd_shift,
+ *              media_duration (64), track_duration (64),
+ *              edit count, { segment_duration (64), media_time (64), media_rate } * edit count,
+ *              chunk count, { data_offset (64), length (64), number, data reference number } * chunk count,
+ *              sample info count, pos (64) * n, dts (64) * (n + 1), offset * n, length * n, index * n, chunk number * n, property * n,
+ *              bunch count, { pos (64), duration, offset, length, index, chunk number, property, sample_count } * bunch count
+ *   property : post_roll_identifier, post_roll_complete, pre_roll_distance,
+ *              ra_flags (8), allow_earlier (8), leading (8), independent (8), disposable (8), redundant (8)
+ * The data reference number is 0 if the chunk is in the file itself.
+ * The checksum is the FNV-1a hash of the rest of the index following it. */
+#define ISOM_TIMELINE_INDEX_MAGIC           LSMASH_4CC( 'l', 's', 'i', 'x' )
+#define ISOM_TIMELINE_INDEX_VERSION         1
+#define ISOM_TIMELINE_INDEX_CHECKSUM_OFFSET 40
+#define ISOM_TIMELINE_INDEX_HEADER_SIZE     52
+#define ISOM_FNV1A_64_BASIS                 UINT64_C(0xcbf29ce484222325)
+#define ISOM_FNV1A_64_PRIME                 UINT64_C(0x100000001b3)
+
+typedef struct
+{
+    uint64_t size;
+    int64_t  mtime;
+    uint64_t hash;
+} isom_timeline_index_source_t;
+
+/* FNV-1a hash of the types, the positions and the sizes of a box and its descendants */
+static uint64_t isom_hash_box_layout( uint64_t hash, isom_box_t *box )
+{
+    uint64_t value[3] = { box->type.fourcc, box->pos, box->size };
+    for( int i = 0; i < 3; i++ )
+        for( int shift = 0; shift < 64; shift += 8 )
+        {
+            hash ^= (value[i] >> shift) & 0xff;
+            hash *= ISOM_FNV1A_64_PRIME;
+        }
+    for( lsmash_entry_t *entry = box->extensions.head; entry; entry = entry->next )
+        if( entry->data )
+            hash = isom_hash_box_layout( hash, (isom_box_t *)entry->data );
+    return hash;
+}
+
+static int isom_get_timeline_index_source( lsmash_file_t *file, isom_timeline_index_source_t *source )
+{
+    if( LSMASH_IS_NON_EXISTING_BOX( file->moov ) )
+        return LSMASH_ERR_NAMELESS;
+    int err = isom_get_file_status( file, &source->size, &source->mtime );
+    if( err < 0 )
+        return err;
+    source->hash = isom_hash_box_layout( ISOM_FNV1A_64_BASIS, (isom_box_t *)file->moov );
+    return 0;
+}
+
+static uint64_t isom_get_timeline_index_checksum( const uint8_t *data, uint64_t index_size )
+{
+    uint64_t hash = ISOM_FNV1A_64_BASIS;
+    for( uint64_t i = ISOM_TIMELINE_INDEX_CHECKSUM_OFFSET + 8; i < index_size; i++ )
+    {
+        hash ^= data[i];
+        hash *= ISOM_FNV1A_64_PRIME;
+    }
+    return hash;
+}
+
+static void isom_put_packed_sample_property( lsmash_bs_t *bs, isom_packed_sample_property_t *prop )
+{
+    lsmash_bs_put_be32( bs, prop->post_roll_identifier );
+    lsmash_bs_put_be32( bs, prop->post_roll_complete );
+    lsmash_bs_put_be32( bs, prop->pre_roll_distance );
+    lsmash_bs_put_byte( bs, prop->ra_flags );
+    lsmash_bs_put_byte( bs, prop->allow_earlier );
+    lsmash_bs_put_byte( bs, prop->leading );
+    lsmash_bs_put_byte( bs, prop->independent );
+    lsmash_bs_put_byte( bs, prop->disposable );
+    lsmash_bs_put_byte( bs, prop->redundant );
+}
+
+static void isom_get_packed_sample_property( lsmash_bs_t *bs, isom_packed_sample_property_t *prop )
+{
+    prop->post_roll_identifier = lsmash_bs_get_be32( bs );
+    prop->post_roll_complete   = lsmash_bs_get_be32( bs );
+    prop->pre_roll_distance    = lsmash_bs_get_be32( bs );
+    prop->ra_flags             = lsmash_bs_get_byte( bs );
+    prop->allow_earlier        = lsmash_bs_get_byte( bs );
+    prop->leading              = lsmash_bs_get_byte( bs );
+    prop->independent          = lsmash_bs_get_byte( bs );
+    prop->disposable           = lsmash_bs_get_byte( bs );
+    prop->redundant            = lsmash_bs_get_byte( bs );
+}
+
+/* Get the number of a chunk in the list of chunks.
+ * The search starts from the chunk found last since the samples are mostly in the order of chunks. */
+static uint32_t isom_get_portable_chunk_number( lsmash_entry_list_t *chunk_list, isom_portable_chunk_t *chunk,
+                                                lsmash_entry_t **last_entry, uint32_t *last_number )
+{
+    for( int retry = 0; retry < 2; retry++ )
+    {
+        lsmash_entry_t *entry  = retry ? chunk_list->head : *last_entry;
+        uint32_t        number = retry ? 1                : *last_number;
+        for( ; entry; entry = entry->next, number++ )
+            if( entry->data == chunk )
+            {
+                *last_entry  = entry;
+                *last_number = number;
+                return number;
+            }
+    }
+    return 0;
+}
+
+static uint32_t isom_get_data_reference_number( lsmash_entry_list_t *dref_list, lsmash_file_t *ref_file )
+{
+    if( !ref_file || !dref_list )
+        return 0;
+    uint32_t number = 1;
+    for( lsmash_entry_t *entry = dref_list->head; entry; entry = entry->next, number++ )
+    {
+        isom_dref_entry_t *dref_entry = (isom_dref_entry_t *)entry->data;
+        if( dref_entry && dref_entry->ref_file == ref_file )
+            return number;
+    }
+    return 0;
+}
+
+static void isom_put_timeline_to_index( lsmash_bs_t *bs, isom_timeline_t *timeline, lsmash_entry_list_t *dref_list )
+{
+    lsmash_bs_put_be32( bs, timeline->track_ID );
+    lsmash_bs_put_be32( bs, timeline->movie_timescale );
+    lsmash_bs_put_be32( bs, timeline->media_timescale );
+    lsmash_bs_put_be32( bs, timeline->sample_count );
+    lsmash_bs_put_be32( bs, timeline->max_sample_size );
+    lsmash_bs_put_be32( bs, timeline->ctd_shift );
+    lsmash_bs_put_be64( bs, timeline->media_duration );
+    lsmash_bs_put_be64( bs, timeline->track_duration );
+    lsmash_bs_put_be32( bs, timeline->edit_list->entry_count );
+    for( lsmash_entry_t *entry = timeline->edit_list->head; entry; entry = entry->next )
+    {
+        isom_elst_entry_t *edit = (isom_elst_entry_t *)entry->data;
+        lsmash_bs_put_be64( bs, edit->segment_duration );
+        lsmash_bs_put_be64( bs, edit->media_time );
+        lsmash_bs_put_be32( bs, edit->media_rate );
+    }
+    lsmash_bs_put_be32( bs, timeline->chunk_list->entry_count );
+    for( lsmash_entry_t *entry = timeline->chunk_list->head; entry; entry = entry->next )
+    {
+        isom_portable_chunk_t *chunk = (isom_portable_chunk_t *)entry->data;
+        lsmash_bs_put_be64( bs, chunk->data_offset );
+        lsmash_bs_put_be64( bs, chunk->length );
+        lsmash_bs_put_be32( bs, chunk->number );
+        lsmash_bs_put_be32( bs, isom_get_data_reference_number( dref_list, chunk->file ) );
+    }
+    isom_sample_info_array_t *info = &timeline->info;
+    lsmash_entry_t *last_entry  = timeline->chunk_list->head;
+    uint32_t        last_number = 1;
+    lsmash_bs_put_be32( bs, info->sample_count );
+    if( info->sample_count )
+    {
+        lsmash_bs_put_be64_array( bs, info->pos,    info->sample_count );
+        lsmash_bs_put_be64_array( bs, info->dts,    info->sample_count + 1 );
+        lsmash_bs_put_be32_array( bs, info->offset, info->sample_count );
+        lsmash_bs_put_be32_array( bs, info->length, info->sample_count );
+        lsmash_bs_put_be32_array( bs, info->index,  info->sample_count );
+        for( uint32_t i = 0; i < info->sample_count; i++ )
+            lsmash_bs_put_be32( bs, isom_get_portable_chunk_number( timeline->chunk_list, info->chunk[i], &last_entry, &last_number ) );
+        for( uint32_t i = 0; i < info->sample_count; i++ )
+            isom_put_packed_sample_property( bs, &info->prop[i] );
+    }
+    lsmash_bs_put_be32( bs, timeline->bunch_list->entry_count );
+    for( lsmash_entry_t *entry = timeline->bunch_list->head; entry; entry = entry->next )
+    {
+        isom_lpcm_bunch_t *bunch = (isom_lpcm_bunch_t *)entry->data;
+        isom_packed_sample_property_t prop;
+        isom_pack_sample_property( &prop, &bunch->prop );
+        lsmash_bs_put_be64( bs, bunch->pos );
+        lsmash_bs_put_be32( bs, bunch->duration );
+        lsmash_bs_put_be32( bs, bunch->offset );
+        lsmash_bs_put_be32( bs, bunch->length );
+        lsmash_bs_put_be32( bs, bunch->index );
+        lsmash_bs_put_be32( bs, isom_get_portable_chunk_number( timeline->chunk_list, bunch->chunk, &last_entry, &last_number ) );
+        isom_put_packed_sample_property( bs, &prop );
+        lsmash_bs_put_be32( bs, bunch->sample_count );
+    }
+}
+
+/* Check if a timeline is cached in the index.
+ * Only the timelines visible through the API are cached.
+ * The lazy timeline is not since it refers to the sample tables and is cheap to construct anyway. */
+static int isom_is_indexable_timeline( lsmash_file_t *file, isom_timeline_t *timeline )
+{
+    return timeline
+        && !timeline->stbl_index
+        && timeline == lsmash_id_index_get( &file->timeline_index, timeline->track_ID );
+}
+
+static void isom_put_timeline_index( lsmash_bs_t *bs, lsmash_file_t *file, isom_timeline_index_source_t *source, uint32_t timeline_count )
+{
+    lsmash_bs_put_be32( bs, ISOM_TIMELINE_INDEX_MAGIC );
+    lsmash_bs_put_be32( bs, ISOM_TIMELINE_INDEX_VERSION );
+    lsmash_bs_put_be64( bs, 0 );    /* index size, set later */
+    lsmash_bs_put_be64( bs, source->size );
+    lsmash_bs_put_be64( bs, source->mtime );
+    lsmash_bs_put_be64( bs, source->hash );
+    lsmash_bs_put_be64( bs, 0 );    /* checksum, set later */
+    lsmash_bs_put_be32( bs, timeline_count );
+    for( uint32_t i = 1; timeline_count && i <= file->timeline->entry_count; i++ )
+    {
+        isom_timeline_t *timeline = (isom_timeline_t *)lsmash_vector_get_entry_data( file->timeline, i );
+        if( !isom_is_indexable_timeline( file, timeline ) )
+            continue;
+        isom_dref_t *dref = isom_get_trak( file, timeline->track_ID )->mdia->minf->dinf->dref;
+        isom_put_timeline_to_index( bs, timeline, LSMASH_IS_EXISTING_BOX( dref ) ? &dref->list : NULL );
+    }
+}
+
+#define ISOM_TIMELINE_INDEX_MIN_TIMELINE_SIZE 56
+#define ISOM_TIMELINE_INDEX_EDIT_SIZE         20
+#define ISOM_TIMELINE_INDEX_CHUNK_SIZE        24
+#define ISOM_TIMELINE_INDEX_SAMPLE_INFO_SIZE  50
+#define ISOM_TIMELINE_INDEX_BUNCH_SIZE        50
+
+static int isom_get_timeline_from_index( lsmash_bs_t *bs, lsmash_file_t *file, isom_timeline_t **p_timeline )
+{
+    isom_timeline_t *timeline = isom_timeline_create();
+    if( !timeline )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    isom_portable_chunk_t **chunks = NULL;
+    int err = LSMASH_ERR_INVALID_DATA;
+    timeline->track_ID        = lsmash_bs_get_be32( bs );
+    timeline->movie_timescale = lsmash_bs_get_be32( bs );
+    timeline->media_timescale = lsmash_bs_get_be32( bs );
+    timeline->sample_count    = lsmash_bs_get_be32( bs );
+    timeline->max_sample_size = lsmash_bs_get_be32( bs );
+    timeline->ctd_shift       = lsmash_bs_get_be32( bs );
+    timeline->media_duration  = lsmash_bs_get_be64( bs );
+    timeline->track_duration  = lsmash_bs_get_be64( bs );
+    isom_trak_t *trak = isom_get_trak( file, timeline->track_ID );
+    if( LSMASH_IS_NON_EXISTING_BOX( trak->tkhd ) )
+        goto fail;
+    isom_dref_t *dref = trak->mdia->minf->dinf->dref;
+    lsmash_entry_list_t *dref_list = LSMASH_IS_EXISTING_BOX( dref ) ? &dref->list : NULL;
+    /* Edits */
+    uint32_t edit_count = lsmash_bs_get_be32( bs );
+    if( edit_count > lsmash_bs_get_remaining_buffer_size( bs ) / ISOM_TIMELINE_INDEX_EDIT_SIZE )
+        goto fail;
+    for( uint32_t i = 0; i < edit_count; i++ )
+    {
+        isom_elst_entry_t *edit = lsmash_malloc( sizeof(isom_elst_entry_t) );
+        if( !edit || lsmash_list_add_entry( timeline->edit_list, edit ) < 0 )
+        {
+            lsmash_free( edit );
+            err = LSMASH_ERR_MEMORY_ALLOC;
+            goto fail;
+        }
+        edit->segment_duration = lsmash_bs_get_be64( bs );
+        edit->media_time       = lsmash_bs_get_be64( bs );
+        edit->media_rate       = lsmash_bs_get_be32( bs );
+    }
+    /* Chunks */
+    uint32_t chunk_count = lsmash_bs_get_be32( bs );
+    if( chunk_count > lsmash_bs_get_remaining_buffer_size( bs ) / ISOM_TIMELINE_INDEX_CHUNK_SIZE )
+        goto fail;
+    if( chunk_count )
+    {
+        chunks = lsmash_malloc( chunk_count * sizeof(isom_portable_chunk_t *) );
+        if( !chunks )
+        {
+            err = LSMASH_ERR_MEMORY_ALLOC;
+            goto fail;
+        }
+    }
+    for( uint32_t i = 0; i < chunk_count; i++ )
+    {
+        isom_portable_chunk_t chunk;
+        chunk.data_offset = lsmash_bs_get_be64( bs );
+        chunk.length      = lsmash_bs_get_be64( bs );
+        chunk.number      = lsmash_bs_get_be32( bs );
+        chunk.file        = NULL;
+        uint32_t data_reference_number = lsmash_bs_get_be32( bs );
+        if( chunk.data_offset > INT64_MAX )
+            goto fail;
+        if( data_reference_number )
+        {
+            isom_dref_entry_t *dref_entry = dref_list ? (isom_dref_entry_t *)lsmash_list_get_entry_data( dref_list, data_reference_number ) : NULL;
+            if( !dref_entry )
+                goto fail;
+            chunk.file = LSMASH_IS_NON_EXISTING_BOX( dref_entry->ref_file ) ? NULL : dref_entry->ref_file;
+        }
+        if( (err = isom_add_portable_chunk_entry( timeline, &chunk )) < 0 )
+            goto fail;
+        chunks[i] = (isom_portable_chunk_t *)timeline->chunk_list->tail->data;
+    }
+    err = LSMASH_ERR_INVALID_DATA;
+    /* Samples */
+    isom_sample_info_array_t *info = &timeline->info;
+    uint32_t sample_count = lsmash_bs_get_be32( bs );
+    if( sample_count > lsmash_bs_get_remaining_buffer_size( bs ) / ISOM_TIMELINE_INDEX_SAMPLE_INFO_SIZE )
+        goto fail;
+    if( sample_count )
+    {
+        if( (err = isom_resize_sample_info_array( info, sample_count )) < 0 )
+            goto fail;
+        err = LSMASH_ERR_INVALID_DATA;
+        info->sample_count = sample_count;
+        lsmash_bs_get_be64_array( bs, info->pos,    sample_count );
+        lsmash_bs_get_be64_array( bs, info->dts,    sample_count + 1 );
+        lsmash_bs_get_be32_array( bs, info->offset, sample_count );
+        lsmash_bs_get_be32_array( bs, info->length, sample_count );
+        lsmash_bs_get_be32_array( bs, info->index,  sample_count );
+        for( uint32_t i = 0; i < sample_count; i++ )
+        {
+            uint32_t chunk_number = lsmash_bs_get_be32( bs );
+            if( chunk_number == 0 || chunk_number > chunk_count )
+                goto fail;
+            info->chunk[i] = chunks[chunk_number - 1];
+            if( info->pos[i] > INT64_MAX )
+                goto fail;
+        }
+        for( uint32_t i = 0; i < sample_count; i++ )
+            isom_get_packed_sample_property( bs, &info->prop[i] );
+    }
+    /* LPCM bunches */
+    uint32_t bunch_count = lsmash_bs_get_be32( bs );
+    if( bunch_count > lsmash_bs_get_remaining_buffer_size( bs ) / ISOM_TIMELINE_INDEX_BUNCH_SIZE
+     || (bunch_count && sample_count) )
+        goto fail;
+    for( uint32_t i = 0; i < bunch_count; i++ )
+    {
+        isom_lpcm_bunch_t bunch;
+        isom_packed_sample_property_t prop;
+        bunch.pos      = lsmash_bs_get_be64( bs );
+        bunch.duration = lsmash_bs_get_be32( bs );
+        bunch.offset   = lsmash_bs_get_be32( bs );
+        bunch.length   = lsmash_bs_get_be32( bs );
+        bunch.index    = lsmash_bs_get_be32( bs );
+        uint32_t chunk_number = lsmash_bs_get_be32( bs );
+        if( chunk_number == 0 || chunk_number > chunk_count || bunch.pos > INT64_MAX )
+            goto fail;
+        bunch.chunk = chunks[chunk_number - 1];
+        isom_get_packed_sample_property( bs, &prop );
+        isom_unpack_sample_property( &bunch.prop, &prop );
+        bunch.sample_count = lsmash_bs_get_be32( bs );
+        if( (err = isom_add_lpcm_bunch_entry( timeline, &bunch )) < 0 )
+            goto fail;
+        err = LSMASH_ERR_INVALID_DATA;
+        sample_count += bunch.sample_count;
+    }
+    if( bs->eob || bs->error || sample_count != timeline->sample_count )
+        goto fail;
+    if( timeline->info.sample_count )
+        isom_timeline_set_sample_getter_funcs( timeline );
+    else
+        isom_timeline_set_lpcm_sample_getter_funcs( timeline );
+    lsmash_free( chunks );
+    *p_timeline = timeline;
+    return 0;
+fail:
+    lsmash_free( chunks );
+    isom_timeline_destroy( timeline );
+    return err;
+}
+
+static int isom_get_timeline_index( lsmash_bs_t *bs, lsmash_file_t *file, isom_timeline_index_source_t *source, uint64_t index_size )
+{
+    if( index_size < ISOM_TIMELINE_INDEX_HEADER_SIZE
+     || lsmash_bs_get_be32( bs ) != ISOM_TIMELINE_INDEX_MAGIC
+     || lsmash_bs_get_be32( bs ) != ISOM_TIMELINE_INDEX_VERSION
+     || lsmash_bs_get_be64( bs ) != index_size
+     || lsmash_bs_get_be64( bs ) != source->size
+     || (int64_t)lsmash_bs_get_be64( bs ) != source->mtime
+     || lsmash_bs_get_be64( bs ) != source->hash
+     || lsmash_bs_get_be64( bs ) != isom_get_timeline_index_checksum( bs->buffer.data, index_size ) )
+        return LSMASH_ERR_INVALID_DATA;
+    uint32_t timeline_count = lsmash_bs_get_be32( bs );
+    if( timeline_count > lsmash_bs_get_remaining_buffer_size( bs ) / ISOM_TIMELINE_INDEX_MIN_TIMELINE_SIZE )
+        return LSMASH_ERR_INVALID_DATA;
+    if( timeline_count == 0 )
+        return bs->eob || bs->error ? LSMASH_ERR_INVALID_DATA : 0;
+    isom_timeline_t **timeline = lsmash_malloc_zero( timeline_count * sizeof(isom_timeline_t *) );
+    if( !timeline )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    int err = 0;
+    for( uint32_t i = 0; i < timeline_count && err == 0; i++ )
+        err = isom_get_timeline_from_index( bs, file, &timeline[i] );
+    if( err == 0 && lsmash_bs_get_remaining_buffer_size( bs ) )
+        err = LSMASH_ERR_INVALID_DATA;
+    /* Add the timelines only after all of them are loaded successfully.
+     * The timelines constructed already take precedence over the loaded ones. */
+    for( uint32_t i = 0; i < timeline_count; i++ )
+        if( err == 0
+         && !lsmash_id_index_get( &file->timeline_index, timeline[i]->track_ID )
+         && (err = isom_add_timeline( file, timeline[i] )) == 0 )
+            timeline[i] = NULL;
+        else
+            isom_timeline_destroy( timeline[i] );
+    lsmash_free( timeline );
+    return err;
+}
+
+int lsmash_write_timeline_index( lsmash_root_t *root, const char *filename )
+{
+    if( isom_check_initializer_present( root ) < 0 || !filename )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    lsmash_file_t *file = root->file;
+    isom_timeline_index_source_t source;
+    int err = isom_get_timeline_index_source( file, &source );
+    if( err < 0 )
+        return err;
+    uint32_t timeline_count = 0;
+    for( uint32_t i = 1; file->timeline && i <= file->timeline->entry_count; i++ )
+        if( isom_is_indexable_timeline( file, (isom_timeline_t *)lsmash_vector_get_entry_data( file->timeline, i ) ) )
+            ++timeline_count;
+    /* Get the size of the index by the bytestream without buffer, and then write the index into the buffer of the exact size. */
+    lsmash_bs_t bs = { 0 };
+    isom_put_timeline_index( &bs, file, &source, timeline_count );
+    uint64_t index_size = bs.buffer.store;
+    if( index_size > SIZE_MAX )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    uint8_t *data = lsmash_malloc( index_size );
+    if( !data )
+        return LSMASH_ERR_MEMORY_ALLOC;
+    memset( &bs, 0, sizeof(lsmash_bs_t) );
+    bs.buffer.data  = data;
+    bs.buffer.alloc = index_size;
+    isom_put_timeline_index( &bs, file, &source, timeline_count );
+    assert( bs.buffer.store == index_size && !bs.error );
+    LSMASH_SET_BE64( &data[8], index_size );
+    LSMASH_SET_BE64( &data[ISOM_TIMELINE_INDEX_CHECKSUM_OFFSET], isom_get_timeline_index_checksum( data, index_size ) );
+    FILE *fp = lsmash_fopen( filename, "wb" );
+    if( !fp )
+        err = LSMASH_ERR_NAMELESS;
+    else
+    {
+        if( fwrite( data, 1, index_size, fp ) != index_size )
+            err = LSMASH_ERR_NAMELESS;
+        if( fclose( fp ) != 0 )
+            err = LSMASH_ERR_NAMELESS;
+    }
+    lsmash_free( data );
+    return err;
+}
+
+int lsmash_read_timeline_index( lsmash_root_t *root, const char *filename )
+{
+    if( isom_check_initializer_present( root ) < 0 || !filename )
+        return LSMASH_ERR_FUNCTION_PARAM;
+    lsmash_file_t *file = root->file;
+    isom_timeline_index_source_t source;
+    int err = isom_get_timeline_index_source( file, &source );
+    if( err < 0 )
+        return err;
+    FILE *fp = lsmash_fopen( filename, "rb" );
+    if( !fp )
+        return LSMASH_ERR_NAMELESS;
+    /* Get the whole index by a mapping or a single read. */
+    uint64_t index_size = 0;
+    uint8_t *data   = lsmash_map_file( fp, &index_size );
+    int      mapped = !!data;
+    if( !mapped
+     && lsmash_fseek( fp, 0, SEEK_END ) == 0 )
+    {
+        int64_t end = lsmash_ftell( fp );
+        if( end > 0
+         && (uint64_t)end <= SIZE_MAX
+         && lsmash_fseek( fp, 0, SEEK_SET ) == 0
+         && (data = lsmash_malloc( end )) != NULL )
+        {
+            index_size = end;
+            if( fread( data, 1, index_size, fp ) != index_size )
+            {
+                lsmash_free( data );
+                data = NULL;
+            }
+        }
+    }
+    fclose( fp );
+    if( !data )
+        return LSMASH_ERR_INVALID_DATA;
+    lsmash_bs_t bs = { 0 };
+    if( (err = lsmash_bs_set_mapped_stream( &bs, data, index_size )) == 0 )
+        err = isom_get_timeline_index( &bs, file, &source, index_size );
+    if( mapped )
+        lsmash_unmap_file( data, index_size );
+    else
+        lsmash_free( data );
+    return err;
+}
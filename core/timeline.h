@@ -105,11 +105,25 @@ isom_timeline_t *isom_get_timeline
     uint32_t       track_ID
 );
 
+/* Add a timeline to a file. The file takes the ownership of the timeline if successful. */
+int isom_add_timeline
+(
+    lsmash_file_t   *file,
+    isom_timeline_t *timeline
+);
+
 void isom_remove_timelines
 (
     lsmash_file_t *file
 );
 
+/* Expand every timeline of a file constructed by lsmash_construct_lazy_timeline() so that it no longer refers to the sample tables.
+ * A timeline which cannot be expanded is destructed. */
+void isom_expand_lazy_timelines
+(
+    lsmash_file_t *file
+);
+
 int isom_timeline_construct
 (
     lsmash_root_t *root,
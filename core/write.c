@@ -875,34 +875,20 @@ static int isom_write_stsd( lsmash_bs_t *bs, isom_box_t *box )
 static int isom_write_stts( lsmash_bs_t *bs, isom_box_t *box )
 {
     isom_stts_t *stts = (isom_stts_t *)box;
-    assert( stts->list );
+    isom_stts_entry_t *data = (isom_stts_entry_t *)stts->table.data;
     isom_bs_put_box_common( bs, stts );
-    lsmash_bs_put_be32( bs, stts->list->entry_count );
-    for( lsmash_entry_t *entry = stts->list->head; entry; entry = entry->next )
-    {
-        isom_stts_entry_t *data = (isom_stts_entry_t *)entry->data;
-        if( !data )
-            return LSMASH_ERR_NAMELESS;
-        lsmash_bs_put_be32( bs, data->sample_count );
-        lsmash_bs_put_be32( bs, data->sample_delta );
-    }
+    lsmash_bs_put_be32( bs, stts->table.entry_count );
+    lsmash_bs_put_be32_array( bs, (const uint32_t *)data, 2 * (size_t)stts->table.entry_count );
     return 0;
 }
 
 static int isom_write_ctts( lsmash_bs_t *bs, isom_box_t *box )
 {
     isom_ctts_t *ctts = (isom_ctts_t *)box;
-    assert( ctts->list );
+    isom_ctts_entry_t *data = (isom_ctts_entry_t *)ctts->table.data;
     isom_bs_put_box_common( bs, ctts );
-    lsmash_bs_put_be32( bs, ctts->list->entry_count );
-    for( lsmash_entry_t *entry = ctts->list->head; entry; entry = entry->next )
-    {
-        isom_ctts_entry_t *data = (isom_ctts_entry_t *)entry->data;
-        if( !data )
-            return LSMASH_ERR_NAMELESS;
-        lsmash_bs_put_be32( bs, data->sample_count );
-        lsmash_bs_put_be32( bs, data->sample_offset );
-    }
+    lsmash_bs_put_be32( bs, ctts->table.entry_count );
+    lsmash_bs_put_be32_array( bs, (const uint32_t *)data, 2 * (size_t)ctts->table.entry_count );
     return 0;
 }
 
@@ -921,57 +907,43 @@ static int isom_write_cslg( lsmash_bs_t *bs, isom_box_t *box )
 static int isom_write_stsz( lsmash_bs_t *bs, isom_box_t *box )
 {
     isom_stsz_t *stsz = (isom_stsz_t *)box;
+    isom_stsz_entry_t *data = (isom_stsz_entry_t *)stsz->table.data;
     isom_bs_put_box_common( bs, stsz );
     lsmash_bs_put_be32( bs, stsz->sample_size );
     lsmash_bs_put_be32( bs, stsz->sample_count );
-    if( stsz->sample_size == 0 && stsz->list )
-        for( lsmash_entry_t *entry = stsz->list->head; entry; entry = entry->next )
-        {
-            isom_stsz_entry_t *data = (isom_stsz_entry_t *)entry->data;
-            if( !data )
-                return LSMASH_ERR_NAMELESS;
-            lsmash_bs_put_be32( bs, data->entry_size );
-        }
+    if( stsz->sample_size == 0 )
+        lsmash_bs_put_be32_array( bs, (const uint32_t *)data, stsz->table.entry_count );
     return 0;
 }
 
 static int isom_write_stz2( lsmash_bs_t *bs, isom_box_t *box )
 {
     isom_stz2_t *stz2 = (isom_stz2_t *)box;
+    isom_stsz_entry_t *data = (isom_stsz_entry_t *)stz2->table.data;
+    uint32_t entry_count = stz2->table.entry_count;
     isom_bs_put_box_common( bs, stz2 );
     lsmash_bs_put_be32( bs, (stz2->reserved << 8) | stz2->field_size );
     lsmash_bs_put_be32( bs, stz2->sample_count );
     if( stz2->field_size == 16 )
-        for( lsmash_entry_t *entry = stz2->list->head; entry; entry = entry->next )
+        for( uint32_t i = 0; i < entry_count; i++ )
         {
-            isom_stsz_entry_t *data = (isom_stsz_entry_t *)entry->data;
-            if( !data )
-                return LSMASH_ERR_NAMELESS;
-            assert( data->entry_size <= 0xffff );
-            lsmash_bs_put_be16( bs, data->entry_size );
+            assert( data[i].entry_size <= 0xffff );
+            lsmash_bs_put_be16( bs, data[i].entry_size );
         }
     else if( stz2->field_size == 8 )
-        for( lsmash_entry_t *entry = stz2->list->head; entry; entry = entry->next )
+        for( uint32_t i = 0; i < entry_count; i++ )
         {
-            isom_stsz_entry_t *data = (isom_stsz_entry_t *)entry->data;
-            if( !data )
-                return LSMASH_ERR_NAMELESS;
-            assert( data->entry_size <= 0xff );
-            lsmash_bs_put_byte( bs, data->entry_size );
+            assert( data[i].entry_size <= 0xff );
+            lsmash_bs_put_byte( bs, data[i].entry_size );
         }
     else if( stz2->field_size == 4 )
-    {
-        isom_stsz_entry_t zero_padding = { .entry_size = 0 };
-        for( lsmash_entry_t *entry = stz2->list->head; entry; entry = entry->next ? entry->next->next : entry->next )
+        for( uint32_t i = 0; i < entry_count; i += 2 )
         {
-            isom_stsz_entry_t *data_o = (isom_stsz_entry_t *)entry->data;
-            isom_stsz_entry_t *data_e = (isom_stsz_entry_t *)(entry->next ? entry->next->data : &zero_padding);
-            if( !data_o || !data_e )
-                return LSMASH_ERR_NAMELESS;
-            assert( data_o->entry_size <= 0xf && data_e->entry_size <= 0xf );
-            lsmash_bs_put_byte( bs, (data_o->entry_size << 4) | data_e->entry_size );
+            uint32_t entry_size_o = data[i].entry_size;
+            uint32_t entry_size_e = i + 1 < entry_count ? data[i + 1].entry_size : 0;
+            assert( entry_size_o <= 0xf && entry_size_e <= 0xf );
+            lsmash_bs_put_byte( bs, (entry_size_o << 4) | entry_size_e );
         }
-    }
     else
         return LSMASH_ERR_NAMELESS;
     return 0;
@@ -980,49 +952,34 @@ static int isom_write_stz2( lsmash_bs_t *bs, isom_box_t *box )
 static int isom_write_stss( lsmash_bs_t *bs, isom_box_t *box )
 {
     isom_stss_t *stss = (isom_stss_t *)box;
-    assert( stss->list );
+    isom_stss_entry_t *data = (isom_stss_entry_t *)stss->table.data;
     isom_bs_put_box_common( bs, stss );
-    lsmash_bs_put_be32( bs, stss->list->entry_count );
-    for( lsmash_entry_t *entry = stss->list->head; entry; entry = entry->next )
-    {
-        isom_stss_entry_t *data = (isom_stss_entry_t *)entry->data;
-        if( !data )
-            return LSMASH_ERR_NAMELESS;
-        lsmash_bs_put_be32( bs, data->sample_number );
-    }
+    lsmash_bs_put_be32( bs, stss->table.entry_count );
+    lsmash_bs_put_be32_array( bs, (const uint32_t *)data, stss->table.entry_count );
     return 0;
 }
 
 static int isom_write_stps( lsmash_bs_t *bs, isom_box_t *box )
 {
     isom_stps_t *stps = (isom_stps_t *)box;
-    assert( stps->list );
+    isom_stps_entry_t *data = (isom_stps_entry_t *)stps->table.data;
     isom_bs_put_box_common( bs, stps );
-    lsmash_bs_put_be32( bs, stps->list->entry_count );
-    for( lsmash_entry_t *entry = stps->list->head; entry; entry = entry->next )
-    {
-        isom_stps_entry_t *data = (isom_stps_entry_t *)entry->data;
-        if( !data )
-            return LSMASH_ERR_NAMELESS;
-        lsmash_bs_put_be32( bs, data->sample_number );
-    }
+    lsmash_bs_put_be32( bs, stps->table.entry_count );
+    lsmash_bs_put_be32_array( bs, (const uint32_t *)data, stps->table.entry_count );
     return 0;
 }
 
 static int isom_write_sdtp( lsmash_bs_t *bs, isom_box_t *box )
 {
     isom_sdtp_t *sdtp = (isom_sdtp_t *)box;
-    assert( sdtp->list );
+    isom_sdtp_entry_t *data = (isom_sdtp_entry_t *)sdtp->table.data;
     isom_bs_put_box_common( bs, sdtp );
-    for( lsmash_entry_t *entry = sdtp->list->head; entry; entry = entry->next )
+    for( uint32_t i = 0; i < sdtp->table.entry_count; i++ )
     {
-        isom_sdtp_entry_t *data = (isom_sdtp_entry_t *)entry->data;
-        if( !data )
-            return LSMASH_ERR_NAMELESS;
-        uint8_t temp = (data->is_leading            << 6)
-                     | (data->sample_depends_on     << 4)
-                     | (data->sample_is_depended_on << 2)
-                     |  data->sample_has_redundancy;
+        uint8_t temp = (data[i].is_leading            << 6)
+                     | (data[i].sample_depends_on     << 4)
+                     | (data[i].sample_is_depended_on << 2)
+                     |  data[i].sample_has_redundancy;
         lsmash_bs_put_byte( bs, temp );
     }
     return 0;
@@ -1031,34 +988,20 @@ static int isom_write_sdtp( lsmash_bs_t *bs, isom_box_t *box )
 static int isom_write_stsc( lsmash_bs_t *bs, isom_box_t *box )
 {
     isom_stsc_t *stsc = (isom_stsc_t *)box;
-    assert( stsc->list );
+    isom_stsc_entry_t *data = (isom_stsc_entry_t *)stsc->table.data;
     isom_bs_put_box_common( bs, stsc );
-    lsmash_bs_put_be32( bs, stsc->list->entry_count );
-    for( lsmash_entry_t *entry = stsc->list->head; entry; entry = entry->next )
-    {
-        isom_stsc_entry_t *data = (isom_stsc_entry_t *)entry->data;
-        if( !data )
-            return LSMASH_ERR_NAMELESS;
-        lsmash_bs_put_be32( bs, data->first_chunk );
-        lsmash_bs_put_be32( bs, data->samples_per_chunk );
-        lsmash_bs_put_be32( bs, data->sample_description_index );
-    }
+    lsmash_bs_put_be32( bs, stsc->table.entry_count );
+    lsmash_bs_put_be32_array( bs, (const uint32_t *)data, 3 * (size_t)stsc->table.entry_count );
     return 0;
 }
 
 static int isom_write_co64( lsmash_bs_t *bs, isom_box_t *box )
 {
     isom_stco_t *co64 = (isom_stco_t *)box;
-    assert( co64->list );
+    isom_co64_entry_t *data = (isom_co64_entry_t *)co64->table.data;
     isom_bs_put_box_common( bs, co64 );
-    lsmash_bs_put_be32( bs, co64->list->entry_count );
-    for( lsmash_entry_t *entry = co64->list->head; entry; entry = entry->next )
-    {
-        isom_co64_entry_t *data = (isom_co64_entry_t *)entry->data;
-        if( !data )
-            return LSMASH_ERR_NAMELESS;
-        lsmash_bs_put_be64( bs, data->chunk_offset );
-    }
+    lsmash_bs_put_be32( bs, co64->table.entry_count );
+    lsmash_bs_put_be64_array( bs, (const uint64_t *)data, co64->table.entry_count );
     return 0;
 }
 
@@ -1067,16 +1010,10 @@ static int isom_write_stco( lsmash_bs_t *bs, isom_box_t *box )
     isom_stco_t *stco = (isom_stco_t *)box;
     if( stco->large_presentation )
         return isom_write_co64( bs, box );
-    assert( stco->list );
+    isom_stco_entry_t *data = (isom_stco_entry_t *)stco->table.data;
     isom_bs_put_box_common( bs, stco );
-    lsmash_bs_put_be32( bs, stco->list->entry_count );
-    for( lsmash_entry_t *entry = stco->list->head; entry; entry = entry->next )
-    {
-        isom_stco_entry_t *data = (isom_stco_entry_t *)entry->data;
-        if( !data )
-            return LSMASH_ERR_NAMELESS;
-        lsmash_bs_put_be32( bs, data->chunk_offset );
-    }
+    lsmash_bs_put_be32( bs, stco->table.entry_count );
+    lsmash_bs_put_be32_array( bs, (const uint32_t *)data, stco->table.entry_count );
     return 0;
 }
 
@@ -1526,7 +1463,10 @@ static int isom_write_mdat( lsmash_bs_t *bs, isom_box_t *box )
             isom_sample_pool_t *pool = (isom_sample_pool_t *)entry->data;
             if( !pool )
                 return LSMASH_ERR_NAMELESS;
-            lsmash_bs_put_bytes( bs, pool->size, pool->data );
+            int err = lsmash_bs_write_vectors_and_free( bs, pool->data, pool->entry_count );
+            pool->entry_count = 0;
+            if( err < 0 )
+                return err;
         }
         mdat->media_size = file->fragment->pool_size;
         return 0;
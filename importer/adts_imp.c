@@ -332,7 +332,7 @@ static int mp4sys_adts_get_accessunit
     }
     lsmash_bs_t *bs = importer->bs;
     /* read a raw_data_block(), typically == payload of a ADTS frame */
-    lsmash_sample_t *sample = lsmash_create_sample( raw_data_block_size );
+    lsmash_sample_t *sample = isom_create_sample( importer->root->sample_pool, raw_data_block_size );
     if( !sample )
         return LSMASH_ERR_MEMORY_ALLOC;
     *p_sample = sample;
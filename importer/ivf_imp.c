@@ -176,7 +176,7 @@ static int ivf_importer_get_accessunit( importer_t *importer, uint32_t track_num
         current_status = IMPORTER_CHANGE;
     }
 
-    lsmash_sample_t *sample = lsmash_create_sample( samplesize );
+    lsmash_sample_t *sample = isom_create_sample( importer->root->sample_pool, samplesize );
     if( !sample ) {
         lsmash_free( samplebuf );
         return LSMASH_ERR_MEMORY_ALLOC;
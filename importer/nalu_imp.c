@@ -437,7 +437,7 @@ static int h264_importer_get_accessunit
         }
         importer->status = IMPORTER_OK;
     }
-    lsmash_sample_t *sample = lsmash_create_sample( h264_imp->max_au_length );
+    lsmash_sample_t *sample = isom_create_sample( importer->root->sample_pool, h264_imp->max_au_length );
     if( !sample )
         return LSMASH_ERR_MEMORY_ALLOC;
     *p_sample = sample;
@@ -1308,7 +1308,7 @@ static int hevc_importer_get_accessunit( importer_t *importer, uint32_t track_nu
         }
         importer->status = IMPORTER_OK;
     }
-    lsmash_sample_t *sample = lsmash_create_sample( hevc_imp->max_au_length );
+    lsmash_sample_t *sample = isom_create_sample( importer->root->sample_pool, hevc_imp->max_au_length );
     if( !sample )
         return LSMASH_ERR_MEMORY_ALLOC;
     *p_sample = sample;
@@ -285,7 +285,7 @@ static int vc1_importer_get_accessunit( importer_t *importer, uint32_t track_num
         importer->status = IMPORTER_ERROR;
         return err;
     }
-    lsmash_sample_t *sample = lsmash_create_sample( vc1_imp->max_au_length );
+    lsmash_sample_t *sample = isom_create_sample( importer->root->sample_pool, vc1_imp->max_au_length );
     if( !sample )
         return LSMASH_ERR_MEMORY_ALLOC;
     *p_sample = sample;
@@ -131,7 +131,7 @@ static int wave_importer_get_accessunit( importer_t *importer, uint32_t track_nu
         if( wave_imp->au_length == 0 )
             return IMPORTER_EOF;
     }
-    lsmash_sample_t *sample = lsmash_create_sample( wave_imp->au_length );
+    lsmash_sample_t *sample = isom_create_sample( importer->root->sample_pool, wave_imp->au_length );
     if( !sample )
         return LSMASH_ERR_MEMORY_ALLOC;
     *p_sample = sample;
@@ -382,16 +382,6 @@ static int wave_importer_construct_timeline( importer_t *importer, uint32_t trac
         return LSMASH_ERR_NAMELESS;
     int err;
     lsmash_file_t *file = importer->file;
-    if( !file->timeline )
-    {
-        /* TODO: this is not a proper place. It should be enclosed in isom_timeline_create(). */
-        file->timeline = lsmash_list_create( isom_timeline_destroy );
-        if( !file->timeline )
-        {
-            err = LSMASH_ERR_MEMORY_ALLOC;
-            goto fail;
-        }
-    }
     wave_importer_t *wave_imp = (wave_importer_t *)importer->info;
     if( (err = isom_timeline_set_track_ID( timeline, 1 )) < 0
      || (err = isom_timeline_set_movie_timescale( timeline, wave_imp->fmt.wfx.nSamplesPerSec )) < 0
@@ -425,12 +415,11 @@ static int wave_importer_construct_timeline( importer_t *importer, uint32_t trac
         if( (err = isom_add_lpcm_bunch_entry( timeline, &bunch )) < 0 )
             goto fail;
     }
-    if( (err = lsmash_list_add_entry( file->timeline, timeline )) < 0 )
+    if( (err = isom_add_timeline( file, timeline )) < 0 )
         goto fail;
     return 0;
 fail:
     isom_timeline_destroy( timeline );
-    isom_remove_timelines( file );
     return err;
 }
 
@@ -47,7 +47,7 @@ extern "C" {
  * Version
  ****************************************************************************/
 #define LSMASH_VERSION_MAJOR  2
-#define LSMASH_VERSION_MINOR 20
+#define LSMASH_VERSION_MINOR 21
 #define LSMASH_VERSION_MICRO  0
 
 #define LSMASH_VERSION_INT( a, b, c ) (((a) << 16) | ((b) << 8) | (c))
@@ -259,6 +259,50 @@ typedef struct
     uint64_t max_chunk_size;            /* max size per chunk in bytes. 4*1024*1024 (4MiB) is default value. */
     /** demuxing only **/
     uint64_t max_read_size;             /* max size of reading from the file at a time. 4*1024*1024 (4MiB) is default value. */
+    int      read_mmap;                 /* If set to 1, map the whole file on memory and read it through the mapping
+                                         * instead of buffered reads, so that reads and seeks never copy or call 'read'.
+                                         * Effective only for a regular file opened for reading by lsmash_open_file().
+                                         * The buffered reads are used if the file cannot be mapped.
+                                         * 0 is default value. */
+    int      read_ahead;                /* If set to 1, read the next region of the file in background during sequential reads.
+                                         * Each region has max_read_size bytes, and is discarded by a seek out of it.
+                                         * Effective only for a file opened for reading by lsmash_open_file() and not mapped.
+                                         * 0 is default value. */
+    int      read_lazily;               /* If set to 1, the entries of the table boxes larger than max_read_size, i.e. the large
+                                         * sample tables and track runs, are not read when the file is read but the first time
+                                         * they are needed, e.g. by the construction of a timeline, so that only probing the
+                                         * headers is fast. The smaller ones are read at once since their bytes are on hand.
+                                         * Likewise, the movie fragments indexed by the Segment Index Box or the Movie Fragment
+                                         * Random Access Box are not read until the construction of a timeline unless the rest
+                                         * of the file is not larger than max_read_size, and therefore the time to read a
+                                         * fragmented file does not depend on its duration.
+                                         * Note that only the time to read the file is reduced: all of the deferred movie fragments
+                                         * are read at once by the first construction of a timeline, which still takes the time
+                                         * depending on the duration.
+                                         * The file must be kept open until all of the entries are read.
+                                         * Effective only for a seekable file.
+                                         * 0 is default value. */
+    int      read_minimally;            /* If set to 1, read each top-level box by a read of its exact size
+                                         * and only the header of the Media Data Box and the others skipped,
+                                         * so that no bytes beyond what is needed are read from the file,
+                                         * e.g. the media data preceding the Movie Box at the end of the file.
+                                         * Together with read_lazily, the movie fragments indexed by the Segment Index Box
+                                         * or the Movie Fragment Random Access Box are skipped after reading only their header,
+                                         * but the entries of the table boxes in the Movie Box are read at once since they are on hand.
+                                         * lsmash_count_read_bytes() reports the number of bytes read.
+                                         * The file is read only as ISOBMFF or QTFF, i.e. any other format is not detected.
+                                         * 'read_ahead' is ignored if this is set.
+                                         * Effective only for a seekable file which is not mapped.
+                                         * 0 is default value. */
+    /** muxing only **/
+    int      write_async;               /* If set to 1, write media data and boxes into the file in background.
+                                         * Data waiting to be written is limited to four times max_chunk_size,
+                                         * and writing another one waits for room only when the limit is exceeded.
+                                         * Offsets in the file are decided as if written synchronously.
+                                         * A failure of background writes is reported by a later call which accesses the file
+                                         * or by lsmash_close_file(), which must be called to complete the writes.
+                                         * Effective only for a file opened for writing by lsmash_open_file().
+                                         * 0 is default value. */
 } lsmash_file_parameters_t;
 
 typedef int (*lsmash_adhoc_remux_callback)( void *param, uint64_t done, uint64_t total );
@@ -331,7 +375,20 @@ int64_t lsmash_read_file
     lsmash_file_parameters_t *param
 );
 
-/* Deallocate all boxes within the current active file in a given ROOT. */
+/* Get the total number of bytes read from a given file so far, including the reads after lsmash_read_file().
+ * The data read ahead in background is counted when consumed.
+ *
+ * Return the number of bytes if successful.
+ * Return 0 otherwise. */
+uint64_t lsmash_count_read_bytes
+(
+    lsmash_file_t *file
+);
+
+/* Deallocate all boxes within the current active file in a given ROOT.
+ * The timelines constructed by lsmash_construct_lazy_timeline() for the file are expanded in advance
+ * since they refer to the sample tables, which takes as long and as much memory as lsmash_construct_timeline().
+ * Any of them is destructed if failed to be expanded. */
 void lsmash_discard_boxes
 (
     lsmash_root_t *root     /* the address of a ROOT you want to deallocate all boxes within the active file in it */
@@ -1686,6 +1743,12 @@ typedef struct
 /* Allocate a sample and then allocate data of the allocated sample by 'size'.
  * If 'size' is set to 0, data of the allocated sample won't be allocated and will be set to NULL instead.
  * The allocated sample can be deallocated by lsmash_delete_sample().
+ * Note:
+ *   The library keeps its own header in front of every sample it allocates.
+ *   So, lsmash_sample_alloc(), lsmash_delete_sample() and lsmash_append_sample() accept only the samples allocated
+ *   by the library, i.e. by lsmash_create_sample(), lsmash_create_sample_from_pool(), lsmash_get_sample_from_media_timeline()
+ *   or lsmash_get_sample_from_read_planner(). A sample structure allocated by users, e.g. on the stack or by malloc(),
+ *   shall not be passed to them.
  *
  * Return the address of an allocated sample if successful.
  * Return NULL otherwise. */
@@ -1694,7 +1757,7 @@ lsmash_sample_t *lsmash_create_sample
     uint32_t size   /* size of sample data you request */
 );
 
-/* Allocate data of a given allocated sample by 'size'.
+/* Allocate data of a given sample allocated by the library by 'size'.
  * If the sample data is already allocated, reallocate it by 'size'.
  *
  * Return 0 if successful.
@@ -1705,14 +1768,89 @@ int lsmash_sample_alloc
     uint32_t         size       /* size of sample data you request */
 );
 
-/* Deallocate a given sample. */
+/* Deallocate a given sample allocated by the library. */
 void lsmash_delete_sample
 (
     lsmash_sample_t *sample     /* the address of a sample you want to deallocate */
 );
 
+/* The sample pool recycles the memory blocks of samples and their data.
+ * A sample allocated from a sample pool is deallocated by lsmash_delete_sample() as usual, and then its memory blocks
+ * are kept in the pool in order to be reused by the subsequent allocations of similar sizes. Therefore, steady-state
+ * muxing and demuxing require no heap allocation for each sample.
+ * The memory blocks are returned to the pool whichever thread deallocates them, and the pool can be shared between
+ * multiple ROOTs. The pool is deallocated after it is destroyed and all of the samples allocated from it are deallocated. */
+typedef struct lsmash_sample_pool_tag lsmash_sample_pool_t;
+
+typedef struct
+{
+    uint64_t alloc_count;       /* the number of memory blocks requested
+                                 * A sample with its data requests two blocks. */
+    uint64_t reuse_count;       /* the number of the requests served by cached blocks without heap allocation */
+    uint64_t discard_count;     /* the number of the released blocks deallocated instead of being cached */
+    uint64_t live_count;        /* the number of the blocks in use */
+    uint64_t live_size;         /* the total size of the blocks in use */
+    uint64_t peak_live_size;    /* the maximum total size of the blocks in use ever */
+    uint64_t cached_count;      /* the number of the blocks cached for reuse */
+    uint64_t cached_size;       /* the total size of the blocks cached for reuse */
+} lsmash_sample_pool_stats_t;
+
+/* Create a sample pool.
+ * The pool caches the released memory blocks up to 'max_cached_size' bytes in total.
+ * If 'max_cached_size' is set to 0, the total size is not limited, i.e. up to the peak usage.
+ *
+ * Return the address of an allocated sample pool if successful.
+ * Return NULL otherwise. */
+lsmash_sample_pool_t *lsmash_create_sample_pool
+(
+    uint64_t max_cached_size
+);
+
+/* Destroy a sample pool.
+ * The samples allocated from the pool remain valid, and the pool is actually deallocated after all of them are deallocated. */
+void lsmash_destroy_sample_pool
+(
+    lsmash_sample_pool_t *pool
+);
+
+/* Allocate a sample and then allocate data of the allocated sample by 'size' from a given sample pool.
+ * If 'pool' is set to NULL, this function is equivalent to lsmash_create_sample().
+ * The allocated sample can be deallocated by lsmash_delete_sample().
+ *
+ * Return the address of an allocated sample if successful.
+ * Return NULL otherwise. */
+lsmash_sample_t *lsmash_create_sample_from_pool
+(
+    lsmash_sample_pool_t *pool,
+    uint32_t              size
+);
+
+/* Get the statistics of a sample pool.
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_get_sample_pool_stats
+(
+    lsmash_sample_pool_t       *pool,
+    lsmash_sample_pool_stats_t *stats
+);
+
+/* Set a sample pool to a ROOT.
+ * The samples allocated by the importers and the timelines of the files in the ROOT are allocated from the pool.
+ * The ROOT holds the pool until another pool is set or the ROOT is destroyed, so the pool can be destroyed by the caller
+ * after this call. If 'pool' is set to NULL, the samples are allocated without any pool.
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_set_sample_pool
+(
+    lsmash_root_t        *root,
+    lsmash_sample_pool_t *pool
+);
+
 /* Append a sample to a track.
  * Note:
+ *   The sample shall be allocated by the library. See the note of lsmash_create_sample().
  *   The appended sample will be deleted by lsmash_delete_sample() internally.
  *   Users shall not deallocate the sample by lsmash_delete_sample() if successful to append the sample.
  *
@@ -2087,6 +2225,43 @@ int lsmash_assign_data_reference
     lsmash_file_t *file
 );
 
+typedef struct
+{
+    uint64_t hit_count;         /* the number of the accesses to the referenced files kept open */
+    uint64_t miss_count;        /* the number of the accesses which reopened the referenced files */
+    uint64_t eviction_count;    /* the number of the referenced files closed to keep the limit */
+    uint32_t file_count;        /* the number of the referenced files managed by the cache */
+    uint32_t open_count;        /* the number of the referenced files open currently */
+} lsmash_file_handle_cache_stats_t;
+
+/* Set a file handle cache to a ROOT, or change the limit of the cache if already set.
+ * The cache manages the media files opened for reading by lsmash_open_file() and set to the ROOT by lsmash_set_file()
+ * after the cache is set, except the first file set to the ROOT, which is not a referenced file.
+ * Such a file is opened only while accessed recently, and closed with the release of its buffer when more than
+ * 'max_open_files' files are opened, and then reopened transparently on the next access.
+ * So, lots of referenced files can be read without exhausting file descriptors and memory.
+ * Note that the data gotten by lsmash_get_sample_view_from_media_timeline() from a file managed by the cache is also
+ * invalidated by any read from the other files managed by the same cache, and that the files managed by the cache
+ * must not be accessed concurrently.
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_set_file_handle_cache
+(
+    lsmash_root_t *root,
+    uint32_t       max_open_files
+);
+
+/* Get the statistics of the file handle cache of a ROOT.
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_get_file_handle_cache_stats
+(
+    lsmash_root_t                    *root,
+    lsmash_file_handle_cache_stats_t *stats
+);
+
 /****************************************************************************
  * Track Layer
  ****************************************************************************/
@@ -2416,6 +2591,35 @@ int lsmash_reserve_media_data_size
     uint64_t       media_data_size
 );
 
+/* Reserve the space for the Movie Box in front of the media data region of a non-fragmented movie.
+ * The reserved space is written as a Free Space Box of 'movie_size' bytes including the type and the size fields just
+ * before the first media data, so this function must be called before any lsmash_append_sample() on a seekable output.
+ * When finishing the movie, the Movie Box is written into the reserved space and the rest of it is left as a Free Space
+ * Box. If the Movie Box does not fit in, the reserved space is enlarged by moving the media data only by the shortage
+ * when lsmash_finish_movie() is given 'remux', or the Movie Box is written at the end of the file otherwise.
+ * The size to reserve can be estimated by lsmash_estimate_movie_size().
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_reserve_movie_size
+(
+    lsmash_root_t *root,
+    uint64_t       movie_size
+);
+
+/* Estimate the size of the Movie Box and a Meta Box if any, to be written by lsmash_finish_movie().
+ * The estimate is conservative on the assumption that each track has 'sample_count' samples or the number of samples
+ * appended so far if greater, and every sample is placed in its own chunk and described in every sample table.
+ * The returned size can be passed to lsmash_reserve_movie_size().
+ *
+ * Return the estimated size in bytes if successful.
+ * Return 0 otherwise. */
+uint64_t lsmash_estimate_movie_size
+(
+    lsmash_root_t *root,
+    uint32_t       sample_count
+);
+
 /****************************************************************************
  * Chapter list
  ****************************************************************************/
@@ -2541,6 +2745,86 @@ int lsmash_construct_timeline
     uint32_t       track_ID
 );
 
+/* Construct the timeline for a track without expanding the information of every sample.
+ * The information of a sample is resolved from the sample tables on demand, so the construction is nearly instantaneous
+ * and the memory usage is proportional to the size of the sample tables instead of the number of samples.
+ * Instead, the access to each sample costs logarithmic time in the number of entries of the sample tables.
+ * If the track cannot be handled lazily, e.g. a movie which can be fragmented or LPCM, this function falls back to lsmash_construct_timeline().
+ * The sample tables of the track must not be changed while the timeline is alive.
+ * If the boxes are deallocated by lsmash_discard_boxes(), the timeline is expanded into the one by lsmash_construct_timeline() in advance.
+ * The constructed timeline can be destructed by lsmash_destruct_timeline().
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_construct_lazy_timeline
+(
+    lsmash_root_t *root,
+    uint32_t       track_ID
+);
+
+/* Construct the timelines for all tracks which have no timeline yet.
+ * The timelines are built concurrently on up to 'thread_count' threads including the calling thread.
+ * If 'thread_count' is set to 0, a thread is used for each track.
+ * The boxes required for the construction are read in advance on the calling thread, so the threads never share the stream.
+ * If the construction for any track fails, no timeline is added.
+ * The constructed timelines can be destructed by lsmash_destruct_timeline() one by one.
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_construct_all_timelines
+(
+    lsmash_root_t *root,
+    uint32_t       thread_count
+);
+
+/* Extend the timeline for a given track by the movie fragments appended to the file since the timeline was constructed or extended last.
+ * This is useful for reading a fragmented movie which is still being written, e.g. live recording.
+ * Only the movie fragments written completely are taken in, so this function can be called repeatedly as the file grows.
+ * The number of samples in the extended timeline is set to 'sample_count'.
+ * If the timeline is constructed for a movie without the Movie Extends Box, there is nothing to extend.
+ * A file read through its mapping, i.e. opened with 'read_mmap', is mapped again when it has grown, and then any data gotten
+ * by lsmash_get_sample_view_from_media_timeline() or lsmash_get_sample_views_from_media_timeline() before gets invalid.
+ * If any error occurs, the timeline should be destructed since it may be left incomplete.
+ *
+ * Return 0 if successful.
+ * Return LSMASH_ERR_PATCH_WELCOME if the timeline cannot be extended, e.g. the file is not seekable.
+ * Return another negative value otherwise. */
+int lsmash_extend_timeline
+(
+    lsmash_root_t *root,
+    uint32_t       track_ID,
+    uint32_t      *sample_count
+);
+
+/* Write the timelines constructed for the file in a given ROOT into an index file,
+ * so that lsmash_read_timeline_index() can load them instead of constructing them again when the file is reopened.
+ * The timelines constructed by lsmash_construct_lazy_timeline() are not written since their construction is cheap anyway.
+ * The file must be opened by lsmash_open_file() since the index is validated by the size and the modification time of it.
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_write_timeline_index
+(
+    lsmash_root_t *root,
+    const char    *filename
+);
+
+/* Load the timelines from an index file written by lsmash_write_timeline_index().
+ * The index is valid only if the file in a given ROOT has not been changed since the index was written.
+ * Reading the file with 'read_lazily' is recommended since the sample tables are then never read.
+ * The timelines for the tracks which have any timeline already are not loaded.
+ * The loaded timelines cannot be extended by lsmash_extend_timeline().
+ *
+ * Return 0 if successful.
+ * Return LSMASH_ERR_INVALID_DATA if the index is broken or not valid for the file,
+ * in which case no timeline is loaded and the timelines should be constructed as usual.
+ * Return another negative value otherwise. */
+int lsmash_read_timeline_index
+(
+    lsmash_root_t *root,
+    const char    *filename
+);
+
 /* Destruct the timeline for a given track. */
 void lsmash_destruct_timeline
 (
@@ -2644,6 +2928,60 @@ int lsmash_get_closest_random_accessible_point_detail_from_media_timeline
                                                  * that the sample corresponding to a given number can be decodable correctly by decoding from there will be set */
 );
 
+/* Get the sample number of the sample decoded at a given DTS from the media timeline for a track.
+ * The found sample is the last one in decoding order whose DTS is not greater than the given DTS.
+ * If the given DTS precedes the first sample, the first sample is found.
+ * Also get the closest random accessible point to the found sample in the same way as
+ * lsmash_get_closest_random_accessible_point_from_media_timeline() if 'rap_number' is not NULL.
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_get_sample_number_from_dts
+(
+    lsmash_root_t *root,
+    uint32_t       track_ID,
+    uint64_t       dts,
+    uint32_t      *sample_number,   /* the address of a variable to which the number of the found sample will be set */
+    uint32_t      *rap_number       /* the address of a variable to which the sample number of the closest random accessible point will be set */
+);
+
+/* Get the sample number of the sample presented at a given CTS from the media timeline for a track.
+ * The CTS is expressed in the same way as lsmash_get_cts_from_media_timeline(), i.e. the composition to decode timeline shift is not added.
+ * The found sample is the output sample with the greatest CTS not greater than the given CTS,
+ * and if two or more samples share the CTS, the first one in decoding order is found.
+ * If the given CTS precedes all samples, the first sample in composition order is found.
+ * Also get the closest random accessible point to the found sample in the same way as
+ * lsmash_get_closest_random_accessible_point_from_media_timeline() if 'rap_number' is not NULL.
+ * Note:
+ *   the index of the samples in composition order is built at the first call for a timeline.
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_get_sample_number_from_cts
+(
+    lsmash_root_t *root,
+    uint32_t       track_ID,
+    uint64_t       cts,
+    uint32_t      *sample_number,   /* the address of a variable to which the number of the found sample will be set */
+    uint32_t      *rap_number       /* the address of a variable to which the sample number of the closest random accessible point will be set */
+);
+
+/* Get the sample number of the sample presented at a given time on the presentation timeline for a track.
+ * The given time is expressed in the media timescale, and is mapped to a CTS by the edit list of the track.
+ * If the given time is in an empty edit, the beginning of the next edit is used instead.
+ * After mapping, the sample is found in the same way as lsmash_get_sample_number_from_cts().
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise, e.g. nothing is presented at and after the given time. */
+int lsmash_get_sample_number_from_presentation_time
+(
+    lsmash_root_t *root,
+    uint32_t       track_ID,
+    uint64_t       presentation_time,
+    uint32_t      *sample_number,   /* the address of a variable to which the number of the found sample will be set */
+    uint32_t      *rap_number       /* the address of a variable to which the sample number of the closest random accessible point will be set */
+);
+
 /* Get the number of samples in the media timeline for a track.
  *
  * Return the number of samples in a track if successful.
@@ -2686,6 +3024,84 @@ lsmash_sample_t *lsmash_get_sample_from_media_timeline
     uint32_t       sample_number
 );
 
+/* Get the sample corresponding to a given sample number from the media timeline for a track
+ * without allocating and copying its data.
+ * The structure pointed by 'sample' is provided by the caller, and its 'data' is set to the address
+ * of the data on the internal buffer of the file that contains the sample.
+ * The data must not be modified or deallocated, and is valid until the next read from the same file
+ * or the destruction of the file or the timeline, whichever comes first.
+ * So, don't pass the sample to lsmash_append_sample() and lsmash_delete_sample().
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_get_sample_view_from_media_timeline
+(
+    lsmash_root_t   *root,
+    uint32_t         track_ID,
+    uint32_t         sample_number,
+    lsmash_sample_t *sample
+);
+
+/* Get the samples from a given sample number to the end of the chunk containing it from the media timeline for a track
+ * by a single read without allocating and copying their data.
+ * 'samples' is an array of the structures provided by the caller, and the number of its elements is given by 'sample_count'.
+ * The samples are gotten up to the number, and 'sample_count' is set to the number of the gotten samples.
+ * Since the data of the samples in a chunk are contiguous, the data of the gotten samples are placed contiguously, i.e. the data
+ * of the first sample starts the data of all of the gotten samples.
+ * Passing the number of the next sample of the last gotten one repeatedly, the caller can get all samples in chunk units.
+ * The data have the same validity as the one gotten by lsmash_get_sample_view_from_media_timeline().
+ *
+ * Return 0 if successful.
+ * Return a negative value otherwise. */
+int lsmash_get_sample_views_from_media_timeline
+(
+    lsmash_root_t   *root,
+    uint32_t         track_ID,
+    uint32_t         sample_number,
+    lsmash_sample_t *samples,
+    uint32_t        *sample_count
+);
+
+/* The read planner gets the samples of multiple tracks in a file in the order of their file offsets.
+ * When a sample not read ahead is requested, the planner reads the region from the sample by a single read,
+ * and queues the samples of all planned tracks in the region, so demuxing interleaved tracks at once
+ * doesn't seek back and forth in the file. */
+typedef struct lsmash_read_planner_tag lsmash_read_planner_t;
+
+/* Create a read planner for the media timelines of the given tracks.
+ * 'max_read_size' is the maximum size of a read, and also of the samples read ahead for each track.
+ * If 'max_read_size' is set to 0, the default value (4 MiB) is used.
+ * The planner must be destroyed before the destruction of the ROOT or the timelines.
+ *
+ * Return the address of an allocated read planner if successful.
+ * Return NULL otherwise. */
+lsmash_read_planner_t *lsmash_create_read_planner
+(
+    lsmash_root_t  *root,
+    const uint32_t *track_IDs,
+    uint32_t        track_count,
+    uint32_t        max_read_size
+);
+
+/* Destroy a read planner and the samples read ahead by it. */
+void lsmash_destroy_read_planner
+(
+    lsmash_read_planner_t *planner
+);
+
+/* Get the sample corresponding to a given sample number from the media timeline for a track through a read planner.
+ * The sample is the same as the one gotten by lsmash_get_sample_from_media_timeline(), and can be deallocated by lsmash_delete_sample().
+ * Sequential access to each track is fastest; random access is also allowed but discards the samples read ahead for the track.
+ *
+ * Return the address of an allocated and gotten sample if successful.
+ * Return NULL otherwise. */
+lsmash_sample_t *lsmash_get_sample_from_read_planner
+(
+    lsmash_read_planner_t *planner,
+    uint32_t               track_ID,
+    uint32_t               sample_number
+);
+
 /* Get the information of the sample correspondint to a given sample number from the media timeline for a track.
  * The information includes the size, timestamps and properties of the sample.
  *